@@ -0,0 +1,518 @@
+// Microbenchmarks of the audit engine's hot paths. Nothing here opens a
+// connection: model lists are generated in the shape of the OpenRouter and
+// Google AI Studio catalogs (or read from $LLAUDIT_BENCH_CATALOGS/openrouter.json
+// and google.json), reports are synthetic, and the end-to-end run replays a
+// workspace recorded with `api_tester_cli --record` ($LLAUDIT_BENCH_WORKSPACE).
+//
+// Every benchmark reports allocs/op and alloc_bytes/op next to its time and
+// throughput, counted by the global operator new below.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+
+#include "audit_engine.h"
+#include "header_table.h"
+#include "json_writer.h"
+#include "model_index.h"
+#include "rate_limiter.h"
+#include "report_writer.h"
+#include "trace_store.h"
+#include "workspace.h"
+
+namespace {
+
+std::atomic<std::uint64_t> g_allocs{0};
+std::atomic<std::uint64_t> g_alloc_bytes{0};
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  g_allocs.fetch_add(1, std::memory_order_relaxed);
+  g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return ::operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+using llaudit::AuditReport;
+using llaudit::ChatFormat;
+using nlohmann::json;
+
+// Counts the allocations of every thread from construction to destruction,
+// so declare it just before the timing loop.
+class AllocationCounter {
+ public:
+  explicit AllocationCounter(benchmark::State& state)
+      : state_(state), allocs_(g_allocs.load()), bytes_(g_alloc_bytes.load()) {}
+  ~AllocationCounter() {
+    const auto per_op = benchmark::Counter::kAvgIterations;
+    state_.counters["allocs/op"] =
+        benchmark::Counter(static_cast<double>(g_allocs.load() - allocs_), per_op);
+    state_.counters["alloc_bytes/op"] =
+        benchmark::Counter(static_cast<double>(g_alloc_bytes.load() - bytes_), per_op);
+  }
+
+ private:
+  benchmark::State& state_;
+  std::uint64_t allocs_;
+  std::uint64_t bytes_;
+};
+
+// Discards what is written, so serializers are measured without the cost of
+// growing a string.
+class NullBuffer : public std::streambuf {
+ public:
+  std::size_t size() const { return size_; }
+
+ protected:
+  int_type overflow(int_type c) override {
+    ++size_;
+    return traits_type::not_eof(c);
+  }
+  std::streamsize xsputn(const char*, std::streamsize n) override {
+    size_ += static_cast<std::size_t>(n);
+    return n;
+  }
+
+ private:
+  std::size_t size_ = 0;
+};
+
+std::string ReadOverride(const char* name) {
+  const char* dir = std::getenv("LLAUDIT_BENCH_CATALOGS");
+  if (!dir) return {};
+  std::ifstream ifs(std::filesystem::path(dir) / name, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+const char* const kVendors[] = {"openai",  "anthropic", "google",   "meta-llama", "mistralai",
+                                "qwen",    "deepseek",  "cohere",   "nousresearch", "x-ai",
+                                "microsoft", "amazon",  "perplexity", "01-ai",    "thudm"};
+const char* const kFamilies[] = {"chat", "instruct", "coder", "vision", "thinking", "mini", "large"};
+
+// About 1.3 MB for the ~400 models OpenRouter lists, with the same nesting.
+const std::string& OpenRouterCatalog() {
+  static const std::string payload = [] {
+    if (auto real = ReadOverride("openrouter.json"); !real.empty()) return real;
+    json data = json::array();
+    for (int i = 0; i < 400; ++i) {
+      const std::string vendor = kVendors[i % std::size(kVendors)];
+      const std::string family = kFamilies[i % std::size(kFamilies)];
+      const std::string id = vendor + "/" + family + "-" + std::to_string(i);
+      const bool vision = family == "vision" || i % 5 == 0;
+      data.push_back({
+          {"id", id},
+          {"canonical_slug", id + "-20250101"},
+          {"hugging_face_id", vendor + "/" + family + "-" + std::to_string(i) + "-hf"},
+          {"name", vendor + ": " + family + " " + std::to_string(i)},
+          {"created", 1700000000 + i * 3600},
+          {"description",
+           "A " + family + " model from " + vendor +
+               " tuned for general assistant use, long documents, multilingual chat and "
+               "structured output. It supports function calling and follows system prompts "
+               "closely; see the provider documentation for details on safety behaviour, "
+               "rate limits and recommended sampling settings for production traffic."},
+          {"context_length", 8192 << (i % 8)},
+          {"architecture",
+           {{"modality", vision ? "text+image->text" : "text->text"},
+            {"input_modalities", vision ? json{"text", "image"} : json{"text"}},
+            {"output_modalities", {"text"}},
+            {"tokenizer", "Other"},
+            {"instruct_type", nullptr}}},
+          {"pricing",
+           {{"prompt", "0.0000005"},
+            {"completion", "0.0000015"},
+            {"request", "0"},
+            {"image", vision ? "0.001" : "0"},
+            {"web_search", "0"},
+            {"internal_reasoning", "0"}}},
+          {"top_provider",
+           {{"context_length", 8192 << (i % 8)},
+            {"max_completion_tokens", 4096},
+            {"is_moderated", i % 3 == 0}}},
+          {"per_request_limits", nullptr},
+          {"supported_parameters",
+           {"max_tokens", "temperature", "top_p", "stop", "frequency_penalty", "presence_penalty",
+            "seed", "tools", "tool_choice", "response_format", "structured_outputs"}},
+      });
+    }
+    return json{{"data", std::move(data)}}.dump();
+  }();
+  return payload;
+}
+
+// About 60 models, most of them generateContent-capable, as AI Studio lists.
+const std::string& GoogleCatalog() {
+  static const std::string payload = [] {
+    if (auto real = ReadOverride("google.json"); !real.empty()) return real;
+    json models = json::array();
+    for (int i = 0; i < 60; ++i) {
+      const bool embedding = i % 6 == 5;
+      const std::string name =
+          embedding ? "models/text-embedding-" + std::to_string(i)
+                    : "models/gemini-" + std::to_string(1 + i % 3) + ".5-" +
+                          (i % 2 ? "flash" : "pro") + "-" + std::to_string(i);
+      models.push_back({
+          {"name", name},
+          {"baseModelId", name.substr(7)},
+          {"version", "001"},
+          {"displayName", "Gemini " + std::to_string(i)},
+          {"description", "Fast and versatile multimodal model for scaling across diverse tasks, "
+                          "with thinking and long context."},
+          {"inputTokenLimit", embedding ? 2048 : 1048576},
+          {"outputTokenLimit", embedding ? 1 : 65536},
+          {"supportedGenerationMethods",
+           embedding ? json{"embedContent"}
+                     : json{"generateContent", "countTokens", "createCachedContent",
+                            "batchGenerateContent"}},
+          {"temperature", 1},
+          {"topP", 0.95},
+          {"topK", 64},
+          {"maxTemperature", 2},
+          {"thinking", !embedding},
+      });
+    }
+    return json{{"models", std::move(models)}, {"nextPageToken", ""}}.dump();
+  }();
+  return payload;
+}
+
+std::string ChatCompletion() {
+  return json{{"id", "chatcmpl-9f8e7d6c5b4a"},
+              {"object", "chat.completion"},
+              {"created", 1735000000},
+              {"model", "openai/gpt-4.1"},
+              {"choices",
+               {{{"index", 0},
+                 {"message",
+                  {{"role", "assistant"},
+                   {"content",
+                    "{\"first_action\": \"press\", \"target_id\": \"close_popup\"}\n\nThe "
+                    "modal newsletter sheet blocks the checkout form, so it has to be "
+                    "dismissed before Continue can be pressed."}}},
+                 {"finish_reason", "stop"}}}},
+              {"usage", {{"prompt_tokens", 142}, {"completion_tokens", 41}, {"total_tokens", 183}}}}
+      .dump();
+}
+
+llaudit::RequestTrace MakeTrace(std::size_t i) {
+  static const char* const kSteps[] = {"model_check", "prompt_test:reasoning", "prompt_test:coding",
+                                       "suite:basic/3", "list_models"};
+  llaudit::RequestTrace t;
+  t.seq = i;
+  t.step = kSteps[i % std::size(kSteps)];
+  t.method = t.step == "list_models" ? "GET" : "POST";
+  t.url = "https://openrouter.ai/api/v1/chat/completions";
+  t.status = i % 97 == 0 ? 429 : (i % 211 == 0 ? 500 : 200);
+  t.state = t.status == 429 ? "throttled" : "completed";
+  t.latency_ms = 180 + static_cast<long>((i * 7919) % 2400);
+  t.phases = {0, 0, 0, t.latency_ms * 900LL, t.latency_ms * 1000LL};
+  t.connection_reused = i % 10 != 0;
+  t.rate_limit_headers.Add("x-ratelimit-limit-requests", "500");
+  t.rate_limit_headers.Add("x-ratelimit-remaining-requests", std::to_string(500 - i % 500));
+  t.rate_limit_headers.Add("x-ratelimit-remaining-tokens", std::to_string(200000 - i % 9000));
+  t.rate_limit_headers.Add("x-ratelimit-reset-requests", "12ms");
+  t.response_snippet = llaudit::Snippet(ChatCompletion());
+  if (t.status != 200) t.error = "HTTP " + std::to_string(t.status);
+  return t;
+}
+
+// `providers` keys with traces_per_provider requests each, every one of them
+// retained, plus the model checks and prompt tests a real audit keeps.
+AuditReport MakeReport(int providers, int traces_per_provider) {
+  AuditReport report;
+  report.generated_at_utc = "2026-01-01T00:00:00Z";
+  for (int i = 0; i < 2000; ++i)
+    report.run_logs.push_back("[2026-01-01T00:00:00Z] [Provider] line " + std::to_string(i));
+  for (int p = 0; p < providers; ++p) {
+    llaudit::ProviderAudit a;
+    a.traces = llaudit::TraceStore(llaudit::TraceRetention{traces_per_provider, 0, -1});
+    a.provider_id = "provider_" + std::to_string(p);
+    a.provider_name = "Provider " + std::to_string(p);
+    a.api_key = "sk-bench-" + std::to_string(p) + "-0123456789abcdef";
+    a.key_supplied = true;
+    a.auth_status = a.models_status = 200;
+    a.catalog_source = "network";
+    for (int m = 0; m < 40; ++m) {
+      const std::string model = std::string(kVendors[m % std::size(kVendors)]) + "/model-" +
+                                std::to_string(m);
+      a.sample_models.push_back(model);
+      llaudit::ModelCheck mc;
+      mc.model = model;
+      mc.status = m % 4 ? 200 : 404;
+      mc.latency_ms = 300 + m;
+      mc.working = mc.status == 200;
+      (mc.working ? a.working_models : a.failing_models).push_back(model);
+      a.model_checks.push_back(std::move(mc));
+    }
+    a.model_used = a.working_models.front();
+    for (const char* name : {"reasoning", "coding", "axui"}) {
+      llaudit::PromptTest pt;
+      pt.name = name;
+      pt.status = 200;
+      pt.latency_ms = 900;
+      pt.answer = std::string(600, 'a');
+      a.prompt_tests.push_back(std::move(pt));
+    }
+    for (int i = 0; i < traces_per_provider; ++i) {
+      const auto t = MakeTrace(static_cast<std::size_t>(i));
+      a.latency.Record(t.latency_ms * 1000LL);
+      a.traces.Add(t);
+    }
+    a.total_requests = traces_per_provider;
+    report.providers.push_back(std::move(a));
+  }
+  return report;
+}
+
+const AuditReport& Report10k() {
+  static const AuditReport report = MakeReport(10, 1000);
+  return report;
+}
+
+void AnalyzeCatalog(benchmark::State& state, ChatFormat format, const std::string& payload) {
+  std::size_t models = 0;
+  AllocationCounter allocations(state);
+  for (auto _ : state) {
+    auto catalog = llaudit::AnalyzeCatalog(format, payload);
+    models = catalog.model_ids.size();
+    benchmark::DoNotOptimize(catalog);
+  }
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * payload.size()));
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * models));
+}
+
+void BM_AnalyzeCatalogOpenRouter(benchmark::State& state) {
+  AnalyzeCatalog(state, ChatFormat::kOpenAI, OpenRouterCatalog());
+}
+BENCHMARK(BM_AnalyzeCatalogOpenRouter);
+
+void BM_AnalyzeCatalogGoogle(benchmark::State& state) {
+  AnalyzeCatalog(state, ChatFormat::kGoogle, GoogleCatalog());
+}
+BENCHMARK(BM_AnalyzeCatalogGoogle);
+
+// The DOM parse a catalog used to get, and keep_raw_payload still does.
+void BM_ParseCatalogDom(benchmark::State& state) {
+  const std::string& payload = OpenRouterCatalog();
+  AllocationCounter allocations(state);
+  for (auto _ : state) benchmark::DoNotOptimize(json::parse(payload, nullptr, false));
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * payload.size()));
+}
+BENCHMARK(BM_ParseCatalogDom);
+
+// Every chat answer is parsed like this before its text is extracted.
+void BM_ParseChatResponse(benchmark::State& state) {
+  const std::string body = ChatCompletion();
+  AllocationCounter allocations(state);
+  for (auto _ : state) benchmark::DoNotOptimize(json::parse(body, nullptr, false));
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * body.size()));
+}
+BENCHMARK(BM_ParseChatResponse);
+
+// Response heads as OpenAI, Anthropic and Groq send them, each with its own
+// rate-limit header family, reset formats and the usual unrelated headers.
+const std::vector<std::vector<std::string>>& RecordedHeaderSets() {
+  static const std::vector<std::vector<std::string>> sets = {
+      {"HTTP/1.1 200 OK", "Date: Tue, 13 Oct 2026 09:12:44 GMT",
+       "Content-Type: application/json", "Transfer-Encoding: chunked", "Connection: keep-alive",
+       "openai-organization: user-abc123", "openai-processing-ms: 412",
+       "openai-version: 2020-10-01",
+       "x-ratelimit-limit-requests: 10000", "x-ratelimit-limit-tokens: 2000000",
+       "x-ratelimit-remaining-requests: 9999", "x-ratelimit-remaining-tokens: 1999720",
+       "x-ratelimit-reset-requests: 6ms", "x-ratelimit-reset-tokens: 8ms",
+       "x-request-id: req_7f3a9c0d2e1b4a5f", "strict-transport-security: max-age=31536000",
+       "cf-cache-status: DYNAMIC", "Server: cloudflare", "cf-ray: 8d1f2a3b4c5d6e7f-FRA", ""},
+      {"HTTP/1.1 200 OK", "Date: Tue, 13 Oct 2026 09:12:45 GMT",
+       "Content-Type: application/json", "Content-Length: 512",
+       "anthropic-ratelimit-requests-limit: 4000", "anthropic-ratelimit-requests-remaining: 3999",
+       "anthropic-ratelimit-requests-reset: 2026-10-13T09:12:46Z",
+       "anthropic-ratelimit-tokens-limit: 400000", "anthropic-ratelimit-tokens-remaining: 399000",
+       "anthropic-ratelimit-tokens-reset: 2026-10-13T09:12:46Z",
+       "anthropic-ratelimit-input-tokens-limit: 200000",
+       "anthropic-ratelimit-output-tokens-limit: 80000", "request-id: req_011CQ1x2y3z4",
+       "anthropic-organization-id: 0f1e2d3c-4b5a-6978-8877-665544332211", "via: 1.1 google",
+       "Server: cloudflare", ""},
+      {"HTTP/1.1 429 Too Many Requests", "Date: Tue, 13 Oct 2026 09:12:46 GMT",
+       "Content-Type: application/json", "Content-Length: 271", "retry-after: 2",
+       "x-ratelimit-limit-requests: 14400", "x-ratelimit-limit-tokens: 6000",
+       "x-ratelimit-remaining-requests: 14370", "x-ratelimit-remaining-tokens: 0",
+       "x-ratelimit-reset-requests: 2m59.56s", "x-ratelimit-reset-tokens: 7.66s",
+       "x-groq-region: us-west-1", "vary: Origin", "Server: cloudflare", ""},
+  };
+  return sets;
+}
+
+// What every response costs on arrival: its head lines go into a
+// HeaderTable, and the rate limiter reads the state back out.
+void BM_ParseRateLimitState(benchmark::State& state) {
+  const auto& sets = RecordedHeaderSets();
+  std::size_t lines = 0;
+  for (const auto& set : sets) lines += set.size();
+  AllocationCounter allocations(state);
+  for (auto _ : state) {
+    for (const auto& set : sets) {
+      llaudit::HeaderTable headers;
+      for (const auto& line : set) headers.AddLine(line);
+      benchmark::DoNotOptimize(llaudit::ParseRateLimitState(headers));
+    }
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * lines));
+}
+BENCHMARK(BM_ParseRateLimitState);
+
+// The cut every trace and error field takes: a chat answer under the limit
+// and an HTML error page over it.
+void BM_Snippet(benchmark::State& state) {
+  const std::string answer = ChatCompletion().substr(0, llaudit::kSnippetLen / 2);
+  std::string page = "<!DOCTYPE html><html><head><title>502 Bad Gateway</title></head><body>";
+  while (page.size() < 16 * 1024) {
+    page += "<p>The upstream server returned an invalid response.</p>";
+  }
+  AllocationCounter allocations(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(llaudit::Snippet(answer));
+    benchmark::DoNotOptimize(llaudit::Snippet(page));
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * 2));
+}
+BENCHMARK(BM_Snippet);
+
+// Indexing an aggregator-sized model list, then the lookups a provider audit
+// makes against it: exclusions and preferred candidates.
+void BM_ModelIndex(benchmark::State& state) {
+  std::vector<std::string> ids;
+  for (int i = 0; i < state.range(0); ++i) {
+    ids.push_back(std::string(kVendors[i % std::size(kVendors)]) + "/" +
+                  kFamilies[i % std::size(kFamilies)] + "-" + std::to_string(i));
+  }
+  const std::vector<std::string> lookups = {"embed", "rerank", "GPT-4o", "claude-3-5-sonnet",
+                                            "gemini-1.5", "llama-3.1-70b", "qwen/coder-41"};
+  AllocationCounter allocations(state);
+  for (auto _ : state) {
+    const llaudit::ModelIndex index(ids);
+    std::size_t hits = 0;
+    for (const auto& needle : lookups) hits += index.Containing(needle).size();
+    benchmark::DoNotOptimize(hits);
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * state.range(0)));
+}
+BENCHMARK(BM_ModelIndex)->Arg(400)->Arg(5000);
+
+// One provider's worth of traces through the default retention policy.
+void BM_TraceStoreAdd(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  std::vector<llaudit::RequestTrace> traces;
+  for (std::size_t i = 0; i < count; ++i) traces.push_back(MakeTrace(i));
+  AllocationCounter allocations(state);
+  for (auto _ : state) {
+    llaudit::TraceStore store;
+    for (const auto& t : traces) store.Add(t);
+    benchmark::DoNotOptimize(store.retained());
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * count));
+}
+BENCHMARK(BM_TraceStoreAdd)->Arg(1000)->Arg(10000);
+
+void BM_ReportJson(benchmark::State& state) {
+  const AuditReport& report = Report10k();
+  std::size_t bytes = 0;
+  AllocationCounter allocations(state);
+  for (auto _ : state) {
+    NullBuffer sink;
+    std::ostream out(&sink);
+    llaudit::JsonWriter writer(out);
+    llaudit::WriteReportJson(writer, report);
+    bytes = sink.size();
+  }
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * bytes));
+}
+BENCHMARK(BM_ReportJson)->Unit(benchmark::kMillisecond);
+
+void BM_SummaryText(benchmark::State& state) {
+  const AuditReport& report = Report10k();
+  AllocationCounter allocations(state);
+  for (auto _ : state) benchmark::DoNotOptimize(llaudit::BuildSummaryText(report));
+}
+BENCHMARK(BM_SummaryText)->Unit(benchmark::kMillisecond);
+
+// The JSON report, TXT report and run log together, as an audit ends.
+void BM_WriteReports(benchmark::State& state) {
+  const AuditReport& report = Report10k();
+  const auto dir = std::filesystem::temp_directory_path() / "llaudit_bench_reports";
+  std::filesystem::create_directories(dir);
+  {
+    AllocationCounter allocations(state);
+    for (auto _ : state) benchmark::DoNotOptimize(llaudit::WriteReports(report, dir, dir));
+  }
+  std::error_code ec;
+  std::filesystem::remove_all(dir, ec);
+}
+BENCHMARK(BM_WriteReports)->Unit(benchmark::kMillisecond);
+
+// A whole audit served from a recording at memory speed: what is left is
+// the engine's own work per run.
+void BM_ReplayAudit(benchmark::State& state, const std::string& workspace) {
+  const auto paths = llaudit::BuildPaths(workspace);
+  llaudit::AuditOptions options;
+  std::string error;
+  if (!llaudit::LoadWorkspaceProviders(paths, options.providers, error) ||
+      !llaudit::LoadPromptSuites(paths.suites_dir, options.prompt_suites, error)) {
+    state.SkipWithError(error.c_str());
+    return;
+  }
+  auto fields = llaudit::KeyFieldsFor(options.providers);
+  if (!llaudit::LoadConfig(fields, paths.config_file, error)) {
+    state.SkipWithError(error.c_str());
+    return;
+  }
+  const auto keys = llaudit::KeysToPools(fields);
+  options.catalog_cache_dir = (paths.cache_dir / "catalogs").string();
+  options.record_mode = llaudit::RecordMode::kReplay;
+  options.record_dir = (paths.cache_dir / "responses").string();
+  llaudit::AuditEngine engine(options);
+  const std::atomic<bool> cancel{false};
+
+  std::size_t traces = 0;
+  AllocationCounter allocations(state);
+  for (auto _ : state) {
+    auto report = engine.Run(keys, {}, cancel);
+    traces = 0;
+    for (const auto& p : report.providers) traces += p.traces.size();
+    benchmark::DoNotOptimize(report);
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * traces));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (const char* workspace = std::getenv("LLAUDIT_BENCH_WORKSPACE")) {
+    benchmark::RegisterBenchmark("BM_ReplayAudit", BM_ReplayAudit, std::string(workspace))
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+  }
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
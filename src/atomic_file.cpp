@@ -0,0 +1,27 @@
+#include "atomic_file.h"
+
+#include <fstream>
+#include <system_error>
+
+namespace llaudit {
+
+bool WriteFileAtomically(const std::filesystem::path &path,
+                         const std::string &content, std::string &error) {
+  const auto tmp = path.string() + ".tmp";
+  {
+    std::ofstream ofs(tmp, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!ofs || !(ofs << content) || !ofs.flush()) {
+      error = "Cannot write " + tmp;
+      return false;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, path, ec);
+  if (ec) {
+    error = "Cannot replace " + path.string() + ": " + ec.message();
+    return false;
+  }
+  return true;
+}
+
+} // namespace llaudit
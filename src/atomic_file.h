@@ -0,0 +1,13 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+namespace llaudit {
+
+// Writes content to path + ".tmp" and renames it over path, so a reader (or
+// a run that crashed halfway) sees either the old file or the new one whole.
+bool WriteFileAtomically(const std::filesystem::path& path, const std::string& content,
+                         std::string& error);
+
+}  // namespace llaudit
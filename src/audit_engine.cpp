@@ -1,40 +1,43 @@
 #include "audit_engine.h"
-
-#if defined(_WIN32)
-#ifndef WIN32_LEAN_AND_MEAN
-#define WIN32_LEAN_AND_MEAN
-#endif
-#include <windows.h>
-#include <winhttp.h>
-#else
-#include <curl/curl.h>
-#endif
+#include "audit_metrics.h"
+#include "bounded_log.h"
+#include "catalog_store.h"
+#include "checkpoint_store.h"
+#include "json_stream.h"
+#include "keyword_matcher.h"
+#include "live_stats.h"
+#include "model_index.h"
+#include "sse_parser.h"
 
 #include <algorithm>
 #include <array>
 #include <cctype>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
 #include <ctime>
+#include <deque>
+#include <exception>
 #include <functional>
+#include <future>
+#include <initializer_list>
 #include <iomanip>
-#include <numeric>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <set>
 #include <sstream>
 #include <string_view>
+#include <thread>
+#include <tuple>
 
 namespace llaudit {
 namespace {
 
-struct HttpResponse {
-  long status = -1;
-  long latency_ms = -1;
-  std::string body;
-  std::map<std::string, std::string> headers;
-  std::string error;
-};
-
-constexpr int kSnippetLen = 500;
+constexpr const char *kProbePrompt = "Reply with exactly: OK";
 
 const std::array<std::pair<std::string, std::string>, 3> kPromptSuite = {
     std::pair{"reasoning",
@@ -53,10 +56,7 @@ const std::array<std::pair<std::string, std::string>, 3> kPromptSuite = {
               "target_id that actually completes checkout flow."},
 };
 
-std::string NowUtc() {
-  using namespace std::chrono;
-  const auto now = system_clock::now();
-  const auto t = system_clock::to_time_t(now);
+std::string FormatUtc(std::time_t t) {
   std::tm tm{};
 #if defined(_WIN32)
   gmtime_s(&tm, &t);
@@ -68,6 +68,11 @@ std::string NowUtc() {
   return oss.str();
 }
 
+std::string NowUtc() {
+  return FormatUtc(std::chrono::system_clock::to_time_t(
+      std::chrono::system_clock::now()));
+}
+
 std::string ToLower(std::string s) {
   std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) {
     return static_cast<char>(std::tolower(c));
@@ -75,480 +80,246 @@ std::string ToLower(std::string s) {
   return s;
 }
 
-std::string Trim(std::string s) {
-  auto not_space = [](unsigned char c) { return !std::isspace(c); };
-  s.erase(s.begin(), std::find_if(s.begin(), s.end(), not_space));
-  s.erase(std::find_if(s.rbegin(), s.rend(), not_space).base(), s.end());
-  return s;
+void SortUnique(std::vector<std::string> &v) {
+  std::sort(v.begin(), v.end());
+  v.erase(std::unique(v.begin(), v.end()), v.end());
 }
 
-std::string Snippet(const std::string &s, std::size_t limit = kSnippetLen) {
-  if (s.size() <= limit)
-    return s;
-  return s.substr(0, limit);
+nlohmann::json ParseJson(const std::string &s) {
+  const auto j = nlohmann::json::parse(s, nullptr, false);
+  if (j.is_discarded())
+    return nlohmann::json::object();
+  return j;
 }
 
-#if !defined(_WIN32)
-size_t WriteBodyCallback(void *contents, size_t size, size_t nmemb,
-                         void *userp) {
-  const size_t total_size = size * nmemb;
-  auto *body = static_cast<std::string *>(userp);
-  body->append(static_cast<char *>(contents), total_size);
-  return total_size;
+nlohmann::json HeadersJson(const HeaderTable &headers) {
+  nlohmann::json out = nlohmann::json::object();
+  for (const auto &h : headers)
+    out[std::string(h.name)] = h.value;
+  return out;
 }
 
-size_t HeaderCallback(char *buffer, size_t size, size_t nitems,
-                      void *userdata) {
-  const size_t total = size * nitems;
-  std::string line(buffer, total);
-  auto *out = static_cast<std::map<std::string, std::string> *>(userdata);
-  const auto pos = line.find(':');
-  if (pos != std::string::npos) {
-    const std::string key = ToLower(Trim(line.substr(0, pos)));
-    const std::string value = Trim(line.substr(pos + 1));
-    if (!key.empty()) {
-      (*out)[key] = value;
+// Substrings the catalog analyzer looks for in keys, string values and model
+// ids; bit i of a match mask is kCatalogKeywords[i].
+constexpr std::array<std::string_view, 19> kCatalogKeywords = {
+    "vision", "vl",    "image",  "reason", "thinking", "coder",
+    "code",   "embed", "audio",  "speech", "rerank",   "tool",
+    "function", "context", "inputtokenlimit", "contextwindow", "token",
+    "output", "completion",
+};
+static_assert(KeywordMatcher<kCatalogKeywords.size(),
+                             KeywordStates(kCatalogKeywords)>::
+                  Valid(kCatalogKeywords));
+constexpr KeywordMatcher<kCatalogKeywords.size(),
+                         KeywordStates(kCatalogKeywords)>
+    kCatalogMatcher(kCatalogKeywords);
+
+constexpr std::uint32_t
+KeywordBits(std::initializer_list<std::string_view> words) {
+  std::uint32_t bits = 0;
+  for (const auto word : words) {
+    for (std::size_t i = 0; i < kCatalogKeywords.size(); ++i) {
+      if (kCatalogKeywords[i] == word)
+        bits |= std::uint32_t{1} << i;
     }
   }
-  return total;
-}
-
-HttpResponse Request(const std::string &method, const std::string &url,
-                     const std::vector<std::string> &headers,
-                     const std::optional<std::string> &body,
-                     long timeout_seconds = 60) {
-  HttpResponse result;
-  CURL *curl = curl_easy_init();
-  if (!curl) {
-    result.error = "curl_easy_init failed";
-    return result;
-  }
-
-  struct curl_slist *header_list = nullptr;
-  header_list = curl_slist_append(header_list, "User-Agent: llm-audit-gui/1.0");
-  for (const auto &h : headers) {
-    header_list = curl_slist_append(header_list, h.c_str());
-  }
-
-  std::string response_body;
-  std::map<std::string, std::string> response_headers;
-
-  curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-  curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header_list);
-  curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-  curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeout_seconds);
-  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteBodyCallback);
-  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_body);
-  curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
-  curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response_headers);
-
-  if (method == "POST") {
-    curl_easy_setopt(curl, CURLOPT_POST, 1L);
-  } else if (method != "GET") {
-    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method.c_str());
-  }
-
-  if (body.has_value()) {
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body->c_str());
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE,
-                     static_cast<long>(body->size()));
-  }
-
-  const auto start = std::chrono::steady_clock::now();
-  const CURLcode code = curl_easy_perform(curl);
-  const auto end = std::chrono::steady_clock::now();
-  result.latency_ms =
-      std::chrono::duration_cast<std::chrono::milliseconds>(end - start)
-          .count();
-
-  if (code != CURLE_OK) {
-    result.error = curl_easy_strerror(code);
-  }
-
-  long http_status = -1;
-  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_status);
-  result.status = http_status;
-  result.body = std::move(response_body);
-  result.headers = std::move(response_headers);
-
-  curl_slist_free_all(header_list);
-  curl_easy_cleanup(curl);
-  return result;
-}
-#else
-std::wstring Utf8ToWide(const std::string &s) {
-  if (s.empty())
-    return L"";
-  const int len = MultiByteToWideChar(CP_UTF8, 0, s.data(),
-                                      static_cast<int>(s.size()), nullptr, 0);
-  if (len <= 0)
-    return L"";
-  std::wstring out(static_cast<std::size_t>(len), L'\0');
-  MultiByteToWideChar(CP_UTF8, 0, s.data(), static_cast<int>(s.size()),
-                      out.data(), len);
-  return out;
-}
-
-std::string WideToUtf8(const std::wstring &s) {
-  if (s.empty())
-    return {};
-  const int len =
-      WideCharToMultiByte(CP_UTF8, 0, s.data(), static_cast<int>(s.size()),
-                          nullptr, 0, nullptr, nullptr);
-  if (len <= 0)
-    return {};
-  std::string out(static_cast<std::size_t>(len), '\0');
-  WideCharToMultiByte(CP_UTF8, 0, s.data(), static_cast<int>(s.size()),
-                      out.data(), len, nullptr, nullptr);
-  return out;
+  return bits;
 }
 
-std::string WinErrText(DWORD code) {
-  LPWSTR wbuf = nullptr;
-  const DWORD flags = FORMAT_MESSAGE_ALLOCATE_BUFFER |
-                      FORMAT_MESSAGE_FROM_SYSTEM |
-                      FORMAT_MESSAGE_IGNORE_INSERTS;
-  const DWORD got = FormatMessageW(flags, nullptr, code, 0,
-                                   reinterpret_cast<LPWSTR>(&wbuf), 0, nullptr);
-  std::string out = "winhttp error " + std::to_string(code);
-  if (got > 0 && wbuf) {
-    out += ": " + Trim(WideToUtf8(std::wstring(wbuf, got)));
-  }
-  if (wbuf) {
-    LocalFree(wbuf);
-  }
-  return out;
-}
+struct CapabilityRule {
+  std::uint32_t keywords;
+  const char *tag;
+};
 
-std::map<std::string, std::string> ParseRawHeaders(const std::wstring &raw) {
-  std::map<std::string, std::string> out;
-  std::wistringstream iss(raw);
-  std::wstring line;
-  while (std::getline(iss, line)) {
-    if (!line.empty() && line.back() == L'\r')
-      line.pop_back();
-    const auto pos = line.find(L':');
-    if (pos == std::wstring::npos)
-      continue;
-    const std::string key = ToLower(Trim(WideToUtf8(line.substr(0, pos))));
-    const std::string value = Trim(WideToUtf8(line.substr(pos + 1)));
-    if (!key.empty())
-      out[key] = value;
-  }
-  return out;
+// Sorted by tag, the order reports list them in.
+constexpr std::array<CapabilityRule, 7> kCapabilityRules = {{
+    {KeywordBits({"audio", "speech"}), "audio"},
+    {KeywordBits({"coder", "code"}), "coding"},
+    {KeywordBits({"embed"}), "embeddings"},
+    {KeywordBits({"reason", "thinking"}), "reasoning"},
+    {KeywordBits({"rerank"}), "reranking"},
+    {KeywordBits({"tool", "function"}), "tool_use"},
+    {KeywordBits({"vision", "vl", "image"}), "vision/image"},
+}};
+
+// An integer under a key naming a context window or an input token limit.
+bool IsContextKey(std::uint32_t key) {
+  constexpr auto kContext =
+      KeywordBits({"context", "inputtokenlimit", "contextwindow"});
+  constexpr auto kToken = KeywordBits({"token"});
+  constexpr auto kNotInput = KeywordBits({"output", "completion"});
+  return (key & kContext) != 0 ||
+         ((key & kToken) != 0 && (key & kNotInput) == 0);
 }
 
-HttpResponse Request(const std::string &method, const std::string &url,
-                     const std::vector<std::string> &headers,
-                     const std::optional<std::string> &body,
-                     long timeout_seconds = 60) {
-  HttpResponse result;
-  const auto start = std::chrono::steady_clock::now();
-
-  HINTERNET h_session = nullptr;
-  HINTERNET h_connect = nullptr;
-  HINTERNET h_request = nullptr;
-
-  auto finish = [&]() -> HttpResponse {
-    if (h_request)
-      WinHttpCloseHandle(h_request);
-    if (h_connect)
-      WinHttpCloseHandle(h_connect);
-    if (h_session)
-      WinHttpCloseHandle(h_session);
-    const auto end = std::chrono::steady_clock::now();
-    result.latency_ms =
-        std::chrono::duration_cast<std::chrono::milliseconds>(end - start)
-            .count();
-    return result;
-  };
+enum class CatalogShape {
+  kGeneric,  // ids or names in top-level "data" / "models" arrays
+  kGoogle,   // "models" entries that support generateContent
+  kCohere,   // "models" entries by name
+};
 
-  const std::wstring wurl = Utf8ToWide(url);
-  URL_COMPONENTS comps{};
-  comps.dwStructSize = sizeof(comps);
-  comps.dwSchemeLength = static_cast<DWORD>(-1);
-  comps.dwHostNameLength = static_cast<DWORD>(-1);
-  comps.dwUrlPathLength = static_cast<DWORD>(-1);
-  comps.dwExtraInfoLength = static_cast<DWORD>(-1);
-  if (!WinHttpCrackUrl(wurl.c_str(), 0, 0, &comps)) {
-    result.error = WinErrText(GetLastError());
-    return finish();
-  }
-
-  const std::wstring host(comps.lpszHostName, comps.dwHostNameLength);
-  std::wstring path =
-      comps.dwUrlPathLength > 0
-          ? std::wstring(comps.lpszUrlPath, comps.dwUrlPathLength)
-          : L"/";
-  if (comps.dwExtraInfoLength > 0) {
-    path += std::wstring(comps.lpszExtraInfo, comps.dwExtraInfoLength);
-  }
-  const bool secure = comps.nScheme == INTERNET_SCHEME_HTTPS;
-
-  h_session =
-      WinHttpOpen(L"llm-audit-gui/1.0", WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
-                  WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, 0);
-  if (!h_session) {
-    result.error = WinErrText(GetLastError());
-    return finish();
-  }
-  WinHttpSetTimeouts(h_session, timeout_seconds * 1000, timeout_seconds * 1000,
-                     timeout_seconds * 1000, timeout_seconds * 1000);
-
-  h_connect = WinHttpConnect(h_session, host.c_str(), comps.nPort, 0);
-  if (!h_connect) {
-    result.error = WinErrText(GetLastError());
-    return finish();
-  }
-
-  const std::wstring wmethod = Utf8ToWide(method);
-  h_request = WinHttpOpenRequest(
-      h_connect, wmethod.c_str(), path.c_str(), nullptr, WINHTTP_NO_REFERER,
-      WINHTTP_DEFAULT_ACCEPT_TYPES, secure ? WINHTTP_FLAG_SECURE : 0);
-  if (!h_request) {
-    result.error = WinErrText(GetLastError());
-    return finish();
-  }
-
-  for (const auto &h : headers) {
-    const std::wstring wh = Utf8ToWide(h);
-    if (!WinHttpAddRequestHeaders(h_request, wh.c_str(),
-                                  static_cast<DWORD>(wh.size()),
-                                  WINHTTP_ADDREQ_FLAG_ADD)) {
-      result.error = WinErrText(GetLastError());
-      return finish();
-    }
-  }
-  const std::wstring user_agent = L"User-Agent: llm-audit-gui/1.0";
-  WinHttpAddRequestHeaders(h_request, user_agent.c_str(),
-                           static_cast<DWORD>(user_agent.size()),
-                           WINHTTP_ADDREQ_FLAG_ADD);
-
-  LPVOID body_ptr = WINHTTP_NO_REQUEST_DATA;
-  DWORD body_len = 0;
-  if (body.has_value()) {
-    body_ptr = const_cast<char *>(body->data());
-    body_len = static_cast<DWORD>(body->size());
-  }
-
-  if (!WinHttpSendRequest(h_request, WINHTTP_NO_ADDITIONAL_HEADERS, 0, body_ptr,
-                          body_len, body_len, 0)) {
-    result.error = WinErrText(GetLastError());
-    return finish();
-  }
-  if (!WinHttpReceiveResponse(h_request, nullptr)) {
-    result.error = WinErrText(GetLastError());
-    return finish();
-  }
-
-  DWORD status = 0;
-  DWORD status_size = sizeof(status);
-  if (!WinHttpQueryHeaders(
-          h_request, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
-          WINHTTP_HEADER_NAME_BY_INDEX, &status, &status_size,
-          WINHTTP_NO_HEADER_INDEX)) {
-    result.error = WinErrText(GetLastError());
-    return finish();
-  }
-  result.status = static_cast<long>(status);
-
-  DWORD raw_size = 0;
-  WinHttpQueryHeaders(h_request, WINHTTP_QUERY_RAW_HEADERS_CRLF,
-                      WINHTTP_HEADER_NAME_BY_INDEX, nullptr, &raw_size,
-                      WINHTTP_NO_HEADER_INDEX);
-  if (GetLastError() == ERROR_INSUFFICIENT_BUFFER &&
-      raw_size > sizeof(wchar_t)) {
-    std::wstring raw(raw_size / sizeof(wchar_t), L'\0');
-    if (WinHttpQueryHeaders(h_request, WINHTTP_QUERY_RAW_HEADERS_CRLF,
-                            WINHTTP_HEADER_NAME_BY_INDEX, raw.data(), &raw_size,
-                            WINHTTP_NO_HEADER_INDEX)) {
-      result.headers = ParseRawHeaders(raw);
+// Builds a ModelCatalog from JSON events in one pass: every key and string
+// member value is matched for capability hints, integers under context-like
+// keys raise the context limit, and the entries of the top-level model
+// arrays give the ids. Nothing but the ids is kept.
+class CatalogCollector : public JsonHandler {
+public:
+  explicit CatalogCollector(CatalogShape shape) : shape_(shape) {}
+
+  void StartObject() override {
+    if (Top() == Frame::kModelList) {
+      item_ = {};
+      frames_.push_back(Frame::kModelItem);
+    } else {
+      frames_.push_back(Frame::kObject);
     }
   }
 
-  std::string body_out;
-  for (;;) {
-    DWORD available = 0;
-    if (!WinHttpQueryDataAvailable(h_request, &available)) {
-      result.error = WinErrText(GetLastError());
-      return finish();
-    }
-    if (available == 0)
+  void EndObject() override {
+    if (Top() == Frame::kModelItem)
+      EndItem();
+    frames_.pop_back();
+  }
+
+  void StartArray() override {
+    const bool root_list =
+        (frames_.empty() && shape_ == CatalogShape::kGeneric) ||
+        (frames_.size() == 1 && Top() == Frame::kObject &&
+         (field_ == Field::kModels ||
+          (field_ == Field::kData && shape_ == CatalogShape::kGeneric)));
+    if (root_list)
+      frames_.push_back(Frame::kModelList);
+    else if (Top() == Frame::kModelItem && field_ == Field::kMethods)
+      frames_.push_back(Frame::kMethods);
+    else
+      frames_.push_back(Frame::kArray);
+  }
+
+  void EndArray() override { frames_.pop_back(); }
+
+  void Key(std::string_view k) override {
+    key_bits_ = kCatalogMatcher.Scan(k);
+    keywords_ |= key_bits_;
+    field_ = k == "data"                         ? Field::kData
+             : k == "models"                     ? Field::kModels
+             : k == "id"                         ? Field::kId
+             : k == "name"                       ? Field::kName
+             : k == "supportedGenerationMethods" ? Field::kMethods
+                                                 : Field::kOther;
+  }
+
+  void String(std::string_view v) override {
+    switch (Top()) {
+    case Frame::kModelItem:
+      if (field_ == Field::kId)
+        item_.id.emplace(v);
+      else if (field_ == Field::kName)
+        item_.name.emplace(v);
+      [[fallthrough]];
+    case Frame::kObject:
+      keywords_ |= kCatalogMatcher.Scan(v);
+      break;
+    case Frame::kModelList:
+      if (shape_ != CatalogShape::kGoogle)
+        ids_.emplace_back(v);
+      break;
+    case Frame::kMethods:
+      if (v == "generateContent")
+        item_.generates = true;
+      break;
+    default:
       break;
-
-    std::string chunk(available, '\0');
-    DWORD read = 0;
-    if (!WinHttpReadData(h_request, chunk.data(), available, &read)) {
-      result.error = WinErrText(GetLastError());
-      return finish();
-    }
-    chunk.resize(read);
-    body_out += chunk;
-  }
-  result.body = std::move(body_out);
-  return finish();
-}
-#endif
-
-nlohmann::json ParseJson(const std::string &s) {
-  const auto j = nlohmann::json::parse(s, nullptr, false);
-  if (j.is_discarded())
-    return nlohmann::json::object();
-  return j;
-}
-
-std::map<std::string, std::string>
-RateLimitHeaders(const std::map<std::string, std::string> &headers) {
-  std::map<std::string, std::string> out;
-  for (const auto &[k, v] : headers) {
-    if (k.find("rate") != std::string::npos ||
-        k.find("limit") != std::string::npos ||
-        k.find("quota") != std::string::npos ||
-        k.find("retry") != std::string::npos) {
-      out[k] = v;
     }
   }
-  return out;
-}
 
-std::vector<std::string> ExtractModelIds(const nlohmann::json &j) {
-  std::vector<std::string> out;
-  auto add = [&out](const nlohmann::json &arr) {
-    if (!arr.is_array())
-      return;
-    for (const auto &item : arr) {
-      if (item.is_string()) {
-        out.push_back(item.get<std::string>());
-      } else if (item.is_object()) {
-        if (item.contains("id") && item["id"].is_string()) {
-          out.push_back(item["id"].get<std::string>());
-        } else if (item.contains("name") && item["name"].is_string()) {
-          out.push_back(item["name"].get<std::string>());
-        }
-      }
+  void Integer(long long n) override {
+    const Frame top = Top();
+    if ((top == Frame::kObject || top == Frame::kModelItem) &&
+        IsContextKey(key_bits_))
+      max_context_ = std::max(max_context_, n);
+  }
+
+  // An unparseable document yields an empty catalog, as an error body did
+  // when it was parsed into a DOM.
+  ModelCatalog Take(bool parsed) {
+    ModelCatalog c;
+    if (!parsed)
+      return c;
+    SortUnique(ids_);
+    for (const auto &id : ids_)
+      keywords_ |= kCatalogMatcher.Scan(id);
+    c.model_ids = std::move(ids_);
+    c.max_context = max_context_;
+    for (const auto &rule : kCapabilityRules) {
+      if ((keywords_ & rule.keywords) != 0)
+        c.capability_tags.emplace_back(rule.tag);
     }
-  };
-
-  if (j.is_array()) {
-    add(j);
-  } else if (j.is_object()) {
-    if (j.contains("data"))
-      add(j["data"]);
-    if (j.contains("models"))
-      add(j["models"]);
+    return c;
   }
 
-  std::set<std::string> dedup(out.begin(), out.end());
-  return {dedup.begin(), dedup.end()};
-}
+private:
+  enum class Frame { kNone, kObject, kArray, kModelList, kModelItem, kMethods };
+  enum class Field { kOther, kData, kModels, kId, kName, kMethods };
 
-long long ExtractMaxContext(const nlohmann::json &j) {
-  long long best = -1;
-  std::function<void(const nlohmann::json &, std::string_view)> scan =
-      [&](const nlohmann::json &node, std::string_view key_name) {
-        if (node.is_object()) {
-          for (const auto &[k, v] : node.items()) {
-            const std::string k_low = ToLower(k);
-            if (v.is_number_integer()) {
-              const auto n = v.get<long long>();
-              const bool candidate =
-                  k_low.find("context") != std::string::npos ||
-                  k_low.find("inputtokenlimit") != std::string::npos ||
-                  k_low.find("contextwindow") != std::string::npos ||
-                  (k_low.find("token") != std::string::npos &&
-                   k_low.find("output") == std::string::npos &&
-                   k_low.find("completion") == std::string::npos);
-              if (candidate) {
-                best = std::max(best, n);
-              }
-            }
-            scan(v, k_low);
-          }
-        } else if (node.is_array()) {
-          for (const auto &item : node)
-            scan(item, key_name);
-        }
-      };
+  struct Item {
+    std::optional<std::string> id;
+    std::optional<std::string> name;
+    bool generates = false;
+  };
 
-  scan(j, "");
-  return best;
-}
+  Frame Top() const { return frames_.empty() ? Frame::kNone : frames_.back(); }
 
-std::vector<std::string>
-ExtractCapabilities(const std::vector<std::string> &model_ids,
-                    const nlohmann::json &raw) {
-  std::set<std::string> caps;
-  auto consider = [&caps](const std::string &text) {
-    const auto t = ToLower(text);
-    if (t.find("vision") != std::string::npos ||
-        t.find("vl") != std::string::npos ||
-        t.find("image") != std::string::npos) {
-      caps.insert("vision/image");
-    }
-    if (t.find("reason") != std::string::npos ||
-        t.find("thinking") != std::string::npos) {
-      caps.insert("reasoning");
-    }
-    if (t.find("coder") != std::string::npos ||
-        t.find("code") != std::string::npos) {
-      caps.insert("coding");
-    }
-    if (t.find("embed") != std::string::npos) {
-      caps.insert("embeddings");
-    }
-    if (t.find("audio") != std::string::npos ||
-        t.find("speech") != std::string::npos) {
-      caps.insert("audio");
-    }
-    if (t.find("rerank") != std::string::npos) {
-      caps.insert("reranking");
-    }
-    if (t.find("tool") != std::string::npos ||
-        t.find("function") != std::string::npos) {
-      caps.insert("tool_use");
+  void EndItem() {
+    switch (shape_) {
+    case CatalogShape::kGeneric:
+      if (item_.id)
+        ids_.push_back(std::move(*item_.id));
+      else if (item_.name)
+        ids_.push_back(std::move(*item_.name));
+      break;
+    case CatalogShape::kGoogle:
+      if (item_.name && item_.generates)
+        ids_.push_back(std::move(*item_.name));
+      break;
+    case CatalogShape::kCohere:
+      if (item_.name)
+        ids_.push_back(std::move(*item_.name));
+      break;
     }
-  };
+  }
 
-  for (const auto &id : model_ids)
-    consider(id);
-
-  std::function<void(const nlohmann::json &)> walk =
-      [&](const nlohmann::json &node) {
-        if (node.is_object()) {
-          for (const auto &[k, v] : node.items()) {
-            consider(k);
-            if (v.is_string())
-              consider(v.get<std::string>());
-            walk(v);
-          }
-        } else if (node.is_array()) {
-          for (const auto &it : node)
-            walk(it);
-        }
-      };
-  walk(raw);
+  CatalogShape shape_;
+  std::vector<Frame> frames_;
+  Field field_ = Field::kOther;
+  std::uint32_t key_bits_ = 0;
+  std::uint32_t keywords_ = 0;
+  long long max_context_ = -1;
+  Item item_;
+  std::vector<std::string> ids_;
+};
 
-  return {caps.begin(), caps.end()};
-}
+// The models of a catalog that a provider can chat with: ids into the
+// catalog, ascending, so in catalog order.
+struct ChatModels {
+  std::shared_ptr<const ModelIndex> catalog;
+  std::vector<ModelIndex::Id> ids;
 
-std::string ChooseModel(const std::vector<std::string> &discovered,
+  bool Contains(ModelIndex::Id id) const {
+    return std::binary_search(ids.begin(), ids.end(), id);
+  }
+};
+
+std::string ChooseModel(const ChatModels &models,
                         const std::vector<std::string> &preferred) {
-  if (discovered.empty())
+  if (models.ids.empty())
     return {};
-  std::vector<std::string> lower;
-  lower.reserve(discovered.size());
-  for (const auto &d : discovered)
-    lower.push_back(ToLower(d));
-
   for (const auto &pref : preferred) {
-    const auto p = ToLower(pref);
-    for (std::size_t i = 0; i < discovered.size(); ++i) {
-      if (lower[i] == p || lower[i].find(p) != std::string::npos) {
-        return discovered[i];
-      }
+    for (const auto id : models.catalog->Containing(pref)) {
+      if (models.Contains(id))
+        return models.catalog->Get(id);
     }
   }
-  return discovered.front();
+  return models.catalog->Get(models.ids.front());
 }
 
 std::string ExtractOpenAIText(const nlohmann::json &j) {
@@ -656,442 +427,902 @@ void ScoreProvider(ProviderAudit &p) {
   p.score_total = p.score_reasoning + p.score_coding + p.score_axui;
 }
 
-void AddTrace(ProviderAudit &p, const std::string &step,
-              const std::string &method, const std::string &url,
-              const HttpResponse &r) {
-  RequestTrace t;
-  t.step = step;
-  t.method = method;
-  t.url = url;
-  t.status = r.status;
-  t.latency_ms = r.latency_ms;
-  t.rate_limit_headers = RateLimitHeaders(r.headers);
-  t.response_snippet = Snippet(r.body);
-  t.error = r.error;
-  p.request_traces.push_back(std::move(t));
-
-  p.total_requests += 1;
-  if (r.status >= 200 && r.status < 300 && r.error.empty()) {
-    p.successful_requests += 1;
-  } else {
-    p.failed_requests += 1;
-  }
-}
-
 void FinalizeMetrics(ProviderAudit &p) {
-  std::vector<long> lats;
-  for (const auto &t : p.request_traces) {
-    if (t.latency_ms >= 0)
-      lats.push_back(t.latency_ms);
-  }
-  if (!lats.empty()) {
-    const auto sum = std::accumulate(lats.begin(), lats.end(), 0LL);
-    p.avg_latency_ms =
-        static_cast<long>(sum / static_cast<long long>(lats.size()));
-  }
+  if (p.latency.count() > 0)
+    p.avg_latency_ms = static_cast<long>(p.latency.mean() / 1000);
 }
 
 std::vector<std::string>
-TopCandidates(const std::vector<std::string> &discovered,
-              const std::vector<std::string> &preferred,
-              std::size_t max_count) {
+TopCandidates(const ChatModels &models,
+              const std::vector<std::string> &preferred, std::size_t max_count) {
   std::vector<std::string> out;
-  std::set<std::string> used;
+  std::vector<bool> used(models.catalog->size());
+  auto take = [&](ModelIndex::Id id) {
+    if (used[id])
+      return;
+    used[id] = true;
+    out.push_back(models.catalog->Get(id));
+  };
 
   for (const auto &pref : preferred) {
-    const auto p = ToLower(pref);
-    for (const auto &d : discovered) {
-      const auto dl = ToLower(d);
-      if ((dl == p || dl.find(p) != std::string::npos) && !used.count(d)) {
-        out.push_back(d);
-        used.insert(d);
-      }
+    for (const auto id : models.catalog->Containing(pref)) {
+      if (models.Contains(id))
+        take(id);
       if (out.size() >= max_count)
         return out;
     }
   }
-
-  for (const auto &d : discovered) {
-    if (!used.count(d)) {
-      out.push_back(d);
-      used.insert(d);
-      if (out.size() >= max_count)
-        return out;
-    }
+  for (const auto id : models.ids) {
+    take(id);
+    if (out.size() >= max_count)
+      return out;
   }
   return out;
 }
 
-ProviderAudit
-AuditOpenAICompatible(const std::string &provider_id,
-                      const std::string &provider_name, const std::string &key,
-                      const std::string &list_url, const std::string &chat_url,
-                      const std::vector<std::string> &preferred_models,
-                      const std::vector<std::string> &extra_headers,
-                      const LogFn &log,
-                      const std::atomic<bool> &cancel_requested) {
-  ProviderAudit p;
-  p.provider_id = provider_id;
-  p.provider_name = provider_name;
-  p.api_key = key;
-  p.key_supplied = !key.empty();
+// A model list as obtained for one key. source is "network" for a full
+// download, "revalidated" for a 304 against the disk cache and "disk" when
+// the cached copy was fresh enough to skip the request. The response body is
+// only a snippet; json holds the document when raw payloads are kept.
+struct CatalogFetch {
+  HttpResponse response;
+  ModelCatalog catalog;
+  std::shared_ptr<const ModelIndex> models;
+  nlohmann::json json;
+  std::string source;
+};
 
-  if (key.empty()) {
-    p.notes = "No API key supplied.";
-    return p;
-  }
+bool CatalogUsable(const CatalogFetch &f) {
+  return f.source != "network" ||
+         (f.response.status >= 200 && f.response.status < 300);
+}
 
-  std::vector<std::string> base_headers = extra_headers;
-  base_headers.push_back("Authorization: Bearer " + key);
+// Model catalogs fetched once per provider tier. The first key to ask does
+// the request; the others wait on its result.
+class CatalogCache {
+public:
+  CatalogFetch Get(const std::string &scope,
+                   const std::function<CatalogFetch()> &fetch, bool &fetched) {
+    std::promise<CatalogFetch> promise;
+    std::shared_future<CatalogFetch> result;
+    {
+      std::scoped_lock lock(mutex_);
+      const auto it = entries_.find(scope);
+      fetched = it == entries_.end();
+      if (fetched) {
+        result = promise.get_future().share();
+        entries_.emplace(scope, result);
+      } else {
+        result = it->second;
+      }
+    }
+    if (fetched) {
+      try {
+        promise.set_value(fetch());
+      } catch (...) {
+        promise.set_exception(std::current_exception());
+      }
+    }
+    return result.get();
+  }
 
-  log("[" + provider_name + "] Fetching model list");
-  const auto list_resp = Request("GET", list_url, base_headers, std::nullopt);
-  AddTrace(p, "list_models", "GET", list_url, list_resp);
+private:
+  std::mutex mutex_;
+  std::map<std::string, std::shared_future<CatalogFetch>> entries_;
+};
 
-  p.models_status = list_resp.status;
-  p.models_latency_ms = list_resp.latency_ms;
-  p.models_rate_limit_headers = RateLimitHeaders(list_resp.headers);
-  if (list_resp.status < 200 || list_resp.status >= 300) {
-    p.error_snippet = Snippet(list_resp.body);
-  }
+bool Healthy(const ProviderAudit &p) {
+  return p.key_supplied && !p.working_models.empty();
+}
 
-  const auto models_json = ParseJson(list_resp.body);
-  p.raw_payload["models_response"] = models_json;
-  const auto discovered = ExtractModelIds(models_json);
-  p.sample_models.assign(
-      discovered.begin(),
-      discovered.begin() +
-          static_cast<long>(std::min<std::size_t>(discovered.size(), 30)));
-  p.max_context_seen = ExtractMaxContext(models_json);
-  p.capability_tags = ExtractCapabilities(discovered, models_json);
-
-  if (discovered.empty()) {
-    p.notes = "No models discovered or access denied.";
-    FinalizeMetrics(p);
-    return p;
-  }
+// A checkpoint worth reusing: the key worked and every prompt test and suite
+// request got an answer.
+bool Reusable(const ProviderAudit &p) {
+  if (!Healthy(p))
+    return false;
+  return std::all_of(p.prompt_tests.begin(), p.prompt_tests.end(),
+                     [](const PromptTest &t) {
+                       return t.status >= 200 && t.status < 300;
+                     }) &&
+         std::all_of(p.suites.results.begin(), p.suites.results.end(),
+                     [](const SuiteCaseResult &r) {
+                       return r.status >= 200 && r.status < 300;
+                     });
+}
 
-  const auto model_candidates = TopCandidates(discovered, preferred_models, 8);
-  for (const auto &model : model_candidates) {
-    if (cancel_requested.load()) {
-      p.notes += " Audit canceled by user.";
-      FinalizeMetrics(p);
-      return p;
+// Everything besides the key that decides what a probe does; a checkpoint
+// taken under another signature is stale.
+std::string ProbeSignature(const std::string &provider_id,
+                           const ProviderKey &key,
+                           const AuditOptions &options) {
+  std::ostringstream oss;
+  oss << "tier=" << key.tier << ";stream=" << options.stream_prompts
+      << ";batch=" << options.batch.enabled << ";probe=" << kProbePrompt;
+  for (const auto &[name, prompt] : kPromptSuite)
+    oss << ";" << name << "=" << prompt;
+  for (const auto &suite : options.prompt_suites) {
+    oss << ";suite=" << suite.name;
+    for (const auto &c : suite.cases) {
+      oss << ";" << c.id << "=" << c.prompt << "," << static_cast<int>(c.rule)
+          << "," << c.field << "," << c.match_all << "," << c.ignore_case
+          << "," << c.points << "," << c.max_tokens;
+      for (const auto &e : c.expect)
+        oss << "," << e;
     }
+  }
+  if (!options.prompt_suites.empty())
+    oss << ";suite_models=" << options.suite_max_models;
+  const auto &b = options.benchmark;
+  if (b.enabled &&
+      (b.providers.empty() ||
+       std::find(b.providers.begin(), b.providers.end(), provider_id) !=
+           b.providers.end()))
+    oss << ";bench=" << b.model << "," << b.target_rps << "," << b.concurrency
+        << "," << b.duration_seconds << "," << b.window_seconds << ","
+        << b.max_tokens;
+  return CatalogStore::Fingerprint(oss.str());
+}
 
-    nlohmann::json payload = {
-        {"model", model},
-        {"messages",
-         {{{"role", "user"}, {"content", "Reply with exactly: OK"}}}},
-        {"temperature", 0},
-        {"max_tokens", 64},
+// What a finished provider key adds to the journal after its traces.
+void RecordProvider(const ProviderAudit &p, const RecordFn &record) {
+  for (const auto &c : p.model_checks) {
+    record({
+        {"type", "model_check"},
+        {"provider_id", p.provider_id},
+        {"key_index", p.key_index},
+        {"model", c.model},
+        {"status", c.status},
+        {"latency_ms", c.latency_ms},
+        {"working", c.working},
+        {"error_snippet", RedactKey(c.error_snippet, p.api_key)},
+    });
+  }
+  for (const auto &t : p.prompt_tests) {
+    record({
+        {"type", "prompt_test"},
+        {"provider_id", p.provider_id},
+        {"key_index", p.key_index},
+        {"name", t.name},
+        {"status", t.status},
+        {"latency_ms", t.latency_ms},
+        {"answer", RedactKey(t.answer, p.api_key)},
+        {"error_snippet", RedactKey(t.error_snippet, p.api_key)},
+        {"streamed", t.streamed},
+        {"ttft_us", t.ttft_us},
+        {"inter_token_p50_us", t.inter_token_p50_us},
+        {"inter_token_p90_us", t.inter_token_p90_us},
+        {"inter_token_p99_us", t.inter_token_p99_us},
+        {"output_tokens", t.output_tokens},
+        {"tokens_per_second", t.tokens_per_second},
+    });
+  }
+  for (const auto &s : SummarizeSuites(p.suites)) {
+    record({
+        {"type", "suite_summary"},
+        {"provider_id", p.provider_id},
+        {"key_index", p.key_index},
+        {"suite", s.suite},
+        {"model", s.model},
+        {"cases", s.cases},
+        {"passed", s.passed},
+        {"failed_requests", s.failed_requests},
+        {"points", s.points},
+        {"max_points", s.max_points},
+        {"latency_p50_us", s.latency.Percentile(0.50)},
+        {"latency_p99_us", s.latency.Percentile(0.99)},
+    });
+  }
+
+  nlohmann::json summary = {
+      {"type", "provider"},
+      {"provider_id", p.provider_id},
+      {"provider_name", p.provider_name},
+      {"key_index", p.key_index},
+      {"key_tier", p.key_tier},
+      {"api_key", MaskKey(p.api_key)},
+      {"key_supplied", p.key_supplied},
+      {"healthy", Healthy(p)},
+      {"catalog_source", p.catalog_source},
+      {"checkpoint_saved_at", p.checkpoint_saved_at},
+      {"auth_status", p.auth_status},
+      {"models_status", p.models_status},
+      {"model_used", p.model_used},
+      {"max_context_seen", p.max_context_seen},
+      {"capability_tags", p.capability_tags},
+      {"working_models", p.working_models},
+      {"failing_models", p.failing_models},
+      {"score_reasoning", p.score_reasoning},
+      {"score_coding", p.score_coding},
+      {"score_axui", p.score_axui},
+      {"score_total", p.score_total},
+      {"total_requests", p.total_requests},
+      {"successful_requests", p.successful_requests},
+      {"failed_requests", p.failed_requests},
+      {"throttled_requests", p.throttled_requests},
+      {"avg_latency_ms", p.avg_latency_ms},
+      {"latency_p50_us", p.latency.Percentile(0.50)},
+      {"latency_p90_us", p.latency.Percentile(0.90)},
+      {"latency_p99_us", p.latency.Percentile(0.99)},
+      {"notes", RedactKey(p.notes, p.api_key)},
+      {"error_snippet", RedactKey(p.error_snippet, p.api_key)},
+  };
+  if (!p.batches.empty()) {
+    summary["batches"] = nlohmann::json::array();
+    for (const auto &b : p.batches)
+      summary["batches"].push_back({
+          {"id", b.id},
+          {"model", b.model},
+          {"requests", b.requests},
+          {"status", b.status},
+          {"succeeded", b.succeeded},
+          {"failed", b.failed},
+          {"turnaround_ms", b.turnaround_ms},
+          {"error", RedactKey(b.error, p.api_key)},
+      });
+  }
+  if (p.benchmark.ran) {
+    const auto &b = p.benchmark;
+    summary["benchmark"] = {
+        {"model", b.model},
+        {"mode", b.mode},
+        {"sent", b.sent},
+        {"succeeded", b.succeeded},
+        {"achieved_rps", b.achieved_rps},
+        {"error_rate", b.error_rate},
+        {"p50_us", b.latency.Percentile(0.50)},
+        {"p99_us", b.latency.Percentile(0.99)},
+        {"first_429_ms", b.first_429_ms},
     };
+  }
+  record(summary);
+}
 
-    auto headers = base_headers;
-    headers.push_back("Content-Type: application/json");
-    const auto chat_resp = Request("POST", chat_url, headers, payload.dump());
-    AddTrace(p, "model_check:" + model, "POST", chat_url, chat_resp);
-
-    ModelCheck mc;
-    mc.model = model;
-    mc.status = chat_resp.status;
-    mc.latency_ms = chat_resp.latency_ms;
-    mc.error_snippet = Snippet(chat_resp.body);
-    const auto parsed = ParseJson(chat_resp.body);
-    const auto answer = ExtractOpenAIText(parsed);
-    mc.working =
-        (chat_resp.status >= 200 && chat_resp.status < 300 && !answer.empty());
-    p.model_checks.push_back(mc);
-    if (mc.working) {
-      p.working_models.push_back(model);
+KeyPoolSummary SummarizePool(const std::vector<const ProviderAudit *> &keys) {
+  KeyPoolSummary pool;
+  pool.provider_id = keys.front()->provider_id;
+  pool.provider_name = keys.front()->provider_name;
+  pool.region = keys.front()->region;
+  pool.keys_total = static_cast<int>(keys.size());
+  std::set<std::string> models;
+  for (const ProviderAudit *p : keys) {
+    const std::string masked = MaskKey(p->api_key);
+    if (Healthy(*p)) {
+      pool.keys_healthy += 1;
+      pool.healthy_keys.push_back(masked);
+      models.insert(p->working_models.begin(), p->working_models.end());
     } else {
-      p.failing_models.push_back(model);
+      pool.unhealthy_keys.push_back(masked);
     }
-  }
+    pool.throttled_requests += p->throttled_requests;
+
+    // Prefer what the chat endpoint last reported over the catalog response.
+    RateLimitState quota = p->rate_limit;
+    if (quota.remaining_requests < 0 && quota.remaining_tokens < 0)
+      quota = ParseRateLimitState(p->models_rate_limit_headers);
+    if (quota.remaining_requests >= 0 || quota.remaining_tokens >= 0)
+      pool.keys_reporting_quota += 1;
+    if (quota.remaining_requests >= 0)
+      pool.remaining_requests =
+          std::max(0LL, pool.remaining_requests) + quota.remaining_requests;
+    if (quota.remaining_tokens >= 0)
+      pool.remaining_tokens =
+          std::max(0LL, pool.remaining_tokens) + quota.remaining_tokens;
+  }
+  pool.working_models.assign(models.begin(), models.end());
+  return pool;
+}
 
-  p.model_used = !p.working_models.empty()
-                     ? p.working_models.front()
-                     : ChooseModel(discovered, preferred_models);
+struct RunContext {
+  const LogFn &log;
+  const std::atomic<bool> &cancel_requested;
+  HttpClient &http;
+  const AuditOptions &options;
+  RateLimiterPool &rate_limits;
+  CatalogCache &catalogs;
+  const CatalogStore &catalog_store;
+  const RecordFn &record;
+};
 
-  for (const auto &prompt : kPromptSuite) {
-    if (cancel_requested.load()) {
-      p.notes += " Audit canceled by user.";
-      FinalizeMetrics(p);
-      return p;
-    }
+long long UnixNow() {
+  using namespace std::chrono;
+  return duration_cast<seconds>(system_clock::now().time_since_epoch())
+      .count();
+}
 
-    log("[" + provider_name + "] Prompt test: " + prompt.first);
-    nlohmann::json payload = {
-        {"model", p.model_used},
-        {"messages", {{{"role", "user"}, {"content", prompt.second}}}},
-        {"temperature", 0},
-        {"max_tokens", 300},
-    };
+// How a traced request went through the rate limiter.
+struct TraceAttempt {
+  int attempt = 1;
+  long long paced_ms = 0;
+  long long backoff_ms = 0;
+  bool throttled = false;  // rejected with 429/503 and retried
+};
 
-    auto headers = base_headers;
-    headers.push_back("Content-Type: application/json");
-    const auto resp = Request("POST", chat_url, headers, payload.dump());
-    AddTrace(p, "prompt_test:" + prompt.first, "POST", chat_url, resp);
+// Keys never reach the journal: every free-text field goes through RedactKey.
+nlohmann::json TraceRecord(const ProviderAudit &p, const RequestTrace &t) {
+  return {
+      {"type", "trace"},
+      {"provider_id", p.provider_id},
+      {"api_key", MaskKey(p.api_key)},
+      {"seq", t.seq},
+      {"step", t.step},
+      {"method", t.method},
+      {"url", RedactKey(t.url, p.api_key)},
+      {"status", t.status},
+      {"latency_ms", t.latency_ms},
+      {"phases_us",
+       {
+           {"dns", t.phases.dns_us},
+           {"connect", t.phases.connect_us},
+           {"tls", t.phases.tls_us},
+           {"ttfb", t.phases.ttfb_us},
+           {"total", t.phases.total_us},
+       }},
+      {"connection_reused", t.connection_reused},
+      {"rate_limit_headers", HeadersJson(t.rate_limit_headers)},
+      {"response_snippet", RedactKey(t.response_snippet, p.api_key)},
+      {"error", RedactKey(t.error, p.api_key)},
+      {"state", t.state},
+      {"attempt", t.attempt},
+      {"paced_ms", t.paced_ms},
+      {"backoff_ms", t.backoff_ms},
+  };
+}
 
-    const auto parsed = ParseJson(resp.body);
-    PromptTest t;
-    t.name = prompt.first;
-    t.status = resp.status;
-    t.latency_ms = resp.latency_ms;
-    t.rate_limit_headers = RateLimitHeaders(resp.headers);
-    t.answer = Snippet(ExtractOpenAIText(parsed), 1400);
-    if (resp.status < 200 || resp.status >= 300) {
-      t.error_snippet = Snippet(resp.body, 700);
-    }
-    p.prompt_tests.push_back(std::move(t));
-  }
+long long LatencyUs(const HttpResponse &r) {
+  if (r.phases.total_us >= 0)
+    return r.phases.total_us;
+  return r.latency_ms >= 0 ? r.latency_ms * 1000LL : -1;
+}
 
-  ScoreProvider(p);
-  FinalizeMetrics(p);
-  return p;
+// Brackets every request sent for the live dashboard. Completion is noted
+// when the engine gets the response, which for the batched model checks is
+// when their futures are collected.
+void LiveStart(const RunContext &ctx, const std::string &provider_id) {
+  if (ctx.options.live)
+    ctx.options.live->RequestStarted(provider_id);
 }
 
-ProviderAudit AuditGoogle(const std::string &key, const LogFn &log,
-                          const std::atomic<bool> &cancel_requested) {
-  ProviderAudit p;
-  p.provider_id = "google_ai_studio";
-  p.provider_name = "Google AI Studio";
-  p.api_key = key;
-  p.key_supplied = !key.empty();
+void LiveFinish(const RunContext &ctx, const std::string &provider_id,
+                const HttpResponse &r) {
+  if (ctx.options.live)
+    ctx.options.live->RequestFinished(provider_id, r.status, LatencyUs(r));
+}
 
-  if (key.empty()) {
-    p.notes = "No API key supplied.";
-    return p;
+void AddTrace(ProviderAudit &p, const RunContext &ctx, const std::string &step,
+              const std::string &method, const std::string &url,
+              const HttpResponse &r, const std::string &model = {},
+              const TraceAttempt &attempt = {}) {
+  RequestTrace t;
+  t.seq = p.traces.size();
+  t.step = step;
+  t.method = method;
+  t.url = url;
+  t.status = r.status;
+  t.latency_ms = r.latency_ms;
+  t.phases = r.phases;
+  t.connection_reused = r.connection_reused;
+  t.rate_limit_headers = r.headers.RateLimitOnly();
+  t.response_snippet = Snippet(r.body);
+  t.error = r.error;
+  t.attempt = attempt.attempt;
+  t.paced_ms = attempt.paced_ms;
+  if (attempt.throttled) {
+    t.state = "throttled";
+    t.backoff_ms = attempt.backoff_ms;
   }
+  p.traces.Add(t);
+  if (ctx.record)
+    ctx.record(TraceRecord(p, t));
 
-  const std::string list_url =
-      "https://generativelanguage.googleapis.com/v1beta/models?key=" + key;
-  log("[Google AI Studio] Fetching model list");
-  const auto list_resp = Request("GET", list_url, {}, std::nullopt);
-  AddTrace(p, "list_models", "GET", list_url, list_resp);
-  p.models_status = list_resp.status;
-  p.models_latency_ms = list_resp.latency_ms;
-  p.models_rate_limit_headers = RateLimitHeaders(list_resp.headers);
-  if (list_resp.status < 200 || list_resp.status >= 300) {
-    p.error_snippet = Snippet(list_resp.body);
+  p.total_requests += 1;
+  // 304 only comes back for a conditional catalog revalidation.
+  const bool ok = (r.status >= 200 && r.status < 300) || r.status == 304;
+  if (ok && r.error.empty()) {
+    p.successful_requests += 1;
+  } else {
+    p.failed_requests += 1;
   }
 
-  const auto list_json = ParseJson(list_resp.body);
-  p.raw_payload["models_response"] = list_json;
-
-  std::vector<std::string> discovered;
-  if (list_json.is_object() && list_json.contains("models") &&
-      list_json["models"].is_array()) {
-    for (const auto &model : list_json["models"]) {
-      if (!model.is_object())
-        continue;
-      if (!model.contains("name") || !model["name"].is_string())
-        continue;
-      const std::string name = model["name"].get<std::string>();
-      bool supports_generate = false;
-      if (model.contains("supportedGenerationMethods") &&
-          model["supportedGenerationMethods"].is_array()) {
-        for (const auto &m : model["supportedGenerationMethods"]) {
-          if (m.is_string() && m.get<std::string>() == "generateContent") {
-            supports_generate = true;
-            break;
-          }
-        }
-      }
-      if (supports_generate)
-        discovered.push_back(name);
-    }
+  const long long us = LatencyUs(r);
+  if (us >= 0) {
+    p.latency.Record(us);
+    if (!model.empty())
+      p.model_latency[model].Record(us);
   }
 
-  std::set<std::string> dedup(discovered.begin(), discovered.end());
-  discovered.assign(dedup.begin(), dedup.end());
-  p.sample_models.assign(
-      discovered.begin(),
-      discovered.begin() +
-          static_cast<long>(std::min<std::size_t>(discovered.size(), 30)));
-  p.max_context_seen = ExtractMaxContext(list_json);
-  p.capability_tags = ExtractCapabilities(discovered, list_json);
-
-  const std::vector<std::string> preferred = {
-      "models/gemini-2.5-pro", "models/gemini-2.5-flash",
-      "models/gemini-2.0-flash", "models/gemini-1.5-pro"};
-
-  if (discovered.empty()) {
-    p.notes = "No generateContent models discovered.";
-    FinalizeMetrics(p);
-    return p;
+  if (AuditMetrics *metrics = ctx.options.metrics) {
+    metrics->ObserveRequest(p.provider_id, model, ok && r.error.empty(),
+                            attempt.throttled, us);
+    metrics->ObserveRateLimit(p.provider_id, model,
+                              ParseRateLimitState(r.headers));
   }
+}
 
-  const auto check_candidates = TopCandidates(discovered, preferred, 8);
-  for (const auto &model : check_candidates) {
-    if (cancel_requested.load()) {
-      p.notes += " Audit canceled by user.";
-      FinalizeMetrics(p);
-      return p;
-    }
-    nlohmann::json payload = {
-        {"contents",
-         {{{"role", "user"},
-           {"parts", {{{"text", "Reply with exactly: OK"}}}}}}},
-        {"generationConfig", {{"temperature", 0}, {"maxOutputTokens", 64}}},
-    };
-
-    const std::string url =
-        "https://generativelanguage.googleapis.com/v1beta/" + model +
-        ":generateContent?key=" + key;
-    const auto resp = Request("POST", url, {"Content-Type: application/json"},
-                              payload.dump());
-    AddTrace(p, "model_check:" + model, "POST", url, resp);
-
-    ModelCheck mc;
-    mc.model = model;
-    mc.status = resp.status;
-    mc.latency_ms = resp.latency_ms;
-    mc.error_snippet = Snippet(resp.body);
-    const auto parsed = ParseJson(resp.body);
-    const auto answer = ExtractGoogleText(parsed);
-    mc.working = (resp.status >= 200 && resp.status < 300 && !answer.empty());
-    p.model_checks.push_back(mc);
-    if (mc.working)
-      p.working_models.push_back(model);
-    if (!mc.working)
-      p.failing_models.push_back(model);
+// Serves the model list from the disk cache while it is within the TTL,
+// otherwise revalidates it with If-None-Match / If-Modified-Since.
+CatalogFetch FetchCatalogOnce(const std::string &provider_id,
+                              const std::string &identity,
+                              const std::string &url,
+                              const std::vector<std::string> &headers,
+                              CatalogShape shape, const RunContext &ctx) {
+  CatalogFetch out;
+  auto cached = ctx.catalog_store.Load(provider_id, identity);
+  const long long now = UnixNow();
+  if (cached && now - cached->fetched_at >= 0 &&
+      now - cached->fetched_at < ctx.options.catalog_cache_ttl_seconds) {
+    out.catalog = std::move(cached->catalog);
+    out.source = "disk";
+    return out;
+  }
+
+  std::vector<std::string> request_headers = headers;
+  if (cached && !cached->etag.empty())
+    request_headers.push_back("If-None-Match: " + cached->etag);
+  if (cached && !cached->last_modified.empty())
+    request_headers.push_back("If-Modified-Since: " + cached->last_modified);
+
+  // The body is analyzed as it arrives; only a snippet is kept, plus the
+  // whole document when raw payloads are requested and it fits the cap.
+  CatalogCollector collector(shape);
+  JsonStreamParser parser(collector);
+  std::string head;
+  std::string raw;
+  std::size_t body_bytes = 0;
+  const bool keep_raw = ctx.options.keep_raw_payload;
+  const std::size_t raw_cap = ctx.options.raw_payload_max_bytes;
+  LiveStart(ctx, provider_id);
+  out.response = ctx.http.Stream(
+      "GET", url, request_headers, std::nullopt, [&](std::string_view chunk) {
+        body_bytes += chunk.size();
+        if (head.size() < kSnippetLen)
+          head.append(chunk.substr(0, kSnippetLen - head.size()));
+        if (keep_raw && body_bytes <= raw_cap)
+          raw.append(chunk);
+        parser.Feed(chunk);
+      });
+  LiveFinish(ctx, provider_id, out.response);
+  out.response.body = std::move(head);
+
+  if (cached && out.response.status == 304) {
+    cached->fetched_at = now;
+    ctx.catalog_store.Save(provider_id, identity, *cached);
+    out.catalog = std::move(cached->catalog);
+    out.source = "revalidated";
+    return out;
+  }
+
+  out.source = "network";
+  out.catalog = collector.Take(parser.Finish());
+  if (keep_raw)
+    out.json = body_bytes <= raw_cap
+                   ? ParseJson(raw)
+                   : nlohmann::json{{"omitted_bytes", body_bytes}};
+  if (out.response.status >= 200 && out.response.status < 300 &&
+      !out.catalog.model_ids.empty()) {
+    CachedCatalog entry;
+    entry.catalog = out.catalog;
+    entry.fetched_at = now;
+    if (const auto etag = out.response.headers.Find("etag"))
+      entry.etag = *etag;
+    if (const auto modified = out.response.headers.Find("last-modified"))
+      entry.last_modified = *modified;
+    ctx.catalog_store.Save(provider_id, identity, entry);
   }
+  return out;
+}
 
-  p.model_used = !p.working_models.empty() ? p.working_models.front()
-                                           : ChooseModel(discovered, preferred);
+// Loads the model list into p and returns an index of its ids. Keys on the
+// same tier share one fetch, one disk entry and one index; a failed shared
+// fetch is retried with this key.
+std::shared_ptr<const ModelIndex>
+LoadCatalog(ProviderAudit &p, const std::string &url,
+            const std::vector<std::string> &headers, CatalogShape shape,
+            const RunContext &ctx) {
+  const std::string identity =
+      p.key_tier.empty() ? p.api_key : "tier:" + p.key_tier;
+  auto fetch = [&] {
+    CatalogFetch f =
+        FetchCatalogOnce(p.provider_id, identity, url, headers, shape, ctx);
+    f.models = std::make_shared<const ModelIndex>(f.catalog.model_ids);
+    return f;
+  };
 
-  for (const auto &prompt : kPromptSuite) {
-    if (cancel_requested.load()) {
-      p.notes += " Audit canceled by user.";
-      FinalizeMetrics(p);
-      return p;
+  CatalogFetch result;
+  bool fetched = true;
+  if (!p.key_tier.empty()) {
+    result =
+        ctx.catalogs.Get(p.provider_id + "|" + p.key_tier, fetch, fetched);
+    if (!fetched && !CatalogUsable(result)) {
+      result = fetch();
+      fetched = true;
     }
-    log("[Google AI Studio] Prompt test: " + prompt.first);
+    p.catalog_shared = !fetched;
+  } else {
+    result = fetch();
+  }
 
-    nlohmann::json payload = {
-        {"contents",
-         {{{"role", "user"}, {"parts", {{{"text", prompt.second}}}}}}},
-        {"generationConfig", {{"temperature", 0}, {"maxOutputTokens", 300}}},
-    };
+  if (fetched && result.source != "disk")
+    AddTrace(p, ctx, "list_models", "GET", url, result.response);
+  if (result.source == "disk")
+    ctx.log("[" + p.provider_name + "] Model list served from disk cache");
+  p.catalog_source = result.source;
+  p.models_status = result.response.status;
+  p.models_latency_ms = result.response.latency_ms;
+  p.models_rate_limit_headers = result.response.headers.RateLimitOnly();
+  if (result.source == "network") {
+    if (result.response.status < 200 || result.response.status >= 300)
+      p.error_snippet = Snippet(result.response.body);
+    if (ctx.options.keep_raw_payload)
+      p.raw_payload["models_response"] = std::move(result.json);
+  }
 
-    const std::string url =
-        "https://generativelanguage.googleapis.com/v1beta/" + p.model_used +
-        ":generateContent?key=" + key;
-    const auto resp = Request("POST", url, {"Content-Type: application/json"},
-                              payload.dump());
-    AddTrace(p, "prompt_test:" + prompt.first, "POST", url, resp);
+  const auto &ids = result.catalog.model_ids;
+  p.sample_models.assign(
+      ids.begin(),
+      ids.begin() + static_cast<long>(std::min<std::size_t>(ids.size(), 30)));
+  p.max_context_seen = result.catalog.max_context;
+  p.capability_tags = result.catalog.capability_tags;
+  return result.models;
+}
 
-    PromptTest t;
-    t.name = prompt.first;
-    t.status = resp.status;
-    t.latency_ms = resp.latency_ms;
-    t.rate_limit_headers = RateLimitHeaders(resp.headers);
-    t.answer = Snippet(ExtractGoogleText(ParseJson(resp.body)), 1400);
-    if (resp.status < 200 || resp.status >= 300)
-      t.error_snippet = Snippet(resp.body, 700);
-    p.prompt_tests.push_back(std::move(t));
+ProviderAudit StartAudit(const std::string &provider_id,
+                         const std::string &provider_name,
+                         const ProviderKey &credential, const RunContext &ctx) {
+  ProviderAudit p;
+  p.provider_id = provider_id;
+  p.provider_name = provider_name;
+  p.api_key = credential.key;
+  p.key_tier = credential.tier;
+  p.key_supplied = !credential.key.empty();
+  p.traces = TraceStore(ctx.options.traces);
+  return p;
+}
+
+// nullptr when adaptive rate limiting is off.
+RateLimiter *LimiterFor(const ProviderAudit &p, const std::string &url,
+                        const RunContext &ctx) {
+  if (!ctx.options.adaptive_rate_limit)
+    return nullptr;
+  const auto &seeds = ctx.options.initial_rate_limits;
+  const auto seed = seeds.find(p.provider_id + "|" + p.api_key);
+  return &ctx.rate_limits.For(
+      p.provider_id + "|" + HostOf(url) + "|" + p.api_key,
+      seed == seeds.end() ? nullptr : &seed->second);
+}
+
+void SyncRateLimit(ProviderAudit &p, const RateLimiter *limiter) {
+  if (!limiter)
+    return;
+  p.rate_limit = limiter->last_state();
+  p.throttled_requests = limiter->throttled_count();
+}
+
+// Rough prompt plus completion size, for the tokens-per-window bucket.
+long long EstimateTokens(const std::string &body, int max_tokens) {
+  return static_cast<long long>(body.size() / 4) + max_tokens;
+}
+
+// Sends through the key's rate limiter and retries 429/503 once the limiter's
+// backoff has passed. Every attempt is traced; retried ones as "throttled".
+HttpResponse SendPaced(ProviderAudit &p, const std::string &step,
+                       const std::string &url, long long token_cost,
+                       const std::string &model, const RunContext &ctx,
+                       const std::function<HttpResponse()> &send) {
+  RateLimiter *limiter = LimiterFor(p, url, ctx);
+  for (int attempt = 1;; ++attempt) {
+    const long long paced_ms =
+        limiter ? limiter->Acquire(token_cost, &ctx.cancel_requested) : 0;
+    LiveStart(ctx, p.provider_id);
+    HttpResponse resp = send();
+    LiveFinish(ctx, p.provider_id, resp);
+    const long long backoff_ms =
+        limiter ? limiter->Observe(resp.status, resp.headers) : 0;
+    const bool retry = limiter && limiter->ShouldRetry(resp.status, attempt) &&
+                       !ctx.cancel_requested.load();
+
+    AddTrace(p, ctx, step, "POST", url, resp, retry ? "" : model,
+             {attempt, paced_ms, backoff_ms, retry});
+    if (!retry) {
+      SyncRateLimit(p, limiter);
+      return resp;
+    }
+    ctx.log("[" + p.provider_name + "] " + step + " throttled (" +
+            std::to_string(resp.status) + "), retrying in " +
+            std::to_string(backoff_ms) + " ms");
   }
+}
 
-  ScoreProvider(p);
-  FinalizeMetrics(p);
-  return p;
+struct ProbeRequest {
+  std::string url;
+  std::vector<std::string> headers;
+  std::string body;
+};
+
+// How a provider accepts chat requests. "{model}" in url is replaced with the
+// model id.
+struct ChatEndpoint {
+  ChatFormat format = ChatFormat::kOpenAI;
+  std::string url;
+  std::vector<std::string> headers;
+  bool send_temperature = true;
+  std::string (*extract_text)(const nlohmann::json &) = ExtractOpenAIText;
+  // Google streams from a different method; the others take stream=true.
+  std::string stream_url;
+};
+
+bool CanStream(const ChatEndpoint &ep) {
+  return ep.format != ChatFormat::kGoogle || !ep.stream_url.empty();
 }
 
-ProviderAudit AuditCohere(const std::string &key, const LogFn &log,
-                          const std::atomic<bool> &cancel_requested) {
-  ProviderAudit p;
-  p.provider_id = "cohere";
-  p.provider_name = "Cohere";
-  p.api_key = key;
-  p.key_supplied = !key.empty();
+ProbeRequest BuildChatRequest(const ChatEndpoint &ep, const std::string &model,
+                              const std::string &prompt, int max_tokens,
+                              bool stream = false) {
+  std::string url =
+      stream && ep.format == ChatFormat::kGoogle ? ep.stream_url : ep.url;
+  const auto pos = url.find("{model}");
+  if (pos != std::string::npos)
+    url.replace(pos, 7, model);
+
+  nlohmann::json payload;
+  switch (ep.format) {
+  case ChatFormat::kGoogle:
+    payload = {
+        {"contents", {{{"role", "user"}, {"parts", {{{"text", prompt}}}}}}},
+        {"generationConfig",
+         {{"temperature", 0}, {"maxOutputTokens", max_tokens}}},
+    };
+    break;
+  case ChatFormat::kCohere:
+    payload = {
+        {"model", model},
+        {"message", prompt},
+        {"max_tokens", max_tokens},
+    };
+    break;
+  case ChatFormat::kOpenAI:
+    payload = {
+        {"model", model},
+        {"messages", {{{"role", "user"}, {"content", prompt}}}},
+        {"max_tokens", max_tokens},
+    };
+    break;
+  }
+  if (ep.send_temperature && ep.format != ChatFormat::kGoogle)
+    payload["temperature"] = 0;
+  if (stream && ep.format != ChatFormat::kGoogle)
+    payload["stream"] = true;
+  return ProbeRequest{url, ep.headers, payload.dump()};
+}
 
-  if (key.empty()) {
-    p.notes = "No API key supplied.";
-    return p;
+long long IntAt(const nlohmann::json &j,
+                std::initializer_list<const char *> path) {
+  const nlohmann::json *node = &j;
+  for (const char *key : path) {
+    if (!node->is_object() || !node->contains(key))
+      return -1;
+    node = &(*node)[key];
   }
+  return node->is_number_integer() ? node->get<long long>() : -1;
+}
 
-  std::vector<std::string> base_headers = {
-      "Authorization: Bearer " + key,
-      "Cohere-Version: 2022-12-06",
-  };
+// Text carried by one streamed event, plus the output token count when the
+// provider reports usage in it.
+struct StreamDelta {
+  std::string text;
+  long long output_tokens = -1;
+};
 
-  const std::string list_url = "https://api.cohere.com/v1/models";
-  log("[Cohere] Fetching model list");
-  const auto list_resp = Request("GET", list_url, base_headers, std::nullopt);
-  AddTrace(p, "list_models", "GET", list_url, list_resp);
-
-  p.models_status = list_resp.status;
-  p.models_latency_ms = list_resp.latency_ms;
-  p.models_rate_limit_headers = RateLimitHeaders(list_resp.headers);
-  if (list_resp.status < 200 || list_resp.status >= 300)
-    p.error_snippet = Snippet(list_resp.body);
-
-  const auto list_json = ParseJson(list_resp.body);
-  p.raw_payload["models_response"] = list_json;
-
-  std::vector<std::string> discovered;
-  if (list_json.is_object() && list_json.contains("models") &&
-      list_json["models"].is_array()) {
-    for (const auto &model : list_json["models"]) {
-      if (model.is_object() && model.contains("name") &&
-          model["name"].is_string()) {
-        discovered.push_back(model["name"].get<std::string>());
-      } else if (model.is_string()) {
-        discovered.push_back(model.get<std::string>());
+StreamDelta ExtractStreamDelta(ChatFormat format, const nlohmann::json &j) {
+  StreamDelta out;
+  switch (format) {
+  case ChatFormat::kOpenAI:
+    if (j.contains("choices") && j["choices"].is_array() &&
+        !j["choices"].empty()) {
+      const auto &c = j["choices"][0];
+      if (c.is_object() && c.contains("delta") && c["delta"].is_object() &&
+          c["delta"].contains("content") &&
+          c["delta"]["content"].is_string())
+        out.text = c["delta"]["content"].get<std::string>();
+    }
+    out.output_tokens = IntAt(j, {"usage", "completion_tokens"});
+    if (out.output_tokens < 0)
+      out.output_tokens = IntAt(j, {"x_groq", "usage", "completion_tokens"});
+    break;
+  case ChatFormat::kGoogle:
+    if (j.contains("candidates") && j["candidates"].is_array() &&
+        !j["candidates"].empty()) {
+      const auto &c0 = j["candidates"][0];
+      if (c0.is_object() && c0.contains("content") &&
+          c0["content"].is_object() && c0["content"].contains("parts") &&
+          c0["content"]["parts"].is_array()) {
+        for (const auto &part : c0["content"]["parts"]) {
+          if (part.is_object() && part.contains("text") &&
+              part["text"].is_string())
+            out.text += part["text"].get<std::string>();
+        }
       }
     }
+    out.output_tokens = IntAt(j, {"usageMetadata", "candidatesTokenCount"});
+    break;
+  case ChatFormat::kCohere:
+    if (j.value("event_type", "") == "text-generation" &&
+        j.contains("text") && j["text"].is_string())
+      out.text = j["text"].get<std::string>();
+    out.output_tokens =
+        IntAt(j, {"response", "meta", "billed_units", "output_tokens"});
+    if (out.output_tokens < 0)
+      out.output_tokens =
+          IntAt(j, {"response", "meta", "tokens", "output_tokens"});
+    break;
   }
+  return out;
+}
 
-  std::set<std::string> dedup(discovered.begin(), discovered.end());
-  discovered.assign(dedup.begin(), dedup.end());
-  p.sample_models.assign(
-      discovered.begin(),
-      discovered.begin() +
-          static_cast<long>(std::min<std::size_t>(discovered.size(), 30)));
-  p.max_context_seen = ExtractMaxContext(list_json);
-  p.capability_tags = ExtractCapabilities(discovered, list_json);
-
-  const std::vector<std::string> preferred = {"command-a-reasoning-08-2025",
-                                              "command-r-08-2024",
-                                              "command-a-vision-07-2025"};
-
-  std::vector<std::string> chat_candidates;
-  for (const auto &m : discovered) {
-    const auto ml = ToLower(m);
-    if (ml.find("embed") != std::string::npos ||
-        ml.find("rerank") != std::string::npos)
-      continue;
-    chat_candidates.push_back(m);
-  }
+// Sends one prompt with streaming on and parses events as chunks arrive; only
+// the first bytes of the raw stream are kept, as the response snippet.
+HttpResponse StreamPrompt(const ProbeRequest &req, ChatFormat format,
+                          PromptTest &t, const RunContext &ctx) {
+  using namespace std::chrono;
+  constexpr std::size_t kRawKeep = 700;
+  const auto start = steady_clock::now();
+  std::string text;
+  std::string raw_prefix;
+  std::vector<long long> token_us;
+  long long reported_tokens = -1;
+  // SendPaced calls this again after a 429 or 503; nothing of the throttled
+  // attempt may survive into the figures of the one that gets through.
+  t.ttft_us = -1;
+  t.inter_token_p50_us = -1;
+  t.inter_token_p90_us = -1;
+  t.inter_token_p99_us = -1;
+  t.output_tokens = -1;
+  t.tokens_per_second = -1.0;
+
+  SseParser parser([&](std::string_view data) {
+    if (data == "[DONE]")
+      return;
+    const auto j = nlohmann::json::parse(data, nullptr, false);
+    if (!j.is_object())
+      return;
+    auto delta = ExtractStreamDelta(format, j);
+    if (delta.output_tokens >= 0)
+      reported_tokens = delta.output_tokens;
+    if (delta.text.empty())
+      return;
+    token_us.push_back(
+        duration_cast<microseconds>(steady_clock::now() - start).count());
+    text += delta.text;
+  });
+  auto resp = ctx.http.Stream("POST", req.url, req.headers, req.body,
+                              [&](std::string_view chunk) {
+                                if (raw_prefix.size() < kRawKeep)
+                                  raw_prefix.append(chunk.substr(
+                                      0, kRawKeep - raw_prefix.size()));
+                                parser.Feed(chunk);
+                              });
+  parser.Finish();
+  resp.body = std::move(raw_prefix);
+
+  t.streamed = true;
+  t.answer = Snippet(text, 1400);
+  if (!token_us.empty()) {
+    t.ttft_us = token_us.front();
+    LatencyHistogram gaps;
+    for (std::size_t i = 1; i < token_us.size(); ++i)
+      gaps.Record(token_us[i] - token_us[i - 1]);
+    t.inter_token_p50_us = gaps.Percentile(0.50);
+    t.inter_token_p90_us = gaps.Percentile(0.90);
+    t.inter_token_p99_us = gaps.Percentile(0.99);
+    t.output_tokens = reported_tokens >= 0
+                          ? reported_tokens
+                          : static_cast<long long>(token_us.size());
+    const long long decode_us = token_us.back() - token_us.front();
+    if (t.output_tokens > 1 && decode_us > 0)
+      t.tokens_per_second = static_cast<double>(t.output_tokens - 1) * 1e6 /
+                            static_cast<double>(decode_us);
+  }
+  return resp;
+}
 
-  if (chat_candidates.empty()) {
-    p.notes = "No chat-capable models inferred from model names.";
-    FinalizeMetrics(p);
-    return p;
+void AddModelCheck(ProviderAudit &p, ModelCheck mc, const RunContext &ctx) {
+  if (ctx.options.metrics)
+    ctx.options.metrics->SetModelWorking(p.provider_id, mc.model, mc.working);
+  if (mc.working) {
+    p.working_models.push_back(mc.model);
+  } else {
+    p.failing_models.push_back(mc.model);
   }
+  p.model_checks.push_back(std::move(mc));
+}
 
-  const auto checks = TopCandidates(chat_candidates, preferred, 8);
-  for (const auto &model : checks) {
-    if (cancel_requested.load()) {
-      p.notes += " Audit canceled by user.";
-      FinalizeMetrics(p);
-      return p;
+// Puts every model_check probe in flight at once (the transport enforces the
+// per-host cap and the rate limiter paces submission), retries throttled
+// probes in further rounds, then records the results in candidate order.
+// Returns false on cancellation.
+bool RunModelChecks(ProviderAudit &p,
+                    const std::vector<std::string> &candidates,
+                    const ChatEndpoint &ep, const RunContext &ctx) {
+  constexpr int kMaxTokens = 64;
+  std::vector<ProbeRequest> requests;
+  requests.reserve(candidates.size());
+  for (const auto &model : candidates)
+    requests.push_back(BuildChatRequest(ep, model, kProbePrompt, kMaxTokens));
+  if (requests.empty())
+    return true;
+
+  ctx.log("[" + p.provider_name + "] Probing " +
+          std::to_string(requests.size()) + " models");
+  if (ctx.options.live)
+    ctx.options.live->PlanModels(p.provider_id,
+                                 static_cast<int>(requests.size()));
+  RateLimiter *limiter = LimiterFor(p, requests.front().url, ctx);
+
+  struct Attempt {
+    HttpResponse response;
+    long long paced_ms = 0;
+    long long backoff_ms = 0;
+  };
+  // Throttled attempts first, the final response last.
+  std::vector<std::vector<Attempt>> attempts(requests.size());
+  std::vector<std::size_t> todo(requests.size());
+  for (std::size_t i = 0; i < todo.size(); ++i)
+    todo[i] = i;
+
+  for (int round = 1; !todo.empty(); ++round) {
+    std::vector<std::future<HttpResponse>> pending;
+    std::vector<long long> paced;
+    pending.reserve(todo.size());
+    for (const std::size_t i : todo) {
+      const auto &req = requests[i];
+      paced.push_back(limiter ? limiter->Acquire(
+                                    EstimateTokens(req.body, kMaxTokens),
+                                    &ctx.cancel_requested)
+                              : 0);
+      LiveStart(ctx, p.provider_id);
+      pending.push_back(
+          ctx.http.RequestAsync("POST", req.url, req.headers, req.body));
     }
 
-    nlohmann::json payload = {
-        {"model", model},
-        {"message", "Reply with exactly: OK"},
-        {"temperature", 0},
-        {"max_tokens", 64},
-    };
-
-    auto headers = base_headers;
-    headers.push_back("Content-Type: application/json");
-    const auto resp = Request("POST", "https://api.cohere.com/v1/chat", headers,
-                              payload.dump());
-    AddTrace(p, "model_check:" + model, "POST",
-             "https://api.cohere.com/v1/chat", resp);
+    std::vector<std::size_t> retry;
+    for (std::size_t k = 0; k < pending.size(); ++k) {
+      HttpResponse resp = pending[k].get();
+      LiveFinish(ctx, p.provider_id, resp);
+      const long long backoff_ms =
+          limiter ? limiter->Observe(resp.status, resp.headers) : 0;
+      const bool again = limiter && limiter->ShouldRetry(resp.status, round) &&
+                         !ctx.cancel_requested.load();
+      attempts[todo[k]].push_back(
+          {std::move(resp), paced[k], again ? backoff_ms : 0});
+      if (again)
+        retry.push_back(todo[k]);
+      else if (ctx.options.live)
+        ctx.options.live->ModelProbed(p.provider_id);
+    }
+    todo = std::move(retry);
+  }
+  SyncRateLimit(p, limiter);
+
+  // A cancel leaves some probes unsent; every probe that did get a response
+  // is still recorded.
+  bool canceled = false;
+  for (std::size_t i = 0; i < candidates.size(); ++i) {
+    const auto &resp = attempts[i].back().response;
+    const auto &model = candidates[i];
+    const std::string step = "model_check:" + model;
+    for (std::size_t a = 0; a < attempts[i].size(); ++a) {
+      const bool last = a + 1 == attempts[i].size();
+      const auto &sent = attempts[i][a];
+      if (sent.response.error == "canceled")
+        continue;
+      AddTrace(p, ctx, step, "POST", requests[i].url, sent.response,
+               last ? model : "",
+               {static_cast<int>(a) + 1, sent.paced_ms, sent.backoff_ms,
+                !last});
+    }
+    if (resp.error == "canceled") {
+      canceled = true;
+      continue;
+    }
 
     ModelCheck mc;
     mc.model = model;
@@ -1099,324 +1330,855 @@ ProviderAudit AuditCohere(const std::string &key, const LogFn &log,
     mc.latency_ms = resp.latency_ms;
     mc.error_snippet = Snippet(resp.body);
     mc.working = (resp.status >= 200 && resp.status < 300 &&
-                  !ExtractCohereText(ParseJson(resp.body)).empty());
-    p.model_checks.push_back(mc);
-    if (mc.working)
-      p.working_models.push_back(model);
-    if (!mc.working)
-      p.failing_models.push_back(model);
+                  !ep.extract_text(ParseJson(resp.body)).empty());
+    AddModelCheck(p, std::move(mc), ctx);
   }
+  if (canceled) {
+    p.notes += " Audit canceled by user.";
+    return false;
+  }
+  return true;
+}
 
-  p.model_used = !p.working_models.empty()
-                     ? p.working_models.front()
-                     : ChooseModel(chat_candidates, preferred);
-
+// Runs kPromptSuite against model_used. Returns false on cancellation.
+bool RunPromptSuite(ProviderAudit &p, const ChatEndpoint &ep,
+                    const RunContext &ctx) {
   for (const auto &prompt : kPromptSuite) {
-    if (cancel_requested.load()) {
+    if (ctx.cancel_requested.load()) {
       p.notes += " Audit canceled by user.";
-      FinalizeMetrics(p);
-      return p;
+      return false;
     }
 
-    log("[Cohere] Prompt test: " + prompt.first);
-    nlohmann::json payload = {
-        {"model", p.model_used},
-        {"message", prompt.second},
-        {"temperature", 0},
-        {"max_tokens", 300},
-    };
-
-    auto headers = base_headers;
-    headers.push_back("Content-Type: application/json");
-    const auto resp = Request("POST", "https://api.cohere.com/v1/chat", headers,
-                              payload.dump());
-    AddTrace(p, "prompt_test:" + prompt.first, "POST",
-             "https://api.cohere.com/v1/chat", resp);
+    ctx.log("[" + p.provider_name + "] Prompt test: " + prompt.first);
+    const bool stream = ctx.options.stream_prompts && CanStream(ep);
+    const auto req =
+        BuildChatRequest(ep, p.model_used, prompt.second, 300, stream);
 
     PromptTest t;
+    const auto resp = SendPaced(
+        p, "prompt_test:" + prompt.first, req.url,
+        EstimateTokens(req.body, 300), p.model_used, ctx, [&] {
+          return stream ? StreamPrompt(req, ep.format, t, ctx)
+                        : ctx.http.Request("POST", req.url, req.headers,
+                                           req.body);
+        });
+    if (!stream)
+      t.answer = Snippet(ep.extract_text(ParseJson(resp.body)), 1400);
+
     t.name = prompt.first;
     t.status = resp.status;
     t.latency_ms = resp.latency_ms;
-    t.rate_limit_headers = RateLimitHeaders(resp.headers);
-    t.answer = Snippet(ExtractCohereText(ParseJson(resp.body)), 1400);
+    t.rate_limit_headers = resp.headers.RateLimitOnly();
     if (resp.status < 200 || resp.status >= 300)
       t.error_snippet = Snippet(resp.body, 700);
     p.prompt_tests.push_back(std::move(t));
   }
+  return true;
+}
 
-  ScoreProvider(p);
-  FinalizeMetrics(p);
-  return p;
+// The first suite_max_models of models, or all of them.
+std::vector<std::string> SuiteModels(std::vector<std::string> models,
+                                     const AuditOptions &options) {
+  const int max_models = options.suite_max_models;
+  if (max_models > 0 && models.size() > static_cast<std::size_t>(max_models))
+    models.resize(static_cast<std::size_t>(max_models));
+  return models;
 }
 
-ProviderAudit AuditVercel(const std::string &key, const LogFn &log,
-                          const std::atomic<bool> &cancel_requested) {
-  ProviderAudit p;
-  p.provider_id = "vercel";
-  p.provider_name = "Vercel AI Gateway";
-  p.api_key = key;
-  p.key_supplied = !key.empty();
+// text is the answer of a 2xx response and the error body otherwise.
+SuiteCaseResult SuiteResult(SuiteResults &out, const PromptSuite &suite,
+                            const PromptCase &c, const std::string &model,
+                            long status, long latency_ms,
+                            const std::string &text) {
+  SuiteCaseResult r;
+  r.suite = out.names.Intern(suite.name);
+  r.case_id = out.names.Intern(c.id);
+  r.model = out.names.Intern(model);
+  r.status = static_cast<std::int32_t>(status);
+  r.latency_ms = static_cast<std::int32_t>(latency_ms);
+  r.points = status >= 200 && status < 300 ? ScoreAnswer(c, text) : 0;
+  r.max_points = c.points;
+  r.response = out.responses.Intern(
+      std::string_view(text).substr(0, kSuiteResponseChars));
+  r.response_hash = HashText(text);
+  return r;
+}
 
-  if (key.empty()) {
-    p.notes = "No API key supplied.";
-    return p;
+// Sends every case of the workspace suites to each working model, keeping at
+// most suite_max_in_flight requests outstanding (the transport still applies
+// the per-host cap and the rate limiter paces submission). Throttled requests
+// go back on the queue. Returns false on cancellation.
+bool RunSuites(ProviderAudit &p, const ChatEndpoint &ep,
+               const RunContext &ctx) {
+  const auto &suites = ctx.options.prompt_suites;
+  const std::vector<std::string> models =
+      SuiteModels(p.working_models, ctx.options);
+  if (suites.empty() || models.empty())
+    return true;
+
+  struct Job {
+    const PromptSuite *suite;
+    const PromptCase *c;
+    std::size_t model;
+  };
+  std::vector<Job> jobs;
+  for (const auto &suite : suites) {
+    for (const auto &c : suite.cases) {
+      for (std::size_t m = 0; m < models.size(); ++m)
+        jobs.push_back({&suite, &c, m});
+    }
   }
+  ctx.log("[" + p.provider_name + "] Running " + std::to_string(jobs.size()) +
+          " suite prompts on " + std::to_string(models.size()) + " models");
 
-  const std::vector<std::string> headers = {"Authorization: Bearer " + key};
-
-  log("[Vercel] Validating user token");
-  const auto auth_resp =
-      Request("GET", "https://api.vercel.com/v2/user", headers, std::nullopt);
-  AddTrace(p, "auth_user", "GET", "https://api.vercel.com/v2/user", auth_resp);
-  p.auth_status = auth_resp.status;
-  p.auth_latency_ms = auth_resp.latency_ms;
-  p.auth_rate_limit_headers = RateLimitHeaders(auth_resp.headers);
-
-  log("[Vercel] Fetching AI Gateway models");
-  const auto list_resp = Request(
-      "GET", "https://ai-gateway.vercel.sh/v1/models", headers, std::nullopt);
-  AddTrace(p, "list_models", "GET", "https://ai-gateway.vercel.sh/v1/models",
-           list_resp);
-  p.models_status = list_resp.status;
-  p.models_latency_ms = list_resp.latency_ms;
-  p.models_rate_limit_headers = RateLimitHeaders(list_resp.headers);
-  if (list_resp.status < 200 || list_resp.status >= 300)
-    p.error_snippet = Snippet(list_resp.body);
-
-  const auto list_json = ParseJson(list_resp.body);
-  p.raw_payload["auth_response"] = ParseJson(auth_resp.body);
-  p.raw_payload["models_response"] = list_json;
-
-  auto discovered = ExtractModelIds(list_json);
-  p.sample_models.assign(
-      discovered.begin(),
-      discovered.begin() +
-          static_cast<long>(std::min<std::size_t>(discovered.size(), 30)));
-  p.max_context_seen = ExtractMaxContext(list_json);
-  p.capability_tags = ExtractCapabilities(discovered, list_json);
-
-  const std::vector<std::string> preferred = {
-      "openai/gpt-5", "openai/gpt-4.1", "openai/gpt-4o",
-      "anthropic/claude-3.7-sonnet", "google/gemini-2.5-pro"};
-
-  if (discovered.empty()) {
-    p.notes = "No models discovered from AI Gateway.";
-    FinalizeMetrics(p);
-    return p;
+  struct InFlight {
+    std::size_t job = 0;
+    int attempt = 1;
+    long long paced_ms = 0;
+    RateLimiter *limiter = nullptr;
+    std::string url;
+    std::future<HttpResponse> response;
+  };
+  const auto window = static_cast<std::size_t>(
+      std::max(1, ctx.options.suite_max_in_flight));
+  std::deque<InFlight> pending;
+  std::deque<std::pair<std::size_t, int>> retry;  // job, next attempt
+  std::size_t next_job = 0;
+  RateLimiter *last_limiter = nullptr;
+  bool canceled = false;
+
+  SuiteResults &out = p.suites;
+  std::vector<std::optional<SuiteCaseResult>> slots(jobs.size());
+  for (;;) {
+    while (!canceled && pending.size() < window &&
+           (!retry.empty() || next_job < jobs.size())) {
+      if (ctx.cancel_requested.load()) {
+        canceled = true;
+        break;
+      }
+      InFlight f;
+      if (!retry.empty()) {
+        std::tie(f.job, f.attempt) = retry.front();
+        retry.pop_front();
+      } else {
+        f.job = next_job++;
+      }
+      const Job &job = jobs[f.job];
+      const auto req = BuildChatRequest(ep, models[job.model], job.c->prompt,
+                                        job.c->max_tokens);
+      f.url = req.url;
+      f.limiter = LimiterFor(p, req.url, ctx);
+      f.paced_ms = f.limiter
+                       ? f.limiter->Acquire(
+                             EstimateTokens(req.body, job.c->max_tokens),
+                             &ctx.cancel_requested)
+                       : 0;
+      LiveStart(ctx, p.provider_id);
+      f.response =
+          ctx.http.RequestAsync("POST", req.url, req.headers, req.body);
+      pending.push_back(std::move(f));
+    }
+    if (pending.empty())
+      break;
+
+    InFlight f = std::move(pending.front());
+    pending.pop_front();
+    HttpResponse resp = f.response.get();
+    LiveFinish(ctx, p.provider_id, resp);
+    if (f.limiter)
+      last_limiter = f.limiter;
+    const long long backoff_ms =
+        f.limiter ? f.limiter->Observe(resp.status, resp.headers) : 0;
+    const bool again = f.limiter &&
+                       f.limiter->ShouldRetry(resp.status, f.attempt) &&
+                       !ctx.cancel_requested.load();
+    const Job &job = jobs[f.job];
+    const std::string &model = models[job.model];
+    AddTrace(p, ctx, "suite:" + job.suite->name + "/" + job.c->id, "POST",
+             f.url, resp, again ? "" : model,
+             {f.attempt, f.paced_ms, again ? backoff_ms : 0, again});
+    if (again) {
+      retry.emplace_back(f.job, f.attempt + 1);
+      continue;
+    }
+    if (resp.error == "canceled") {
+      canceled = true;
+      continue;
+    }
+
+    const bool ok = resp.status >= 200 && resp.status < 300;
+    slots[f.job] = SuiteResult(
+        out, *job.suite, *job.c, model, resp.status, resp.latency_ms,
+        ok ? ep.extract_text(ParseJson(resp.body)) : resp.body);
   }
+  SyncRateLimit(p, last_limiter);
 
-  const auto checks = TopCandidates(discovered, preferred, 8);
-  std::vector<std::string> post_headers = headers;
-  post_headers.push_back("Content-Type: application/json");
+  for (auto &slot : slots) {
+    if (slot)
+      out.results.push_back(*slot);
+  }
+  if (canceled) {
+    p.notes += " Audit canceled by user.";
+    return false;
+  }
+  for (const auto &s : SummarizeSuites(out)) {
+    ctx.log("[" + p.provider_name + "] Suite " + s.suite + " on " + s.model +
+            ": " + std::to_string(s.points) + "/" +
+            std::to_string(s.max_points) + " points, " +
+            std::to_string(s.passed) + "/" + std::to_string(s.cases) +
+            " passed, latency_ms " + FormatLatencyMs(s.latency));
+  }
+  return true;
+}
 
-  for (const auto &model : checks) {
-    if (cancel_requested.load()) {
-      p.notes += " Audit canceled by user.";
-      FinalizeMetrics(p);
-      return p;
+// Sleeps for ms; returns false as soon as cancellation is requested.
+bool WaitCancelable(long long ms, const std::atomic<bool> &cancel) {
+  using namespace std::chrono;
+  const auto until = steady_clock::now() + milliseconds(ms);
+  while (!cancel.load()) {
+    const auto now = steady_clock::now();
+    if (now >= until)
+      return true;
+    std::this_thread::sleep_for(
+        std::min<steady_clock::duration>(until - now, milliseconds(100)));
+  }
+  return false;
+}
+
+// Batch mode: the model checks, and the prompt tests and suites for every
+// candidate, go into one input file per job (per model where the provider
+// takes the model per job). The jobs are polled until they finish, then
+// their output and error files are mapped back into ModelCheck, PromptTest
+// and suite results as if each request had been sent directly. Results for
+// models that fail their check are dropped. Returns false on cancellation.
+bool RunBatched(ProviderAudit &p, const ProviderSpec &spec,
+                const std::vector<std::string> &candidates,
+                const ChatModels &chat_models,
+                const std::vector<std::string> &auth_headers,
+                const ChatEndpoint &ep, const RunContext &ctx) {
+  constexpr int kCheckTokens = 64;
+  constexpr int kPromptTokens = 300;
+  constexpr long kFileTimeoutSeconds = 300;
+  const BatchOptions &options = ctx.options.batch;
+  const std::string tag = "[" + p.provider_name + "] ";
+  if (candidates.empty())
+    return true;
+  BatchEndpoint batch;
+  batch.style = spec.batch;
+  batch.base_url = spec.batch_url;
+
+  struct SuiteJob {
+    const PromptSuite *suite;
+    const PromptCase *c;
+  };
+  std::vector<SuiteJob> suite_jobs;
+  for (const auto &suite : ctx.options.prompt_suites) {
+    for (const auto &c : suite.cases)
+      suite_jobs.push_back({&suite, &c});
+  }
+  // Which models work is not known until the jobs finish, so the suite cap
+  // applies to the candidates; see AuditOptions::suite_max_models.
+  const std::size_t suite_models =
+      SuiteModels(candidates, ctx.options).size();
+
+  // custom_id is the request's position in this order: per model its check,
+  // its prompt tests, then its suite cases.
+  const std::size_t per_job = spec.batch == BatchStyle::kMistral ? 1 : 0;
+  std::vector<std::string> files(per_job ? candidates.size() : 1);
+  std::vector<BatchRun> runs(files.size());
+  std::vector<std::size_t> item_run;
+  constexpr std::size_t kNone = std::numeric_limits<std::size_t>::max();
+  std::vector<std::size_t> check_item(candidates.size(), kNone);
+  std::vector<std::size_t> prompt_item(candidates.size() * kPromptSuite.size(),
+                                       kNone);
+  std::vector<std::size_t> suite_item(suite_jobs.size() * suite_models, kNone);
+  auto add = [&](std::size_t m, const std::string &prompt, int max_tokens) {
+    const std::size_t g = per_job ? m : 0;
+    const std::size_t item = item_run.size();
+    item_run.push_back(g);
+    runs[g].requests += 1;
+    const auto req = BuildChatRequest(ep, candidates[m], prompt, max_tokens);
+    files[g] += BatchLine(batch, std::to_string(item), ParseJson(req.body));
+    files[g] += '\n';
+    return item;
+  };
+  for (std::size_t m = 0; m < candidates.size(); ++m) {
+    if (per_job)
+      runs[m].model = candidates[m];
+    check_item[m] = add(m, kProbePrompt, kCheckTokens);
+    for (std::size_t t = 0; t < kPromptSuite.size(); ++t)
+      prompt_item[m * kPromptSuite.size() + t] =
+          add(m, kPromptSuite[t].second, kPromptTokens);
+    if (m < suite_models) {
+      for (std::size_t j = 0; j < suite_jobs.size(); ++j)
+        suite_item[j * suite_models + m] =
+            add(m, suite_jobs[j].c->prompt, suite_jobs[j].c->max_tokens);
     }
-    nlohmann::json payload = {
-        {"model", model},
-        {"messages",
-         {{{"role", "user"}, {"content", "Reply with exactly: OK"}}}},
-        {"max_tokens", 64},
-    };
+  }
+  ctx.log(tag + "Submitting " + std::to_string(item_run.size()) +
+          " requests for " + std::to_string(candidates.size()) +
+          " models in " + std::to_string(runs.size()) + " batch job(s)");
+  if (ctx.options.live)
+    ctx.options.live->PlanModels(p.provider_id,
+                                 static_cast<int>(candidates.size()));
+
+  std::vector<std::string> json_headers = auth_headers;
+  json_headers.push_back("Content-Type: application/json");
+  auto send = [&](const std::string &step, const std::string &method,
+                  const std::string &url,
+                  const std::vector<std::string> &headers,
+                  const std::optional<std::string> &body,
+                  long timeout_seconds = 60) {
+    LiveStart(ctx, p.provider_id);
     const auto resp =
-        Request("POST", "https://ai-gateway.vercel.sh/v1/chat/completions",
-                post_headers, payload.dump());
-    AddTrace(p, "model_check:" + model, "POST",
-             "https://ai-gateway.vercel.sh/v1/chat/completions", resp);
+        ctx.http.Request(method, url, headers, body, timeout_seconds);
+    LiveFinish(ctx, p.provider_id, resp);
+    AddTrace(p, ctx, step, method, url, resp);
+    return resp;
+  };
+  auto ok = [](const HttpResponse &r) {
+    return r.status >= 200 && r.status < 300 && r.error.empty();
+  };
+
+  using Clock = std::chrono::steady_clock;
+  std::vector<BatchStatus> status(runs.size());
+  std::vector<Clock::time_point> created(runs.size());
+  std::vector<std::size_t> active;
+  for (std::size_t g = 0; g < runs.size(); ++g) {
+    BatchRun &run = runs[g];
+    if (ctx.cancel_requested.load())
+      break;
+    const auto upload = BatchUpload(
+        files[g], "llaudit_" + p.provider_id + "_" + std::to_string(g) +
+                      ".jsonl");
+    std::string().swap(files[g]);
+    std::vector<std::string> upload_headers = auth_headers;
+    upload_headers.push_back("Content-Type: " + upload.content_type);
+    const auto uploaded =
+        send("batch_upload", "POST", batch.FilesUrl(), upload_headers,
+             upload.body, kFileTimeoutSeconds);
+    run.upload_ms = uploaded.latency_ms;
+    const std::string file_id = UploadedFileId(ParseJson(uploaded.body));
+    if (!ok(uploaded) || file_id.empty()) {
+      run.status = "error";
+      run.error = "upload failed (" + std::to_string(uploaded.status) +
+                  "): " + Snippet(uploaded.error + uploaded.body);
+      continue;
+    }
 
+    const auto job = send(
+        "batch_create", "POST", batch.JobsUrl(), json_headers,
+        BatchCreateBody(batch, file_id, run.model, options.completion_window));
+    status[g] = ParseBatchStatus(batch, ParseJson(job.body));
+    run.id = status[g].id;
+    run.status = status[g].status;
+    if (!ok(job) || run.id.empty()) {
+      run.status = "error";
+      run.error = "create failed (" + std::to_string(job.status) +
+                  "): " + Snippet(job.error + job.body);
+      continue;
+    }
+    created[g] = Clock::now();
+    ctx.log(tag + "Batch " + run.id + " created with " +
+            std::to_string(run.requests) + " requests");
+    if (status[g].finished)
+      run.turnaround_ms = 0;
+    else
+      active.push_back(g);
+  }
+
+  long long delay_ms = options.poll_initial_ms;
+  bool canceled = ctx.cancel_requested.load();
+  while (!active.empty() && !canceled) {
+    if (!WaitCancelable(delay_ms, ctx.cancel_requested)) {
+      canceled = true;
+      break;
+    }
+    delay_ms = std::min(delay_ms * 2, std::max(options.poll_max_ms, 1LL));
+    std::vector<std::size_t> still;
+    for (const std::size_t g : active) {
+      BatchRun &run = runs[g];
+      const auto polled = send("batch_poll", "GET", batch.JobUrl(run.id),
+                               auth_headers, std::nullopt);
+      run.polls += 1;
+      const auto elapsed_ms =
+          std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() -
+                                                                created[g])
+              .count();
+      if (ok(polled)) {
+        status[g] = ParseBatchStatus(batch, ParseJson(polled.body));
+        run.status = status[g].status;
+      }
+      if (status[g].finished) {
+        run.turnaround_ms = elapsed_ms;
+        ctx.log(tag + "Batch " + run.id + " " + run.status + " after " +
+                std::to_string(elapsed_ms / 1000) + " s");
+      } else if (elapsed_ms >= options.timeout_seconds * 1000) {
+        send("batch_cancel", "POST", batch.CancelUrl(run.id), json_headers,
+             std::string("{}"));
+        run.status = "timeout";
+        run.turnaround_ms = elapsed_ms;
+        run.error = "still " + status[g].status + " after " +
+                    std::to_string(options.timeout_seconds) + " s";
+      } else {
+        still.push_back(g);
+      }
+    }
+    active = std::move(still);
+  }
+  if (canceled) {
+    // Jobs left running would still be billed.
+    for (const std::size_t g : active) {
+      send("batch_cancel", "POST", batch.CancelUrl(runs[g].id), json_headers,
+           std::string("{}"));
+      runs[g].status = "canceled";
+    }
+    p.batches = std::move(runs);
+    p.notes += " Audit canceled by user.";
+    return false;
+  }
+
+  std::vector<BatchItemResult> results;
+  for (std::size_t g = 0; g < runs.size(); ++g) {
+    for (const auto &[step, file_id] :
+         {std::pair{"batch_output", status[g].output_file_id},
+          std::pair{"batch_errors", status[g].error_file_id}}) {
+      if (file_id.empty())
+        continue;
+      const auto file = send(step, "GET", batch.FileContentUrl(file_id),
+                             auth_headers, std::nullopt, kFileTimeoutSeconds);
+      if (ok(file))
+        ParseBatchResults(file.body, results);
+      else if (runs[g].error.empty())
+        runs[g].error = std::string(step) + " download failed (" +
+                        std::to_string(file.status) + ")";
+    }
+    if (runs[g].error.empty() && !status[g].succeeded)
+      runs[g].error = status[g].error;
+  }
+
+  std::vector<const BatchItemResult *> by_item(item_run.size(), nullptr);
+  for (const auto &r : results) {
+    const auto item = std::strtoull(r.custom_id.c_str(), nullptr, 10);
+    if (item < by_item.size() && !by_item[item])
+      by_item[item] = &r;
+  }
+  for (std::size_t item = 0; item < by_item.size(); ++item) {
+    const BatchItemResult *r = by_item[item];
+    BatchRun &run = runs[item_run[item]];
+    if (r && r->status >= 200 && r->status < 300)
+      run.succeeded += 1;
+    else
+      run.failed += 1;
+  }
+  for (const auto &run : runs) {
+    if (ctx.options.metrics)
+      ctx.options.metrics->ObserveBatch(p.provider_id, run.model,
+                                        run.error.empty() && !run.id.empty(),
+                                        run.turnaround_ms);
+  }
+
+  // Status, answer and error text of one item, as a direct request gives.
+  struct Outcome {
+    long status = -1;
+    std::string text;
+    std::string error;
+  };
+  auto outcome = [&](std::size_t item) {
+    Outcome o;
+    const BatchItemResult *r = by_item[item];
+    if (!r) {
+      const BatchRun &run = runs[item_run[item]];
+      o.error = "No batch result (job " + run.status +
+                (run.error.empty() ? "" : ": " + run.error) + ")";
+      return o;
+    }
+    o.status = r->status;
+    if (o.status >= 200 && o.status < 300)
+      o.text = ep.extract_text(r->body);
+    else
+      o.error = !r->error.empty() ? r->error : r->body.dump();
+    return o;
+  };
+
+  for (std::size_t m = 0; m < candidates.size(); ++m) {
+    const Outcome o = outcome(check_item[m]);
     ModelCheck mc;
-    mc.model = model;
-    mc.status = resp.status;
-    mc.latency_ms = resp.latency_ms;
-    mc.error_snippet = Snippet(resp.body);
-    mc.working = (resp.status >= 200 && resp.status < 300 &&
-                  !ExtractOpenAIText(ParseJson(resp.body)).empty());
-    p.model_checks.push_back(mc);
-    if (mc.working)
-      p.working_models.push_back(model);
-    if (!mc.working)
-      p.failing_models.push_back(model);
+    mc.model = candidates[m];
+    mc.status = o.status;
+    mc.error_snippet = Snippet(o.error);
+    mc.working = o.status >= 200 && o.status < 300 && !o.text.empty();
+    AddModelCheck(p, std::move(mc), ctx);
+    if (ctx.options.live)
+      ctx.options.live->ModelProbed(p.provider_id);
   }
 
-  p.model_used = !p.working_models.empty() ? p.working_models.front()
-                                           : ChooseModel(discovered, preferred);
+  p.model_used = !p.working_models.empty()
+                     ? p.working_models.front()
+                     : ChooseModel(chat_models, spec.preferred_models);
+  const auto used = std::find(candidates.begin(), candidates.end(),
+                              p.model_used) -
+                    candidates.begin();
+  if (static_cast<std::size_t>(used) < candidates.size()) {
+    for (std::size_t t = 0; t < kPromptSuite.size(); ++t) {
+      const Outcome o =
+          outcome(prompt_item[static_cast<std::size_t>(used) *
+                                  kPromptSuite.size() +
+                              t]);
+      PromptTest test;
+      test.name = kPromptSuite[t].first;
+      test.status = o.status;
+      test.answer = Snippet(o.text, 1400);
+      test.error_snippet = Snippet(o.error, 700);
+      p.prompt_tests.push_back(std::move(test));
+    }
+  }
 
-  for (const auto &prompt : kPromptSuite) {
-    if (cancel_requested.load()) {
-      p.notes += " Audit canceled by user.";
-      FinalizeMetrics(p);
-      return p;
+  std::vector<bool> working(candidates.size());
+  for (std::size_t m = 0; m < candidates.size(); ++m)
+    working[m] = p.model_checks[p.model_checks.size() - candidates.size() + m]
+                     .working;
+  for (std::size_t j = 0; j < suite_jobs.size(); ++j) {
+    for (std::size_t m = 0; m < suite_models; ++m) {
+      if (!working[m])
+        continue;
+      const Outcome o = outcome(suite_item[j * suite_models + m]);
+      p.suites.results.push_back(
+          SuiteResult(p.suites, *suite_jobs[j].suite, *suite_jobs[j].c,
+                      candidates[m], o.status, -1,
+                      o.status >= 200 && o.status < 300 ? o.text : o.error));
     }
+  }
+  p.batches = std::move(runs);
+  return true;
+}
 
-    log("[Vercel] Prompt test: " + prompt.first);
-    nlohmann::json payload = {
-        {"model", p.model_used},
-        {"messages", {{{"role", "user"}, {"content", prompt.second}}}},
-        {"max_tokens", 300},
-    };
-    const auto resp =
-        Request("POST", "https://ai-gateway.vercel.sh/v1/chat/completions",
-                post_headers, payload.dump());
-    AddTrace(p, "prompt_test:" + prompt.first, "POST",
-             "https://ai-gateway.vercel.sh/v1/chat/completions", resp);
+struct BenchmarkSample {
+  long long scheduled_us = 0; // offset from the benchmark start
+  long long latency_us = 0;
+  long long paced_ms = 0;
+  HttpResponse response;
+};
 
-    PromptTest t;
-    t.name = prompt.first;
-    t.status = resp.status;
-    t.latency_ms = resp.latency_ms;
-    t.rate_limit_headers = RateLimitHeaders(resp.headers);
-    t.answer = Snippet(ExtractOpenAIText(ParseJson(resp.body)), 1400);
-    if (resp.status < 200 || resp.status >= 300)
-      t.error_snippet = Snippet(resp.body, 700);
-    p.prompt_tests.push_back(std::move(t));
+void SummarizeBenchmark(BenchmarkResult &b,
+                        std::vector<BenchmarkSample> &samples,
+                        long long window_us, double elapsed_s) {
+  std::sort(samples.begin(), samples.end(),
+            [](const BenchmarkSample &a, const BenchmarkSample &b) {
+              return a.scheduled_us < b.scheduled_us;
+            });
+
+  std::vector<LatencyHistogram> window_latency;
+  for (std::size_t i = 0; i < samples.size(); ++i) {
+    const auto &s = samples[i];
+    const auto &r = s.response;
+    const bool ok = r.error.empty() && r.status >= 200 && r.status < 300;
+    const std::size_t w = static_cast<std::size_t>(s.scheduled_us / window_us);
+    if (w >= b.windows.size()) {
+      b.windows.resize(w + 1);
+      window_latency.resize(w + 1);
+    }
+    auto &win = b.windows[w];
+
+    b.completed += 1;
+    b.status_counts[r.error.empty() ? r.status : -1] += 1;
+    b.latency.Record(s.latency_us);
+    window_latency[w].Record(s.latency_us);
+    win.sent += 1;
+    if (ok) {
+      b.succeeded += 1;
+    } else {
+      win.errors += 1;
+    }
+    if (r.status == 429) {
+      win.rate_limited += 1;
+      if (b.first_429_ms < 0) {
+        b.first_429_ms = s.scheduled_us / 1000;
+        b.sent_before_first_429 = static_cast<int>(i);
+        int recent = 0;
+        for (std::size_t j = 0; j < i; ++j) {
+          if (samples[j].scheduled_us >= s.scheduled_us - window_us)
+            recent += 1;
+        }
+        b.rps_at_first_429 = static_cast<double>(recent) * 1e6 /
+                             static_cast<double>(window_us);
+      }
+    }
+    auto limits = r.headers.RateLimitOnly();
+    if (!limits.empty())
+      b.last_rate_limit_headers = std::move(limits);
   }
 
-  ScoreProvider(p);
-  FinalizeMetrics(p);
-  return p;
+  for (std::size_t w = 0; w < b.windows.size(); ++w) {
+    b.windows[w].start_ms = static_cast<long long>(w) * window_us / 1000;
+    b.windows[w].p50_us = window_latency[w].Percentile(0.50);
+    b.windows[w].p99_us = window_latency[w].Percentile(0.99);
+  }
+  if (elapsed_s > 0)
+    b.achieved_rps = static_cast<double>(b.completed) / elapsed_s;
+  if (b.completed > 0)
+    b.error_rate = static_cast<double>(b.completed - b.succeeded) /
+                   static_cast<double>(b.completed);
 }
 
-ProviderAudit AuditGitHubToken(const std::string &provider_id,
-                               const std::string &provider_name,
-                               const std::string &token, const LogFn &log,
-                               const std::atomic<bool> &cancel_requested) {
-  ProviderAudit p;
-  p.provider_id = provider_id;
-  p.provider_name = provider_name;
-  p.api_key = token;
-  p.key_supplied = !token.empty();
-
-  if (token.empty()) {
-    p.notes = "No API key supplied.";
-    return p;
+// Drives one model at a fixed arrival rate (open loop) or a fixed number of
+// outstanding requests (closed loop) for a set duration.
+void RunBenchmark(ProviderAudit &p, const ChatEndpoint &ep,
+                  const RunContext &ctx) {
+  using namespace std::chrono;
+  const auto &o = ctx.options.benchmark;
+  if (!o.enabled || ctx.cancel_requested.load())
+    return;
+  if (!o.providers.empty() &&
+      std::find(o.providers.begin(), o.providers.end(), p.provider_id) ==
+          o.providers.end())
+    return;
+  const std::string model = o.model.empty() ? p.model_used : o.model;
+  if (model.empty())
+    return;
+
+  BenchmarkResult &b = p.benchmark;
+  b.ran = true;
+  b.model = model;
+  b.mode = o.target_rps > 0 ? "open_loop" : "closed_loop";
+  b.target_rps = o.target_rps > 0 ? o.target_rps : 0.0;
+  b.concurrency = o.target_rps > 0 ? 0 : std::max(o.concurrency, 1);
+  b.duration_seconds = std::max(o.duration_seconds, 1);
+  const long long window_us =
+      static_cast<long long>(std::max(o.window_seconds, 1)) * 1000000;
+
+  const auto req = BuildChatRequest(ep, model, kProbePrompt, o.max_tokens);
+  const long long token_cost = EstimateTokens(req.body, o.max_tokens);
+  RateLimiter *limiter = LimiterFor(p, req.url, ctx);
+  // Left raised for the rest of the run: several providers can share a host
+  // and benchmark it at the same time.
+  ctx.http.SetHostLimit(HostOf(req.url),
+                        std::max({o.max_in_flight, b.concurrency,
+                                  ctx.options.max_in_flight_per_host}));
+
+  if (b.mode == "open_loop") {
+    std::ostringstream rps;
+    rps << b.target_rps;
+    ctx.log("[" + p.provider_name + "] Benchmark: " + rps.str() + " rps for " +
+            std::to_string(b.duration_seconds) + "s on " + model);
+  } else {
+    ctx.log("[" + p.provider_name + "] Benchmark: " +
+            std::to_string(b.concurrency) + " concurrent for " +
+            std::to_string(b.duration_seconds) + "s on " + model);
   }
 
-  const std::vector<std::string> gh_headers = {
-      "Authorization: Bearer " + token,
-      "Accept: application/vnd.github+json",
+  std::mutex mutex;
+  std::condition_variable all_done;
+  std::vector<BenchmarkSample> samples;
+  int outstanding = 0;
+
+  const auto start = steady_clock::now();
+  const auto end = start + seconds(b.duration_seconds);
+  auto since_start_us = [start](steady_clock::time_point t) {
+    return duration_cast<microseconds>(t - start).count();
   };
 
-  log("[" + provider_name + "] Validating GitHub user scope");
-  const auto user_resp =
-      Request("GET", "https://api.github.com/user", gh_headers, std::nullopt);
-  AddTrace(p, "auth_user", "GET", "https://api.github.com/user", user_resp);
-  p.auth_status = user_resp.status;
-  p.auth_latency_ms = user_resp.latency_ms;
-  p.auth_rate_limit_headers = RateLimitHeaders(user_resp.headers);
+  if (b.mode == "open_loop") {
+    const double interval_us = 1e6 / b.target_rps;
+    for (long long i = 0;; ++i) {
+      const auto scheduled =
+          start + microseconds(static_cast<long long>(interval_us * i));
+      if (scheduled >= end || ctx.cancel_requested.load())
+        break;
+      std::this_thread::sleep_until(scheduled);
+      const long long scheduled_us = since_start_us(scheduled);
+      const long long paced_ms =
+          limiter ? limiter->Acquire(token_cost, &ctx.cancel_requested) : 0;
+      {
+        std::scoped_lock lock(mutex);
+        outstanding += 1;
+      }
+      b.sent += 1;
+      LiveStart(ctx, p.provider_id);
+      // Latency runs from the scheduled send time, so a request held back by
+      // the rate limiter or the transport's queue is charged for the wait.
+      auto on_done = [&, scheduled_us, paced_ms](HttpResponse r) {
+        const long long now_us = since_start_us(steady_clock::now());
+        LiveFinish(ctx, p.provider_id, r);
+        if (limiter)
+          limiter->Observe(r.status, r.headers);
+        std::scoped_lock lock(mutex);
+        samples.push_back(
+            {scheduled_us, now_us - scheduled_us, paced_ms, std::move(r)});
+        outstanding -= 1;
+        all_done.notify_all();
+      };
+      ctx.http.RequestAsync("POST", req.url, req.headers, req.body,
+                            std::move(on_done));
+    }
+    std::unique_lock lock(mutex);
+    all_done.wait(lock, [&] { return outstanding == 0; });
+  } else {
+    std::atomic<int> sent{0};
+    std::vector<std::thread> users;
+    users.reserve(static_cast<std::size_t>(b.concurrency));
+    for (int u = 0; u < b.concurrency; ++u) {
+      users.emplace_back([&] {
+        while (steady_clock::now() < end && !ctx.cancel_requested.load()) {
+          const long long paced_ms =
+              limiter ? limiter->Acquire(token_cost, &ctx.cancel_requested)
+                      : 0;
+          const auto sent_at = steady_clock::now();
+          sent.fetch_add(1);
+          LiveStart(ctx, p.provider_id);
+          auto r = ctx.http.Request("POST", req.url, req.headers, req.body);
+          LiveFinish(ctx, p.provider_id, r);
+          const long long latency_us =
+              duration_cast<microseconds>(steady_clock::now() - sent_at)
+                  .count();
+          if (limiter)
+            limiter->Observe(r.status, r.headers);
+          std::scoped_lock lock(mutex);
+          samples.push_back({since_start_us(sent_at), latency_us, paced_ms,
+                             std::move(r)});
+        }
+      });
+    }
+    for (auto &u : users)
+      u.join();
+    b.sent = sent.load();
+  }
+
+  const double elapsed_s =
+      static_cast<double>(since_start_us(steady_clock::now())) / 1e6;
+  samples.erase(std::remove_if(samples.begin(), samples.end(),
+                               [](const BenchmarkSample &s) {
+                                 return s.response.error == "canceled";
+                               }),
+                samples.end());
+  SummarizeBenchmark(b, samples, window_us, elapsed_s);
+  for (const auto &s : samples)
+    AddTrace(p, ctx, "benchmark", "POST", req.url, s.response, {},
+             {1, s.paced_ms, 0, false});
+  SyncRateLimit(p, limiter);
+
+  if (ctx.cancel_requested.load())
+    b.notes = "Benchmark canceled by user.";
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(2) << b.achieved_rps;
+  ctx.log("[" + p.provider_name + "] Benchmark done: " +
+          std::to_string(b.completed) + " completed, " + oss.str() +
+          " rps, " + std::to_string(b.completed - b.succeeded) + " errors");
+}
+
+std::string WithKey(std::string text, const std::string &key) {
+  for (auto pos = text.find("{key}"); pos != std::string::npos;
+       pos = text.find("{key}", pos + key.size()))
+    text.replace(pos, 5, key);
+  return text;
+}
 
-  const std::vector<std::string> models_headers = {
-      "Authorization: Bearer " + token,
-  };
-  log("[" + provider_name + "] Fetching GitHub Models catalog");
-  const auto list_resp =
-      Request("GET", "https://models.inference.ai.azure.com/models",
-              models_headers, std::nullopt);
-  AddTrace(p, "list_models", "GET",
-           "https://models.inference.ai.azure.com/models", list_resp);
-
-  p.models_status = list_resp.status;
-  p.models_latency_ms = list_resp.latency_ms;
-  p.models_rate_limit_headers = RateLimitHeaders(list_resp.headers);
-  if (list_resp.status < 200 || list_resp.status >= 300)
-    p.error_snippet = Snippet(list_resp.body);
-
-  const auto list_json = ParseJson(list_resp.body);
-  p.raw_payload["user_response"] = ParseJson(user_resp.body);
-  p.raw_payload["models_response"] = list_json;
-
-  auto discovered = ExtractModelIds(list_json);
-  p.sample_models.assign(
-      discovered.begin(),
-      discovered.begin() +
-          static_cast<long>(std::min<std::size_t>(discovered.size(), 30)));
-  p.max_context_seen = ExtractMaxContext(list_json);
-  p.capability_tags = ExtractCapabilities(discovered, list_json);
+CatalogShape ShapeOf(ChatFormat format) {
+  switch (format) {
+  case ChatFormat::kGoogle:
+    return CatalogShape::kGoogle;
+  case ChatFormat::kCohere:
+    return CatalogShape::kCohere;
+  case ChatFormat::kOpenAI:
+    break;
+  }
+  return CatalogShape::kGeneric;
+}
 
-  const std::vector<std::string> preferred = {
-      "gpt-4.1", "gpt-4o", "gpt-4o-mini", "deepseek-r1", "phi-4"};
+// The one audit pipeline every registry entry runs through: optional token
+// check, model list, model probes, prompt tests, workspace suites and
+// benchmark.
+ProviderAudit AuditProvider(const ProviderSpec &spec,
+                            const ProviderKey &credential,
+                            const RunContext &ctx) {
+  const std::string &key = credential.key;
+  ProviderAudit p = StartAudit(spec.id, spec.name, credential, ctx);
 
-  if (discovered.empty()) {
-    p.notes = "No models discovered for this token.";
-    FinalizeMetrics(p);
+  if (key.empty()) {
+    p.notes = "No API key supplied.";
     return p;
   }
 
-  const auto checks = TopCandidates(discovered, preferred, 8);
-  std::vector<std::string> post_headers = models_headers;
-  post_headers.push_back("Content-Type: application/json");
+  const std::string tag = "[" + spec.name + "] ";
+  std::vector<std::string> headers;
+  if (spec.auth == AuthStyle::kBearer)
+    headers.push_back("Authorization: Bearer " + key);
+  for (const auto &h : spec.headers)
+    headers.push_back(WithKey(h, key));
+
+  if (!spec.check_url.empty()) {
+    const std::string url = WithKey(spec.check_url, key);
+    std::vector<std::string> check_headers = headers;
+    check_headers.insert(check_headers.end(), spec.check_headers.begin(),
+                         spec.check_headers.end());
+    ctx.log(tag + "Validating token");
+    LiveStart(ctx, p.provider_id);
+    const auto resp = ctx.http.Request("GET", url, check_headers, std::nullopt);
+    LiveFinish(ctx, p.provider_id, resp);
+    AddTrace(p, ctx, "auth_user", "GET", url, resp);
+    p.auth_status = resp.status;
+    p.auth_latency_ms = resp.latency_ms;
+    p.auth_rate_limit_headers = resp.headers.RateLimitOnly();
+    if (ctx.options.keep_raw_payload)
+      p.raw_payload["auth_response"] = ParseJson(resp.body);
+  }
+
+  ctx.log(tag + "Fetching model list");
+  ChatModels chat_models;
+  chat_models.catalog = LoadCatalog(p, WithKey(spec.list_url, key), headers,
+                                    ShapeOf(spec.format), ctx);
+  std::vector<bool> excluded(chat_models.catalog->size());
+  for (const auto &x : spec.exclude_models) {
+    for (const auto id : chat_models.catalog->Containing(x))
+      excluded[id] = true;
+  }
+  for (ModelIndex::Id id = 0; id < excluded.size(); ++id) {
+    if (!excluded[id])
+      chat_models.ids.push_back(id);
+  }
+  if (chat_models.ids.empty()) {
+    p.notes = spec.no_models_note;
+    FinalizeMetrics(p);
+    return p;
+  }
 
-  for (const auto &model : checks) {
-    if (cancel_requested.load()) {
-      p.notes += " Audit canceled by user.";
+  ChatEndpoint chat;
+  chat.format = spec.format;
+  chat.url = WithKey(spec.chat_url, key);
+  if (!spec.stream_url.empty())
+    chat.stream_url = WithKey(spec.stream_url, key);
+  chat.headers = headers;
+  chat.headers.push_back("Content-Type: application/json");
+  chat.send_temperature = spec.send_temperature;
+  if (spec.format == ChatFormat::kGoogle)
+    chat.extract_text = ExtractGoogleText;
+  else if (spec.format == ChatFormat::kCohere)
+    chat.extract_text = ExtractCohereText;
+  if (spec.max_in_flight > 0)
+    ctx.http.SetHostLimit(HostOf(chat.url), spec.max_in_flight);
+
+  const auto checks = TopCandidates(chat_models, spec.preferred_models, 8);
+  if (ctx.options.batch.enabled && spec.batch != BatchStyle::kNone) {
+    if (!RunBatched(p, spec, checks, chat_models, headers, chat, ctx)) {
       FinalizeMetrics(p);
       return p;
     }
-
-    nlohmann::json payload = {
-        {"model", model},
-        {"messages",
-         {{{"role", "user"}, {"content", "Reply with exactly: OK"}}}},
-        {"temperature", 0},
-        {"max_tokens", 64},
-    };
-
-    const auto resp = Request(
-        "POST", "https://models.inference.ai.azure.com/chat/completions",
-        post_headers, payload.dump());
-    AddTrace(p, "model_check:" + model, "POST",
-             "https://models.inference.ai.azure.com/chat/completions", resp);
-
-    ModelCheck mc;
-    mc.model = model;
-    mc.status = resp.status;
-    mc.latency_ms = resp.latency_ms;
-    mc.error_snippet = Snippet(resp.body);
-    mc.working = (resp.status >= 200 && resp.status < 300 &&
-                  !ExtractOpenAIText(ParseJson(resp.body)).empty());
-    p.model_checks.push_back(mc);
-    if (mc.working)
-      p.working_models.push_back(model);
-    if (!mc.working)
-      p.failing_models.push_back(model);
-  }
-
-  p.model_used = !p.working_models.empty() ? p.working_models.front()
-                                           : ChooseModel(discovered, preferred);
-
-  for (const auto &prompt : kPromptSuite) {
-    if (cancel_requested.load()) {
-      p.notes += " Audit canceled by user.";
+  } else {
+    if (!RunModelChecks(p, checks, chat, ctx)) {
       FinalizeMetrics(p);
       return p;
     }
 
-    log("[" + provider_name + "] Prompt test: " + prompt.first);
-    nlohmann::json payload = {
-        {"model", p.model_used},
-        {"messages", {{{"role", "user"}, {"content", prompt.second}}}},
-        {"temperature", 0},
-        {"max_tokens", 300},
-    };
-
-    const auto resp = Request(
-        "POST", "https://models.inference.ai.azure.com/chat/completions",
-        post_headers, payload.dump());
-    AddTrace(p, "prompt_test:" + prompt.first, "POST",
-             "https://models.inference.ai.azure.com/chat/completions", resp);
+    p.model_used = !p.working_models.empty()
+                       ? p.working_models.front()
+                       : ChooseModel(chat_models, spec.preferred_models);
 
-    PromptTest t;
-    t.name = prompt.first;
-    t.status = resp.status;
-    t.latency_ms = resp.latency_ms;
-    t.rate_limit_headers = RateLimitHeaders(resp.headers);
-    t.answer = Snippet(ExtractOpenAIText(ParseJson(resp.body)), 1400);
-    if (resp.status < 200 || resp.status >= 300)
-      t.error_snippet = Snippet(resp.body, 700);
-    p.prompt_tests.push_back(std::move(t));
+    if (!RunPromptSuite(p, chat, ctx) || !RunSuites(p, chat, ctx)) {
+      FinalizeMetrics(p);
+      return p;
+    }
   }
+  RunBenchmark(p, chat, ctx);
 
   ScoreProvider(p);
   FinalizeMetrics(p);
@@ -1425,193 +2187,301 @@ ProviderAudit AuditGitHubToken(const std::string &provider_id,
 
 } // namespace
 
+std::vector<ProviderKey> ParseKeyList(const std::string &text) {
+  std::vector<ProviderKey> out;
+  std::set<std::string> seen;
+  std::string token;
+  auto flush = [&] {
+    if (token.empty())
+      return;
+    ProviderKey k;
+    const auto at = token.rfind('@');
+    if (at != std::string::npos && at > 0) {
+      k.key = token.substr(0, at);
+      k.tier = token.substr(at + 1);
+    } else {
+      k.key = token;
+    }
+    if (seen.insert(k.key).second)
+      out.push_back(std::move(k));
+    token.clear();
+  };
+  for (const char c : text) {
+    if (c == ',' || c == ';' || std::isspace(static_cast<unsigned char>(c)))
+      flush();
+    else
+      token += c;
+  }
+  flush();
+  return out;
+}
+
+std::string Snippet(const std::string &s, std::size_t limit) {
+  if (s.size() <= limit)
+    return s;
+  return s.substr(0, limit);
+}
+
+ModelCatalog AnalyzeCatalog(ChatFormat format, std::string_view body) {
+  CatalogCollector collector(ShapeOf(format));
+  JsonStreamParser parser(collector);
+  parser.Feed(body);
+  return collector.Take(parser.Finish());
+}
+
+AuditEngine::AuditEngine(AuditOptions options) : options_(options) {}
+
 AuditReport AuditEngine::Run(const std::map<std::string, std::string> &keys,
                              const LogFn &log,
-                             const std::atomic<bool> &cancel_requested) {
+                             const std::atomic<bool> &cancel_requested,
+                             const RecordFn &record) {
+  KeyPools pools;
+  for (const auto &[provider_id, key] : keys)
+    pools[provider_id] = {ProviderKey{key, ""}};
+  return Run(pools, log, cancel_requested, record);
+}
+
+AuditReport AuditEngine::Run(const KeyPools &keys, const LogFn &log,
+                             const std::atomic<bool> &cancel_requested,
+                             const RecordFn &record) {
   AuditReport report;
   report.generated_at_utc = NowUtc();
 
-#if !defined(_WIN32)
-  curl_global_init(CURL_GLOBAL_DEFAULT);
-#endif
-
-  auto push_log = [&](const std::string &message) {
+  std::mutex log_mutex;
+  BoundedLog run_log(options_.max_run_log_lines);
+  const LogFn push_log = [&](const std::string &message) {
     const std::string line = "[" + NowUtc() + "] " + message;
-    report.run_logs.push_back(line);
+    std::scoped_lock lock(log_mutex);
     if (log)
       log(line);
-  };
-
-  auto key_of = [&](const std::string &k) {
-    const auto it = keys.find(k);
-    if (it == keys.end())
-      return std::string{};
-    return it->second;
+    run_log.Push(line);
   };
 
   if (cancel_requested.load()) {
     push_log("Audit canceled before start.");
-#if !defined(_WIN32)
-    curl_global_cleanup();
-#endif
+    report.run_logs = run_log.Take();
     return report;
   }
 
   push_log("Starting full provider audit");
+  if (options_.metrics)
+    options_.metrics->RunStarted();
+
+  std::mutex record_mutex;
+  const RecordFn push_record =
+      record ? RecordFn([&](const nlohmann::json &r) {
+        std::scoped_lock lock(record_mutex);
+        record(r);
+      })
+             : RecordFn();
+
+  ResponseStore responses(options_.record_dir, options_.record_mode);
+  if (options_.record_mode == RecordMode::kReplay)
+    push_log("Replaying " + std::to_string(responses.size()) +
+             " recorded responses from " + options_.record_dir);
+  else if (options_.record_mode == RecordMode::kRecord)
+    push_log("Recording responses to " + options_.record_dir);
+  if (const auto error = responses.error(); !error.empty())
+    push_log("Response store: " + error);
+  HttpClient http(options_.max_in_flight_per_host, &cancel_requested);
+  http.SetResponseStore(&responses, options_.replay_latency);
+  RateLimiterPool rate_limits(options_.rate_limit);
+  CatalogCache catalogs;
+  const CatalogStore catalog_store(options_.catalog_cache_dir);
+  const RunContext ctx{push_log,      cancel_requested, http,
+                       options_,      rate_limits,      catalogs,
+                       catalog_store, push_record};
+
+  const std::vector<ProviderSpec> &providers =
+      options_.providers.empty() ? BuiltinProviders() : options_.providers;
+
+  const CheckpointStore checkpoints(options_.checkpoint_dir);
+  const auto resume = [&](const std::string &provider_id,
+                          const ProviderKey &key,
+                          const std::string &signature, std::size_t k)
+      -> std::optional<ProviderAudit> {
+    if (!options_.resume || key.key.empty())
+      return std::nullopt;
+    auto saved = checkpoints.Load(provider_id, key.key, options_.traces);
+    if (!saved)
+      return std::nullopt;
+    const long long age = UnixNow() - saved->saved_at;
+    if (saved->signature != signature || age < 0 ||
+        age > options_.checkpoint_ttl_seconds || !Reusable(saved->audit))
+      return std::nullopt;
+    push_log("Reusing checkpoint for " + provider_id + " key #" +
+             std::to_string(k + 1) + " (" + std::to_string(age) + "s old)");
+    saved->audit.api_key = key.key;
+    saved->audit.checkpoint_saved_at = saved->saved_at;
+    return std::move(saved->audit);
+  };
+
+  // One job per key, listed in report order; results are slotted back by
+  // index so the order stays the same regardless of which worker finishes
+  // first. A provider without keys still gets its "no key" record.
+  std::vector<std::function<ProviderAudit()>> jobs;
+  for (const auto &spec : providers) {
+    const std::string &provider_id = spec.id;
+    std::vector<ProviderKey> pool;
+    if (const auto it = keys.find(provider_id); it != keys.end())
+      pool = it->second;
+    if (pool.empty())
+      pool.emplace_back();
+    if (pool.size() > 1)
+      push_log("Auditing " + std::to_string(pool.size()) + " keys for " +
+               provider_id);
+    for (std::size_t k = 0; k < pool.size(); ++k) {
+      jobs.push_back([&, id = provider_id, &spec = spec, key = pool[k], k] {
+        const std::string signature = ProbeSignature(id, key, options_);
+        if (auto reused = resume(id, key, signature, k)) {
+          reused->key_index = static_cast<int>(k);
+          return std::move(*reused);
+        }
+        ProviderAudit p = AuditProvider(spec, key, ctx);
+        p.key_index = static_cast<int>(k);
+        // A key cut short by cancellation is not a result worth keeping.
+        if (checkpoints.enabled() && p.key_supplied &&
+            !cancel_requested.load() &&
+            !checkpoints.Save(p, signature, UnixNow()))
+          push_log("Could not save checkpoint for " + id + " key #" +
+                   std::to_string(k + 1));
+        return p;
+      });
+    }
+  }
 
-  report.providers.push_back(AuditOpenAICompatible(
-      "openrouter", "OpenRouter", key_of("openrouter"),
-      "https://openrouter.ai/api/v1/models",
-      "https://openrouter.ai/api/v1/chat/completions",
-      {"openai/gpt-4.1", "openai/gpt-4o", "anthropic/claude-3.7-sonnet",
-       "google/gemini-2.5-pro"},
-      {}, push_log, cancel_requested));
-
-  if (!cancel_requested.load()) {
-    report.providers.push_back(
-        AuditGoogle(key_of("google_ai_studio"), push_log, cancel_requested));
-  }
-  if (!cancel_requested.load()) {
-    report.providers.push_back(AuditOpenAICompatible(
-        "mistral", "Mistral", key_of("mistral"),
-        "https://api.mistral.ai/v1/models",
-        "https://api.mistral.ai/v1/chat/completions",
-        {"mistral-large-latest", "magistral-medium-latest",
-         "mistral-medium-latest", "mistral-small-latest"},
-        {}, push_log, cancel_requested));
-  }
-  if (!cancel_requested.load()) {
-    report.providers.push_back(
-        AuditVercel(key_of("vercel"), push_log, cancel_requested));
-  }
-  if (!cancel_requested.load()) {
-    report.providers.push_back(AuditOpenAICompatible(
-        "groq", "Groq", key_of("groq"), "https://api.groq.com/openai/v1/models",
-        "https://api.groq.com/openai/v1/chat/completions",
-        {"llama-3.3-70b-versatile", "deepseek-r1-distill-llama-70b",
-         "qwen/qwen3-32b"},
-        {}, push_log, cancel_requested));
-  }
-  if (!cancel_requested.load()) {
-    report.providers.push_back(
-        AuditCohere(key_of("cohere"), push_log, cancel_requested));
-  }
-  if (!cancel_requested.load()) {
-    report.providers.push_back(AuditOpenAICompatible(
-        "ai21", "AI21", key_of("ai21"), "https://api.ai21.com/studio/v1/models",
-        "https://api.ai21.com/studio/v1/chat/completions",
-        {"jamba-1.5-large", "jamba-large", "jamba-1.5-mini", "jamba-mini"}, {},
-        push_log, cancel_requested));
-  }
-  if (!cancel_requested.load()) {
-    report.providers.push_back(
-        AuditGitHubToken("github_chatgpt", "GitHub PAT (chatgpt)",
-                         key_of("github_chatgpt"), push_log, cancel_requested));
-  }
-  if (!cancel_requested.load()) {
-    report.providers.push_back(AuditGitHubToken(
-        "github_chatgpt5", "GitHub PAT (chatgpt5)", key_of("github_chatgpt5"),
-        push_log, cancel_requested));
-  }
-  if (!cancel_requested.load()) {
-    report.providers.push_back(AuditGitHubToken(
-        "github_deepseek", "GitHub PAT (deepseek)", key_of("github_deepseek"),
-        push_log, cancel_requested));
-  }
-  if (!cancel_requested.load()) {
-    report.providers.push_back(
-        AuditGitHubToken("github_jamba", "GitHub PAT (jamba)",
-                         key_of("github_jamba"), push_log, cancel_requested));
+  if (push_record)
+    push_record({{"type", "run_start"},
+                 {"generated_at_utc", report.generated_at_utc},
+                 {"keys", jobs.size()}});
+
+  std::vector<std::optional<ProviderAudit>> results(jobs.size());
+  std::vector<std::exception_ptr> errors(jobs.size());
+  std::atomic<std::size_t> next_job{0};
+
+  auto work = [&]() {
+    for (;;) {
+      const std::size_t i = next_job.fetch_add(1);
+      if (i >= jobs.size() || cancel_requested.load())
+        return;
+      try {
+        results[i] = jobs[i]();
+        if (push_record)
+          RecordProvider(*results[i], push_record);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    }
+  };
+
+  const std::size_t worker_count =
+      options_.parallel
+          ? std::clamp<std::size_t>(
+                static_cast<std::size_t>(std::max(options_.max_workers, 1)), 1,
+                jobs.size())
+          : 1;
+  if (worker_count <= 1) {
+    work();
+  } else {
+    push_log("Running providers in parallel with " +
+             std::to_string(worker_count) + " workers");
+    std::vector<std::thread> workers;
+    workers.reserve(worker_count);
+    for (std::size_t i = 0; i < worker_count; ++i)
+      workers.emplace_back(work);
+    for (auto &w : workers)
+      w.join();
+  }
+
+  for (const auto &e : errors) {
+    if (!e)
+      continue;
+    if (options_.metrics)
+      options_.metrics->RunFinished(false, UnixNow());
+    std::rethrow_exception(e);
+  }
+
+  for (auto &r : results) {
+    if (r)
+      report.providers.push_back(std::move(*r));
   }
 
+  report.pools = SummarizePools(report.providers);
+
+  if (options_.record_mode == RecordMode::kRecord) {
+    push_log("Recorded " + std::to_string(responses.size()) + " responses");
+    if (const auto error = responses.error(); !error.empty())
+      push_log("Response store: " + error);
+  }
   if (cancel_requested.load()) {
     push_log("Audit ended early due to cancellation request.");
   } else {
     push_log("Audit completed.");
   }
 
-#if !defined(_WIN32)
-  curl_global_cleanup();
-#endif
+  if (options_.metrics)
+    options_.metrics->RunFinished(!cancel_requested.load(), UnixNow());
+  if (push_record)
+    push_record({{"type", "run_end"},
+                 {"canceled", cancel_requested.load()},
+                 {"providers", report.providers.size()}});
+  report.run_logs = run_log.Take();
   return report;
 }
 
-nlohmann::json ReportToJson(const AuditReport &report) {
-  nlohmann::json out;
-  out["generated_at_utc"] = report.generated_at_utc;
-  out["run_logs"] = report.run_logs;
-  out["providers"] = nlohmann::json::array();
-
-  for (const auto &p : report.providers) {
-    nlohmann::json pj;
-    pj["provider_id"] = p.provider_id;
-    pj["provider_name"] = p.provider_name;
-    pj["api_key"] = p.api_key;
-    pj["key_supplied"] = p.key_supplied;
-    pj["auth_status"] = p.auth_status;
-    pj["models_status"] = p.models_status;
-    pj["auth_latency_ms"] = p.auth_latency_ms;
-    pj["models_latency_ms"] = p.models_latency_ms;
-    pj["auth_rate_limit_headers"] = p.auth_rate_limit_headers;
-    pj["models_rate_limit_headers"] = p.models_rate_limit_headers;
-    pj["sample_models"] = p.sample_models;
-    pj["capability_tags"] = p.capability_tags;
-    pj["working_models"] = p.working_models;
-    pj["failing_models"] = p.failing_models;
-    pj["model_used"] = p.model_used;
-    pj["max_context_seen"] = p.max_context_seen;
-    pj["score_reasoning"] = p.score_reasoning;
-    pj["score_coding"] = p.score_coding;
-    pj["score_axui"] = p.score_axui;
-    pj["score_total"] = p.score_total;
-    pj["total_requests"] = p.total_requests;
-    pj["successful_requests"] = p.successful_requests;
-    pj["failed_requests"] = p.failed_requests;
-    pj["avg_latency_ms"] = p.avg_latency_ms;
-    pj["notes"] = p.notes;
-    pj["error_snippet"] = p.error_snippet;
-
-    pj["model_checks"] = nlohmann::json::array();
-    for (const auto &c : p.model_checks) {
-      pj["model_checks"].push_back({
-          {"model", c.model},
-          {"status", c.status},
-          {"latency_ms", c.latency_ms},
-          {"working", c.working},
-          {"error_snippet", c.error_snippet},
-      });
-    }
-
-    pj["prompt_tests"] = nlohmann::json::array();
-    for (const auto &t : p.prompt_tests) {
-      pj["prompt_tests"].push_back({
-          {"name", t.name},
-          {"status", t.status},
-          {"latency_ms", t.latency_ms},
-          {"rate_limit_headers", t.rate_limit_headers},
-          {"answer", t.answer},
-          {"error_snippet", t.error_snippet},
-      });
-    }
+std::string FormatLatencyMs(const LatencyHistogram &h) {
+  if (h.count() == 0)
+    return "n/a";
+  auto ms = [](long long us) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1)
+        << static_cast<double>(us) / 1000.0;
+    return oss.str();
+  };
+  return "p50=" + ms(h.Percentile(0.50)) + " p90=" + ms(h.Percentile(0.90)) +
+         " p99=" + ms(h.Percentile(0.99)) + " min=" + ms(h.min()) +
+         " max=" + ms(h.max()) + " (n=" + std::to_string(h.count()) + ")";
+}
 
-    pj["request_traces"] = nlohmann::json::array();
-    for (const auto &tr : p.request_traces) {
-      pj["request_traces"].push_back({
-          {"step", tr.step},
-          {"method", tr.method},
-          {"url", tr.url},
-          {"status", tr.status},
-          {"latency_ms", tr.latency_ms},
-          {"rate_limit_headers", tr.rate_limit_headers},
-          {"response_snippet", tr.response_snippet},
-          {"error", tr.error},
-      });
+std::vector<SuiteSummary> SummarizeSuites(const SuiteResults &suites) {
+  std::vector<SuiteSummary> out;
+  std::map<std::pair<StringInterner::Id, StringInterner::Id>, std::size_t>
+      index;
+  for (const auto &r : suites.results) {
+    const auto [it, added] = index.try_emplace({r.suite, r.model}, out.size());
+    if (added) {
+      SuiteSummary s;
+      s.suite = suites.names.Get(r.suite);
+      s.model = suites.names.Get(r.model);
+      out.push_back(std::move(s));
     }
-
-    pj["raw_payload"] = p.raw_payload;
-    out["providers"].push_back(std::move(pj));
+    SuiteSummary &s = out[it->second];
+    s.cases += 1;
+    s.points += r.points;
+    s.max_points += r.max_points;
+    if (r.status < 200 || r.status >= 300)
+      s.failed_requests += 1;
+    else if (r.points >= r.max_points)
+      s.passed += 1;
+    if (r.latency_ms >= 0)
+      s.latency.Record(r.latency_ms * 1000LL);
   }
+  return out;
+}
 
+std::vector<KeyPoolSummary>
+SummarizePools(const std::vector<ProviderAudit> &providers) {
+  std::vector<KeyPoolSummary> out;
+  for (std::size_t i = 0; i < providers.size();) {
+    std::vector<const ProviderAudit *> pool;
+    const ProviderAudit &first = providers[i];
+    for (; i < providers.size() &&
+           providers[i].provider_id == first.provider_id &&
+           providers[i].region == first.region;
+         ++i)
+      pool.push_back(&providers[i]);
+    out.push_back(SummarizePool(pool));
+  }
   return out;
 }
 
@@ -1620,11 +2490,50 @@ std::string BuildSummaryText(const AuditReport &report) {
   oss << "API-Tester Audit Summary\n";
   oss << "Generated at (UTC): " << report.generated_at_utc << "\n\n";
 
+  std::set<std::string> pooled;
+  for (const auto &pool : report.pools) {
+    if (pool.keys_total <= 1)
+      continue;
+    if (pooled.empty())
+      oss << "Key pools:\n";
+    pooled.insert(pool.provider_id);
+    oss << "  " << pool.provider_name;
+    if (!pool.region.empty())
+      oss << " [" << pool.region << "]";
+    oss << ": " << pool.keys_healthy << "/"
+        << pool.keys_total << " keys healthy";
+    if (pool.keys_reporting_quota > 0)
+      oss << " | remaining requests " << pool.remaining_requests
+          << ", tokens " << pool.remaining_tokens << " (from "
+          << pool.keys_reporting_quota << " keys)";
+    oss << " | working models " << pool.working_models.size() << "\n";
+    for (const auto &k : pool.unhealthy_keys)
+      oss << "    unhealthy: " << k << "\n";
+  }
+  if (!pooled.empty())
+    oss << "\n";
+
   for (const auto &p : report.providers) {
     oss << "Provider: " << p.provider_name << " (" << p.provider_id << ")\n";
     oss << "Key supplied: " << (p.key_supplied ? "yes" : "no") << "\n";
+    if (!p.region.empty())
+      oss << "Region: " << p.region << "\n";
+    if (p.key_supplied &&
+        (pooled.count(p.provider_id) > 0 || !p.key_tier.empty())) {
+      oss << "Key: #" << p.key_index + 1 << " " << MaskKey(p.api_key);
+      if (!p.key_tier.empty())
+        oss << " (tier " << p.key_tier
+            << (p.catalog_shared ? ", shared catalog" : "") << ")";
+      oss << "\n";
+    }
     oss << "Models status: " << p.models_status
         << " | Auth status: " << p.auth_status << "\n";
+    if (!p.catalog_source.empty() && p.catalog_source != "network")
+      oss << "Model list: " << p.catalog_source << " cache\n";
+    if (p.checkpoint_saved_at >= 0)
+      oss << "Reused from checkpoint saved at "
+          << FormatUtc(static_cast<std::time_t>(p.checkpoint_saved_at))
+          << "\n";
     oss << "Model used: " << p.model_used << "\n";
     oss << "Working models: " << p.working_models.size()
         << " | Failing models: " << p.failing_models.size() << "\n";
@@ -1635,6 +2544,41 @@ std::string BuildSummaryText(const AuditReport &report) {
     oss << "Requests total/success/fail: " << p.total_requests << "/"
         << p.successful_requests << "/" << p.failed_requests
         << " | avg latency(ms): " << p.avg_latency_ms << "\n";
+    if (p.latency.count() > 0)
+      oss << "Latency (ms): " << FormatLatencyMs(p.latency) << "\n";
+    if (!p.model_latency.empty()) {
+      oss << "Model latency (ms):\n";
+      for (const auto &[model, hist] : p.model_latency)
+        oss << "  " << model << ": " << FormatLatencyMs(hist) << "\n";
+    }
+    if (p.throttled_requests > 0)
+      oss << "Throttled responses (429/503): " << p.throttled_requests
+          << "\n";
+    if (p.benchmark.ran) {
+      const auto &b = p.benchmark;
+      oss << "Benchmark (" << b.mode << ", " << b.model << "): " << b.completed
+          << " completed, " << std::fixed << std::setprecision(2)
+          << b.achieved_rps << " rps, error rate " << b.error_rate * 100.0
+          << "%" << std::defaultfloat << "\n";
+      oss << "  Latency (ms): " << FormatLatencyMs(b.latency) << "\n";
+      if (b.first_429_ms >= 0)
+        oss << "  First 429 at " << b.first_429_ms << " ms after "
+            << b.sent_before_first_429 << " requests\n";
+    }
+    for (const auto &b : p.batches) {
+      oss << "Batch " << (b.id.empty() ? "(not created)" : b.id);
+      if (!b.model.empty())
+        oss << " (" << b.model << ")";
+      oss << ": " << b.status << ", " << b.succeeded << "/" << b.requests
+          << " succeeded";
+      if (b.turnaround_ms >= 0)
+        oss << ", turnaround " << std::fixed << std::setprecision(1)
+            << static_cast<double>(b.turnaround_ms) / 1000.0 << " s"
+            << std::defaultfloat;
+      if (!b.error.empty())
+        oss << ", " << b.error;
+      oss << "\n";
+    }
     if (!p.notes.empty())
       oss << "Notes: " << p.notes << "\n";
     if (!p.error_snippet.empty())
@@ -1642,15 +2586,37 @@ std::string BuildSummaryText(const AuditReport &report) {
 
     if (!p.models_rate_limit_headers.empty()) {
       oss << "Model rate-limit headers:\n";
-      for (const auto &[k, v] : p.models_rate_limit_headers)
-        oss << "  " << k << ": " << v << "\n";
+      for (const auto &h : p.models_rate_limit_headers)
+        oss << "  " << h.name << ": " << h.value << "\n";
     }
 
     if (!p.prompt_tests.empty()) {
       oss << "Prompt tests:\n";
       for (const auto &t : p.prompt_tests) {
         oss << "  - " << t.name << ": status=" << t.status
-            << ", latency_ms=" << t.latency_ms << "\n";
+            << ", latency_ms=" << t.latency_ms;
+        if (t.streamed && t.ttft_us >= 0) {
+          oss << ", ttft_ms=" << t.ttft_us / 1000
+              << ", gap_p50_ms=" << std::fixed << std::setprecision(1)
+              << static_cast<double>(t.inter_token_p50_us) / 1000.0
+              << ", tok/s=" << t.tokens_per_second << std::defaultfloat;
+        }
+        oss << "\n";
+      }
+    }
+
+    const auto suites = SummarizeSuites(p.suites);
+    if (!suites.empty()) {
+      oss << "Prompt suites:\n";
+      for (const auto &s : suites) {
+        oss << "  - " << s.suite << " on " << s.model << ": " << s.points
+            << "/" << s.max_points << " points, " << s.passed << "/"
+            << s.cases << " passed";
+        if (s.failed_requests > 0)
+          oss << ", " << s.failed_requests << " failed requests";
+        if (s.latency.count() > 0)
+          oss << ", latency (ms): " << FormatLatencyMs(s.latency);
+        oss << "\n";
       }
     }
 
@@ -1,22 +1,49 @@
 #pragma once
 
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <nlohmann/json.hpp>
 
+#include "catalog_store.h"
+#include "http_client.h"
+#include "key_redaction.h"
+#include "latency_histogram.h"
+#include "prompt_suite.h"
+#include "provider_registry.h"
+#include "rate_limiter.h"
+#include "response_store.h"
+#include "string_interner.h"
+#include "trace_store.h"
+
 namespace llaudit {
 
+class AuditMetrics;
+class LiveStats;
+
 struct PromptTest {
   std::string name;
   long status = -1;
   long latency_ms = -1;
-  std::map<std::string, std::string> rate_limit_headers;
+  HeaderTable rate_limit_headers;
   std::string answer;
   std::string error_snippet;
+
+  // Streaming mode only. Times are microseconds from submitting the request;
+  // tokens_per_second is the decode rate after the first token.
+  bool streamed = false;
+  long long ttft_us = -1;
+  long long inter_token_p50_us = -1;
+  long long inter_token_p90_us = -1;
+  long long inter_token_p99_us = -1;
+  long long output_tokens = -1;
+  double tokens_per_second = -1.0;
 };
 
 struct ModelCheck {
@@ -27,14 +54,100 @@ struct ModelCheck {
   std::string error_snippet;
 };
 
-struct RequestTrace {
-  std::string step;
-  std::string method;
-  std::string url;
-  long status = -1;
-  long latency_ms = -1;
-  std::map<std::string, std::string> rate_limit_headers;
-  std::string response_snippet;
+// One prompt-suite case sent to one model. Names and response texts live in
+// the owning SuiteResults, so a result is a handful of integers however many
+// cases a suite has.
+struct SuiteCaseResult {
+  StringInterner::Id suite = 0;  // SuiteResults::names
+  StringInterner::Id case_id = 0;
+  StringInterner::Id model = 0;
+  std::int32_t status = -1;
+  std::int32_t latency_ms = -1;
+  std::int32_t points = 0;
+  std::int32_t max_points = 0;
+  // SuiteResults::responses: the answer text, or the error body of a failed
+  // request, cut at kSuiteResponseChars. Identical responses share one entry.
+  StringInterner::Id response = 0;
+  // HashText() of the whole response before it was cut.
+  std::uint64_t response_hash = 0;
+};
+
+inline constexpr std::size_t kSuiteResponseChars = 1400;
+
+struct SuiteResults {
+  StringInterner names;      // suite names, case ids and models
+  StringInterner responses;  // distinct response texts
+  std::vector<SuiteCaseResult> results;  // by suite, then case, then model
+};
+
+// Score and latency of one suite on one model.
+struct SuiteSummary {
+  std::string suite;
+  std::string model;
+  int cases = 0;
+  int passed = 0;  // earned all of their points
+  int failed_requests = 0;
+  int points = 0;
+  int max_points = 0;
+  LatencyHistogram latency;  // in microseconds, like every histogram
+};
+
+// Suites in the order they ran, each with its models in the order they ran.
+std::vector<SuiteSummary> SummarizeSuites(const SuiteResults& suites);
+
+struct BenchmarkWindow {
+  long long start_ms = 0;  // offset from the benchmark start
+  int sent = 0;
+  int errors = 0;
+  int rate_limited = 0;
+  long long p50_us = -1;
+  long long p99_us = -1;
+};
+
+struct BenchmarkResult {
+  bool ran = false;
+  std::string model;
+  // "open_loop" sends at target_rps regardless of responses; "closed_loop"
+  // keeps `concurrency` requests outstanding.
+  std::string mode;
+  double target_rps = 0.0;
+  int concurrency = 0;
+  int duration_seconds = 0;
+
+  int sent = 0;
+  int completed = 0;
+  int succeeded = 0;
+  double achieved_rps = 0.0;
+  double error_rate = 0.0;
+  // Keyed by HTTP status; -1 counts transport errors.
+  std::map<long, int> status_counts;
+  // Open loop: measured from each request's scheduled send time, so time spent
+  // queued behind a slow provider is included (no coordinated omission).
+  LatencyHistogram latency;
+  std::vector<BenchmarkWindow> windows;
+
+  long long first_429_ms = -1;
+  int sent_before_first_429 = -1;
+  double rps_at_first_429 = -1.0;
+  HeaderTable last_rate_limit_headers;
+  std::string notes;
+};
+
+// One provider batch job of a key audited in batch mode.
+struct BatchRun {
+  std::string id;
+  // Set for providers that take one model per job.
+  std::string model;
+  int requests = 0;
+  // The provider's final status; "timeout", "canceled" or "error" when the
+  // job never got one.
+  std::string status;
+  int succeeded = 0;  // 2xx results mapped back
+  int failed = 0;     // error results, plus requests with no result at all
+  long long upload_ms = -1;
+  // From job creation until a final status was seen; the batch metric.
+  long long turnaround_ms = -1;
+  int polls = 0;
   std::string error;
 };
 
@@ -43,14 +156,27 @@ struct ProviderAudit {
   std::string provider_name;
   std::string api_key;
   bool key_supplied = false;
+  // Position in the provider's key pool, and the tier it was given.
+  int key_index = 0;
+  std::string key_tier;
+  // Cluster mode: the region of the worker that probed the key; empty for a
+  // local run.
+  std::string region;
+  // The model list came from another key on the same tier.
+  bool catalog_shared = false;
+  // "network", "revalidated" (304 from the disk cache) or "disk".
+  std::string catalog_source;
+  // Unix seconds the result was checkpointed, when it was reused instead of
+  // probed again; -1 for a fresh probe.
+  long long checkpoint_saved_at = -1;
 
   long auth_status = -1;
   long models_status = -1;
   long auth_latency_ms = -1;
   long models_latency_ms = -1;
 
-  std::map<std::string, std::string> auth_rate_limit_headers;
-  std::map<std::string, std::string> models_rate_limit_headers;
+  HeaderTable auth_rate_limit_headers;
+  HeaderTable models_rate_limit_headers;
 
   std::vector<std::string> sample_models;
   std::vector<std::string> capability_tags;
@@ -62,7 +188,13 @@ struct ProviderAudit {
 
   std::vector<ModelCheck> model_checks;
   std::vector<PromptTest> prompt_tests;
-  std::vector<RequestTrace> request_traces;
+  // The workspace prompt suites, run on every working model.
+  SuiteResults suites;
+  // Batch mode only: the jobs model checks and prompts were sent in.
+  std::vector<BatchRun> batches;
+  // Every request made for this provider; see TraceStore for what is kept.
+  TraceStore traces;
+  BenchmarkResult benchmark;
 
   int score_reasoning = 0;
   int score_coding = 0;
@@ -73,27 +205,195 @@ struct ProviderAudit {
   int successful_requests = 0;
   int failed_requests = 0;
   long avg_latency_ms = -1;
+  // Recorded per request as traces are added; model_latency covers the
+  // model_check and prompt_test requests of each model.
+  LatencyHistogram latency;
+  std::map<std::string, LatencyHistogram> model_latency;
+  // Last rate-limit state seen on the chat endpoint.
+  RateLimitState rate_limit;
+  int throttled_requests = 0;
 
   std::string notes;
   std::string error_snippet;
   nlohmann::json raw_payload;
 };
 
+// Roll-up of every key audited for one provider.
+struct KeyPoolSummary {
+  std::string provider_id;
+  std::string provider_name;
+  std::string region;  // see ProviderAudit::region
+  int keys_total = 0;
+  int keys_healthy = 0;  // supplied and at least one working model
+  std::vector<std::string> healthy_keys;  // masked
+  std::vector<std::string> unhealthy_keys;
+  // Sums over the keys that reported a value; -1 when none did.
+  long long remaining_requests = -1;
+  long long remaining_tokens = -1;
+  int keys_reporting_quota = 0;
+  int throttled_requests = 0;
+  std::vector<std::string> working_models;  // union over healthy keys
+};
+
 struct AuditReport {
   std::string generated_at_utc;
   std::vector<std::string> run_logs;
+  // One record per audited key, grouped by provider in a fixed order.
   std::vector<ProviderAudit> providers;
+  std::vector<KeyPoolSummary> pools;
 };
 
+struct ProviderKey {
+  std::string key;
+  // Keys on the same non-empty tier share one model catalog fetch.
+  std::string tier;
+};
+
+// Provider id to the keys to audit for it.
+using KeyPools = std::map<std::string, std::vector<ProviderKey>>;
+
+// Splits "key1, key2@tier key3" on commas, semicolons and whitespace; an
+// "@tier" suffix sets the tier. Duplicates are dropped, order is kept.
+std::vector<ProviderKey> ParseKeyList(const std::string& text);
+
+// The catalog an audit reads from a model-list body of a provider with this
+// chat format, the same single streaming pass it makes while the list
+// downloads. Exposed for api_tester_bench.
+ModelCatalog AnalyzeCatalog(ChatFormat format, std::string_view body);
+
+// Response bodies kept in traces and error fields are cut to this many bytes.
+inline constexpr std::size_t kSnippetLen = 500;
+// The first limit bytes of s. Exposed for api_tester_bench.
+std::string Snippet(const std::string& s, std::size_t limit = kSnippetLen);
+
 using LogFn = std::function<void(const std::string&)>;
+// Results as soon as they are known: a "trace" record for every request when
+// it completes, then "model_check", "prompt_test", "suite_summary" and
+// "provider" records when a provider key finishes, bracketed by "run_start"
+// and "run_end". Keys are masked. Called from worker threads, but never concurrently.
+using RecordFn = std::function<void(const nlohmann::json&)>;
+
+struct BenchmarkOptions {
+  bool enabled = false;
+  // Empty runs the benchmark for every provider with a key.
+  std::vector<std::string> providers;
+  // Overrides model_used when set.
+  std::string model;
+  // Open-loop arrival rate; when 0, runs closed-loop at `concurrency`.
+  double target_rps = 2.0;
+  int concurrency = 4;
+  int duration_seconds = 30;
+  int window_seconds = 5;
+  // Per-host in-flight cap while the benchmark runs.
+  int max_in_flight = 64;
+  int max_tokens = 16;
+};
+
+// Opt-in: providers with a batch endpoint (ProviderSpec::batch) get their
+// model checks, prompt tests and suites packed into batch job uploads, which
+// are polled with exponential backoff and mapped back into the usual results.
+// The prompts go to every probed model in the same upload, and results of
+// models that fail their check are dropped, so one turnaround covers the key.
+// Batch results carry no per-request latency or streaming figures.
+struct BatchOptions {
+  bool enabled = false;
+  long long poll_initial_ms = 2000;
+  long long poll_max_ms = 60000;
+  // Jobs still running after this are canceled and their requests failed.
+  long long timeout_seconds = 2 * 60 * 60;
+  std::string completion_window = "24h";
+};
+
+struct AuditOptions {
+  // Audit providers concurrently; each provider still runs its own steps in order.
+  bool parallel = true;
+  int max_workers = 11;
+  // Upper bound on concurrent requests sent to any single host.
+  int max_in_flight_per_host = 4;
+  // Providers to audit, in report order; empty means BuiltinProviders().
+  std::vector<ProviderSpec> providers;
+  // Pace chat requests from rate-limit headers and retry 429/503 with backoff.
+  bool adaptive_rate_limit = true;
+  RateLimiterOptions rate_limit;
+  // Send prompt tests with stream=true and record TTFT and decode throughput.
+  bool stream_prompts = false;
+  // Run after the built-in prompt tests on working models in probe order;
+  // suite_max_models caps how many (0 is all of them), and at most
+  // suite_max_in_flight suite requests of one key are outstanding at once.
+  // In batch mode the suites go into the upload before any check has
+  // answered, so the cap takes the first suite_max_models probed models and
+  // keeps the results of those that work: fewer models than the cap may get
+  // suite results even when more of them work.
+  std::vector<PromptSuite> prompt_suites;
+  int suite_max_models = 0;
+  int suite_max_in_flight = 32;
+  BatchOptions batch;
+  // Sustained-load run against model_used after the prompt suite.
+  BenchmarkOptions benchmark;
+  // Parsed model lists are kept here between runs; empty disables the cache.
+  // Within the TTL the list request is skipped, after it the cached copy is
+  // revalidated with ETag / Last-Modified.
+  std::string catalog_cache_dir;
+  long long catalog_cache_ttl_seconds = 6 * 60 * 60;
+  // Model lists are analyzed while they stream in and then dropped. Keeping
+  // the parsed responses in ProviderAudit::raw_payload is opt-in, and a model
+  // list larger than the cap is recorded by size only.
+  bool keep_raw_payload = false;
+  std::size_t raw_payload_max_bytes = 4 * 1024 * 1024;
+  // Full request traces kept per provider; counts and latency statistics
+  // always cover every request.
+  TraceRetention traces;
+  // AuditReport::run_logs keeps the first and last half of this many lines;
+  // the log callback still sees every line.
+  std::size_t max_run_log_lines = 5000;
+  // Live counters and histograms for a metrics endpoint; not owned, and
+  // shared by every run that is given it.
+  AuditMetrics* metrics = nullptr;
+  // Progress and rolling latency for a live dashboard; not owned.
+  LiveStats* live = nullptr;
+  // Every probed key is saved here as soon as it finishes; empty disables.
+  std::string checkpoint_dir;
+  // Reuse checkpoints younger than the TTL instead of probing again. Keys
+  // whose saved result was unhealthy or had a failed prompt test, and keys
+  // probed with a different tier, prompt suite or streaming/benchmark
+  // setting, are probed as usual.
+  bool resume = false;
+  long long checkpoint_ttl_seconds = 30 * 60;
+  // Record every response of the run into record_dir, or replay an earlier
+  // recording from it without touching the network; see ResponseStore. A
+  // replay serves responses at memory speed, which leaves only the engine's
+  // own CPU time, unless replay_latency waits out the recorded latencies.
+  RecordMode record_mode = RecordMode::kOff;
+  std::string record_dir;
+  bool replay_latency = false;
+  // Rate-limit state a key starts from instead of a fresh bucket, keyed by
+  // provider id and key as "provider|key". Cluster workers pass on what the
+  // previous worker to hold the key last saw.
+  std::map<std::string, RateLimitState> initial_rate_limits;
+};
 
 class AuditEngine {
  public:
+  AuditEngine() = default;
+  explicit AuditEngine(AuditOptions options);
+
+  // The log callback may be invoked from worker threads, but never concurrently.
   AuditReport Run(const std::map<std::string, std::string>& keys, const LogFn& log,
-                  const std::atomic<bool>& cancel_requested);
+                  const std::atomic<bool>& cancel_requested, const RecordFn& record = {});
+  // Audits every key in each pool; a provider with no keys still gets one
+  // "No API key supplied." record.
+  AuditReport Run(const KeyPools& keys, const LogFn& log,
+                  const std::atomic<bool>& cancel_requested, const RecordFn& record = {});
+
+ private:
+  AuditOptions options_;
 };
 
-nlohmann::json ReportToJson(const AuditReport& report);
+// One-line p50/p90/p99/min/max summary in milliseconds.
+std::string FormatLatencyMs(const LatencyHistogram& histogram);
 std::string BuildSummaryText(const AuditReport& report);
+// One roll-up per run of consecutive records with the same provider and
+// region, in report order.
+std::vector<KeyPoolSummary> SummarizePools(const std::vector<ProviderAudit>& providers);
 
 }  // namespace llaudit
@@ -0,0 +1,340 @@
+#include "audit_metrics.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <sstream>
+#include <tuple>
+#include <vector>
+
+namespace llaudit {
+
+struct AuditMetrics::Series {
+  std::string provider;
+  std::string model;
+
+  // Not cumulative; Render() sums them into the "le" buckets. The last one
+  // holds everything above the largest bound.
+  std::array<std::atomic<std::uint64_t>, kLatencyBucketsUs.size() + 1>
+      buckets{};
+  std::atomic<std::uint64_t> latency_sum_us{0};
+
+  std::atomic<std::uint64_t> ok{0};
+  std::atomic<std::uint64_t> failed{0};
+  std::atomic<std::uint64_t> throttled{0};
+
+  std::atomic<std::int64_t> remaining_requests{-1};
+  std::atomic<std::int64_t> remaining_tokens{-1};
+  std::atomic<std::int64_t> limit_requests{-1};
+  std::atomic<std::int64_t> limit_tokens{-1};
+  std::atomic<int> working{-1};
+
+  std::atomic<std::uint64_t> batches_completed{0};
+  std::atomic<std::uint64_t> batches_failed{0};
+  std::atomic<std::int64_t> batch_turnaround_ms{-1};  // the latest
+};
+
+namespace {
+
+std::size_t HashLabels(std::string_view provider, std::string_view model) {
+  const std::size_t h = std::hash<std::string_view>{}(provider);
+  return h ^ (std::hash<std::string_view>{}(model) + 0x9e3779b97f4a7c15ULL +
+              (h << 6) + (h >> 2));
+}
+
+void AppendEscaped(std::string &out, const std::string &value) {
+  for (const char c : value) {
+    if (c == '\\')
+      out += "\\\\";
+    else if (c == '"')
+      out += "\\\"";
+    else if (c == '\n')
+      out += "\\n";
+    else
+      out += c;
+  }
+}
+
+std::string Labels(const std::string &provider, const std::string &model,
+                   const char *extra = nullptr) {
+  std::string out = "{provider=\"";
+  AppendEscaped(out, provider);
+  out += "\",model=\"";
+  AppendEscaped(out, model);
+  out += "\"";
+  if (extra) {
+    out += ",";
+    out += extra;
+  }
+  out += "}";
+  return out;
+}
+
+std::string Seconds(long long us) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.6g", static_cast<double>(us) / 1e6);
+  return buf;
+}
+
+void Header(std::ostringstream &oss, const char *name, const char *type,
+            const char *help) {
+  oss << "# HELP " << name << " " << help << "\n";
+  oss << "# TYPE " << name << " " << type << "\n";
+}
+
+} // namespace
+
+AuditMetrics::AuditMetrics(std::size_t max_series)
+    : capacity_(std::max<std::size_t>(max_series, 1) * 2),
+      slots_(std::make_unique<std::atomic<Series *>[]>(capacity_)) {
+  for (std::size_t i = 0; i < capacity_; ++i)
+    slots_[i].store(nullptr, std::memory_order_relaxed);
+}
+
+AuditMetrics::~AuditMetrics() {
+  for (std::size_t i = 0; i < capacity_; ++i)
+    delete slots_[i].load(std::memory_order_relaxed);
+}
+
+// Linear probing over a table kept at most half full. A new series is
+// published with a compare-exchange; the loser of a race for the same slot
+// frees its copy and either uses the winner's or probes on.
+AuditMetrics::Series *AuditMetrics::Find(std::string_view provider,
+                                         std::string_view model) {
+  const std::size_t start = HashLabels(provider, model) % capacity_;
+  Series *fresh = nullptr;
+  for (std::size_t n = 0; n < capacity_ / 2; ++n) {
+    std::atomic<Series *> &slot = slots_[(start + n) % capacity_];
+    Series *s = slot.load(std::memory_order_acquire);
+    if (!s) {
+      if (!fresh) {
+        fresh = new Series;
+        fresh->provider = provider;
+        fresh->model = model;
+      }
+      if (slot.compare_exchange_strong(s, fresh, std::memory_order_acq_rel,
+                                       std::memory_order_acquire))
+        return fresh;
+    }
+    if (s->provider == provider && s->model == model) {
+      delete fresh;
+      return s;
+    }
+  }
+  delete fresh;
+  dropped_.fetch_add(1, std::memory_order_relaxed);
+  return nullptr;
+}
+
+void AuditMetrics::ObserveRequest(std::string_view provider,
+                                  std::string_view model, bool ok,
+                                  bool throttled, long long latency_us) {
+  Series *s = Find(provider, model);
+  if (!s)
+    return;
+  (ok ? s->ok : s->failed).fetch_add(1, std::memory_order_relaxed);
+  if (throttled)
+    s->throttled.fetch_add(1, std::memory_order_relaxed);
+  if (latency_us < 0)
+    return;
+  std::size_t b = 0;
+  while (b < kLatencyBucketsUs.size() && latency_us > kLatencyBucketsUs[b])
+    ++b;
+  s->buckets[b].fetch_add(1, std::memory_order_relaxed);
+  s->latency_sum_us.fetch_add(static_cast<std::uint64_t>(latency_us),
+                              std::memory_order_relaxed);
+}
+
+void AuditMetrics::ObserveRateLimit(std::string_view provider,
+                                    std::string_view model,
+                                    const RateLimitState &state) {
+  if (state.remaining_requests < 0 && state.remaining_tokens < 0 &&
+      state.limit_requests < 0 && state.limit_tokens < 0)
+    return;
+  Series *s = Find(provider, model);
+  if (!s)
+    return;
+  auto set = [](std::atomic<std::int64_t> &gauge, long long v) {
+    if (v >= 0)
+      gauge.store(v, std::memory_order_relaxed);
+  };
+  set(s->remaining_requests, state.remaining_requests);
+  set(s->remaining_tokens, state.remaining_tokens);
+  set(s->limit_requests, state.limit_requests);
+  set(s->limit_tokens, state.limit_tokens);
+}
+
+void AuditMetrics::SetModelWorking(std::string_view provider,
+                                   std::string_view model, bool working) {
+  if (Series *s = Find(provider, model))
+    s->working.store(working ? 1 : 0, std::memory_order_relaxed);
+}
+
+void AuditMetrics::ObserveBatch(std::string_view provider,
+                                std::string_view model, bool completed,
+                                long long turnaround_ms) {
+  Series *s = Find(provider, model);
+  if (!s)
+    return;
+  (completed ? s->batches_completed : s->batches_failed)
+      .fetch_add(1, std::memory_order_relaxed);
+  if (turnaround_ms >= 0)
+    s->batch_turnaround_ms.store(turnaround_ms, std::memory_order_relaxed);
+}
+
+void AuditMetrics::RunStarted() {
+  runs_started_.fetch_add(1, std::memory_order_relaxed);
+  running_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AuditMetrics::RunFinished(bool completed, long long unix_seconds) {
+  if (completed)
+    last_finished_.store(unix_seconds, std::memory_order_relaxed);
+  else
+    runs_incomplete_.fetch_add(1, std::memory_order_relaxed);
+  running_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+std::string AuditMetrics::Render() const {
+  std::vector<const Series *> series;
+  for (std::size_t i = 0; i < capacity_; ++i) {
+    if (const Series *s = slots_[i].load(std::memory_order_acquire))
+      series.push_back(s);
+  }
+  std::sort(series.begin(), series.end(),
+            [](const Series *a, const Series *b) {
+              return std::tie(a->provider, a->model) <
+                     std::tie(b->provider, b->model);
+            });
+  const auto relaxed = std::memory_order_relaxed;
+
+  std::ostringstream oss;
+  Header(oss, "llaudit_request_duration_seconds", "histogram",
+         "Provider request latency; each retry is its own sample.");
+  for (const Series *s : series) {
+    std::array<std::uint64_t, kLatencyBucketsUs.size() + 1> counts;
+    std::uint64_t count = 0;
+    for (std::size_t b = 0; b < counts.size(); ++b) {
+      counts[b] = s->buckets[b].load(relaxed);
+      count += counts[b];
+    }
+    if (count == 0)
+      continue;
+    std::uint64_t cumulative = 0;
+    for (std::size_t b = 0; b < kLatencyBucketsUs.size(); ++b) {
+      cumulative += counts[b];
+      const std::string le = "le=\"" + Seconds(kLatencyBucketsUs[b]) + "\"";
+      oss << "llaudit_request_duration_seconds_bucket"
+          << Labels(s->provider, s->model, le.c_str()) << " " << cumulative
+          << "\n";
+    }
+    oss << "llaudit_request_duration_seconds_bucket"
+        << Labels(s->provider, s->model, "le=\"+Inf\"") << " " << count
+        << "\n";
+    oss << "llaudit_request_duration_seconds_sum"
+        << Labels(s->provider, s->model) << " "
+        << Seconds(static_cast<long long>(s->latency_sum_us.load(relaxed)))
+        << "\n";
+    oss << "llaudit_request_duration_seconds_count"
+        << Labels(s->provider, s->model) << " " << count << "\n";
+  }
+
+  Header(oss, "llaudit_requests_total", "counter",
+         "Provider requests by outcome; success is a 2xx or 304 response.");
+  for (const Series *s : series) {
+    const std::uint64_t ok = s->ok.load(relaxed);
+    const std::uint64_t failed = s->failed.load(relaxed);
+    if (ok + failed == 0)
+      continue;
+    oss << "llaudit_requests_total"
+        << Labels(s->provider, s->model, "outcome=\"success\"") << " " << ok
+        << "\n";
+    oss << "llaudit_requests_total"
+        << Labels(s->provider, s->model, "outcome=\"failure\"") << " "
+        << failed << "\n";
+  }
+
+  Header(oss, "llaudit_throttled_responses_total", "counter",
+         "429/503 responses that were retried after backoff.");
+  for (const Series *s : series) {
+    if (s->ok.load(relaxed) + s->failed.load(relaxed) == 0)
+      continue;
+    oss << "llaudit_throttled_responses_total"
+        << Labels(s->provider, s->model) << " " << s->throttled.load(relaxed)
+        << "\n";
+  }
+
+  const std::pair<const char *, std::atomic<std::int64_t> Series::*>
+      gauges[] = {
+          {"llaudit_rate_limit_remaining_requests",
+           &Series::remaining_requests},
+          {"llaudit_rate_limit_remaining_tokens", &Series::remaining_tokens},
+          {"llaudit_rate_limit_limit_requests", &Series::limit_requests},
+          {"llaudit_rate_limit_limit_tokens", &Series::limit_tokens},
+      };
+  for (const auto &[name, member] : gauges) {
+    Header(oss, name, "gauge",
+           "Last value the provider reported in its rate-limit headers.");
+    for (const Series *s : series) {
+      const std::int64_t v = (s->*member).load(relaxed);
+      if (v >= 0)
+        oss << name << Labels(s->provider, s->model) << " " << v << "\n";
+    }
+  }
+
+  Header(oss, "llaudit_model_working", "gauge",
+         "1 if the last model check succeeded, 0 if it failed.");
+  for (const Series *s : series) {
+    const int working = s->working.load(relaxed);
+    if (working >= 0)
+      oss << "llaudit_model_working" << Labels(s->provider, s->model) << " "
+          << working << "\n";
+  }
+
+  Header(oss, "llaudit_batches_total", "counter",
+         "Batch jobs by outcome; failure includes jobs that timed out.");
+  for (const Series *s : series) {
+    const std::uint64_t completed = s->batches_completed.load(relaxed);
+    const std::uint64_t failed = s->batches_failed.load(relaxed);
+    if (completed + failed == 0)
+      continue;
+    oss << "llaudit_batches_total"
+        << Labels(s->provider, s->model, "outcome=\"completed\"") << " "
+        << completed << "\n";
+    oss << "llaudit_batches_total"
+        << Labels(s->provider, s->model, "outcome=\"failed\"") << " "
+        << failed << "\n";
+  }
+
+  Header(oss, "llaudit_batch_turnaround_seconds", "gauge",
+         "Time from creating the latest batch job to its final status.");
+  for (const Series *s : series) {
+    const std::int64_t ms = s->batch_turnaround_ms.load(relaxed);
+    if (ms >= 0)
+      oss << "llaudit_batch_turnaround_seconds"
+          << Labels(s->provider, s->model) << " " << Seconds(ms * 1000)
+          << "\n";
+  }
+
+  Header(oss, "llaudit_audit_runs_total", "counter", "Audits started.");
+  oss << "llaudit_audit_runs_total " << runs_started_.load(relaxed) << "\n";
+  Header(oss, "llaudit_audit_runs_incomplete_total", "counter",
+         "Audits that were canceled or failed before finishing.");
+  oss << "llaudit_audit_runs_incomplete_total "
+      << runs_incomplete_.load(relaxed) << "\n";
+  Header(oss, "llaudit_audit_running", "gauge", "Audits in progress.");
+  oss << "llaudit_audit_running " << running_.load(relaxed) << "\n";
+  const std::int64_t last = last_finished_.load(relaxed);
+  if (last >= 0) {
+    Header(oss, "llaudit_audit_last_completed_timestamp_seconds", "gauge",
+           "Unix time the last complete audit finished.");
+    oss << "llaudit_audit_last_completed_timestamp_seconds " << last << "\n";
+  }
+  Header(oss, "llaudit_metrics_dropped_updates_total", "counter",
+         "Updates lost because the series table was full.");
+  oss << "llaudit_metrics_dropped_updates_total " << dropped_.load(relaxed)
+      << "\n";
+  return oss.str();
+}
+
+} // namespace llaudit
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "rate_limiter.h"
+
+namespace llaudit {
+
+// Live audit measurements for a Prometheus scrape, labelled by provider and
+// model. A series is created the first time its labels are seen and lives as
+// long as the registry; it is found through a fixed open-addressing table of
+// atomic pointers, so looking it up and updating it never takes a lock and
+// the request path pays a few relaxed atomic operations. Once the table is
+// full, updates for new label sets are dropped and counted.
+class AuditMetrics {
+ public:
+  // Upper bounds of the request latency buckets, in microseconds.
+  static constexpr std::array<long long, 13> kLatencyBucketsUs = {
+      5'000,     10'000,    25'000,    50'000,     100'000,    250'000,   500'000,
+      1'000'000, 2'500'000, 5'000'000, 10'000'000, 30'000'000, 60'000'000};
+
+  explicit AuditMetrics(std::size_t max_series = 1024);
+  ~AuditMetrics();
+
+  AuditMetrics(const AuditMetrics&) = delete;
+  AuditMetrics& operator=(const AuditMetrics&) = delete;
+
+  // One request as AddTrace records it; latency_us < 0 counts the outcome only.
+  void ObserveRequest(std::string_view provider, std::string_view model, bool ok, bool throttled,
+                      long long latency_us);
+  // Values below 0 (not reported) leave the gauges as they were.
+  void ObserveRateLimit(std::string_view provider, std::string_view model,
+                        const RateLimitState& state);
+  void SetModelWorking(std::string_view provider, std::string_view model, bool working);
+  // A batch job that reached a final status, or gave up waiting for one.
+  void ObserveBatch(std::string_view provider, std::string_view model, bool completed,
+                    long long turnaround_ms);
+
+  void RunStarted();
+  // completed is false for a canceled or failed run.
+  void RunFinished(bool completed, long long unix_seconds);
+
+  // Prometheus text exposition format, version 0.0.4.
+  std::string Render() const;
+
+ private:
+  struct Series;
+
+  Series* Find(std::string_view provider, std::string_view model);
+
+  std::size_t capacity_;
+  std::unique_ptr<std::atomic<Series*>[]> slots_;
+  std::atomic<std::uint64_t> dropped_{0};
+  std::atomic<std::uint64_t> runs_started_{0};
+  std::atomic<std::uint64_t> runs_incomplete_{0};
+  std::atomic<std::int64_t> running_{0};
+  std::atomic<std::int64_t> last_finished_{-1};
+};
+
+}  // namespace llaudit
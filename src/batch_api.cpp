@@ -0,0 +1,182 @@
+#include "batch_api.h"
+
+#include "fnv1a.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+
+namespace llaudit {
+namespace {
+
+using nlohmann::json;
+
+std::string Lower(std::string s) {
+  std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) {
+    return static_cast<char>(std::tolower(c));
+  });
+  return s;
+}
+
+std::string StringAt(const json &j, const char *key) {
+  if (!j.is_object())
+    return {};
+  const auto it = j.find(key);
+  return it != j.end() && it->is_string() ? it->get<std::string>() : "";
+}
+
+// An error member may be a string, {"message": ...}, or OpenAI's
+// {"data": [{"message": ...}]}.
+std::string ErrorText(const json &j) {
+  if (j.is_string())
+    return j.get<std::string>();
+  if (!j.is_object())
+    return {};
+  if (auto message = StringAt(j, "message"); !message.empty())
+    return message;
+  if (j.contains("data") && j["data"].is_array() && !j["data"].empty())
+    return ErrorText(j["data"][0]);
+  return j.dump();
+}
+
+// Derived from the content rather than drawn at random, so the same upload
+// is the same request and replays from a recording.
+std::string Boundary(const std::string &content) {
+  const std::uint64_t h = Fnv1a64(content);
+  static constexpr char kHex[] = "0123456789abcdef";
+  std::string out = "llaudit-";
+  for (int shift = 60; shift >= 0; shift -= 4)
+    out += kHex[(h >> shift) & 0xF];
+  return out;
+}
+
+} // namespace
+
+std::string BatchEndpoint::FilesUrl() const { return base_url + "/files"; }
+
+std::string BatchEndpoint::JobsUrl() const {
+  return base_url +
+         (style == BatchStyle::kMistral ? "/batch/jobs" : "/batches");
+}
+
+std::string BatchEndpoint::JobUrl(const std::string &id) const {
+  return JobsUrl() + "/" + id;
+}
+
+std::string BatchEndpoint::CancelUrl(const std::string &id) const {
+  return JobUrl(id) + "/cancel";
+}
+
+std::string BatchEndpoint::FileContentUrl(const std::string &file_id) const {
+  return FilesUrl() + "/" + file_id + "/content";
+}
+
+MultipartUpload BatchUpload(const std::string &jsonl,
+                            const std::string &file_name) {
+  const std::string boundary = Boundary(jsonl);
+  MultipartUpload out;
+  out.content_type = "multipart/form-data; boundary=" + boundary;
+  out.body.reserve(jsonl.size() + 512);
+  out.body += "--" + boundary + "\r\n";
+  out.body += "Content-Disposition: form-data; name=\"purpose\"\r\n\r\n";
+  out.body += "batch\r\n";
+  out.body += "--" + boundary + "\r\n";
+  out.body += "Content-Disposition: form-data; name=\"file\"; filename=\"" +
+              file_name + "\"\r\n";
+  out.body += "Content-Type: application/jsonl\r\n\r\n";
+  out.body += jsonl;
+  out.body += "\r\n--" + boundary + "--\r\n";
+  return out;
+}
+
+std::string BatchLine(const BatchEndpoint &ep, const std::string &custom_id,
+                      json body) {
+  json line = {{"custom_id", custom_id}};
+  if (ep.style == BatchStyle::kMistral) {
+    body.erase("model");
+  } else {
+    line["method"] = "POST";
+    line["url"] = ep.chat_path;
+  }
+  line["body"] = std::move(body);
+  return line.dump();
+}
+
+std::string UploadedFileId(const json &response) {
+  return StringAt(response, "id");
+}
+
+std::string BatchCreateBody(const BatchEndpoint &ep,
+                            const std::string &file_id,
+                            const std::string &model,
+                            const std::string &completion_window) {
+  if (ep.style == BatchStyle::kMistral)
+    return json{{"input_files", {file_id}},
+                {"model", model},
+                {"endpoint", ep.chat_path}}
+        .dump();
+  return json{{"input_file_id", file_id},
+              {"endpoint", ep.chat_path},
+              {"completion_window", completion_window}}
+      .dump();
+}
+
+BatchStatus ParseBatchStatus(const BatchEndpoint &ep, const json &job) {
+  BatchStatus s;
+  s.id = StringAt(job, "id");
+  s.status = StringAt(job, "status");
+  const std::string status = Lower(s.status);
+  if (ep.style == BatchStyle::kMistral) {
+    s.output_file_id = StringAt(job, "output_file");
+    s.error_file_id = StringAt(job, "error_file");
+    s.succeeded = status == "success";
+    s.finished = s.succeeded || status == "failed" ||
+                 status == "timeout_exceeded" || status == "cancelled";
+  } else {
+    s.output_file_id = StringAt(job, "output_file_id");
+    s.error_file_id = StringAt(job, "error_file_id");
+    s.succeeded = status == "completed";
+    s.finished = s.succeeded || status == "failed" || status == "expired" ||
+                 status == "cancelled";
+  }
+  if (job.is_object()) {
+    if (job.contains("errors") && !job["errors"].is_null())
+      s.error = ErrorText(job["errors"]);
+    else if (job.contains("error") && !job["error"].is_null())
+      s.error = ErrorText(job["error"]);
+  }
+  // A job that ends early still reports the results it produced.
+  if (s.finished && !s.output_file_id.empty())
+    s.succeeded = true;
+  return s;
+}
+
+void ParseBatchResults(std::string_view jsonl,
+                       std::vector<BatchItemResult> &out) {
+  while (!jsonl.empty()) {
+    const auto end = std::min(jsonl.find('\n'), jsonl.size());
+    const auto line = jsonl.substr(0, end);
+    jsonl.remove_prefix(std::min(end + 1, jsonl.size()));
+    const auto j = json::parse(line, nullptr, false);
+    if (!j.is_object() || StringAt(j, "custom_id").empty())
+      continue;
+
+    BatchItemResult r;
+    r.custom_id = StringAt(j, "custom_id");
+    if (j.contains("response") && j["response"].is_object()) {
+      const auto &resp = j["response"];
+      if (resp.contains("status_code") && resp["status_code"].is_number())
+        r.status = resp["status_code"].get<long>();
+      // Some OpenAI-compatible gateways return the body as a JSON string.
+      if (resp.contains("body") && resp["body"].is_string())
+        r.body = json::parse(resp["body"].get<std::string>(), nullptr, false);
+      else if (resp.contains("body"))
+        r.body = resp["body"];
+    }
+    if (j.contains("error") && !j["error"].is_null())
+      r.error = ErrorText(j["error"]);
+    out.push_back(std::move(r));
+  }
+}
+
+} // namespace llaudit
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace llaudit {
+
+// Asynchronous batch endpoints a provider offers for chat requests.
+enum class BatchStyle {
+  kNone,
+  kOpenAI,   // POST /files (purpose=batch), POST /batches, GET /batches/{id}
+  kMistral,  // POST /files (purpose=batch), POST /batch/jobs, one model per job
+};
+
+// The requests and files of batch jobs, and what comes back from them. Only
+// builds and parses payloads; the engine sends them.
+struct BatchEndpoint {
+  BatchStyle style = BatchStyle::kNone;
+  // Ends before "/files", e.g. "https://api.mistral.ai/v1".
+  std::string base_url;
+  // Path every line of the input file targets.
+  std::string chat_path = "/v1/chat/completions";
+
+  std::string FilesUrl() const;
+  std::string JobsUrl() const;
+  std::string JobUrl(const std::string& id) const;
+  std::string CancelUrl(const std::string& id) const;
+  std::string FileContentUrl(const std::string& file_id) const;
+};
+
+// A finished upload: the multipart/form-data body and its Content-Type header.
+struct MultipartUpload {
+  std::string content_type;
+  std::string body;
+};
+
+// The JSONL input file as a "purpose=batch" upload.
+MultipartUpload BatchUpload(const std::string& jsonl, const std::string& file_name);
+
+// One input line for a chat request body. Mistral takes the model per job,
+// so it is dropped from the body there.
+std::string BatchLine(const BatchEndpoint& ep, const std::string& custom_id, nlohmann::json body);
+
+// The id of the file an upload created; empty when the response has none.
+std::string UploadedFileId(const nlohmann::json& response);
+
+// Job creation payload for an uploaded input file; model is used by Mistral
+// only.
+std::string BatchCreateBody(const BatchEndpoint& ep, const std::string& file_id,
+                            const std::string& model, const std::string& completion_window);
+
+struct BatchStatus {
+  std::string id;
+  std::string status;  // as the provider spells it
+  bool finished = false;
+  bool succeeded = false;  // finished and produced results
+  std::string output_file_id;
+  std::string error_file_id;
+  std::string error;
+};
+
+// Reads a job object returned by creation or polling.
+BatchStatus ParseBatchStatus(const BatchEndpoint& ep, const nlohmann::json& job);
+
+struct BatchItemResult {
+  std::string custom_id;
+  long status = -1;
+  // The chat completion, as a direct request would have returned it.
+  nlohmann::json body;
+  std::string error;
+};
+
+// Appends the lines of an output or error file; lines that do not parse
+// are skipped.
+void ParseBatchResults(std::string_view jsonl, std::vector<BatchItemResult>& out);
+
+}  // namespace llaudit
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace llaudit {
+
+// A run log that keeps the first and the last half of max_lines lines, with
+// a marker for what was dropped in between; 0 keeps all. Not thread-safe.
+class BoundedLog {
+ public:
+  explicit BoundedLog(std::size_t max_lines)
+      : head_max_(max_lines == 0 ? std::numeric_limits<std::size_t>::max()
+                                 : (max_lines + 1) / 2),
+        tail_max_(max_lines / 2) {}
+
+  void Push(std::string line) {
+    if (head_.size() < head_max_) {
+      head_.push_back(std::move(line));
+      return;
+    }
+    tail_.push_back(std::move(line));
+    if (tail_.size() > tail_max_) {
+      tail_.pop_front();
+      omitted_ += 1;
+    }
+  }
+
+  std::vector<std::string> Take() {
+    std::vector<std::string> out = std::move(head_);
+    if (omitted_ > 0) out.push_back("... " + std::to_string(omitted_) + " log lines omitted ...");
+    out.insert(out.end(), std::make_move_iterator(tail_.begin()),
+               std::make_move_iterator(tail_.end()));
+    return out;
+  }
+
+ private:
+  std::size_t head_max_;
+  std::size_t tail_max_;
+  std::vector<std::string> head_;
+  std::deque<std::string> tail_;
+  std::size_t omitted_ = 0;
+};
+
+}  // namespace llaudit
@@ -0,0 +1,93 @@
+#include "catalog_store.h"
+
+#include "atomic_file.h"
+#include "fnv1a.h"
+
+#include <cstdint>
+#include <fstream>
+#include <system_error>
+
+#include <nlohmann/json.hpp>
+
+namespace llaudit {
+namespace {
+
+constexpr int kFormatVersion = 1;
+
+} // namespace
+
+std::string CatalogStore::Fingerprint(const std::string &identity) {
+  std::uint64_t h = Fnv1a64(identity);
+  static constexpr char kHex[] = "0123456789abcdef";
+  std::string out(16, '0');
+  for (int i = 15; i >= 0; --i) {
+    out[static_cast<std::size_t>(i)] = kHex[h & 0xF];
+    h >>= 4;
+  }
+  return out;
+}
+
+std::filesystem::path
+CatalogStore::FileFor(const std::string &provider_id,
+                      const std::string &identity) const {
+  return dir_ / (provider_id + "_" + Fingerprint(identity) + ".json");
+}
+
+std::optional<CachedCatalog>
+CatalogStore::Load(const std::string &provider_id,
+                   const std::string &identity) const {
+  if (!enabled())
+    return std::nullopt;
+  std::ifstream ifs(FileFor(provider_id, identity));
+  if (!ifs)
+    return std::nullopt;
+
+  const auto j = nlohmann::json::parse(ifs, nullptr, false);
+  if (!j.is_object() || j.value("version", 0) != kFormatVersion ||
+      !j.contains("model_ids") || !j["model_ids"].is_array())
+    return std::nullopt;
+
+  CachedCatalog entry;
+  for (const auto &id : j["model_ids"]) {
+    if (id.is_string())
+      entry.catalog.model_ids.push_back(id.get<std::string>());
+  }
+  entry.catalog.max_context = j.value("max_context", -1LL);
+  if (j.contains("capability_tags") && j["capability_tags"].is_array()) {
+    for (const auto &tag : j["capability_tags"]) {
+      if (tag.is_string())
+        entry.catalog.capability_tags.push_back(tag.get<std::string>());
+    }
+  }
+  entry.etag = j.value("etag", std::string{});
+  entry.last_modified = j.value("last_modified", std::string{});
+  entry.fetched_at = j.value("fetched_at", 0LL);
+  return entry;
+}
+
+bool CatalogStore::Save(const std::string &provider_id,
+                        const std::string &identity,
+                        const CachedCatalog &entry) const {
+  if (!enabled())
+    return false;
+  std::error_code ec;
+  std::filesystem::create_directories(dir_, ec);
+  if (ec)
+    return false;
+
+  const nlohmann::json j = {
+      {"version", kFormatVersion},
+      {"provider_id", provider_id},
+      {"fetched_at", entry.fetched_at},
+      {"etag", entry.etag},
+      {"last_modified", entry.last_modified},
+      {"model_ids", entry.catalog.model_ids},
+      {"max_context", entry.catalog.max_context},
+      {"capability_tags", entry.catalog.capability_tags},
+  };
+
+  std::string error;
+  return WriteFileAtomically(FileFor(provider_id, identity), j.dump(), error);
+}
+
+} // namespace llaudit
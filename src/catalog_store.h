@@ -0,0 +1,50 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace llaudit {
+
+// What an audit keeps from a provider's model list.
+struct ModelCatalog {
+  std::vector<std::string> model_ids;  // sorted, unique
+  long long max_context = -1;
+  std::vector<std::string> capability_tags;
+};
+
+struct CachedCatalog {
+  ModelCatalog catalog;
+  std::string etag;
+  std::string last_modified;
+  long long fetched_at = 0;  // Unix seconds of the last 200 or 304
+};
+
+// Parsed model catalogs on disk, one JSON file per provider and key
+// fingerprint. Keys themselves are never written. A default-constructed
+// store is disabled: Load() finds nothing and Save() does nothing.
+class CatalogStore {
+ public:
+  CatalogStore() = default;
+  explicit CatalogStore(std::filesystem::path dir) : dir_(std::move(dir)) {}
+
+  bool enabled() const { return !dir_.empty(); }
+
+  std::optional<CachedCatalog> Load(const std::string& provider_id,
+                                    const std::string& identity) const;
+  // Writes through a temporary file so a crash never leaves a torn entry.
+  bool Save(const std::string& provider_id, const std::string& identity,
+            const CachedCatalog& entry) const;
+
+  // 64-bit FNV-1a of the key, as 16 hex digits.
+  static std::string Fingerprint(const std::string& identity);
+
+ private:
+  std::filesystem::path FileFor(const std::string& provider_id,
+                                const std::string& identity) const;
+
+  std::filesystem::path dir_;
+};
+
+}  // namespace llaudit
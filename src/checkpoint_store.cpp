@@ -0,0 +1,541 @@
+#include "checkpoint_store.h"
+
+#include "atomic_file.h"
+#include "catalog_store.h"
+#include "key_redaction.h"
+
+#include <algorithm>
+#include <fstream>
+#include <system_error>
+
+#include <nlohmann/json.hpp>
+
+namespace llaudit {
+namespace {
+
+constexpr int kFormatVersion = 1;
+
+using nlohmann::json;
+
+HeaderTable Headers(const json &j) {
+  HeaderTable out;
+  if (!j.is_object())
+    return out;
+  for (const auto &[k, v] : j.items()) {
+    if (v.is_string())
+      out.Add(k, v.get<std::string>());
+  }
+  return out;
+}
+
+json HeadersJson(const HeaderTable &headers) {
+  json out = json::object();
+  for (const auto &h : headers)
+    out[std::string(h.name)] = h.value;
+  return out;
+}
+
+std::vector<std::string> Strings(const json &j) {
+  std::vector<std::string> out;
+  if (!j.is_array())
+    return out;
+  for (const auto &v : j) {
+    if (v.is_string())
+      out.push_back(v.get<std::string>());
+  }
+  return out;
+}
+
+const json &Member(const json &j, const char *key) {
+  static const json kNull;
+  const auto it = j.find(key);
+  return it != j.end() ? *it : kNull;
+}
+
+// Non-empty buckets as [lower_us, count] pairs. Min, max and the sum come
+// back within a bucket of the original.
+json HistogramJson(const LatencyHistogram &h) {
+  json out = json::array();
+  for (const auto &[lower_us, n] : h.Buckets())
+    out.push_back({lower_us, n});
+  return out;
+}
+
+LatencyHistogram HistogramFrom(const json &j) {
+  LatencyHistogram h;
+  if (!j.is_array())
+    return h;
+  for (const auto &pair : j) {
+    if (pair.is_array() && pair.size() == 2 && pair[0].is_number_integer() &&
+        pair[1].is_number_unsigned())
+      h.RecordMany(pair[0].get<long long>(), pair[1].get<std::uint64_t>());
+  }
+  return h;
+}
+
+json RateLimitJson(const RateLimitState &rl) {
+  return {
+      {"limit_requests", rl.limit_requests},
+      {"remaining_requests", rl.remaining_requests},
+      {"reset_requests_ms", rl.reset_requests_ms},
+      {"limit_tokens", rl.limit_tokens},
+      {"remaining_tokens", rl.remaining_tokens},
+      {"reset_tokens_ms", rl.reset_tokens_ms},
+      {"retry_after_ms", rl.retry_after_ms},
+  };
+}
+
+RateLimitState RateLimitFrom(const json &j) {
+  RateLimitState rl;
+  if (!j.is_object())
+    return rl;
+  rl.limit_requests = j.value("limit_requests", -1LL);
+  rl.remaining_requests = j.value("remaining_requests", -1LL);
+  rl.reset_requests_ms = j.value("reset_requests_ms", -1LL);
+  rl.limit_tokens = j.value("limit_tokens", -1LL);
+  rl.remaining_tokens = j.value("remaining_tokens", -1LL);
+  rl.reset_tokens_ms = j.value("reset_tokens_ms", -1LL);
+  rl.retry_after_ms = j.value("retry_after_ms", -1LL);
+  return rl;
+}
+
+json TraceJson(const RequestTrace &t) {
+  return {
+      {"step", t.step},
+      {"method", t.method},
+      {"url", t.url},
+      {"status", t.status},
+      {"latency_ms", t.latency_ms},
+      {"phases_us",
+       {t.phases.dns_us, t.phases.connect_us, t.phases.tls_us,
+        t.phases.ttfb_us, t.phases.total_us}},
+      {"connection_reused", t.connection_reused},
+      {"rate_limit_headers", HeadersJson(t.rate_limit_headers)},
+      {"response_snippet", t.response_snippet},
+      {"error", t.error},
+      {"state", t.state},
+      {"attempt", t.attempt},
+      {"paced_ms", t.paced_ms},
+      {"backoff_ms", t.backoff_ms},
+  };
+}
+
+RequestTrace TraceFrom(const json &j) {
+  RequestTrace t;
+  t.step = j.value("step", std::string{});
+  t.method = j.value("method", std::string{});
+  t.url = j.value("url", std::string{});
+  t.status = j.value("status", -1L);
+  t.latency_ms = j.value("latency_ms", -1L);
+  const json &phases = Member(j, "phases_us");
+  if (phases.is_array() && phases.size() == 5) {
+    t.phases.dns_us = phases[0].get<long long>();
+    t.phases.connect_us = phases[1].get<long long>();
+    t.phases.tls_us = phases[2].get<long long>();
+    t.phases.ttfb_us = phases[3].get<long long>();
+    t.phases.total_us = phases[4].get<long long>();
+  }
+  t.connection_reused = j.value("connection_reused", false);
+  t.rate_limit_headers = Headers(Member(j, "rate_limit_headers"));
+  t.response_snippet = j.value("response_snippet", std::string{});
+  t.error = j.value("error", std::string{});
+  t.state = j.value("state", std::string{"completed"});
+  t.attempt = j.value("attempt", 1);
+  t.paced_ms = j.value("paced_ms", 0LL);
+  t.backoff_ms = j.value("backoff_ms", 0LL);
+  return t;
+}
+
+json BenchmarkJson(const BenchmarkResult &b) {
+  json windows = json::array();
+  for (const auto &w : b.windows)
+    windows.push_back({w.start_ms, w.sent, w.errors, w.rate_limited, w.p50_us,
+                       w.p99_us});
+  json status_counts = json::array();
+  for (const auto &[status, n] : b.status_counts)
+    status_counts.push_back({status, n});
+  return {
+      {"model", b.model},
+      {"mode", b.mode},
+      {"target_rps", b.target_rps},
+      {"concurrency", b.concurrency},
+      {"duration_seconds", b.duration_seconds},
+      {"sent", b.sent},
+      {"completed", b.completed},
+      {"succeeded", b.succeeded},
+      {"achieved_rps", b.achieved_rps},
+      {"error_rate", b.error_rate},
+      {"status_counts", status_counts},
+      {"latency", HistogramJson(b.latency)},
+      {"windows", windows},
+      {"first_429_ms", b.first_429_ms},
+      {"sent_before_first_429", b.sent_before_first_429},
+      {"rps_at_first_429", b.rps_at_first_429},
+      {"last_rate_limit_headers", HeadersJson(b.last_rate_limit_headers)},
+      {"notes", b.notes},
+  };
+}
+
+BenchmarkResult BenchmarkFrom(const json &j) {
+  BenchmarkResult b;
+  if (!j.is_object())
+    return b;
+  b.ran = true;
+  b.model = j.value("model", std::string{});
+  b.mode = j.value("mode", std::string{});
+  b.target_rps = j.value("target_rps", 0.0);
+  b.concurrency = j.value("concurrency", 0);
+  b.duration_seconds = j.value("duration_seconds", 0);
+  b.sent = j.value("sent", 0);
+  b.completed = j.value("completed", 0);
+  b.succeeded = j.value("succeeded", 0);
+  b.achieved_rps = j.value("achieved_rps", 0.0);
+  b.error_rate = j.value("error_rate", 0.0);
+  for (const auto &pair : Member(j, "status_counts")) {
+    if (pair.is_array() && pair.size() == 2)
+      b.status_counts[pair[0].get<long>()] = pair[1].get<int>();
+  }
+  b.latency = HistogramFrom(Member(j, "latency"));
+  for (const auto &w : Member(j, "windows")) {
+    if (!w.is_array() || w.size() != 6)
+      continue;
+    BenchmarkWindow window;
+    window.start_ms = w[0].get<long long>();
+    window.sent = w[1].get<int>();
+    window.errors = w[2].get<int>();
+    window.rate_limited = w[3].get<int>();
+    window.p50_us = w[4].get<long long>();
+    window.p99_us = w[5].get<long long>();
+    b.windows.push_back(window);
+  }
+  b.first_429_ms = j.value("first_429_ms", -1LL);
+  b.sent_before_first_429 = j.value("sent_before_first_429", -1);
+  b.rps_at_first_429 = j.value("rps_at_first_429", -1.0);
+  b.last_rate_limit_headers = Headers(Member(j, "last_rate_limit_headers"));
+  b.notes = j.value("notes", std::string{});
+  return b;
+}
+
+// Interned strings in id order, so loading them back gives the same ids, and
+// each result as one flat array.
+json SuitesJson(const SuiteResults &s) {
+  json names = json::array();
+  for (StringInterner::Id i = 0; i < s.names.size(); ++i)
+    names.push_back(s.names.Get(i));
+  json responses = json::array();
+  for (StringInterner::Id i = 0; i < s.responses.size(); ++i)
+    responses.push_back(s.responses.Get(i));
+  json results = json::array();
+  for (const auto &r : s.results)
+    results.push_back({r.suite, r.case_id, r.model, r.status, r.latency_ms,
+                       r.points, r.max_points, r.response, r.response_hash});
+  return {{"names", names}, {"responses", responses}, {"results", results}};
+}
+
+SuiteResults SuitesFrom(const json &j) {
+  SuiteResults s;
+  if (!j.is_object())
+    return s;
+  for (const auto &name : Strings(Member(j, "names")))
+    s.names.Intern(name);
+  for (const auto &text : Strings(Member(j, "responses")))
+    s.responses.Intern(text);
+  for (const auto &row : Member(j, "results")) {
+    if (!row.is_array() || row.size() != 9 ||
+        !std::all_of(row.begin(), row.end(),
+                     [](const json &v) { return v.is_number_integer(); }))
+      continue;
+    SuiteCaseResult r;
+    r.suite = row[0].get<StringInterner::Id>();
+    r.case_id = row[1].get<StringInterner::Id>();
+    r.model = row[2].get<StringInterner::Id>();
+    r.status = row[3].get<std::int32_t>();
+    r.latency_ms = row[4].get<std::int32_t>();
+    r.points = row[5].get<std::int32_t>();
+    r.max_points = row[6].get<std::int32_t>();
+    r.response = row[7].get<StringInterner::Id>();
+    r.response_hash = row[8].get<std::uint64_t>();
+    if (r.suite < s.names.size() && r.case_id < s.names.size() &&
+        r.model < s.names.size() && r.response < s.responses.size())
+      s.results.push_back(r);
+  }
+  return s;
+}
+
+json BatchesJson(const std::vector<BatchRun> &batches) {
+  json out = json::array();
+  for (const auto &b : batches) {
+    out.push_back({
+        {"id", b.id},
+        {"model", b.model},
+        {"requests", b.requests},
+        {"status", b.status},
+        {"succeeded", b.succeeded},
+        {"failed", b.failed},
+        {"upload_ms", b.upload_ms},
+        {"turnaround_ms", b.turnaround_ms},
+        {"polls", b.polls},
+        {"error", b.error},
+    });
+  }
+  return out;
+}
+
+std::vector<BatchRun> BatchesFrom(const json &j) {
+  std::vector<BatchRun> out;
+  if (!j.is_array())
+    return out;
+  for (const auto &b : j) {
+    if (!b.is_object())
+      continue;
+    BatchRun run;
+    run.id = b.value("id", std::string{});
+    run.model = b.value("model", std::string{});
+    run.requests = b.value("requests", 0);
+    run.status = b.value("status", std::string{});
+    run.succeeded = b.value("succeeded", 0);
+    run.failed = b.value("failed", 0);
+    run.upload_ms = b.value("upload_ms", -1LL);
+    run.turnaround_ms = b.value("turnaround_ms", -1LL);
+    run.polls = b.value("polls", 0);
+    run.error = b.value("error", std::string{});
+    out.push_back(std::move(run));
+  }
+  return out;
+}
+
+json AuditJson(const ProviderAudit &p) {
+  json checks = json::array();
+  for (const auto &c : p.model_checks) {
+    checks.push_back({
+        {"model", c.model},
+        {"status", c.status},
+        {"latency_ms", c.latency_ms},
+        {"working", c.working},
+        {"error_snippet", c.error_snippet},
+    });
+  }
+  json tests = json::array();
+  for (const auto &t : p.prompt_tests) {
+    tests.push_back({
+        {"name", t.name},
+        {"status", t.status},
+        {"latency_ms", t.latency_ms},
+        {"rate_limit_headers", HeadersJson(t.rate_limit_headers)},
+        {"answer", t.answer},
+        {"error_snippet", t.error_snippet},
+        {"streamed", t.streamed},
+        {"ttft_us", t.ttft_us},
+        {"inter_token_p50_us", t.inter_token_p50_us},
+        {"inter_token_p90_us", t.inter_token_p90_us},
+        {"inter_token_p99_us", t.inter_token_p99_us},
+        {"output_tokens", t.output_tokens},
+        {"tokens_per_second", t.tokens_per_second},
+    });
+  }
+  json traces = json::array();
+  for (const auto &t : p.traces.Retained())
+    traces.push_back(TraceJson(t));
+  json model_latency = json::object();
+  for (const auto &[model, hist] : p.model_latency)
+    model_latency[model] = HistogramJson(hist);
+
+  json out = {
+      {"provider_id", p.provider_id},
+      {"provider_name", p.provider_name},
+      {"key_tier", p.key_tier},
+      {"catalog_shared", p.catalog_shared},
+      {"catalog_source", p.catalog_source},
+      {"auth_status", p.auth_status},
+      {"models_status", p.models_status},
+      {"auth_latency_ms", p.auth_latency_ms},
+      {"models_latency_ms", p.models_latency_ms},
+      {"auth_rate_limit_headers", HeadersJson(p.auth_rate_limit_headers)},
+      {"models_rate_limit_headers", HeadersJson(p.models_rate_limit_headers)},
+      {"sample_models", p.sample_models},
+      {"capability_tags", p.capability_tags},
+      {"working_models", p.working_models},
+      {"failing_models", p.failing_models},
+      {"model_used", p.model_used},
+      {"max_context_seen", p.max_context_seen},
+      {"model_checks", checks},
+      {"prompt_tests", tests},
+      {"suites", SuitesJson(p.suites)},
+      {"batches", BatchesJson(p.batches)},
+      {"traces", traces},
+      {"score_reasoning", p.score_reasoning},
+      {"score_coding", p.score_coding},
+      {"score_axui", p.score_axui},
+      {"score_total", p.score_total},
+      {"total_requests", p.total_requests},
+      {"successful_requests", p.successful_requests},
+      {"failed_requests", p.failed_requests},
+      {"avg_latency_ms", p.avg_latency_ms},
+      {"latency", HistogramJson(p.latency)},
+      {"model_latency", model_latency},
+      {"rate_limit", RateLimitJson(p.rate_limit)},
+      {"throttled_requests", p.throttled_requests},
+      {"notes", p.notes},
+      {"error_snippet", p.error_snippet},
+  };
+  if (p.benchmark.ran)
+    out["benchmark"] = BenchmarkJson(p.benchmark);
+  return out;
+}
+
+ProviderAudit AuditFrom(const json &j, const TraceRetention &retention) {
+  ProviderAudit p;
+  p.provider_id = j.value("provider_id", std::string{});
+  p.provider_name = j.value("provider_name", std::string{});
+  p.key_supplied = true;
+  p.key_tier = j.value("key_tier", std::string{});
+  p.catalog_shared = j.value("catalog_shared", false);
+  p.catalog_source = j.value("catalog_source", std::string{});
+  p.auth_status = j.value("auth_status", -1L);
+  p.models_status = j.value("models_status", -1L);
+  p.auth_latency_ms = j.value("auth_latency_ms", -1L);
+  p.models_latency_ms = j.value("models_latency_ms", -1L);
+  p.auth_rate_limit_headers = Headers(Member(j, "auth_rate_limit_headers"));
+  p.models_rate_limit_headers =
+      Headers(Member(j, "models_rate_limit_headers"));
+  p.sample_models = Strings(Member(j, "sample_models"));
+  p.capability_tags = Strings(Member(j, "capability_tags"));
+  p.working_models = Strings(Member(j, "working_models"));
+  p.failing_models = Strings(Member(j, "failing_models"));
+  p.model_used = j.value("model_used", std::string{});
+  p.max_context_seen = j.value("max_context_seen", -1LL);
+
+  for (const auto &c : Member(j, "model_checks")) {
+    ModelCheck check;
+    check.model = c.value("model", std::string{});
+    check.status = c.value("status", -1L);
+    check.latency_ms = c.value("latency_ms", -1L);
+    check.working = c.value("working", false);
+    check.error_snippet = c.value("error_snippet", std::string{});
+    p.model_checks.push_back(std::move(check));
+  }
+  for (const auto &t : Member(j, "prompt_tests")) {
+    PromptTest test;
+    test.name = t.value("name", std::string{});
+    test.status = t.value("status", -1L);
+    test.latency_ms = t.value("latency_ms", -1L);
+    test.rate_limit_headers = Headers(Member(t, "rate_limit_headers"));
+    test.answer = t.value("answer", std::string{});
+    test.error_snippet = t.value("error_snippet", std::string{});
+    test.streamed = t.value("streamed", false);
+    test.ttft_us = t.value("ttft_us", -1LL);
+    test.inter_token_p50_us = t.value("inter_token_p50_us", -1LL);
+    test.inter_token_p90_us = t.value("inter_token_p90_us", -1LL);
+    test.inter_token_p99_us = t.value("inter_token_p99_us", -1LL);
+    test.output_tokens = t.value("output_tokens", -1LL);
+    test.tokens_per_second = t.value("tokens_per_second", -1.0);
+    p.prompt_tests.push_back(std::move(test));
+  }
+  p.suites = SuitesFrom(Member(j, "suites"));
+  p.batches = BatchesFrom(Member(j, "batches"));
+  p.traces = TraceStore(retention);
+  for (const auto &t : Member(j, "traces")) {
+    if (t.is_object())
+      p.traces.Add(TraceFrom(t));
+  }
+  p.benchmark = BenchmarkFrom(Member(j, "benchmark"));
+
+  p.score_reasoning = j.value("score_reasoning", 0);
+  p.score_coding = j.value("score_coding", 0);
+  p.score_axui = j.value("score_axui", 0);
+  p.score_total = j.value("score_total", 0);
+  p.total_requests = j.value("total_requests", 0);
+  p.successful_requests = j.value("successful_requests", 0);
+  p.failed_requests = j.value("failed_requests", 0);
+  p.avg_latency_ms = j.value("avg_latency_ms", -1L);
+  p.latency = HistogramFrom(Member(j, "latency"));
+  const json &model_latency = Member(j, "model_latency");
+  if (model_latency.is_object()) {
+    for (const auto &[model, hist] : model_latency.items())
+      p.model_latency[model] = HistogramFrom(hist);
+  }
+  p.rate_limit = RateLimitFrom(Member(j, "rate_limit"));
+  p.throttled_requests = j.value("throttled_requests", 0);
+  p.notes = j.value("notes", std::string{});
+  p.error_snippet = j.value("error_snippet", std::string{});
+  return p;
+}
+
+} // namespace
+
+json ProviderAuditToJson(const ProviderAudit &audit) {
+  return AuditJson(audit);
+}
+
+ProviderAudit ProviderAuditFromJson(const json &j,
+                                    const TraceRetention &retention) {
+  return AuditFrom(j, retention);
+}
+
+json RateLimitStateToJson(const RateLimitState &state) {
+  return RateLimitJson(state);
+}
+
+RateLimitState RateLimitStateFromJson(const json &j) {
+  return RateLimitFrom(j);
+}
+
+std::filesystem::path
+CheckpointStore::FileFor(const std::string &provider_id,
+                         const std::string &key) const {
+  return dir_ /
+         (provider_id + "_" + CatalogStore::Fingerprint(key) + ".json");
+}
+
+std::optional<Checkpoint>
+CheckpointStore::Load(const std::string &provider_id, const std::string &key,
+                      const TraceRetention &retention) const {
+  if (!enabled())
+    return std::nullopt;
+  std::ifstream ifs(FileFor(provider_id, key));
+  if (!ifs)
+    return std::nullopt;
+
+  const auto j = nlohmann::json::parse(ifs, nullptr, false);
+  if (!j.is_object() || j.value("version", 0) != kFormatVersion ||
+      !j.contains("audit") || !j["audit"].is_object() ||
+      j["audit"].value("provider_id", std::string{}) != provider_id)
+    return std::nullopt;
+
+  Checkpoint entry;
+  try {
+    entry.audit = AuditFrom(j["audit"], retention);
+  } catch (const json::exception &) {
+    return std::nullopt;
+  }
+  entry.saved_at = j.value("saved_at", 0LL);
+  entry.signature = j.value("signature", std::string{});
+  return entry;
+}
+
+bool CheckpointStore::Save(const ProviderAudit &audit,
+                           const std::string &signature,
+                           long long saved_at) const {
+  if (!enabled() || !audit.key_supplied)
+    return false;
+  std::error_code ec;
+  std::filesystem::create_directories(dir_, ec);
+  if (ec)
+    return false;
+
+  const json j = {
+      {"version", kFormatVersion},
+      {"saved_at", saved_at},
+      {"signature", signature},
+      {"audit", AuditJson(audit)},
+  };
+
+  // Some providers take the key in the URL, and errors may echo it.
+  const std::string text = RedactKey(
+      j.dump(-1, ' ', false, json::error_handler_t::replace), audit.api_key);
+  std::string error;
+  return WriteFileAtomically(FileFor(audit.provider_id, audit.api_key), text,
+                             error);
+}
+
+} // namespace llaudit
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+
+#include "audit_engine.h"
+
+namespace llaudit {
+
+struct Checkpoint {
+  // api_key is empty: the caller looked the entry up by that key.
+  ProviderAudit audit;
+  long long saved_at = 0;  // Unix seconds
+  // What the key was probed with; a mismatch means the result is stale.
+  std::string signature;
+};
+
+// The document a checkpoint stores for one audit, also what cluster workers
+// send their results in. The key, its index and the raw payload are left out,
+// and only retained traces are kept; restored traces are re-added under the
+// given retention policy. Parsing throws nlohmann::json::exception on a
+// malformed document.
+nlohmann::json ProviderAuditToJson(const ProviderAudit& audit);
+ProviderAudit ProviderAuditFromJson(const nlohmann::json& j, const TraceRetention& retention);
+// Missing members read as -1.
+nlohmann::json RateLimitStateToJson(const RateLimitState& state);
+RateLimitState RateLimitStateFromJson(const nlohmann::json& j);
+
+// Finished provider audits on disk, one JSON file per provider and key
+// fingerprint, saved as soon as each key completes so that a canceled or
+// crashed run keeps what it already probed. Keys and raw payloads are never
+// written, and only the retained request traces are kept. A
+// default-constructed store is disabled.
+class CheckpointStore {
+ public:
+  CheckpointStore() = default;
+  explicit CheckpointStore(std::filesystem::path dir) : dir_(std::move(dir)) {}
+
+  bool enabled() const { return !dir_.empty(); }
+
+  // Restored traces are re-added under the given retention policy.
+  std::optional<Checkpoint> Load(const std::string& provider_id, const std::string& key,
+                                 const TraceRetention& retention) const;
+  // Writes through a temporary file so a crash never leaves a torn entry.
+  bool Save(const ProviderAudit& audit, const std::string& signature, long long saved_at) const;
+
+ private:
+  std::filesystem::path FileFor(const std::string& provider_id, const std::string& key) const;
+
+  std::filesystem::path dir_;
+};
+
+}  // namespace llaudit
@@ -0,0 +1,382 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audit_engine.h"
+#include "audit_metrics.h"
+#include "cluster.h"
+#include "metrics_server.h"
+#include "report_writer.h"
+#include "workspace.h"
+
+namespace {
+
+// Set from the signal handler; an audit in flight sees it as a cancel request.
+std::atomic<bool> g_stop{false};
+static_assert(std::atomic<bool>::is_always_lock_free);
+
+void HandleStopSignal(int) { g_stop.store(true); }
+
+struct CliOptions {
+  std::string workspace;
+  bool resume = false;
+  bool batch = false;
+  llaudit::RecordMode record = llaudit::RecordMode::kOff;
+  bool replay_latency = false;
+  bool daemon = false;
+  long long interval_seconds = 60 * 60;
+  bool journal = true;
+  bool history = true;
+  bool quiet = false;
+  int metrics_port = -1;  // < 0: no exporter
+  std::string metrics_bind = "127.0.0.1";
+  // Cluster mode; the shared token comes from LLAUDIT_CLUSTER_TOKEN.
+  int coordinate_port = -1;  // < 0: audit locally
+  std::string cluster_bind = "127.0.0.1";
+  bool cluster_plaintext = false;
+  std::vector<std::string> regions;
+  std::string worker_url;  // set: run as a worker of that coordinator
+  std::string region;
+  std::string worker_name;
+  int slots = 4;
+};
+
+void PrintUsage(std::FILE* out) {
+  std::fputs(
+      "Usage: api_tester_cli [options]\n"
+      "Runs a full audit of the keys in <workspace>/config/api_keys.json and writes\n"
+      "the JSON and TXT reports, run log, run journal and history, like the GUI.\n"
+      "\n"
+      "  --workspace DIR   workspace directory (default: the one last applied in\n"
+      "                    the GUI, else the current directory)\n"
+      "  --resume          reuse fresh checkpoints; re-probe only failed or stale keys\n"
+      "  --batch           send probes and prompts through provider batch APIs where\n"
+      "                    available (slower to finish, cheaper on rate-limited keys)\n"
+      "  --record          save every response to <workspace>/cache/responses\n"
+      "  --replay          serve responses from the last --record run instead of the\n"
+      "                    network, as fast as the engine can consume them\n"
+      "  --replay-latency  like --replay, but wait out the recorded latencies\n"
+      "  --daemon          keep running and audit every --interval seconds\n"
+      "  --interval SECS   time between audit starts in daemon mode (default 3600)\n"
+      "  --no-journal      do not write the run journal\n"
+      "  --no-history      do not append the run to history/\n"
+      "  --quiet           print only the result lines, not the run log\n"
+      "  --metrics-port N  serve Prometheus metrics at http://ADDR:N/metrics\n"
+      "                    (0 picks a free port); most useful with --daemon\n"
+      "  --metrics-bind ADDR  IPv4 address for the exporter (default 127.0.0.1)\n"
+      "\n"
+      "Cluster mode (token for both sides in LLAUDIT_CLUSTER_TOKEN). The protocol is\n"
+      "plain HTTP and leases carry the API keys: beyond localhost, run the coordinator\n"
+      "behind a TLS terminator or tunnel and give workers the https:// or tunnel URL.\n"
+      "  --coordinate PORT hand the keys out to workers on PORT instead of auditing\n"
+      "                    them here, and write the merged reports\n"
+      "  --cluster-bind ADDR  IPv4 address for the coordinator (default 127.0.0.1;\n"
+      "                    any other address needs a token and --cluster-plaintext)\n"
+      "  --cluster-plaintext  allow cleartext HTTP beyond localhost on a network that\n"
+      "                    is already private (coordinator and worker)\n"
+      "  --regions A,B     audit every key once from each region\n"
+      "  --worker URL      audit keys leased from the coordinator at URL; keys come\n"
+      "                    from the coordinator, providers and suites from here;\n"
+      "                    with --daemon, keep waiting for the coordinator's next run\n"
+      "  --region NAME     the region this worker audits from\n"
+      "  --worker-name NAME  how the coordinator names this worker (default: the\n"
+      "                    region, else \"worker\")\n"
+      "  --slots N         keys a worker audits at once (default 4)\n"
+      "\n"
+      "  --help            show this help\n"
+      "\n"
+      "Exit status: 0 when every supplied key is healthy, 2 when some are not or\n"
+      "the audit was interrupted, 1 on usage, workspace or key config errors.\n",
+      out);
+}
+
+bool ParseArgs(int argc, char** argv, CliOptions& options, std::string& error) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    auto value = [&](std::string& out) {
+      if (i + 1 >= argc) {
+        error = arg + " needs a value";
+        return false;
+      }
+      out = argv[++i];
+      return true;
+    };
+    std::string v;
+    if (arg == "--workspace") {
+      if (!value(options.workspace)) return false;
+    } else if (arg == "--resume") {
+      options.resume = true;
+    } else if (arg == "--batch") {
+      options.batch = true;
+    } else if (arg == "--record") {
+      options.record = llaudit::RecordMode::kRecord;
+    } else if (arg == "--replay" || arg == "--replay-latency") {
+      options.record = llaudit::RecordMode::kReplay;
+      options.replay_latency = options.replay_latency || arg == "--replay-latency";
+    } else if (arg == "--daemon") {
+      options.daemon = true;
+    } else if (arg == "--interval") {
+      if (!value(v)) return false;
+      char* end = nullptr;
+      options.interval_seconds = std::strtoll(v.c_str(), &end, 10);
+      if (end == v.c_str() || *end != '\0' || options.interval_seconds <= 0) {
+        error = "--interval needs a positive number of seconds";
+        return false;
+      }
+    } else if (arg == "--no-journal") {
+      options.journal = false;
+    } else if (arg == "--no-history") {
+      options.history = false;
+    } else if (arg == "--quiet") {
+      options.quiet = true;
+    } else if (arg == "--metrics-port") {
+      if (!value(v)) return false;
+      char* end = nullptr;
+      const long port = std::strtol(v.c_str(), &end, 10);
+      if (end == v.c_str() || *end != '\0' || port < 0 || port > 65535) {
+        error = "--metrics-port needs a port number from 0 to 65535";
+        return false;
+      }
+      options.metrics_port = static_cast<int>(port);
+    } else if (arg == "--metrics-bind") {
+      if (!value(options.metrics_bind)) return false;
+    } else if (arg == "--coordinate") {
+      if (!value(v)) return false;
+      char* end = nullptr;
+      const long port = std::strtol(v.c_str(), &end, 10);
+      if (end == v.c_str() || *end != '\0' || port < 0 || port > 65535) {
+        error = "--coordinate needs a port number from 0 to 65535";
+        return false;
+      }
+      options.coordinate_port = static_cast<int>(port);
+    } else if (arg == "--cluster-bind") {
+      if (!value(options.cluster_bind)) return false;
+    } else if (arg == "--cluster-plaintext") {
+      options.cluster_plaintext = true;
+    } else if (arg == "--regions") {
+      if (!value(v)) return false;
+      options.regions.clear();
+      for (std::size_t at = 0; at <= v.size();) {
+        const auto comma = std::min(v.find(',', at), v.size());
+        if (comma > at) options.regions.push_back(v.substr(at, comma - at));
+        at = comma + 1;
+      }
+    } else if (arg == "--worker") {
+      if (!value(options.worker_url)) return false;
+    } else if (arg == "--region") {
+      if (!value(options.region)) return false;
+    } else if (arg == "--worker-name") {
+      if (!value(options.worker_name)) return false;
+    } else if (arg == "--slots") {
+      if (!value(v)) return false;
+      char* end = nullptr;
+      const long slots = std::strtol(v.c_str(), &end, 10);
+      if (end == v.c_str() || *end != '\0' || slots < 1 || slots > 256) {
+        error = "--slots needs a number from 1 to 256";
+        return false;
+      }
+      options.slots = static_cast<int>(slots);
+    } else {
+      error = "unknown option " + arg;
+      return false;
+    }
+  }
+  if (options.coordinate_port >= 0 && !options.worker_url.empty()) {
+    error = "--coordinate and --worker are exclusive";
+    return false;
+  }
+  return true;
+}
+
+std::string ClusterToken() {
+  const char* token = std::getenv("LLAUDIT_CLUSTER_TOKEN");
+  return token ? token : "";
+}
+
+// One audit of the workspace; returns the process exit status.
+int RunOnce(const llaudit::WorkspacePaths& paths, const CliOptions& options,
+            llaudit::AuditMetrics* metrics) {
+  // Reloaded every time so a daemon picks up edited keys and providers.
+  std::vector<llaudit::ProviderSpec> providers;
+  std::string error;
+  if (!llaudit::LoadWorkspaceProviders(paths, providers, error)) {
+    std::cerr << "Provider registry error: " << error << "\n";
+    return 1;
+  }
+  auto fields = llaudit::KeyFieldsFor(providers);
+  if (!llaudit::LoadConfig(fields, paths.config_file, error)) {
+    std::cerr << "Key config error: " << error << "\n";
+    return 1;
+  }
+
+  const auto pools = llaudit::KeysToPools(fields);
+  if (std::none_of(pools.begin(), pools.end(), [](const auto& pool) { return !pool.second.empty(); })) {
+    std::cerr << "No API keys in " << paths.config_file.string() << "\n";
+    return 1;
+  }
+
+  llaudit::WorkspaceRunOptions run_options;
+  run_options.resume = options.resume;
+  run_options.batch = options.batch;
+  run_options.record = options.record;
+  run_options.replay_latency = options.replay_latency;
+  run_options.journal = options.journal;
+  run_options.history = options.history;
+  run_options.metrics = metrics;
+  const llaudit::LogFn log = [&options](const std::string& line) {
+    if (!options.quiet) std::cerr << line << "\n";
+  };
+  llaudit::WorkspaceRun run;
+  if (options.coordinate_port >= 0) {
+    llaudit::CoordinatorOptions cluster;
+    cluster.bind_address = options.cluster_bind;
+    cluster.port = options.coordinate_port;
+    cluster.token = ClusterToken();
+    cluster.allow_plaintext = options.cluster_plaintext;
+    cluster.regions = options.regions;
+    cluster.on_listening = [&options](int port) {
+      std::cout << "Coordinator: http://" << options.cluster_bind << ":" << port << "\n";
+      std::cout.flush();
+    };
+    if (!llaudit::RunClusterAudit(paths, pools, cluster, log, g_stop, run, error)) {
+      std::cerr << "Coordinator failed: " << error << "\n";
+      return 1;
+    }
+  } else {
+    run = llaudit::RunWorkspaceAudit(paths, pools, run_options, log, g_stop);
+  }
+  const auto& report = *run.report;
+
+  // The run has already written the run log.
+  const auto written = llaudit::WriteReports(report, paths.reports_dir, {});
+  std::cout << "JSON report: " << (written.json.empty() ? "(failed)" : written.json) << "\n";
+  std::cout << "TXT report: " << (written.text.empty() ? "(failed)" : written.text) << "\n";
+  std::cout << "Run log: " << (run.run_log_path.empty() ? "(failed)" : run.run_log_path) << "\n";
+  if (!run.journal_path.empty()) std::cout << "Journal: " << run.journal_path << "\n";
+  if (!run.suites_error.empty()) std::cerr << "Prompt suites ignored: " << run.suites_error << "\n";
+  if (!run.journal_error.empty()) std::cerr << "Journal failed: " << run.journal_error << "\n";
+  if (!run.history_error.empty()) std::cerr << "History failed: " << run.history_error << "\n";
+
+  int keys = 0;
+  int healthy = 0;
+  for (const auto& p : report.providers) keys += p.key_supplied ? 1 : 0;
+  for (const auto& pool : report.pools) healthy += pool.keys_healthy;
+  std::cout << "Healthy keys: " << healthy << "/" << keys << "\n";
+  if (!options.quiet && !run.history_delta.empty()) std::cout << run.history_delta;
+
+  if (g_stop.load()) {
+    std::cout << "Audit interrupted.\n";
+    return 2;
+  }
+  return healthy == keys ? 0 : 2;
+}
+
+// Serves a coordinator until it is done, or for good in daemon mode.
+int RunWorker(const llaudit::WorkspacePaths& paths, const CliOptions& options,
+              llaudit::AuditMetrics* metrics) {
+  llaudit::WorkerOptions worker;
+  worker.coordinator_url = options.worker_url;
+  worker.region = options.region;
+  worker.name = !options.worker_name.empty() ? options.worker_name
+                : !options.region.empty()    ? options.region
+                                             : "worker";
+  worker.token = ClusterToken();
+  worker.allow_plaintext = options.cluster_plaintext;
+  worker.slots = options.slots;
+  worker.stay = options.daemon;
+  worker.run.resume = options.resume;
+  worker.run.batch = options.batch;
+  worker.run.record = options.record;
+  worker.run.replay_latency = options.replay_latency;
+  worker.run.metrics = metrics;
+  std::string error;
+  const bool ok = llaudit::RunAuditWorker(
+      paths, worker,
+      [&options](const std::string& line) {
+        if (!options.quiet) std::cerr << line << "\n";
+      },
+      g_stop, error);
+  if (!ok) {
+    std::cerr << "Worker failed: " << error << "\n";
+    return 1;
+  }
+  return g_stop.load() ? 2 : 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  CliOptions options;
+  std::string error;
+  for (int i = 1; i < argc; ++i) {
+    if (std::string(argv[i]) == "--help" || std::string(argv[i]) == "-h") {
+      PrintUsage(stdout);
+      return 0;
+    }
+  }
+  if (!ParseArgs(argc, argv, options, error)) {
+    std::cerr << "api_tester_cli: " << error << "\n";
+    PrintUsage(stderr);
+    return 1;
+  }
+
+  if (options.workspace.empty()) {
+    std::string hint_error;
+    if (!llaudit::LoadWorkspaceHint(options.workspace, hint_error)) {
+      std::cerr << "Workspace hint warning: " << hint_error << "\n";
+    }
+  }
+  if (options.workspace.empty()) options.workspace = std::filesystem::current_path().string();
+
+  const auto paths = llaudit::BuildPaths(options.workspace);
+  if (!llaudit::EnsureWorkspace(paths, error)) {
+    std::cerr << "Workspace setup failed: " << error << "\n";
+    return 1;
+  }
+
+  // One registry for the whole process, so counters keep growing across
+  // daemon runs the way Prometheus expects.
+  llaudit::AuditMetrics metrics;
+  llaudit::MetricsServer metrics_server(metrics);
+  if (options.metrics_port >= 0) {
+    if (!metrics_server.Start(options.metrics_bind, options.metrics_port, error)) {
+      std::cerr << "Metrics exporter failed: " << error << "\n";
+      return 1;
+    }
+    std::cout << "Metrics: http://" << options.metrics_bind << ":" << metrics_server.port()
+              << "/metrics\n";
+  }
+  llaudit::AuditMetrics* run_metrics = options.metrics_port >= 0 ? &metrics : nullptr;
+
+  std::signal(SIGINT, HandleStopSignal);
+  std::signal(SIGTERM, HandleStopSignal);
+
+  if (!options.worker_url.empty()) return RunWorker(paths, options, run_metrics);
+  if (!options.daemon) return RunOnce(paths, options, run_metrics);
+
+  // Audits start on a fixed schedule, so a slow run does not push the next
+  // ones back. The wait polls so a signal ends it promptly.
+  using Clock = std::chrono::steady_clock;
+  const auto interval = std::chrono::seconds(options.interval_seconds);
+  auto next = Clock::now();
+  int status = 0;
+  while (!g_stop.load()) {
+    std::cout << "Audit started at " << llaudit::ReportTimestamp() << "\n";
+    status = RunOnce(paths, options, run_metrics);
+    std::cout.flush();
+    next += interval;
+    while (next <= Clock::now()) next += interval;
+    while (!g_stop.load() && Clock::now() < next) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    }
+  }
+  return status == 1 ? 1 : 0;
+}
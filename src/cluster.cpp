@@ -0,0 +1,846 @@
+#include "cluster.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string_view>
+#include <thread>
+#include <tuple>
+
+#include <nlohmann/json.hpp>
+
+#include "bounded_log.h"
+#include "checkpoint_store.h"
+#include "http_client.h"
+#include "http_server.h"
+#include "report_writer.h"
+#include "run_journal.h"
+
+namespace llaudit {
+namespace {
+
+using nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+// A result carries every retained trace of its key.
+constexpr std::size_t kMaxMessageBytes = 64 * 1024 * 1024;
+constexpr long long kRetryMs = 1000;
+// Once every unit is done the coordinator keeps answering "done" this long,
+// so that idle workers hear the run is over instead of finding it gone.
+constexpr auto kDrainTime = std::chrono::seconds(3);
+// A unit whose audit failed on this many leases is given up.
+constexpr int kMaxAttempts = 3;
+constexpr auto kPollInterval = std::chrono::milliseconds(200);
+constexpr auto kRecordInterval = std::chrono::seconds(1);
+// Records are posted when a unit has some, and at least this often anyway to
+// keep its lease.
+constexpr auto kHeartbeatInterval = std::chrono::seconds(30);
+
+std::string NowUtc() {
+  const std::time_t t =
+      std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+  std::tm tm{};
+#if defined(_WIN32)
+  gmtime_s(&tm, &t);
+#else
+  gmtime_r(&t, &tm);
+#endif
+  std::ostringstream oss;
+  oss << std::put_time(&tm, "%Y-%m-%dT%H:%M:%SZ");
+  return oss.str();
+}
+
+std::string Dump(const json &j) {
+  return j.dump(-1, ' ', false, json::error_handler_t::replace);
+}
+
+ServerReply JsonReply(const json &j, std::string status = "200 OK") {
+  return {std::move(status), "application/json", Dump(j)};
+}
+
+ServerReply ErrorReply(std::string status, const std::string &message) {
+  return JsonReply({{"error", message}}, std::move(status));
+}
+
+// Waits up to ms, returning early once stop is set.
+void Wait(long long ms, const std::atomic<bool> &stop) {
+  const auto until = Clock::now() + std::chrono::milliseconds(ms);
+  while (!stop.load() && Clock::now() < until)
+    std::this_thread::sleep_for(
+        std::min<Clock::duration>(kPollInterval, until - Clock::now()));
+}
+
+// The state a limit was left in, as seen elapsed_ms later: a window that has
+// reset since no longer says anything about what is left in it.
+RateLimitState Aged(RateLimitState s, long long elapsed_ms) {
+  auto age = [elapsed_ms](long long &reset_ms, long long &remaining) {
+    if (reset_ms < 0)
+      return;
+    reset_ms -= elapsed_ms;
+    if (reset_ms <= 0) {
+      reset_ms = -1;
+      remaining = -1;
+    }
+  };
+  age(s.reset_requests_ms, s.remaining_requests);
+  age(s.reset_tokens_ms, s.remaining_tokens);
+  if (s.retry_after_ms >= 0)
+    s.retry_after_ms =
+        s.retry_after_ms > elapsed_ms ? s.retry_after_ms - elapsed_ms : -1;
+  return s;
+}
+
+// Takes as long for every given value of the expected length, so the time
+// to reject a token says nothing about how much of it was right.
+bool SameSecret(std::string_view given, std::string_view expected) {
+  unsigned char diff = given.size() != expected.size() ? 1 : 0;
+  for (std::size_t i = 0; i < expected.size(); ++i)
+    diff |= static_cast<unsigned char>(i < given.size() ? given[i] : 0) ^
+            static_cast<unsigned char>(expected[i]);
+  return diff == 0;
+}
+
+struct Unit {
+  std::string provider_id;
+  std::string provider_name;
+  ProviderKey key;
+  int key_index = 0;
+  // Empty until leased when the coordinator has no regions; the unit then
+  // takes the region of the worker that audits it.
+  std::string region;
+  enum class State { kQueued, kLeased, kDone } state = State::kQueued;
+  std::string lease;
+  std::string worker;
+  Clock::time_point renewed;
+  int failures = 0;
+  std::optional<ProviderAudit> result;
+};
+
+// Where a key's limits stood when its last lease ended.
+struct KeyLimits {
+  bool leased = false;
+  bool known = false;
+  RateLimitState state;
+  Clock::time_point seen;
+};
+
+class Coordinator {
+public:
+  Coordinator(std::vector<Unit> units, const CoordinatorOptions &options,
+              const LogFn &log, RunJournal &journal)
+      : units_(std::move(units)), options_(options), log_(log),
+        journal_(journal) {}
+
+  // Checks the token and method before the server reads a body.
+  std::optional<ServerReply> Gate(const ServerRequest &request) const;
+  ServerReply Handle(const ServerRequest &request);
+  // Hands expired leases back; true once every unit is done.
+  bool Tick();
+  std::vector<Unit> TakeUnits();
+
+private:
+  ServerReply Lease(const json &body);
+  ServerReply Records(const json &body);
+  ServerReply Result(const json &body);
+
+  Unit *Leased(const json &body);
+  KeyLimits &LimitsOf(const Unit &u) {
+    return limits_[u.provider_id + "|" + u.key.key];
+  }
+  void EndLease(Unit &u, Unit::State next);
+  std::string Describe(const Unit &u) const;
+  std::size_t done() const;
+
+  std::mutex mutex_;
+  std::vector<Unit> units_;
+  const CoordinatorOptions &options_;
+  const LogFn &log_;
+  RunJournal &journal_;
+  std::map<std::string, std::size_t> leases_;
+  std::map<std::string, KeyLimits> limits_;
+  unsigned long long next_lease_ = 0;
+};
+
+std::optional<ServerReply>
+Coordinator::Gate(const ServerRequest &request) const {
+  if (!options_.token.empty()) {
+    const auto auth = request.headers.Find("authorization");
+    if (!auth || !SameSecret(*auth, "Bearer " + options_.token))
+      return ErrorReply("401 Unauthorized", "bad cluster token");
+  }
+  if (request.method != "POST")
+    return ErrorReply("405 Method Not Allowed", "POST only");
+  return std::nullopt;
+}
+
+ServerReply Coordinator::Handle(const ServerRequest &request) {
+  const json body = json::parse(request.body, nullptr, false);
+  if (!body.is_object())
+    return ErrorReply("400 Bad Request", "body is not a JSON object");
+
+  std::scoped_lock lock(mutex_);
+  try {
+    if (request.path == "/v1/lease")
+      return Lease(body);
+    if (request.path == "/v1/records")
+      return Records(body);
+    if (request.path == "/v1/result")
+      return Result(body);
+  } catch (const json::exception &ex) {
+    return ErrorReply("400 Bad Request", ex.what());
+  }
+  return ErrorReply("404 Not Found", "no such endpoint");
+}
+
+ServerReply Coordinator::Lease(const json &body) {
+  const std::string worker = body.value("worker", std::string{});
+  const std::string region = body.value("region", std::string{});
+  const auto &regions = options_.regions;
+  if (!regions.empty() &&
+      std::find(regions.begin(), regions.end(), region) == regions.end())
+    return ErrorReply("400 Bad Request", "this run has no region '" + region +
+                                             "'");
+
+  bool pending = false;
+  for (std::size_t i = 0; i < units_.size(); ++i) {
+    Unit &u = units_[i];
+    if (u.state == Unit::State::kDone ||
+        (!regions.empty() && u.region != region))
+      continue;
+    pending = true;
+    KeyLimits &limits = LimitsOf(u);
+    if (u.state != Unit::State::kQueued || limits.leased)
+      continue;
+
+    limits.leased = true;
+    u.state = Unit::State::kLeased;
+    u.region = region;
+    u.worker = worker;
+    u.renewed = Clock::now();
+    u.lease = std::to_string(++next_lease_);
+    leases_[u.lease] = i;
+    json reply = {
+        {"lease", u.lease},
+        {"provider_id", u.provider_id},
+        {"key", u.key.key},
+        {"tier", u.key.tier},
+        {"key_index", u.key_index},
+        {"region", u.region},
+    };
+    if (limits.known) {
+      const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+          u.renewed - limits.seen);
+      reply["rate_limit"] =
+          RateLimitStateToJson(Aged(limits.state, elapsed.count()));
+    }
+    log_("Leased " + Describe(u) + " to " + worker);
+    return JsonReply(reply);
+  }
+  if (pending)
+    return JsonReply({{"retry_ms", kRetryMs}});
+  return JsonReply({{"done", true}});
+}
+
+Unit *Coordinator::Leased(const json &body) {
+  const auto it = leases_.find(body.value("lease", std::string{}));
+  return it == leases_.end() ? nullptr : &units_[it->second];
+}
+
+ServerReply Coordinator::Records(const json &body) {
+  Unit *u = Leased(body);
+  if (!u)
+    return ErrorReply("409 Conflict", "lease expired");
+  u->renewed = Clock::now();
+  const auto records = body.find("records");
+  if (records == body.end() || !records->is_array())
+    return JsonReply({{"ok", true}});
+  for (const auto &r : *records) {
+    if (!r.is_object())
+      continue;
+    // The coordinator brackets the whole run itself.
+    const std::string type = r.value("type", std::string{});
+    if (type == "run_start" || type == "run_end")
+      continue;
+    json out = r;
+    if (out.contains("key_index"))
+      out["key_index"] = u->key_index;
+    if (!u->region.empty())
+      out["region"] = u->region;
+    out["worker"] = u->worker;
+    journal_.Append(out);
+  }
+  return JsonReply({{"ok", true}});
+}
+
+ServerReply Coordinator::Result(const json &body) {
+  Unit *found = Leased(body);
+  if (!found)
+    return ErrorReply("409 Conflict", "lease expired");
+  Unit &u = *found;
+
+  if (body.value("released", false)) {
+    const std::string why = body.value("error", std::string{});
+    if (why.empty()) {
+      log_(Describe(u) + " handed back by " + u.worker);
+      EndLease(u, Unit::State::kQueued);
+    } else if (++u.failures < kMaxAttempts) {
+      log_(Describe(u) + " failed on " + u.worker + ": " + why);
+      EndLease(u, Unit::State::kQueued);
+    } else {
+      log_(Describe(u) + " failed on " + u.worker + ": " + why +
+           "; giving up after " + std::to_string(kMaxAttempts) + " attempts");
+      ProviderAudit p;
+      p.provider_id = u.provider_id;
+      p.provider_name = u.provider_name;
+      p.api_key = u.key.key;
+      p.key_supplied = true;
+      p.key_index = u.key_index;
+      p.key_tier = u.key.tier;
+      p.region = u.region;
+      p.notes = "Audit failed on " + std::to_string(kMaxAttempts) +
+                " workers.";
+      p.error_snippet = why;
+      u.result = std::move(p);
+      EndLease(u, Unit::State::kDone);
+    }
+    return JsonReply({{"ok", true}});
+  }
+
+  ProviderAudit p = ProviderAuditFromJson(body.at("audit"), options_.traces);
+  p.provider_id = u.provider_id;
+  p.provider_name = u.provider_name;
+  p.api_key = u.key.key;
+  p.key_supplied = true;
+  p.key_index = u.key_index;
+  p.key_tier = u.key.tier;
+  p.region = u.region;
+
+  KeyLimits &limits = LimitsOf(u);
+  limits.known = true;
+  limits.state = p.rate_limit;
+  limits.seen = Clock::now();
+  const std::size_t working = p.working_models.size();
+  u.result = std::move(p);
+  EndLease(u, Unit::State::kDone);
+  log_("Result for " + Describe(u) + " from " + u.worker + ": " +
+       std::to_string(working) + " working models (" +
+       std::to_string(done()) + "/" + std::to_string(units_.size()) +
+       " done)");
+  return JsonReply({{"ok", true}});
+}
+
+void Coordinator::EndLease(Unit &u, Unit::State next) {
+  leases_.erase(u.lease);
+  LimitsOf(u).leased = false;
+  u.lease.clear();
+  u.state = next;
+  if (next == Unit::State::kQueued && options_.regions.empty())
+    u.region.clear();
+}
+
+std::string Coordinator::Describe(const Unit &u) const {
+  std::string out =
+      u.provider_id + " key #" + std::to_string(u.key_index + 1);
+  if (!u.region.empty())
+    out += " [" + u.region + "]";
+  return out;
+}
+
+std::size_t Coordinator::done() const {
+  return static_cast<std::size_t>(
+      std::count_if(units_.begin(), units_.end(), [](const Unit &u) {
+        return u.state == Unit::State::kDone;
+      }));
+}
+
+bool Coordinator::Tick() {
+  std::scoped_lock lock(mutex_);
+  const auto now = Clock::now();
+  const auto timeout = std::chrono::seconds(options_.lease_timeout_seconds);
+  for (auto &u : units_) {
+    if (u.state != Unit::State::kLeased || now - u.renewed < timeout)
+      continue;
+    log_("Lease of " + Describe(u) + " on " + u.worker +
+         " expired; queued again");
+    EndLease(u, Unit::State::kQueued);
+  }
+  return done() == units_.size();
+}
+
+std::vector<Unit> Coordinator::TakeUnits() {
+  std::scoped_lock lock(mutex_);
+  return std::move(units_);
+}
+
+bool IsLoopback(std::string_view host) {
+  if (host.size() > 2 && host.front() == '[' && host.back() == ']')
+    host = host.substr(1, host.size() - 2);
+  return host == "localhost" || host == "::1" || host.starts_with("127.");
+}
+
+// The host of an http(s) URL, with an IPv6 literal kept in its brackets.
+std::string UrlHost(const std::string &url) {
+  std::size_t begin = url.find("://");
+  begin = begin == std::string::npos ? 0 : begin + 3;
+  std::size_t end = url.find_first_of(":/?", begin);
+  if (begin < url.size() && url[begin] == '[') {
+    end = url.find(']', begin);
+    if (end != std::string::npos)
+      ++end;
+  }
+  std::string host = url.substr(
+      begin, end == std::string::npos ? std::string::npos : end - begin);
+  for (auto &c : host)
+    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  return host;
+}
+
+class CoordinatorLink {
+public:
+  explicit CoordinatorLink(const WorkerOptions &options)
+      : http_(std::max(options.slots, 1) * 2), base_(options.coordinator_url) {
+    while (!base_.empty() && base_.back() == '/')
+      base_.pop_back();
+    headers_.push_back("Content-Type: application/json");
+    if (!options.token.empty())
+      headers_.push_back("Authorization: Bearer " + options.token);
+  }
+
+  // status -1 when the coordinator could not be reached.
+  HttpResponse Post(const std::string &path, const std::string &body) {
+    return http_.Request("POST", base_ + path, headers_, body, 30);
+  }
+
+private:
+  HttpClient http_;
+  std::string base_;
+  std::vector<std::string> headers_;
+};
+
+// Sends a unit's journal records to the coordinator about once a second,
+// which also keeps its lease. Sets stop when the run is canceled or the
+// coordinator has handed the lease to another worker.
+class RecordUplink {
+public:
+  RecordUplink(CoordinatorLink &link, std::string lease, std::string key,
+               const std::atomic<bool> &cancel, std::atomic<bool> &stop)
+      : link_(link), lease_(std::move(lease)), key_(std::move(key)),
+        cancel_(cancel), stop_(stop), thread_([this] { Run(); }) {}
+  ~RecordUplink() { Finish(); }
+
+  void Push(const json &record) {
+    std::scoped_lock lock(mutex_);
+    pending_.push_back(record);
+  }
+  // Stops the thread and sends what is left.
+  void Finish();
+  bool lost() const { return lost_.load(); }
+
+private:
+  void Run();
+  void Send();
+
+  CoordinatorLink &link_;
+  const std::string lease_;
+  const std::string key_;
+  const std::atomic<bool> &cancel_;
+  std::atomic<bool> &stop_;
+  std::atomic<bool> lost_{false};
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool finishing_ = false;
+  json pending_ = json::array();
+  std::thread thread_;
+};
+
+void RecordUplink::Finish() {
+  {
+    std::scoped_lock lock(mutex_);
+    if (finishing_)
+      return;
+    finishing_ = true;
+  }
+  wake_.notify_all();
+  thread_.join();
+  Send();
+}
+
+void RecordUplink::Run() {
+  auto last_sent = Clock::now();
+  std::unique_lock lock(mutex_);
+  while (!finishing_) {
+    wake_.wait_for(lock, kPollInterval);
+    if (cancel_.load())
+      stop_.store(true);
+    const auto now = Clock::now();
+    if (finishing_ || lost_.load() || now - last_sent < kRecordInterval ||
+        (pending_.empty() && now - last_sent < kHeartbeatInterval))
+      continue;
+    lock.unlock();
+    Send();
+    lock.lock();
+    last_sent = now;
+  }
+}
+
+void RecordUplink::Send() {
+  if (lost_.load())
+    return;
+  json records = json::array();
+  {
+    std::scoped_lock lock(mutex_);
+    records.swap(pending_);
+  }
+  const auto r = link_.Post(
+      "/v1/records",
+      RedactKey(Dump({{"lease", lease_}, {"records", records}}), key_));
+  if (r.status == 409) {
+    lost_.store(true);
+    stop_.store(true);
+  } else if (r.status != 200) {
+    // Kept for the next attempt, ahead of anything recorded since.
+    std::scoped_lock lock(mutex_);
+    for (auto &record : pending_)
+      records.push_back(std::move(record));
+    pending_ = std::move(records);
+  }
+}
+
+struct WorkerLease {
+  std::string id;
+  std::string provider_id;
+  ProviderKey key;
+  int key_index = 0;
+  std::string region;
+  std::optional<RateLimitState> rate_limit;
+};
+
+WorkerLease LeaseFrom(const json &j) {
+  WorkerLease lease;
+  lease.id = j.value("lease", std::string{});
+  lease.provider_id = j.value("provider_id", std::string{});
+  lease.key.key = j.value("key", std::string{});
+  lease.key.tier = j.value("tier", std::string{});
+  lease.key_index = j.value("key_index", 0);
+  lease.region = j.value("region", std::string{});
+  if (const auto it = j.find("rate_limit"); it != j.end() && it->is_object())
+    lease.rate_limit = RateLimitStateFromJson(*it);
+  return lease;
+}
+
+struct WorkerContext {
+  const WorkspacePaths &paths;
+  const WorkerOptions &options;
+  CoordinatorLink &link;
+  const LogFn &log;
+  const std::atomic<bool> &cancel_requested;
+};
+
+// Audits one leased key and posts its result, or hands it back.
+void AuditUnit(const WorkerLease &lease, const WorkerContext &ctx) {
+  const std::string name = lease.provider_id + " key #" +
+                           std::to_string(lease.key_index + 1);
+  ctx.log("Auditing " + name);
+
+  std::atomic<bool> stop{false};
+  std::string failure;
+  std::shared_ptr<const AuditReport> report;
+  {
+    RecordUplink uplink(ctx.link, lease.id, lease.key.key,
+                        ctx.cancel_requested, stop);
+    WorkspaceRunOptions run = ctx.options.run;
+    run.journal = false;
+    run.history = false;
+    run.only_keyed_providers = true;
+    run.on_record = [&uplink](const json &r) { uplink.Push(r); };
+    if (lease.rate_limit)
+      run.initial_rate_limits[lease.provider_id + "|" + lease.key.key] =
+          *lease.rate_limit;
+    try {
+      report = RunWorkspaceAudit(ctx.paths,
+                                 {{lease.provider_id, {lease.key}}}, run,
+                                 ctx.log, stop)
+                   .report;
+    } catch (const std::exception &ex) {
+      failure = ex.what();
+    }
+    uplink.Finish();
+    if (uplink.lost()) {
+      ctx.log("Lease of " + name + " expired; result dropped");
+      return;
+    }
+  }
+
+  json result = {{"lease", lease.id}};
+  if (failure.empty() && !stop.load() &&
+      (!report || report->providers.size() != 1))
+    failure = "provider " + lease.provider_id + " is unknown to this worker";
+  if (stop.load() || !failure.empty()) {
+    result["released"] = true;
+    if (!failure.empty())
+      result["error"] = failure;
+  } else {
+    result["audit"] = ProviderAuditToJson(report->providers.front());
+  }
+  const std::string body = RedactKey(Dump(result), lease.key.key);
+
+  // The result is worth waiting for, even when the run was canceled.
+  const std::atomic<bool> never{false};
+  const auto give_up = Clock::now() +
+                       std::chrono::seconds(ctx.options.give_up_seconds);
+  for (;;) {
+    const auto r = ctx.link.Post("/v1/result", body);
+    if (r.status == 200)
+      break;
+    if (r.status > 0 || Clock::now() >= give_up) {
+      ctx.log("Could not deliver " + name + ": " +
+              (r.status > 0 ? r.body : r.error));
+      return;
+    }
+    Wait(kRetryMs, never);
+  }
+  ctx.log((failure.empty() && !stop.load() ? "Delivered " : "Handed back ") +
+          name);
+}
+
+} // namespace
+
+bool RunClusterAudit(const WorkspacePaths &paths, const KeyPools &keys,
+                     const CoordinatorOptions &options, const LogFn &log,
+                     const std::atomic<bool> &cancel_requested,
+                     WorkspaceRun &out, std::string &error) {
+  if (!IsLoopback(options.bind_address)) {
+    if (options.token.empty()) {
+      error = "a cluster token is required to listen on " +
+              options.bind_address;
+      return false;
+    }
+    if (!options.allow_plaintext) {
+      error = "listening on " + options.bind_address +
+              " would send keys in cleartext; put a TLS terminator or tunnel "
+              "in front, or allow plaintext explicitly";
+      return false;
+    }
+  }
+
+  std::vector<ProviderSpec> providers;
+  if (!LoadWorkspaceProviders(paths, providers, out.providers_error) && log)
+    log("Provider registry ignored: " + out.providers_error);
+
+  AuditReport report;
+  report.generated_at_utc = NowUtc();
+  std::mutex log_mutex;
+  BoundedLog run_log(options.max_run_log_lines);
+  const LogFn push_log = [&](const std::string &message) {
+    const std::string line = "[" + NowUtc() + "] " + message;
+    std::scoped_lock lock(log_mutex);
+    if (log)
+      log(line);
+    run_log.Push(line);
+  };
+
+  // Queued in report order, so workers take keys provider by provider.
+  std::vector<Unit> units;
+  const std::vector<std::string> regions =
+      options.regions.empty() ? std::vector<std::string>{""}
+                              : options.regions;
+  for (const auto &spec : providers) {
+    const auto it = keys.find(spec.id);
+    if (it == keys.end())
+      continue;
+    for (const auto &region : regions) {
+      for (std::size_t k = 0; k < it->second.size(); ++k) {
+        Unit u;
+        u.provider_id = spec.id;
+        u.provider_name = spec.name;
+        u.key = it->second[k];
+        u.key_index = static_cast<int>(k);
+        u.region = region;
+        units.push_back(std::move(u));
+      }
+    }
+  }
+
+  JournalOptions journal_options;
+  journal_options.compress = RunJournal::CompressionAvailable();
+  RunJournal journal(paths.reports_dir /
+                         ("llm_api_audit_" + ReportTimestamp() +
+                          RunJournal::Extension(journal_options)),
+                     journal_options);
+  journal.Append({{"type", "run_start"},
+                  {"generated_at_utc", report.generated_at_utc},
+                  {"keys", units.size()},
+                  {"regions", options.regions}});
+
+  const std::size_t unit_count = units.size();
+  Coordinator coordinator(std::move(units), options, push_log, journal);
+  HttpServer server(
+      [&coordinator](const ServerRequest &r) { return coordinator.Handle(r); },
+      kMaxMessageBytes,
+      [&coordinator](const ServerRequest &r) { return coordinator.Gate(r); });
+  if (!server.Start(options.bind_address, options.port, error))
+    return false;
+  if (options.on_listening)
+    options.on_listening(server.port());
+  push_log("Coordinating " + std::to_string(unit_count) + " work units on " +
+           options.bind_address + ":" + std::to_string(server.port()));
+
+  while (!cancel_requested.load() && !coordinator.Tick())
+    std::this_thread::sleep_for(kPollInterval);
+  if (!cancel_requested.load())
+    Wait(std::chrono::duration_cast<std::chrono::milliseconds>(kDrainTime)
+             .count(),
+         cancel_requested);
+  server.Stop();
+  units = coordinator.TakeUnits();
+
+  // Provider, then region, then key; without named regions the region of a
+  // unit is whichever worker took it.
+  std::map<std::string, std::size_t> provider_rank;
+  for (std::size_t i = 0; i < providers.size(); ++i)
+    provider_rank.emplace(providers[i].id, i);
+  auto region_rank = [&options](const std::string &region) {
+    const auto &r = options.regions;
+    return static_cast<std::size_t>(std::find(r.begin(), r.end(), region) -
+                                    r.begin());
+  };
+  std::stable_sort(units.begin(), units.end(),
+                   [&](const Unit &a, const Unit &b) {
+                     return std::tuple(provider_rank[a.provider_id],
+                                       region_rank(a.region), a.region,
+                                       a.key_index) <
+                            std::tuple(provider_rank[b.provider_id],
+                                       region_rank(b.region), b.region,
+                                       b.key_index);
+                   });
+
+  // A provider without keys still gets its one "no key" record.
+  std::size_t next = 0;
+  for (const auto &spec : providers) {
+    const auto it = keys.find(spec.id);
+    if (it != keys.end() && !it->second.empty()) {
+      for (; next < units.size() && units[next].provider_id == spec.id; ++next)
+        if (units[next].result)
+          report.providers.push_back(std::move(*units[next].result));
+      continue;
+    }
+    ProviderAudit p;
+    p.provider_id = spec.id;
+    p.provider_name = spec.name;
+    p.notes = "No API key supplied.";
+    journal.Append({{"type", "provider"},
+                    {"provider_id", p.provider_id},
+                    {"provider_name", p.provider_name},
+                    {"key_index", p.key_index},
+                    {"key_supplied", false},
+                    {"healthy", false},
+                    {"notes", p.notes}});
+    report.providers.push_back(std::move(p));
+  }
+  report.pools = SummarizePools(report.providers);
+
+  if (cancel_requested.load())
+    push_log("Audit ended early due to cancellation request.");
+  else
+    push_log("Audit completed.");
+  journal.Append({{"type", "run_end"},
+                  {"canceled", cancel_requested.load()},
+                  {"providers", report.providers.size()}});
+  journal.Close();
+  report.run_logs = run_log.Take();
+  out.journal_path = journal.path().string();
+  if (!journal.ok())
+    out.journal_error = journal.error();
+
+  out.report = std::make_shared<const AuditReport>(std::move(report));
+  out.run_log_path = WriteRunLog(*out.report, paths.logs_dir);
+  return true;
+}
+
+bool RunAuditWorker(const WorkspacePaths &paths, const WorkerOptions &options,
+                    const LogFn &log,
+                    const std::atomic<bool> &cancel_requested,
+                    std::string &error) {
+  const std::string host = UrlHost(options.coordinator_url);
+  if (options.coordinator_url.rfind("http://", 0) == 0 && !IsLoopback(host) &&
+      !options.allow_plaintext) {
+    error = "http://" + host +
+            " would receive the token and keys in cleartext; use an https:// "
+            "or tunnel URL, or allow plaintext explicitly";
+    return false;
+  }
+  std::mutex log_mutex;
+  const LogFn push_log = [&](const std::string &line) {
+    std::scoped_lock lock(log_mutex);
+    if (log)
+      log(line.starts_with("[") ? line : "[" + NowUtc() + "] " + line);
+  };
+  CoordinatorLink link(options);
+  const WorkerContext ctx{paths, options, link, push_log, cancel_requested};
+
+  // Set once the run is over for every slot: the coordinator said so, gave
+  // up on the worker, or went away.
+  std::atomic<bool> finished{false};
+  std::mutex error_mutex;
+  const auto give_up = std::chrono::seconds(options.give_up_seconds);
+
+  auto slot = [&] {
+    auto last_contact = Clock::now();
+    while (!cancel_requested.load() && !finished.load()) {
+      const auto r = link.Post(
+          "/v1/lease",
+          Dump({{"worker", options.name}, {"region", options.region}}));
+      const json reply = json::parse(r.body, nullptr, false);
+      if (r.status == 400 || r.status == 401) {
+        std::scoped_lock lock(error_mutex);
+        error = "coordinator refused the worker: " +
+                (reply.is_object() ? reply.value("error", r.body) : r.body);
+        finished.store(true);
+        return;
+      }
+      if (r.status != 200 || !reply.is_object()) {
+        if (!options.stay && Clock::now() - last_contact > give_up) {
+          push_log("Coordinator unreachable for " +
+                   std::to_string(options.give_up_seconds) + "s; stopping");
+          finished.store(true);
+          return;
+        }
+        Wait(kRetryMs, cancel_requested);
+        continue;
+      }
+      last_contact = Clock::now();
+      if (reply.value("done", false)) {
+        if (!options.stay) {
+          finished.store(true);
+          return;
+        }
+        Wait(5 * kRetryMs, cancel_requested);
+      } else if (reply.contains("lease")) {
+        AuditUnit(LeaseFrom(reply), ctx);
+      } else {
+        Wait(reply.value("retry_ms", kRetryMs), cancel_requested);
+      }
+    }
+  };
+
+  push_log("Worker " + options.name +
+           (options.region.empty() ? "" : " (" + options.region + ")") +
+           " taking work from " + options.coordinator_url);
+  std::vector<std::thread> slots;
+  for (int i = 0; i < std::max(options.slots, 1); ++i)
+    slots.emplace_back(slot);
+  for (auto &t : slots)
+    t.join();
+
+  std::scoped_lock lock(error_mutex);
+  return error.empty();
+}
+
+} // namespace llaudit
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "workspace.h"
+
+namespace llaudit {
+
+// Cluster mode spreads one audit over workers on other machines, typically
+// a few per region. The coordinator holds the keys and hands them out as
+// work units of one (provider, key, region); a key's model checks, prompt
+// tests and suites build on each other, so a worker audits a key whole. With
+// several regions every key is audited once from each of them.
+//
+// Workers lease a unit, stream its journal records back while it runs and
+// post the finished ProviderAudit, which the coordinator merges into one
+// report ordered by provider, region and key, each record tagged with its
+// region. A key is leased to one worker at a time, and each lease carries the
+// rate-limit state the key's previous lease ended with, so its pacing holds
+// across the cluster. A lease that goes quiet for lease_timeout_seconds is
+// handed out again.
+//
+// The protocol is JSON over plain HTTP with a shared bearer token, and the
+// leases carry the provider keys. Beyond loopback it belongs behind a TLS
+// terminator or a tunnel, with workers given the https:// or tunnel URL;
+// both sides refuse a plaintext remote peer unless allow_plaintext is set.
+//   POST /v1/lease   {worker, region} -> a unit, {retry_ms} or {done: true}
+//   POST /v1/records {lease, records}    renews the lease
+//   POST /v1/result  {lease, audit} or {lease, released: true, error}
+
+struct CoordinatorOptions {
+  std::string bind_address = "127.0.0.1";
+  int port = 0;  // 0 picks a free port
+  // Required unless bind_address is a loopback address.
+  std::string token;
+  // Listen beyond loopback in cleartext, for a network that is already
+  // private; a TLS terminator in front should listen there instead.
+  bool allow_plaintext = false;
+  // Empty audits every key once, from workers of any region.
+  std::vector<std::string> regions;
+  long long lease_timeout_seconds = 10 * 60;
+  // Applied to every worker result and to the run log, as in AuditOptions.
+  TraceRetention traces;
+  std::size_t max_run_log_lines = 5000;
+  // Called with the port once the coordinator listens.
+  std::function<void(int port)> on_listening;
+};
+
+// Serves the workspace keys to workers until every unit has a result or
+// cancel_requested is set, writing the journal and run log the way
+// RunWorkspaceAudit does. History is left alone: a run per region would
+// count every key several times.
+bool RunClusterAudit(const WorkspacePaths& paths, const KeyPools& keys,
+                     const CoordinatorOptions& options, const LogFn& log,
+                     const std::atomic<bool>& cancel_requested, WorkspaceRun& out,
+                     std::string& error);
+
+struct WorkerOptions {
+  std::string coordinator_url;  // e.g. https://audit.example.net:8750
+  std::string region;
+  // How the coordinator's log and journal name this worker.
+  std::string name = "worker";
+  std::string token;
+  // Talk plain http:// to a coordinator that is not on loopback.
+  bool allow_plaintext = false;
+  // Units audited at once.
+  int slots = 4;
+  // Resume, batch and record/replay settings for each unit; the journal,
+  // history and key filtering are the worker's own.
+  WorkspaceRunOptions run;
+  // Stop once the coordinator has been unreachable for this long.
+  long long give_up_seconds = 60;
+  // Keep asking for work after a run is done, for a coordinator in daemon
+  // mode; the worker then never gives up.
+  bool stay = false;
+};
+
+// Audits units leased from the coordinator until it reports the run done,
+// it stays unreachable, or cancel_requested is set; a unit cut short is
+// handed back. False when the coordinator refused the worker.
+bool RunAuditWorker(const WorkspacePaths& paths, const WorkerOptions& options, const LogFn& log,
+                    const std::atomic<bool>& cancel_requested, std::string& error);
+
+}  // namespace llaudit
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace llaudit {
+
+inline constexpr std::uint64_t kFnv1a64Offset = 14695981039346656037ULL;
+inline constexpr std::uint64_t kFnv1a64Prime = 1099511628211ULL;
+
+// 64-bit FNV-1a of text. Passing an earlier result as h continues that hash,
+// so parts can be hashed one after another.
+constexpr std::uint64_t Fnv1a64(std::string_view text, std::uint64_t h = kFnv1a64Offset) {
+  for (const char c : text) {
+    h ^= static_cast<unsigned char>(c);
+    h *= kFnv1a64Prime;
+  }
+  return h;
+}
+
+// Fnv1a64 of text with ASCII letters lower-cased on the fly, so that any
+// spelling of a case-insensitive name hashes alike.
+constexpr std::uint64_t Fnv1a64Lower(std::string_view text) {
+  std::uint64_t h = kFnv1a64Offset;
+  for (const char c : text) {
+    const char lower = c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    h ^= static_cast<unsigned char>(lower);
+    h *= kFnv1a64Prime;
+  }
+  return h;
+}
+
+}  // namespace llaudit
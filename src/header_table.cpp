@@ -0,0 +1,161 @@
+#include "header_table.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include "rate_limiter.h"
+
+namespace llaudit {
+namespace {
+
+std::string_view TrimView(std::string_view s) {
+  while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front())))
+    s.remove_prefix(1);
+  while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back())))
+    s.remove_suffix(1);
+  return s;
+}
+
+// Leading integer of a header value; tolerates "100, 100;w=60" style lists.
+long long LeadingInt(std::string_view value) {
+  if (value.empty() || !std::isdigit(static_cast<unsigned char>(value[0])))
+    return -1;
+  long long out = 0;
+  for (const char c : value) {
+    if (!std::isdigit(static_cast<unsigned char>(c)))
+      break;
+    out = out * 10 + (c - '0');
+  }
+  return out;
+}
+
+bool LooksRateLimited(std::string_view name) {
+  for (const std::string_view word : {"rate", "limit", "quota", "retry"}) {
+    if (name.find(word) != std::string_view::npos)
+      return true;
+  }
+  return false;
+}
+
+} // namespace
+
+void HeaderTable::Add(std::string_view name, std::string_view value) {
+  name = TrimView(name);
+  value = TrimView(value);
+  if (name.empty())
+    return;
+
+  Entry e;
+  e.hash = HeaderHash(name);
+  e.offset = static_cast<std::uint32_t>(bytes_.size());
+  e.name_size = static_cast<std::uint32_t>(name.size());
+  e.value_size = static_cast<std::uint32_t>(value.size());
+  for (const char c : name)
+    bytes_ += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  bytes_.append(value);
+  const std::string_view lower(bytes_.data() + e.offset, e.name_size);
+
+  e.rate_limit = LooksRateLimited(lower);
+  for (const auto &known : kKnownRateLimitHeaders) {
+    if (known.hash == e.hash && known.name == lower) {
+      e.field = known.field;
+      e.rank = known.rank;
+      e.number = known.reset ? ParseResetMs(value) : LeadingInt(value);
+      break;
+    }
+  }
+
+  for (std::size_t i = 0; i < size_; ++i) {
+    Entry &old = EntryAt(i);
+    if (old.hash == e.hash && At(i).name == lower) {
+      old = e;
+      return;
+    }
+  }
+  Push(e);
+}
+
+void HeaderTable::AddLine(std::string_view line) {
+  const auto colon = line.find(':');
+  if (colon != std::string_view::npos)
+    Add(line.substr(0, colon), line.substr(colon + 1));
+}
+
+void HeaderTable::Push(const Entry &e) {
+  if (size_ < kInlineEntries)
+    inline_[size_] = e;
+  else
+    more_.push_back(e);
+  ++size_;
+}
+
+std::optional<std::string_view>
+HeaderTable::Find(std::string_view name) const {
+  const std::uint64_t hash = HeaderHash(name);
+  for (std::size_t i = 0; i < size_; ++i) {
+    if (EntryAt(i).hash != hash)
+      continue;
+    const Header h = At(i);
+    if (h.name == name)
+      return h.value;
+  }
+  return std::nullopt;
+}
+
+HeaderTable::Header HeaderTable::At(std::size_t i) const {
+  const Entry &e = EntryAt(i);
+  Header h;
+  h.name = std::string_view(bytes_.data() + e.offset, e.name_size);
+  h.value =
+      std::string_view(bytes_.data() + e.offset + e.name_size, e.value_size);
+  h.field = e.field;
+  h.rank = e.rank;
+  h.number = e.number;
+  h.rate_limit = e.rate_limit;
+  return h;
+}
+
+HeaderTable HeaderTable::RateLimitOnly() const {
+  std::array<std::size_t, kInlineEntries> inline_order;
+  std::vector<std::size_t> more_order;
+  std::size_t n = 0;
+  auto slot = [&](std::size_t k) -> std::size_t & {
+    return k < kInlineEntries ? inline_order[k]
+                              : more_order[k - kInlineEntries];
+  };
+  for (std::size_t i = 0; i < size_; ++i) {
+    if (!EntryAt(i).rate_limit)
+      continue;
+    if (n >= kInlineEntries)
+      more_order.push_back(i);
+    else
+      inline_order[n] = i;
+    ++n;
+  }
+
+  HeaderTable out;
+  if (n == 0)
+    return out;
+  // Insertion sort: a response carries a handful of these at most.
+  for (std::size_t k = 1; k < n; ++k) {
+    for (std::size_t j = k; j > 0 && At(slot(j)).name < At(slot(j - 1)).name;
+         --j)
+      std::swap(slot(j), slot(j - 1));
+  }
+  std::size_t bytes = 0;
+  for (std::size_t k = 0; k < n; ++k) {
+    const Entry &e = EntryAt(slot(k));
+    bytes += e.name_size + e.value_size;
+  }
+  out.bytes_.reserve(bytes);
+  for (std::size_t k = 0; k < n; ++k) {
+    Entry e = EntryAt(slot(k));
+    const auto offset = static_cast<std::uint32_t>(out.bytes_.size());
+    out.bytes_.append(bytes_, e.offset, e.name_size + e.value_size);
+    e.offset = offset;
+    out.Push(e);
+  }
+  return out;
+}
+
+} // namespace llaudit
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fnv1a.h"
+
+namespace llaudit {
+
+// 64-bit FNV-1a of a header name, lower-cased on the fly so that any
+// spelling of a name hashes alike.
+constexpr std::uint64_t HeaderHash(std::string_view name) { return Fnv1a64Lower(name); }
+
+// The RateLimitState member a known rate-limit header fills.
+enum class RateLimitField : std::uint8_t {
+  kNone,
+  kLimitRequests,
+  kRemainingRequests,
+  kResetRequests,
+  kLimitTokens,
+  kRemainingTokens,
+  kResetTokens,
+  kRetryAfter,
+};
+
+struct KnownRateLimitHeader {
+  std::string_view name;
+  RateLimitField field;
+  // Among the headers for one field, the lowest rank present wins.
+  std::uint8_t rank;
+  // The value is a duration or reset time (ParseResetMs) rather than a count.
+  bool reset;
+  std::uint64_t hash;
+};
+
+inline constexpr std::array<KnownRateLimitHeader, 18> kKnownRateLimitHeaders = [] {
+  using F = RateLimitField;
+  std::array<KnownRateLimitHeader, 18> out = {{
+      {"x-ratelimit-limit-requests", F::kLimitRequests, 0, false, 0},
+      {"x-ratelimit-limit-req-minute", F::kLimitRequests, 1, false, 0},
+      {"x-ratelimit-limit", F::kLimitRequests, 2, false, 0},
+      {"ratelimit-limit", F::kLimitRequests, 3, false, 0},
+      {"x-ratelimit-remaining-requests", F::kRemainingRequests, 0, false, 0},
+      {"x-ratelimit-remaining-req-minute", F::kRemainingRequests, 1, false, 0},
+      {"x-ratelimit-remaining", F::kRemainingRequests, 2, false, 0},
+      {"ratelimit-remaining", F::kRemainingRequests, 3, false, 0},
+      {"x-ratelimit-reset-requests", F::kResetRequests, 0, true, 0},
+      {"x-ratelimit-reset", F::kResetRequests, 1, true, 0},
+      {"ratelimit-reset", F::kResetRequests, 2, true, 0},
+      {"x-ratelimit-limit-tokens", F::kLimitTokens, 0, false, 0},
+      {"x-ratelimit-limit-tokens-minute", F::kLimitTokens, 1, false, 0},
+      {"x-ratelimit-remaining-tokens", F::kRemainingTokens, 0, false, 0},
+      {"x-ratelimit-remaining-tokens-minute", F::kRemainingTokens, 1, false, 0},
+      {"x-ratelimit-reset-tokens", F::kResetTokens, 0, true, 0},
+      // An HTTP-date retry-after does not parse and falls back to backoff.
+      {"retry-after-ms", F::kRetryAfter, 0, false, 0},
+      {"retry-after", F::kRetryAfter, 1, true, 0},
+  }};
+  for (auto& h : out) h.hash = HeaderHash(h.name);
+  return out;
+}();
+
+static_assert(
+    [] {
+      for (std::size_t i = 0; i < kKnownRateLimitHeaders.size(); ++i) {
+        for (std::size_t j = i + 1; j < kKnownRateLimitHeaders.size(); ++j) {
+          if (kKnownRateLimitHeaders[i].hash == kKnownRateLimitHeaders[j].hash) return false;
+        }
+      }
+      return true;
+    }(),
+    "known rate-limit header names must hash apart");
+
+// Response headers in one flat table: fixed-size entries, the first
+// kInlineEntries of them inside the object, and every name and value in one
+// byte buffer. Names are lower-cased and matched by hash; a repeated name
+// replaces the earlier value. Each entry also records whether the name looks
+// rate-limit related (it contains "rate", "limit", "quota" or "retry") and,
+// for the known rate-limit headers, the value already parsed to a number,
+// so ParseRateLimitState() reads integers instead of strings.
+class HeaderTable {
+ public:
+  static constexpr std::size_t kInlineEntries = 16;
+
+  struct Header {
+    std::string_view name;
+    std::string_view value;
+    RateLimitField field = RateLimitField::kNone;
+    std::uint8_t rank = 0;
+    // Known rate-limit headers: the parsed count or milliseconds, -1 if the
+    // value did not parse; -1 for every other header.
+    long long number = -1;
+    bool rate_limit = false;
+  };
+
+  class const_iterator {
+   public:
+    const_iterator(const HeaderTable* table, std::size_t i) : table_(table), i_(i) {}
+    Header operator*() const { return table_->At(i_); }
+    const_iterator& operator++() {
+      ++i_;
+      return *this;
+    }
+    bool operator==(const const_iterator& other) const { return i_ == other.i_; }
+    bool operator!=(const const_iterator& other) const { return i_ != other.i_; }
+
+   private:
+    const HeaderTable* table_;
+    std::size_t i_;
+  };
+
+  // Surrounding whitespace is trimmed from both; an empty name is ignored.
+  void Add(std::string_view name, std::string_view value);
+  // One "Name: value" line, as a transport receives it; lines without a
+  // colon (the status line, the blank end line) are ignored.
+  void AddLine(std::string_view line);
+
+  // name must be lower-case.
+  std::optional<std::string_view> Find(std::string_view name) const;
+
+  // The rate-limit related headers alone, in name order.
+  HeaderTable RateLimitOnly() const;
+
+  // Room for this many bytes of names and values before the buffer grows.
+  void reserve(std::size_t bytes) { bytes_.reserve(bytes); }
+
+  bool empty() const { return size_ == 0; }
+  std::size_t size() const { return size_; }
+  Header At(std::size_t i) const;
+  const_iterator begin() const { return {this, 0}; }
+  const_iterator end() const { return {this, size_}; }
+
+ private:
+  struct Entry {
+    std::uint64_t hash = 0;
+    std::uint32_t offset = 0;  // name, then value, in bytes_
+    std::uint32_t name_size = 0;
+    std::uint32_t value_size = 0;
+    RateLimitField field = RateLimitField::kNone;
+    std::uint8_t rank = 0;
+    bool rate_limit = false;
+    long long number = -1;
+  };
+
+  Entry& EntryAt(std::size_t i) {
+    return i < kInlineEntries ? inline_[i] : more_[i - kInlineEntries];
+  }
+  const Entry& EntryAt(std::size_t i) const {
+    return i < kInlineEntries ? inline_[i] : more_[i - kInlineEntries];
+  }
+  void Push(const Entry& e);
+
+  std::array<Entry, kInlineEntries> inline_{};
+  std::vector<Entry> more_;
+  std::size_t size_ = 0;
+  std::string bytes_;
+};
+
+}  // namespace llaudit
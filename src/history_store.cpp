@@ -0,0 +1,521 @@
+#include "history_store.h"
+
+#include "atomic_file.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <system_error>
+
+#include <nlohmann/json.hpp>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace llaudit {
+namespace {
+
+constexpr int kFormatVersion = 1;
+
+// Values are stored in host byte order.
+enum Column {
+  kRun,
+  kSeries,
+  kSamples,
+  kP50,
+  kP95,
+  kP99,
+  kOk,
+  kTotal,
+  kWorking,
+  kScore,
+  kHistOffset, // first HistPair of the row in hist.bin
+  kHistCount,
+  kColumns,
+};
+
+struct ColumnSpec {
+  const char *file;
+  std::size_t width;
+};
+
+constexpr std::array<ColumnSpec, kColumns> kColumnSpecs = {{
+    {"run.u32", 4},
+    {"series.u32", 4},
+    {"samples.i64", 8},
+    {"p50_us.i64", 8},
+    {"p95_us.i64", 8},
+    {"p99_us.i64", 8},
+    {"ok.i32", 4},
+    {"total.i32", 4},
+    {"working.i32", 4},
+    {"score.i32", 4},
+    {"hist_offset.u64", 8},
+    {"hist_count.u32", 4},
+}};
+
+// One non-empty latency bucket.
+struct HistPair {
+  std::int64_t lower_us;
+  std::uint32_t count;
+  std::uint32_t reserved;
+};
+static_assert(sizeof(HistPair) == 16);
+
+// Read-only view of a whole file; empty if it is missing or empty.
+class MappedFile {
+public:
+  MappedFile() = default;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile() { Close(); }
+
+  void Open(const std::filesystem::path &path) {
+    Close();
+#if defined(_WIN32)
+    file_ = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE)
+      return;
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file_, &size) || size.QuadPart == 0)
+      return;
+    mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_ == nullptr)
+      return;
+    void *view = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr)
+      return;
+    data_ = static_cast<const unsigned char *>(view);
+    size_ = static_cast<std::size_t>(size.QuadPart);
+#else
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if (fd_ < 0)
+      return;
+    struct stat st {};
+    if (::fstat(fd_, &st) != 0 || st.st_size == 0)
+      return;
+    void *view = ::mmap(nullptr, static_cast<std::size_t>(st.st_size),
+                        PROT_READ, MAP_SHARED, fd_, 0);
+    if (view == MAP_FAILED)
+      return;
+    data_ = static_cast<const unsigned char *>(view);
+    size_ = static_cast<std::size_t>(st.st_size);
+#endif
+  }
+
+  const unsigned char *data() const { return data_; }
+  std::size_t size() const { return size_; }
+
+private:
+  void Close() {
+#if defined(_WIN32)
+    if (data_ != nullptr)
+      UnmapViewOfFile(data_);
+    if (mapping_ != nullptr)
+      CloseHandle(mapping_);
+    if (file_ != INVALID_HANDLE_VALUE)
+      CloseHandle(file_);
+    mapping_ = nullptr;
+    file_ = INVALID_HANDLE_VALUE;
+#else
+    if (data_ != nullptr)
+      ::munmap(const_cast<unsigned char *>(data_), size_);
+    if (fd_ >= 0)
+      ::close(fd_);
+    fd_ = -1;
+#endif
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+#if defined(_WIN32)
+  HANDLE file_ = INVALID_HANDLE_VALUE;
+  HANDLE mapping_ = nullptr;
+#else
+  int fd_ = -1;
+#endif
+  const unsigned char *data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+template <typename T> T At(const MappedFile &f, std::size_t index) {
+  T value;
+  std::memcpy(&value, f.data() + index * sizeof(T), sizeof(T));
+  return value;
+}
+
+template <typename T> void Put(std::ofstream &out, T value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+std::string SeriesName(std::string_view provider_id, std::string_view model) {
+  std::string name(provider_id);
+  if (!model.empty()) {
+    name += '/';
+    name += model;
+  }
+  return name;
+}
+
+// A series' values for the report being ingested.
+struct Row {
+  std::string series;
+  std::string label;
+  LatencyHistogram latency;
+  int ok = 0;
+  int total = 0;
+  int working = 0;
+  int score = -1;
+};
+
+bool Succeeded(long status) { return status >= 200 && status < 300; }
+
+// Every key of a provider is folded into one provider row, and into one row
+// per model the provider's keys measured.
+std::vector<Row> RowsOf(const AuditReport &report) {
+  std::vector<Row> rows;
+  for (std::size_t i = 0; i < report.providers.size();) {
+    const std::string &provider_id = report.providers[i].provider_id;
+    Row provider;
+    provider.series = provider_id;
+    provider.label = report.providers[i].provider_name;
+    std::set<std::string> working_models;
+    std::map<std::string, Row> models;
+    bool supplied = false;
+
+    for (; i < report.providers.size() &&
+           report.providers[i].provider_id == provider_id;
+         ++i) {
+      const ProviderAudit &p = report.providers[i];
+      // A reused checkpoint was recorded by the run that probed it.
+      if (!p.key_supplied || p.checkpoint_saved_at >= 0)
+        continue;
+      supplied = true;
+      provider.latency.Merge(p.latency);
+      provider.ok += p.successful_requests;
+      provider.total += p.total_requests;
+      provider.score = std::max(provider.score, p.score_total);
+      working_models.insert(p.working_models.begin(), p.working_models.end());
+
+      for (const auto &[model, hist] : p.model_latency)
+        models[model].latency.Merge(hist);
+      for (const auto &c : p.model_checks) {
+        Row &m = models[c.model];
+        m.total += 1;
+        m.ok += c.working ? 1 : 0;
+        m.working = std::max(m.working, c.working ? 1 : 0);
+      }
+      if (!p.model_used.empty()) {
+        for (const auto &t : p.prompt_tests) {
+          Row &m = models[p.model_used];
+          m.total += 1;
+          m.ok += Succeeded(t.status) ? 1 : 0;
+        }
+      }
+    }
+    if (!supplied)
+      continue;
+
+    provider.working = static_cast<int>(working_models.size());
+    rows.push_back(std::move(provider));
+    for (auto &[model, row] : models) {
+      row.series = SeriesName(provider_id, model);
+      row.label = model;
+      rows.push_back(std::move(row));
+    }
+  }
+  return rows;
+}
+
+// Cuts a file back to the bytes meta.json vouches for.
+void TruncateTo(const std::filesystem::path &path, std::uint64_t bytes) {
+  std::error_code ec;
+  const auto size = std::filesystem::file_size(path, ec);
+  if (!ec && size > bytes)
+    std::filesystem::resize_file(path, bytes, ec);
+}
+
+std::string FormatUtc(long long unix_seconds) {
+  const auto t = static_cast<std::time_t>(unix_seconds);
+  std::tm tm{};
+#if defined(_WIN32)
+  gmtime_s(&tm, &t);
+#else
+  gmtime_r(&t, &tm);
+#endif
+  std::ostringstream oss;
+  oss << std::put_time(&tm, "%Y-%m-%d %H:%M UTC");
+  return oss.str();
+}
+
+std::string Signed(long long delta) {
+  std::string out = delta >= 0 ? "+" : "";
+  out += std::to_string(delta);
+  return out;
+}
+
+std::string MsWithDelta(long long us, long long previous_us) {
+  if (us < 0)
+    return "n/a";
+  std::string out = std::to_string(us / 1000) + " ms";
+  if (previous_us >= 0)
+    out += " (" + Signed(us / 1000 - previous_us / 1000) + ")";
+  return out;
+}
+
+} // namespace
+
+struct HistoryStore::Mapping {
+  std::array<MappedFile, kColumns> columns;
+  MappedFile hist;
+  std::size_t rows = 0; // rows every column actually holds
+};
+
+HistoryStore::HistoryStore(std::filesystem::path dir) : dir_(std::move(dir)) {
+  readable_ = Load();
+}
+
+HistoryStore::~HistoryStore() = default;
+
+bool HistoryStore::Load() {
+  std::ifstream meta_in(dir_ / "meta.json");
+  if (!meta_in)
+    return true; // a new store
+  const auto meta = nlohmann::json::parse(meta_in, nullptr, false);
+  if (!meta.is_object() || meta.value("version", 0) != kFormatVersion)
+    return false;
+  rows_ = meta.value("rows", std::size_t{0});
+  hist_pairs_ = meta.value("hist_pairs", std::uint64_t{0});
+  const auto run_count = meta.value("runs", std::size_t{0});
+  const auto series_count = meta.value("series", std::size_t{0});
+
+  std::ifstream series_in(dir_ / "series.txt");
+  std::string line;
+  while (series_.size() < series_count && std::getline(series_in, line)) {
+    series_ids_.emplace(line, static_cast<std::uint32_t>(series_.size()));
+    series_.push_back(line);
+  }
+
+  std::ifstream runs_in(dir_ / "runs.i64", std::ios::binary);
+  std::int64_t t = 0;
+  while (run_times_.size() < run_count &&
+         runs_in.read(reinterpret_cast<char *>(&t), sizeof(t)))
+    run_times_.push_back(t);
+  return series_.size() == series_count && run_times_.size() == run_count;
+}
+
+std::uint32_t HistoryStore::SeriesId(const std::string &name) {
+  const auto [it, inserted] = series_ids_.emplace(
+      name, static_cast<std::uint32_t>(series_.size()));
+  if (inserted)
+    series_.push_back(name);
+  return it->second;
+}
+
+const HistoryStore::Mapping &HistoryStore::Map() const {
+  if (!mapping_) {
+    mapping_ = std::make_unique<Mapping>();
+    mapping_->rows = rows_;
+    for (std::size_t c = 0; c < kColumns; ++c) {
+      auto &file = mapping_->columns[c];
+      file.Open(dir_ / kColumnSpecs[c].file);
+      mapping_->rows =
+          std::min(mapping_->rows, file.size() / kColumnSpecs[c].width);
+    }
+    mapping_->hist.Open(dir_ / "hist.bin");
+  }
+  return *mapping_;
+}
+
+bool HistoryStore::Ingest(const AuditReport &report, std::string &error) {
+  std::error_code ec;
+  std::filesystem::create_directories(dir_, ec);
+  if (ec) {
+    error = "Cannot create " + dir_.string() + ": " + ec.message();
+    return false;
+  }
+  if (!readable_) {
+    error = "Unsupported or damaged history in " + dir_.string();
+    return false;
+  }
+  mapping_.reset();
+
+  // Anything past the committed counts is left over from an interrupted
+  // ingest.
+  for (const auto &spec : kColumnSpecs)
+    TruncateTo(dir_ / spec.file, rows_ * spec.width);
+  TruncateTo(dir_ / "hist.bin", hist_pairs_ * sizeof(HistPair));
+  TruncateTo(dir_ / "runs.i64", run_times_.size() * sizeof(std::int64_t));
+
+  std::array<std::ofstream, kColumns> columns;
+  for (std::size_t c = 0; c < kColumns; ++c) {
+    columns[c].open(dir_ / kColumnSpecs[c].file,
+                    std::ios::out | std::ios::app | std::ios::binary);
+    if (!columns[c]) {
+      error = std::string("Cannot open history column ") +
+              kColumnSpecs[c].file;
+      return false;
+    }
+  }
+  std::ofstream hist(dir_ / "hist.bin",
+                     std::ios::out | std::ios::app | std::ios::binary);
+  std::ofstream runs(dir_ / "runs.i64",
+                     std::ios::out | std::ios::app | std::ios::binary);
+  if (!hist || !runs) {
+    error = "Cannot open history files in " + dir_.string();
+    return false;
+  }
+
+  const auto run = static_cast<std::uint32_t>(run_times_.size());
+  const auto now = static_cast<long long>(std::time(nullptr));
+  const std::vector<Row> rows = RowsOf(report);
+  std::uint64_t hist_pairs = hist_pairs_;
+  for (const Row &row : rows) {
+    const auto buckets = row.latency.Buckets();
+    Put<std::uint32_t>(columns[kRun], run);
+    Put<std::uint32_t>(columns[kSeries], SeriesId(row.series));
+    Put<std::int64_t>(columns[kSamples], row.latency.count());
+    Put<std::int64_t>(columns[kP50], row.latency.Percentile(0.50));
+    Put<std::int64_t>(columns[kP95], row.latency.Percentile(0.95));
+    Put<std::int64_t>(columns[kP99], row.latency.Percentile(0.99));
+    Put<std::int32_t>(columns[kOk], row.ok);
+    Put<std::int32_t>(columns[kTotal], row.total);
+    Put<std::int32_t>(columns[kWorking], row.working);
+    Put<std::int32_t>(columns[kScore], row.score);
+    Put<std::uint64_t>(columns[kHistOffset], hist_pairs);
+    Put<std::uint32_t>(columns[kHistCount],
+                       static_cast<std::uint32_t>(buckets.size()));
+    for (const auto &[lower_us, n] : buckets)
+      Put(hist, HistPair{lower_us, n, 0});
+    hist_pairs += buckets.size();
+  }
+  Put<std::int64_t>(runs, now);
+
+  bool written = hist.flush() && runs.flush();
+  for (auto &c : columns)
+    written = c.flush() && written;
+  if (!written) {
+    error = "Write to " + dir_.string() + " failed.";
+    return false;
+  }
+
+  std::string series_text;
+  for (const auto &name : series_)
+    series_text += name + "\n";
+  if (!WriteFileAtomically(dir_ / "series.txt", series_text, error))
+    return false;
+
+  const nlohmann::json meta = {
+      {"version", kFormatVersion},
+      {"rows", rows_ + rows.size()},
+      {"runs", run_times_.size() + 1},
+      {"series", series_.size()},
+      {"hist_pairs", hist_pairs},
+  };
+  if (!WriteFileAtomically(dir_ / "meta.json", meta.dump(2), error))
+    return false;
+
+  rows_ += rows.size();
+  hist_pairs_ = hist_pairs;
+  run_times_.push_back(now);
+  return true;
+}
+
+HistoryWindow HistoryStore::Query(std::string_view provider_id,
+                                  std::string_view model,
+                                  std::size_t last_runs) const {
+  HistoryWindow window;
+  const auto it = series_ids_.find(SeriesName(provider_id, model));
+  if (it == series_ids_.end() || last_runs == 0)
+    return window;
+  const std::uint32_t id = it->second;
+
+  const Mapping &m = Map();
+  const auto &cols = m.columns;
+  const std::size_t hist_capacity = m.hist.size() / sizeof(HistPair);
+  for (std::size_t r = m.rows; r-- > 0 && window.points.size() < last_runs;) {
+    if (At<std::uint32_t>(cols[kSeries], r) != id)
+      continue;
+    HistoryPoint pt;
+    pt.run = At<std::uint32_t>(cols[kRun], r);
+    pt.run_time = pt.run < run_times_.size() ? run_times_[pt.run] : 0;
+    pt.samples = At<std::int64_t>(cols[kSamples], r);
+    pt.p50_us = At<std::int64_t>(cols[kP50], r);
+    pt.p95_us = At<std::int64_t>(cols[kP95], r);
+    pt.p99_us = At<std::int64_t>(cols[kP99], r);
+    pt.ok = At<std::int32_t>(cols[kOk], r);
+    pt.total = At<std::int32_t>(cols[kTotal], r);
+    pt.working = At<std::int32_t>(cols[kWorking], r);
+    pt.score = At<std::int32_t>(cols[kScore], r);
+
+    const auto offset = At<std::uint64_t>(cols[kHistOffset], r);
+    const auto count = At<std::uint32_t>(cols[kHistCount], r);
+    for (std::uint64_t b = offset; b < offset + count && b < hist_capacity;
+         ++b) {
+      const auto pair = At<HistPair>(m.hist, static_cast<std::size_t>(b));
+      pt.latency.RecordMany(pair.lower_us, pair.count);
+    }
+
+    window.latency.Merge(pt.latency);
+    window.ok += pt.ok;
+    window.total += pt.total;
+    window.points.push_back(std::move(pt));
+  }
+  std::reverse(window.points.begin(), window.points.end());
+  return window;
+}
+
+std::string BuildHistoryDeltaText(const HistoryStore &history,
+                                  const AuditReport &report) {
+  std::ostringstream oss;
+  if (history.runs() == 0) {
+    oss << "History: first recorded run.\n";
+    return oss.str();
+  }
+
+  bool header = false;
+  for (const Row &row : RowsOf(report)) {
+    if (row.series.find('/') != std::string::npos)
+      continue;
+    if (!header) {
+      oss << "Changes since the previous run:\n";
+      header = true;
+    }
+    const HistoryWindow prev = history.Query(row.series, "", 1);
+    oss << "  " << row.label << ": ";
+    if (prev.points.empty()) {
+      oss << "first recorded run\n";
+      continue;
+    }
+    const HistoryPoint &p = prev.points.back();
+    oss << "p50 " << MsWithDelta(row.latency.Percentile(0.50), p.p50_us)
+        << ", p95 " << MsWithDelta(row.latency.Percentile(0.95), p.p95_us)
+        << ", ok " << row.ok << "/" << row.total;
+    if (row.total > 0 && p.total > 0) {
+      const double now_pct = 100.0 * row.ok / row.total;
+      const double prev_pct = 100.0 * p.ok / p.total;
+      oss << " (" << std::showpos << std::fixed << std::setprecision(1)
+          << now_pct - prev_pct << std::noshowpos << " pts)";
+    }
+    oss << ", working models " << row.working << " ("
+        << Signed(row.working - p.working) << ")";
+    oss << " | last " << FormatUtc(p.run_time) << "\n";
+  }
+  return oss.str();
+}
+
+} // namespace llaudit
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "audit_engine.h"
+#include "latency_histogram.h"
+
+namespace llaudit {
+
+// One run of one series: a provider (all its keys together) or one model of
+// a provider.
+struct HistoryPoint {
+  std::uint32_t run = 0;
+  long long run_time = 0;  // Unix seconds
+  long long samples = 0;
+  long long p50_us = -1;
+  long long p95_us = -1;
+  long long p99_us = -1;
+  // Successful and total requests; for a model, its check and prompt tests.
+  int ok = 0;
+  int total = 0;
+  // Provider: working models and best score over its keys. Model: whether
+  // any key could use it (1/0); score is -1.
+  int working = 0;
+  int score = -1;
+  LatencyHistogram latency;
+};
+
+struct HistoryWindow {
+  std::vector<HistoryPoint> points;  // oldest first
+  LatencyHistogram latency;          // every sample of the window
+  int ok = 0;
+  int total = 0;
+
+  double availability() const { return total > 0 ? static_cast<double>(ok) / total : -1.0; }
+};
+
+// Time series of past audits under <workspace>/history. Every row is one
+// series in one run, and every metric is its own fixed-width column file
+// (run.u32, series.u32, p95_us.i64, ...) that queries memory-map and scan
+// from the end; the latency histograms live in hist.bin. meta.json holds
+// the committed row count and is replaced last, so rows from an interrupted
+// ingest are ignored and overwritten. Not thread-safe.
+class HistoryStore {
+ public:
+  explicit HistoryStore(std::filesystem::path dir);
+  ~HistoryStore();
+
+  HistoryStore(const HistoryStore&) = delete;
+  HistoryStore& operator=(const HistoryStore&) = delete;
+
+  // Appends the report as the newest run.
+  bool Ingest(const AuditReport& report, std::string& error);
+
+  std::size_t runs() const { return run_times_.size(); }
+  std::size_t rows() const { return rows_; }
+  // "provider_id" and "provider_id/model" names, in first-seen order.
+  const std::vector<std::string>& series() const { return series_; }
+
+  // The latest last_runs runs that recorded the series. An empty model
+  // selects the provider as a whole.
+  HistoryWindow Query(std::string_view provider_id, std::string_view model,
+                      std::size_t last_runs) const;
+
+ private:
+  struct Mapping;
+
+  // False if meta.json is from another version or disagrees with the files,
+  // in which case Ingest() refuses to touch them.
+  bool Load();
+  std::uint32_t SeriesId(const std::string& name);
+  const Mapping& Map() const;
+
+  std::filesystem::path dir_;
+  bool readable_ = true;
+  std::vector<std::string> series_;
+  std::map<std::string, std::uint32_t, std::less<>> series_ids_;
+  std::vector<long long> run_times_;
+  std::size_t rows_ = 0;
+  std::uint64_t hist_pairs_ = 0;
+  mutable std::unique_ptr<Mapping> mapping_;
+};
+
+// "Changes since the previous run" for the summary panel: per provider,
+// latency, success rate and working models against the newest run in the
+// store. Call before ingesting the report.
+std::string BuildHistoryDeltaText(const HistoryStore& history, const AuditReport& report);
+
+}  // namespace llaudit
@@ -0,0 +1,1050 @@
+#include "http_client.h"
+
+#include "response_store.h"
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <winhttp.h>
+#else
+#include <curl/curl.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string_view>
+#include <thread>
+
+namespace llaudit {
+namespace {
+
+std::string ToLower(std::string s) {
+  std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) {
+    return static_cast<char>(std::tolower(c));
+  });
+  return s;
+}
+
+#if !defined(_WIN32)
+size_t WriteBodyCallback(void *contents, size_t size, size_t nmemb,
+                         void *userp) {
+  const size_t total_size = size * nmemb;
+  auto *body = static_cast<std::string *>(userp);
+  body->append(static_cast<char *>(contents), total_size);
+  return total_size;
+}
+
+size_t HeaderCallback(char *buffer, size_t size, size_t nitems,
+                      void *userdata) {
+  const size_t total = size * nitems;
+  static_cast<HeaderTable *>(userdata)->AddLine(
+      std::string_view(buffer, total));
+  return total;
+}
+#else
+std::string Trim(std::string s) {
+  auto not_space = [](unsigned char c) { return !std::isspace(c); };
+  s.erase(s.begin(), std::find_if(s.begin(), s.end(), not_space));
+  s.erase(std::find_if(s.rbegin(), s.rend(), not_space).base(), s.end());
+  return s;
+}
+
+std::wstring Utf8ToWide(const std::string &s) {
+  if (s.empty())
+    return L"";
+  const int len = MultiByteToWideChar(CP_UTF8, 0, s.data(),
+                                      static_cast<int>(s.size()), nullptr, 0);
+  if (len <= 0)
+    return L"";
+  std::wstring out(static_cast<std::size_t>(len), L'\0');
+  MultiByteToWideChar(CP_UTF8, 0, s.data(), static_cast<int>(s.size()),
+                      out.data(), len);
+  return out;
+}
+
+std::string WideToUtf8(const std::wstring &s) {
+  if (s.empty())
+    return {};
+  const int len =
+      WideCharToMultiByte(CP_UTF8, 0, s.data(), static_cast<int>(s.size()),
+                          nullptr, 0, nullptr, nullptr);
+  if (len <= 0)
+    return {};
+  std::string out(static_cast<std::size_t>(len), '\0');
+  WideCharToMultiByte(CP_UTF8, 0, s.data(), static_cast<int>(s.size()),
+                      out.data(), len, nullptr, nullptr);
+  return out;
+}
+
+std::string WinErrText(DWORD code) {
+  LPWSTR wbuf = nullptr;
+  const DWORD flags = FORMAT_MESSAGE_ALLOCATE_BUFFER |
+                      FORMAT_MESSAGE_FROM_SYSTEM |
+                      FORMAT_MESSAGE_IGNORE_INSERTS;
+  const DWORD got = FormatMessageW(flags, nullptr, code, 0,
+                                   reinterpret_cast<LPWSTR>(&wbuf), 0, nullptr);
+  std::string out = "winhttp error " + std::to_string(code);
+  if (got > 0 && wbuf) {
+    out += ": " + Trim(WideToUtf8(std::wstring(wbuf, got)));
+  }
+  if (wbuf) {
+    LocalFree(wbuf);
+  }
+  return out;
+}
+
+HeaderTable ParseRawHeaders(const std::wstring &raw) {
+  HeaderTable out;
+  out.reserve(raw.size());
+  std::wistringstream iss(raw);
+  std::wstring line;
+  while (std::getline(iss, line))
+    out.AddLine(WideToUtf8(line));
+  return out;
+}
+#endif
+
+struct PendingRequest {
+  std::string method;
+  std::string url;
+  std::string host;
+  std::vector<std::string> headers;
+  std::optional<std::string> body;
+  long timeout_seconds = 60;
+  BodyChunkFn on_chunk;
+  HttpCallback on_done;
+};
+
+void Complete(PendingRequest &request, HttpResponse response) {
+  if (!request.on_done)
+    return;
+  try {
+    request.on_done(std::move(response));
+  } catch (...) {
+    // A throwing callback must not take down the transport thread.
+  }
+}
+
+void DeliverChunk(PendingRequest &request, std::string_view chunk) {
+  try {
+    request.on_chunk(chunk);
+  } catch (...) {
+    // Same rule as Complete(): never unwind into the transport.
+  }
+}
+
+HttpResponse Canceled() {
+  HttpResponse r;
+  r.error = "canceled";
+  return r;
+}
+
+long ElapsedMs(std::chrono::steady_clock::time_point start) {
+  return static_cast<long>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count());
+}
+
+} // namespace
+
+std::string HostOf(const std::string &url) {
+  std::size_t begin = url.find("://");
+  begin = begin == std::string::npos ? 0 : begin + 3;
+  const std::size_t end = url.find_first_of(":/?", begin);
+  return ToLower(url.substr(begin, end == std::string::npos ? std::string::npos
+                                                              : end - begin));
+}
+
+
+#if !defined(_WIN32)
+namespace {
+
+LatencyPhases ReadPhases(CURL *curl) {
+  auto read = [curl](CURLINFO info) {
+    curl_off_t v = -1;
+    if (curl_easy_getinfo(curl, info, &v) != CURLE_OK)
+      return -1LL;
+    return static_cast<long long>(v);
+  };
+  LatencyPhases ph;
+  ph.dns_us = read(CURLINFO_NAMELOOKUP_TIME_T);
+  ph.connect_us = read(CURLINFO_CONNECT_TIME_T);
+  ph.tls_us = read(CURLINFO_APPCONNECT_TIME_T);
+  ph.ttfb_us = read(CURLINFO_STARTTRANSFER_TIME_T);
+  ph.total_us = read(CURLINFO_TOTAL_TIME_T);
+  return ph;
+}
+
+size_t StreamBodyCallback(void *contents, size_t size, size_t nmemb,
+                          void *userp) {
+  const size_t total_size = size * nmemb;
+  DeliverChunk(*static_cast<PendingRequest *>(userp),
+               std::string_view(static_cast<char *>(contents), total_size));
+  return total_size;
+}
+
+struct Transfer {
+  PendingRequest request;
+  CURL *curl = nullptr;
+  curl_slist *header_list = nullptr;
+  std::string response_body;
+  HeaderTable response_headers;
+  std::chrono::steady_clock::time_point start;
+};
+
+} // namespace
+
+struct HttpClient::Impl {
+  int per_host = 4;
+  const std::atomic<bool> *cancel_requested = nullptr;
+
+  CURLM *multi = nullptr;
+  CURLSH *share = nullptr;
+
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Transfer>> submitted;
+  std::map<std::string, int> host_limits;
+  bool stopping = false;
+
+  // Everything below is only touched by the I/O thread.
+  std::map<std::string, std::deque<std::unique_ptr<Transfer>>> waiting;
+  std::map<std::string, int> active;
+  std::map<CURL *, std::unique_ptr<Transfer>> running;
+  std::map<std::string, std::vector<CURL *>> idle_handles;
+  std::map<std::string, int> limits;
+  std::thread io_thread;
+
+  void Submit(PendingRequest request) {
+    auto t = std::make_unique<Transfer>();
+    t->request = std::move(request);
+    {
+      std::scoped_lock lock(mutex);
+      submitted.push_back(std::move(t));
+    }
+    curl_multi_wakeup(multi);
+  }
+
+  CURL *AcquireHandle(const std::string &host) {
+    auto &handles = idle_handles[host];
+    if (!handles.empty()) {
+      CURL *curl = handles.back();
+      handles.pop_back();
+      return curl;
+    }
+    return curl_easy_init();
+  }
+
+  void ReleaseHandle(const std::string &host, CURL *curl) {
+    // Reset drops per-request options; the multi handle keeps the live
+    // connection so the next request to this host can pick it up.
+    curl_easy_reset(curl);
+    idle_handles[host].push_back(curl);
+  }
+
+  void Start(std::unique_ptr<Transfer> t) {
+    const PendingRequest &req = t->request;
+    CURL *curl = AcquireHandle(req.host);
+    if (!curl) {
+      HttpResponse r;
+      r.error = "curl_easy_init failed";
+      Complete(t->request, std::move(r));
+      return;
+    }
+    t->curl = curl;
+
+    t->header_list =
+        curl_slist_append(t->header_list, "User-Agent: llm-audit-gui/1.0");
+    for (const auto &h : req.headers)
+      t->header_list = curl_slist_append(t->header_list, h.c_str());
+
+    curl_easy_setopt(curl, CURLOPT_URL, req.url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, t->header_list);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, req.timeout_seconds);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+    if (share)
+      curl_easy_setopt(curl, CURLOPT_SHARE, share);
+    if (t->request.on_chunk) {
+      curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, StreamBodyCallback);
+      curl_easy_setopt(curl, CURLOPT_WRITEDATA, &t->request);
+    } else {
+      curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteBodyCallback);
+      curl_easy_setopt(curl, CURLOPT_WRITEDATA, &t->response_body);
+    }
+    // Enough for a typical response's headers in one allocation.
+    t->response_headers.reserve(1024);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &t->response_headers);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, t.get());
+
+    if (req.method == "POST") {
+      curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    } else if (req.method != "GET") {
+      curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, req.method.c_str());
+    }
+
+    if (req.body.has_value()) {
+      curl_easy_setopt(curl, CURLOPT_POSTFIELDS, req.body->c_str());
+      curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE,
+                       static_cast<long>(req.body->size()));
+    }
+
+    t->start = std::chrono::steady_clock::now();
+    active[req.host] += 1;
+    curl_multi_add_handle(multi, curl);
+    running.emplace(curl, std::move(t));
+  }
+
+  void Finish(CURL *curl, CURLcode code) {
+    auto it = running.find(curl);
+    if (it == running.end())
+      return;
+    std::unique_ptr<Transfer> t = std::move(it->second);
+    running.erase(it);
+    curl_multi_remove_handle(multi, curl);
+
+    HttpResponse result;
+    result.latency_ms = ElapsedMs(t->start);
+    if (code != CURLE_OK)
+      result.error = curl_easy_strerror(code);
+    long http_status = -1;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_status);
+    long new_connects = 0;
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &new_connects);
+    result.status = http_status;
+    result.connection_reused = code == CURLE_OK && new_connects == 0;
+    result.phases = ReadPhases(curl);
+    result.body = std::move(t->response_body);
+    result.headers = std::move(t->response_headers);
+
+    curl_slist_free_all(t->header_list);
+    ReleaseHandle(t->request.host, curl);
+    active[t->request.host] -= 1;
+    Complete(t->request, std::move(result));
+  }
+
+  void Loop() {
+    for (;;) {
+      {
+        std::scoped_lock lock(mutex);
+        for (auto &t : submitted) {
+          const std::string host = t->request.host;
+          waiting[host].push_back(std::move(t));
+        }
+        submitted.clear();
+        limits = host_limits;
+        const bool idle =
+            running.empty() &&
+            std::all_of(waiting.begin(), waiting.end(),
+                        [](const auto &q) { return q.second.empty(); });
+        if (stopping && idle)
+          return;
+      }
+
+      const bool canceled = cancel_requested && cancel_requested->load();
+      for (auto &[host, queue] : waiting) {
+        const auto limit = limits.find(host);
+        const int cap = limit != limits.end() ? limit->second : per_host;
+        while (!queue.empty() && (canceled || active[host] < cap)) {
+          std::unique_ptr<Transfer> t = std::move(queue.front());
+          queue.pop_front();
+          if (canceled) {
+            Complete(t->request, Canceled());
+          } else {
+            Start(std::move(t));
+          }
+        }
+      }
+
+      int still_running = 0;
+      curl_multi_perform(multi, &still_running);
+
+      bool finished_any = false;
+      int msgs_left = 0;
+      while (CURLMsg *msg = curl_multi_info_read(multi, &msgs_left)) {
+        if (msg->msg == CURLMSG_DONE) {
+          Finish(msg->easy_handle, msg->data.result);
+          finished_any = true;
+        }
+      }
+      // A finished transfer may free a per-host slot; go round again so the
+      // next queued request starts without waiting out the poll timeout.
+      if (!finished_any)
+        curl_multi_poll(multi, nullptr, 0, 100, nullptr);
+    }
+  }
+};
+
+HttpClient::HttpClient(int max_in_flight_per_host,
+                       const std::atomic<bool> *cancel_requested)
+    : impl_(std::make_unique<Impl>()) {
+  curl_global_init(CURL_GLOBAL_DEFAULT);
+  impl_->per_host = std::max(max_in_flight_per_host, 1);
+  impl_->cancel_requested = cancel_requested;
+  impl_->multi = curl_multi_init();
+  curl_multi_setopt(impl_->multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+  // The multi handle keeps its own connection cache; the share object adds
+  // DNS and TLS session reuse. Both are only used from the I/O thread.
+  impl_->share = curl_share_init();
+  if (impl_->share) {
+    curl_share_setopt(impl_->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(impl_->share, CURLSHOPT_SHARE,
+                      CURL_LOCK_DATA_SSL_SESSION);
+  }
+  impl_->io_thread = std::thread([impl = impl_.get()] { impl->Loop(); });
+}
+
+HttpClient::~HttpClient() {
+  {
+    std::scoped_lock lock(impl_->mutex);
+    impl_->stopping = true;
+  }
+  curl_multi_wakeup(impl_->multi);
+  impl_->io_thread.join();
+
+  for (auto &[host, handles] : impl_->idle_handles) {
+    for (CURL *curl : handles)
+      curl_easy_cleanup(curl);
+  }
+  curl_multi_cleanup(impl_->multi);
+  if (impl_->share)
+    curl_share_cleanup(impl_->share);
+  curl_global_cleanup();
+}
+#else
+struct HttpClient::Impl {
+  struct Transfer {
+    PendingRequest request;
+    Impl *owner = nullptr;
+    HINTERNET h_request = nullptr;
+    std::vector<char> buffer;
+    std::string response_body;
+    HttpResponse result;
+    bool connected = false;
+    bool secure = false;
+    bool done = false;
+    std::chrono::steady_clock::time_point start;
+
+    long long SinceStartUs() const {
+      return std::chrono::duration_cast<std::chrono::microseconds>(
+                 std::chrono::steady_clock::now() - start)
+          .count();
+    }
+  };
+
+  int per_host = 4;
+  const std::atomic<bool> *cancel_requested = nullptr;
+  HINTERNET session = nullptr;
+
+  std::mutex mutex;
+  std::condition_variable drained;
+  std::map<std::wstring, HINTERNET> connections;
+  std::map<std::string, std::deque<PendingRequest>> waiting;
+  std::map<std::string, int> active;
+  std::map<std::string, int> host_limits;
+  int open_transfers = 0;
+
+  // Caller holds mutex.
+  int LimitFor(const std::string &host) const {
+    const auto it = host_limits.find(host);
+    return it != host_limits.end() ? it->second : per_host;
+  }
+
+  HINTERNET Connect(const std::wstring &host, INTERNET_PORT port) {
+    const std::wstring key = host + L":" + std::to_wstring(port);
+    std::scoped_lock lock(mutex);
+    auto it = connections.find(key);
+    if (it != connections.end())
+      return it->second;
+    HINTERNET h_connect = WinHttpConnect(session, host.c_str(), port, 0);
+    if (h_connect)
+      connections.emplace(key, h_connect);
+    return h_connect;
+  }
+
+  void Submit(PendingRequest request) {
+    if (cancel_requested && cancel_requested->load()) {
+      Complete(request, Canceled());
+      return;
+    }
+    {
+      std::scoped_lock lock(mutex);
+      if (active[request.host] >= LimitFor(request.host)) {
+        waiting[request.host].push_back(std::move(request));
+        return;
+      }
+      active[request.host] += 1;
+      open_transfers += 1;
+    }
+    Start(std::move(request));
+  }
+
+  // Called once a transfer has delivered its result; frees the host slot and
+  // starts the next queued request for that host.
+  void SlotFreed(const std::string &host) {
+    std::vector<PendingRequest> to_cancel;
+    std::optional<PendingRequest> next;
+    {
+      std::scoped_lock lock(mutex);
+      active[host] -= 1;
+      auto &queue = waiting[host];
+      if (cancel_requested && cancel_requested->load()) {
+        to_cancel.assign(std::make_move_iterator(queue.begin()),
+                         std::make_move_iterator(queue.end()));
+        queue.clear();
+      } else if (!queue.empty()) {
+        next = std::move(queue.front());
+        queue.pop_front();
+        active[host] += 1;
+        open_transfers += 1;
+      }
+    }
+    for (auto &r : to_cancel)
+      Complete(r, Canceled());
+    if (next)
+      Start(std::move(*next));
+  }
+
+  void TransferClosed(Transfer *t) {
+    delete t;
+    std::scoped_lock lock(mutex);
+    open_transfers -= 1;
+    if (open_transfers == 0)
+      drained.notify_all();
+  }
+
+  // Delivers the result exactly once and closes the request handle. The
+  // Transfer itself is freed when WinHTTP reports HANDLE_CLOSING.
+  static void Finish(Transfer *t, DWORD error) {
+    if (t->done)
+      return;
+    t->done = true;
+    if (error != 0)
+      t->result.error = WinErrText(error);
+    t->result.latency_ms = ElapsedMs(t->start);
+    t->result.connection_reused = !t->connected;
+    LatencyPhases &ph = t->result.phases;
+    ph.total_us = t->SinceStartUs();
+    if (t->result.connection_reused && t->result.status > 0) {
+      ph.dns_us = ph.connect_us = ph.tls_us = 0;
+    } else if (!t->secure && ph.connect_us >= 0) {
+      ph.tls_us = 0;
+    }
+    t->result.body = std::move(t->response_body);
+    Impl *owner = t->owner;
+    const std::string host = t->request.host;
+    Complete(t->request, std::move(t->result));
+    WinHttpCloseHandle(t->h_request);
+    owner->SlotFreed(host);
+  }
+
+  static void ReadHeaders(Transfer *t) {
+    DWORD status = 0;
+    DWORD status_size = sizeof(status);
+    if (WinHttpQueryHeaders(
+            t->h_request, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+            WINHTTP_HEADER_NAME_BY_INDEX, &status, &status_size,
+            WINHTTP_NO_HEADER_INDEX)) {
+      t->result.status = static_cast<long>(status);
+    }
+
+    DWORD raw_size = 0;
+    WinHttpQueryHeaders(t->h_request, WINHTTP_QUERY_RAW_HEADERS_CRLF,
+                        WINHTTP_HEADER_NAME_BY_INDEX, nullptr, &raw_size,
+                        WINHTTP_NO_HEADER_INDEX);
+    if (GetLastError() == ERROR_INSUFFICIENT_BUFFER &&
+        raw_size > sizeof(wchar_t)) {
+      std::wstring raw(raw_size / sizeof(wchar_t), L'\0');
+      if (WinHttpQueryHeaders(t->h_request, WINHTTP_QUERY_RAW_HEADERS_CRLF,
+                              WINHTTP_HEADER_NAME_BY_INDEX, raw.data(),
+                              &raw_size, WINHTTP_NO_HEADER_INDEX)) {
+        t->result.headers = ParseRawHeaders(raw);
+      }
+    }
+  }
+
+  static void CALLBACK OnStatus(HINTERNET, DWORD_PTR context, DWORD status,
+                                LPVOID info, DWORD info_len) {
+    auto *t = reinterpret_cast<Transfer *>(context);
+    if (!t)
+      return;
+    LatencyPhases &ph = t->result.phases;
+    switch (status) {
+    case WINHTTP_CALLBACK_STATUS_NAME_RESOLVED:
+      ph.dns_us = t->SinceStartUs();
+      break;
+    case WINHTTP_CALLBACK_STATUS_CONNECTED_TO_SERVER:
+      t->connected = true;
+      ph.connect_us = t->SinceStartUs();
+      break;
+    case WINHTTP_CALLBACK_STATUS_SENDING_REQUEST:
+      // WinHTTP finishes the TLS handshake before it starts sending.
+      if (t->secure && t->connected && ph.tls_us < 0)
+        ph.tls_us = t->SinceStartUs();
+      break;
+    case WINHTTP_CALLBACK_STATUS_RESPONSE_RECEIVED:
+      if (ph.ttfb_us < 0)
+        ph.ttfb_us = t->SinceStartUs();
+      break;
+    case WINHTTP_CALLBACK_STATUS_SENDREQUEST_COMPLETE:
+      if (!WinHttpReceiveResponse(t->h_request, nullptr))
+        Finish(t, GetLastError());
+      break;
+    case WINHTTP_CALLBACK_STATUS_HEADERS_AVAILABLE:
+      ReadHeaders(t);
+      if (!WinHttpQueryDataAvailable(t->h_request, nullptr))
+        Finish(t, GetLastError());
+      break;
+    case WINHTTP_CALLBACK_STATUS_DATA_AVAILABLE: {
+      const DWORD available = *static_cast<DWORD *>(info);
+      if (available == 0) {
+        Finish(t, 0);
+        break;
+      }
+      t->buffer.resize(available);
+      if (!WinHttpReadData(t->h_request, t->buffer.data(), available,
+                           nullptr))
+        Finish(t, GetLastError());
+      break;
+    }
+    case WINHTTP_CALLBACK_STATUS_READ_COMPLETE:
+      if (info_len == 0) {
+        Finish(t, 0);
+        break;
+      }
+      if (t->request.on_chunk) {
+        DeliverChunk(t->request,
+                     std::string_view(static_cast<const char *>(info),
+                                      info_len));
+      } else {
+        t->response_body.append(static_cast<const char *>(info), info_len);
+      }
+      if (!WinHttpQueryDataAvailable(t->h_request, nullptr))
+        Finish(t, GetLastError());
+      break;
+    case WINHTTP_CALLBACK_STATUS_REQUEST_ERROR:
+      Finish(t, static_cast<WINHTTP_ASYNC_RESULT *>(info)->dwError);
+      break;
+    case WINHTTP_CALLBACK_STATUS_HANDLE_CLOSING:
+      t->owner->TransferClosed(t);
+      break;
+    default:
+      break;
+    }
+  }
+
+  void Start(PendingRequest request) {
+    auto *t = new Transfer();
+    t->request = std::move(request);
+    t->owner = this;
+    t->start = std::chrono::steady_clock::now();
+
+    // Failures before a request handle exists never reach the callback, so
+    // they complete inline and release the slot here.
+    auto fail_early = [&](DWORD error) {
+      HttpResponse r;
+      r.error = WinErrText(error);
+      r.latency_ms = ElapsedMs(t->start);
+      const std::string host = t->request.host;
+      Complete(t->request, std::move(r));
+      TransferClosed(t);
+      SlotFreed(host);
+    };
+
+    const std::wstring wurl = Utf8ToWide(t->request.url);
+    URL_COMPONENTS comps{};
+    comps.dwStructSize = sizeof(comps);
+    comps.dwSchemeLength = static_cast<DWORD>(-1);
+    comps.dwHostNameLength = static_cast<DWORD>(-1);
+    comps.dwUrlPathLength = static_cast<DWORD>(-1);
+    comps.dwExtraInfoLength = static_cast<DWORD>(-1);
+    if (!WinHttpCrackUrl(wurl.c_str(), 0, 0, &comps)) {
+      fail_early(GetLastError());
+      return;
+    }
+
+    const std::wstring host(comps.lpszHostName, comps.dwHostNameLength);
+    std::wstring path =
+        comps.dwUrlPathLength > 0
+            ? std::wstring(comps.lpszUrlPath, comps.dwUrlPathLength)
+            : L"/";
+    if (comps.dwExtraInfoLength > 0) {
+      path += std::wstring(comps.lpszExtraInfo, comps.dwExtraInfoLength);
+    }
+    const bool secure = comps.nScheme == INTERNET_SCHEME_HTTPS;
+    t->secure = secure;
+
+    HINTERNET h_connect = Connect(host, comps.nPort);
+    if (!h_connect) {
+      fail_early(GetLastError());
+      return;
+    }
+
+    const std::wstring wmethod = Utf8ToWide(t->request.method);
+    t->h_request = WinHttpOpenRequest(
+        h_connect, wmethod.c_str(), path.c_str(), nullptr, WINHTTP_NO_REFERER,
+        WINHTTP_DEFAULT_ACCEPT_TYPES, secure ? WINHTTP_FLAG_SECURE : 0);
+    if (!t->h_request) {
+      fail_early(GetLastError());
+      return;
+    }
+    DWORD_PTR context = reinterpret_cast<DWORD_PTR>(t);
+    WinHttpSetOption(t->h_request, WINHTTP_OPTION_CONTEXT_VALUE, &context,
+                     sizeof(context));
+    const int timeout_ms = static_cast<int>(t->request.timeout_seconds * 1000);
+    WinHttpSetTimeouts(t->h_request, timeout_ms, timeout_ms, timeout_ms,
+                       timeout_ms);
+
+    // From here on the request handle owns the Transfer: every failure goes
+    // through Finish(), and HANDLE_CLOSING frees it.
+    for (const auto &h : t->request.headers) {
+      const std::wstring wh = Utf8ToWide(h);
+      if (!WinHttpAddRequestHeaders(t->h_request, wh.c_str(),
+                                    static_cast<DWORD>(wh.size()),
+                                    WINHTTP_ADDREQ_FLAG_ADD)) {
+        Finish(t, GetLastError());
+        return;
+      }
+    }
+    const std::wstring user_agent = L"User-Agent: llm-audit-gui/1.0";
+    WinHttpAddRequestHeaders(t->h_request, user_agent.c_str(),
+                             static_cast<DWORD>(user_agent.size()),
+                             WINHTTP_ADDREQ_FLAG_ADD);
+
+    LPVOID body_ptr = WINHTTP_NO_REQUEST_DATA;
+    DWORD body_len = 0;
+    if (t->request.body.has_value()) {
+      body_ptr = t->request.body->data();
+      body_len = static_cast<DWORD>(t->request.body->size());
+    }
+
+    if (!WinHttpSendRequest(t->h_request, WINHTTP_NO_ADDITIONAL_HEADERS, 0,
+                            body_ptr, body_len, body_len, context)) {
+      Finish(t, GetLastError());
+    }
+  }
+};
+
+HttpClient::HttpClient(int max_in_flight_per_host,
+                       const std::atomic<bool> *cancel_requested)
+    : impl_(std::make_unique<Impl>()) {
+  impl_->per_host = std::max(max_in_flight_per_host, 1);
+  impl_->cancel_requested = cancel_requested;
+  impl_->session =
+      WinHttpOpen(L"llm-audit-gui/1.0", WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+                  WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS,
+                  WINHTTP_FLAG_ASYNC);
+  if (impl_->session) {
+    DWORD protocols = WINHTTP_PROTOCOL_FLAG_HTTP2;
+    WinHttpSetOption(impl_->session, WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL,
+                     &protocols, sizeof(protocols));
+    WinHttpSetStatusCallback(impl_->session, &Impl::OnStatus,
+                             WINHTTP_CALLBACK_FLAG_ALL_COMPLETIONS |
+                                 WINHTTP_CALLBACK_FLAG_RESOLVE_NAME |
+                                 WINHTTP_CALLBACK_FLAG_CONNECT_TO_SERVER |
+                                 WINHTTP_CALLBACK_FLAG_SEND_REQUEST |
+                                 WINHTTP_CALLBACK_FLAG_RECEIVE_RESPONSE |
+                                 WINHTTP_CALLBACK_FLAG_HANDLES,
+                             0);
+  }
+}
+
+HttpClient::~HttpClient() {
+  {
+    std::unique_lock lock(impl_->mutex);
+    impl_->drained.wait(lock, [&] { return impl_->open_transfers == 0; });
+  }
+  for (auto &[key, h_connect] : impl_->connections)
+    WinHttpCloseHandle(h_connect);
+  if (impl_->session) {
+    WinHttpSetStatusCallback(impl_->session, nullptr, 0, 0);
+    WinHttpCloseHandle(impl_->session);
+  }
+}
+#endif
+
+struct HttpClient::Replay {
+  using Clock = std::chrono::steady_clock;
+
+  struct Item {
+    PendingRequest request;
+    HttpResponse response;
+    // Streams deliver their body at ttfb and complete at done_at.
+    Clock::time_point done_at;
+    bool body_sent = false;
+  };
+
+  ResponseStore *store = nullptr;
+  bool latency = false;
+  HttpClient::Impl *impl = nullptr;
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::multimap<Clock::time_point, Item> due;
+  // The transport's per-host caps hold for replays too, so queueing shows
+  // up in replayed timings as it did in the recorded run.
+  std::map<std::string, int> active;
+  std::map<std::string, std::deque<std::pair<PendingRequest, std::string>>>
+      waiting;
+  bool stopping = false;
+  std::thread thread;
+
+  ~Replay() {
+    if (!thread.joinable())
+      return;
+    {
+      std::scoped_lock lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    thread.join();
+  }
+
+  bool Canceled() const {
+    return impl->cancel_requested && impl->cancel_requested->load();
+  }
+
+  int LimitFor(const std::string &host) {
+    std::scoped_lock lock(impl->mutex);
+    const auto it = impl->host_limits.find(host);
+    return it != impl->host_limits.end() ? it->second : impl->per_host;
+  }
+
+  // Caller holds mutex and has taken a slot for the request's host.
+  void Schedule(PendingRequest request, const std::string &fingerprint) {
+    Item item;
+    const auto start = Clock::now();
+    auto at = start;
+    if (auto recorded = store->Replay(fingerprint)) {
+      item.response = std::move(*recorded);
+      if (latency) {
+        const long long total_us =
+            std::max(item.response.latency_ms, 0L) * 1000LL;
+        const long long ttfb_us = item.response.phases.ttfb_us;
+        item.done_at = start + std::chrono::microseconds(total_us);
+        at = request.on_chunk && ttfb_us >= 0 && ttfb_us < total_us
+                 ? start + std::chrono::microseconds(ttfb_us)
+                 : item.done_at;
+      }
+    } else {
+      item.response.error = "not recorded";
+    }
+    item.request = std::move(request);
+    due.emplace(at, std::move(item));
+  }
+
+  void Submit(PendingRequest request, const std::string &fingerprint) {
+    const int cap = LimitFor(request.host);
+    {
+      std::scoped_lock lock(mutex);
+      int &running = active[request.host];
+      if (running >= cap && !Canceled()) {
+        waiting[request.host].emplace_back(std::move(request), fingerprint);
+        return;
+      }
+      running += 1;
+      Schedule(std::move(request), fingerprint);
+    }
+    wake.notify_one();
+  }
+
+  // Called on the replay thread without mutex held.
+  void Deliver(Item item) {
+    if (Canceled()) {
+      Complete(item.request, llaudit::Canceled());
+    } else if (item.request.on_chunk && !item.body_sent) {
+      if (!item.response.body.empty())
+        DeliverChunk(item.request, item.response.body);
+      item.response.body.clear();
+      item.body_sent = true;
+      if (item.done_at > Clock::now()) {
+        const auto at = item.done_at;
+        std::scoped_lock lock(mutex);
+        due.emplace(at, std::move(item));
+        return;
+      }
+      Complete(item.request, std::move(item.response));
+    } else {
+      Complete(item.request, std::move(item.response));
+    }
+
+    const std::string &host = item.request.host;
+    const int cap = LimitFor(host);
+    std::scoped_lock lock(mutex);
+    active[host] -= 1;
+    auto &queue = waiting[host];
+    while (!queue.empty() && (active[host] < cap || Canceled())) {
+      auto [request, fingerprint] = std::move(queue.front());
+      queue.pop_front();
+      active[host] += 1;
+      Schedule(std::move(request), fingerprint);
+    }
+  }
+
+  void Loop() {
+    std::unique_lock lock(mutex);
+    for (;;) {
+      wake.wait(lock, [&] { return stopping || !due.empty(); });
+      if (due.empty())
+        return;
+      const auto next = due.begin()->first;
+      if (!stopping && !Canceled() && next > Clock::now()) {
+        wake.wait_until(lock, next);
+        continue;
+      }
+      Item item = std::move(due.begin()->second);
+      due.erase(due.begin());
+      lock.unlock();
+      Deliver(std::move(item));
+      lock.lock();
+    }
+  }
+};
+
+void HttpClient::SetResponseStore(ResponseStore *store, bool replay_latency) {
+  if (!store || store->mode() == RecordMode::kOff) {
+    replay_.reset();
+    return;
+  }
+  replay_ = std::make_unique<Replay>();
+  replay_->store = store;
+  replay_->latency = replay_latency;
+  replay_->impl = impl_.get();
+  if (store->mode() == RecordMode::kReplay)
+    replay_->thread = std::thread([r = replay_.get()] { r->Loop(); });
+}
+
+void HttpClient::SetHostLimit(const std::string &host, int max_in_flight) {
+  {
+    std::scoped_lock lock(impl_->mutex);
+    if (max_in_flight > 0) {
+      impl_->host_limits[host] = max_in_flight;
+    } else {
+      impl_->host_limits.erase(host);
+    }
+  }
+#if !defined(_WIN32)
+  curl_multi_wakeup(impl_->multi);
+#endif
+}
+
+void HttpClient::RequestAsync(const std::string &method,
+                              const std::string &url,
+                              const std::vector<std::string> &headers,
+                              const std::optional<std::string> &body,
+                              HttpCallback on_done, long timeout_seconds) {
+  StreamAsync(method, url, headers, body, nullptr, std::move(on_done),
+              timeout_seconds);
+}
+
+void HttpClient::StreamAsync(const std::string &method,
+                             const std::string &url,
+                             const std::vector<std::string> &headers,
+                             const std::optional<std::string> &body,
+                             BodyChunkFn on_chunk, HttpCallback on_done,
+                             long timeout_seconds) {
+  PendingRequest request;
+  request.method = method;
+  request.url = url;
+  request.host = HostOf(url);
+  request.headers = headers;
+  request.body = body;
+  request.timeout_seconds = timeout_seconds;
+  request.on_chunk = std::move(on_chunk);
+  request.on_done = std::move(on_done);
+  if (replay_) {
+    const std::string fingerprint =
+        ResponseStore::Fingerprint(method, url, headers, body);
+    if (replay_->store->mode() == RecordMode::kReplay) {
+      replay_->Submit(std::move(request), fingerprint);
+      return;
+    }
+    // A stream's body never reaches HttpResponse, so keep a copy of the
+    // chunks for the store.
+    auto streamed = std::make_shared<std::string>();
+    if (request.on_chunk) {
+      request.on_chunk = [streamed, inner = std::move(request.on_chunk)](
+                             std::string_view chunk) {
+        streamed->append(chunk);
+        inner(chunk);
+      };
+    }
+    request.on_done = [store = replay_->store, fingerprint, streamed,
+                       stream = static_cast<bool>(request.on_chunk),
+                       inner = std::move(request.on_done)](HttpResponse r) {
+      if (stream) {
+        std::swap(r.body, *streamed);
+        store->Record(fingerprint, r);
+        std::swap(r.body, *streamed);
+      } else {
+        store->Record(fingerprint, r);
+      }
+      if (inner)
+        inner(std::move(r));
+    };
+  }
+#if !defined(_WIN32)
+  impl_->Submit(std::move(request));
+#else
+  if (!impl_->session) {
+    HttpResponse r;
+    r.error = "WinHttpOpen failed";
+    Complete(request, std::move(r));
+    return;
+  }
+  impl_->Submit(std::move(request));
+#endif
+}
+
+std::future<HttpResponse>
+HttpClient::RequestAsync(const std::string &method, const std::string &url,
+                         const std::vector<std::string> &headers,
+                         const std::optional<std::string> &body,
+                         long timeout_seconds) {
+  auto promise = std::make_shared<std::promise<HttpResponse>>();
+  auto future = promise->get_future();
+  RequestAsync(
+      method, url, headers, body,
+      [promise](HttpResponse r) { promise->set_value(std::move(r)); },
+      timeout_seconds);
+  return future;
+}
+
+HttpResponse HttpClient::Request(const std::string &method,
+                                 const std::string &url,
+                                 const std::vector<std::string> &headers,
+                                 const std::optional<std::string> &body,
+                                 long timeout_seconds) {
+  return RequestAsync(method, url, headers, body, timeout_seconds).get();
+}
+
+HttpResponse HttpClient::Stream(const std::string &method,
+                                const std::string &url,
+                                const std::vector<std::string> &headers,
+                                const std::optional<std::string> &body,
+                                BodyChunkFn on_chunk, long timeout_seconds) {
+  // Shared with the callback: the I/O thread may still be inside it,
+  // after set_value, when get() returns and this frame unwinds.
+  auto promise = std::make_shared<std::promise<HttpResponse>>();
+  auto future = promise->get_future();
+  StreamAsync(
+      method, url, headers, body, std::move(on_chunk),
+      [promise](HttpResponse r) { promise->set_value(std::move(r)); },
+      timeout_seconds);
+  return future.get();
+}
+
+} // namespace llaudit
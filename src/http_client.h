@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "header_table.h"
+
+namespace llaudit {
+
+// Transport phase timings in microseconds, each measured from the start of the
+// request (curl's convention). Setup phases are 0 on a reused connection and
+// tls_us is 0 for plain http; -1 means the phase was never reached.
+struct LatencyPhases {
+  long long dns_us = -1;
+  long long connect_us = -1;
+  long long tls_us = -1;
+  long long ttfb_us = -1;
+  long long total_us = -1;
+};
+
+struct HttpResponse {
+  long status = -1;
+  long latency_ms = -1;
+  LatencyPhases phases;
+  bool connection_reused = false;
+  std::string body;
+  HeaderTable headers;
+  std::string error;
+};
+
+class ResponseStore;
+
+using HttpCallback = std::function<void(HttpResponse)>;
+// Receives response body bytes as they arrive.
+using BodyChunkFn = std::function<void(std::string_view)>;
+
+// Lower-cased host name of an http(s) URL, without port or path.
+std::string HostOf(const std::string& url);
+
+// Event-driven HTTP transport. On POSIX a single I/O thread drives every
+// transfer through curl_multi; on Windows WinHTTP runs in async callback mode.
+// DNS results, TLS sessions and open connections are kept alive between
+// requests, so one client is meant to live for a single audit run.
+//
+// At most max_in_flight_per_host requests run against one host at a time;
+// the rest wait in a per-host queue. Once cancel_requested is set, queued
+// requests fail with error "canceled" instead of being sent.
+class HttpClient {
+ public:
+  explicit HttpClient(int max_in_flight_per_host = 4,
+                      const std::atomic<bool>* cancel_requested = nullptr);
+  ~HttpClient();
+
+  HttpClient(const HttpClient&) = delete;
+  HttpClient& operator=(const HttpClient&) = delete;
+
+  // Overrides max_in_flight_per_host for one host; 0 restores the default.
+  void SetHostLimit(const std::string& host, int max_in_flight);
+
+  // Routes every request through the store: in record mode responses are
+  // written to it as they complete, in replay mode they are served from it
+  // and nothing is sent; a request it does not hold fails with error
+  // "not recorded". With replay_latency each replayed response arrives after
+  // its recorded latency (a stream's body after its recorded TTFB), otherwise
+  // at once. Call before the first request; the store must outlive the client.
+  void SetResponseStore(ResponseStore* store, bool replay_latency = false);
+
+  // Completion callbacks run on the transport's own thread(s) and must not
+  // block or issue a blocking Request().
+  void RequestAsync(const std::string& method, const std::string& url,
+                    const std::vector<std::string>& headers,
+                    const std::optional<std::string>& body, HttpCallback on_done,
+                    long timeout_seconds = 60);
+
+  std::future<HttpResponse> RequestAsync(const std::string& method, const std::string& url,
+                                         const std::vector<std::string>& headers,
+                                         const std::optional<std::string>& body,
+                                         long timeout_seconds = 60);
+
+  HttpResponse Request(const std::string& method, const std::string& url,
+                       const std::vector<std::string>& headers,
+                       const std::optional<std::string>& body, long timeout_seconds = 60);
+
+  // Like RequestAsync, but the body is handed to on_chunk piece by piece on the
+  // transport thread instead of being collected into HttpResponse::body.
+  void StreamAsync(const std::string& method, const std::string& url,
+                   const std::vector<std::string>& headers,
+                   const std::optional<std::string>& body, BodyChunkFn on_chunk,
+                   HttpCallback on_done, long timeout_seconds = 60);
+
+  HttpResponse Stream(const std::string& method, const std::string& url,
+                      const std::vector<std::string>& headers,
+                      const std::optional<std::string>& body, BodyChunkFn on_chunk,
+                      long timeout_seconds = 60);
+
+ private:
+  struct Impl;
+  struct Replay;
+  std::unique_ptr<Impl> impl_;
+  // Destroyed before impl_, so no replayed completion outlives the transport.
+  std::unique_ptr<Replay> replay_;
+};
+
+}  // namespace llaudit
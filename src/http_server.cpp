@@ -0,0 +1,244 @@
+#include "http_server.h"
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+namespace llaudit {
+namespace {
+
+#if defined(_WIN32)
+using Socket = SOCKET;
+constexpr Socket kNoSocket = INVALID_SOCKET;
+
+void CloseSocket(Socket s) { closesocket(s); }
+
+int PollOne(Socket s, int timeout_ms) {
+  WSAPOLLFD fd{};
+  fd.fd = s;
+  fd.events = POLLRDNORM;
+  return WSAPoll(&fd, 1, timeout_ms);
+}
+
+void SetRecvTimeout(Socket s, int ms) {
+  const DWORD timeout = static_cast<DWORD>(ms);
+  setsockopt(s, SOL_SOCKET, SO_RCVTIMEO,
+             reinterpret_cast<const char *>(&timeout), sizeof(timeout));
+}
+
+std::string LastSocketError() {
+  return "socket error " + std::to_string(WSAGetLastError());
+}
+#else
+using Socket = int;
+constexpr Socket kNoSocket = -1;
+
+void CloseSocket(Socket s) { close(s); }
+
+int PollOne(Socket s, int timeout_ms) {
+  pollfd fd{};
+  fd.fd = s;
+  fd.events = POLLIN;
+  return poll(&fd, 1, timeout_ms);
+}
+
+void SetRecvTimeout(Socket s, int ms) {
+  timeval tv{};
+  tv.tv_sec = ms / 1000;
+  tv.tv_usec = (ms % 1000) * 1000;
+  setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+std::string LastSocketError() { return std::strerror(errno); }
+#endif
+
+constexpr std::size_t kMaxHeadBytes = 8 * 1024;
+constexpr int kPollIntervalMs = 200;
+constexpr int kClientTimeoutMs = 2000;
+
+#if defined(MSG_NOSIGNAL)
+constexpr int kSendFlags = MSG_NOSIGNAL; // a client hanging up is no SIGPIPE
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+void SendAll(Socket s, std::string_view data) {
+  while (!data.empty()) {
+    const auto n =
+        send(s, data.data(), static_cast<int>(data.size()), kSendFlags);
+    if (n <= 0)
+      return;
+    data.remove_prefix(static_cast<std::size_t>(n));
+  }
+}
+
+void Respond(Socket s, const ServerReply &reply, bool head) {
+  std::string out = "HTTP/1.0 " + reply.status;
+  out += "\r\nContent-Type: " + reply.content_type;
+  out += "\r\nContent-Length: " + std::to_string(reply.body.size());
+  out += "\r\nConnection: close\r\n\r\n";
+  if (!head)
+    out += reply.body;
+  SendAll(s, out);
+}
+
+// Reads until the buffer holds at least `size` bytes; false if the client
+// stops sending first.
+bool ReadUntil(Socket s, std::string &buffer, std::size_t size) {
+  char buf[16 * 1024];
+  while (buffer.size() < size) {
+    const auto n = recv(s, buf, sizeof(buf), 0);
+    if (n <= 0)
+      return false;
+    buffer.append(buf, static_cast<std::size_t>(n));
+  }
+  return true;
+}
+
+} // namespace
+
+HttpServer::~HttpServer() { Stop(); }
+
+bool HttpServer::Start(const std::string &bind_address, int port,
+                       std::string &error) {
+  if (thread_.joinable()) {
+    error = "server already running";
+    return false;
+  }
+#if defined(_WIN32)
+  WSADATA wsa;
+  if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+    error = "WSAStartup failed";
+    return false;
+  }
+#endif
+  auto fail = [&error](std::string message) {
+    error = std::move(message);
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+    return false;
+  };
+
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(static_cast<unsigned short>(port));
+  if (inet_pton(AF_INET, bind_address.c_str(), &addr.sin_addr) != 1)
+    return fail("not an IPv4 address: " + bind_address);
+
+  const Socket s = socket(AF_INET, SOCK_STREAM, 0);
+  if (s == kNoSocket)
+    return fail(LastSocketError());
+  const int on = 1;
+  setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&on),
+             sizeof(on));
+  if (bind(s, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0 ||
+      listen(s, 16) != 0) {
+    const std::string reason = LastSocketError();
+    CloseSocket(s);
+    return fail("cannot listen on " + bind_address + ":" +
+                std::to_string(port) + ": " + reason);
+  }
+  socklen_t len = sizeof(addr);
+  getsockname(s, reinterpret_cast<sockaddr *>(&addr), &len);
+  port_ = ntohs(addr.sin_port);
+
+  listener_ = static_cast<long long>(s);
+  stop_.store(false);
+  thread_ = std::thread([this] { Serve(); });
+  return true;
+}
+
+void HttpServer::Stop() {
+  stop_.store(true);
+  if (thread_.joinable())
+    thread_.join();
+  if (listener_ != -1) {
+    CloseSocket(static_cast<Socket>(listener_));
+    listener_ = -1;
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+  }
+}
+
+void HttpServer::Serve() {
+  const auto listener = static_cast<Socket>(listener_);
+  while (!stop_.load()) {
+    if (PollOne(listener, kPollIntervalMs) <= 0)
+      continue;
+    const Socket client = accept(listener, nullptr, nullptr);
+    if (client == kNoSocket)
+      continue;
+    SetRecvTimeout(client, kClientTimeoutMs);
+
+    std::string data;
+    char buf[1024];
+    std::size_t head_end = std::string::npos;
+    while ((head_end = data.find("\r\n\r\n")) == std::string::npos &&
+           data.size() < kMaxHeadBytes) {
+      const auto n = recv(client, buf, sizeof(buf), 0);
+      if (n <= 0)
+        break;
+      data.append(buf, static_cast<std::size_t>(n));
+    }
+
+    ServerRequest request;
+    const std::string_view head =
+        std::string_view(data).substr(0, head_end);
+    const std::string_view line = head.substr(0, head.find("\r\n"));
+    const auto sp1 = line.find(' ');
+    const auto sp2 = line.find(' ', sp1 + 1);
+    request.method = std::string(line.substr(0, sp1));
+    if (sp1 != std::string_view::npos) {
+      const std::string_view target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+      request.path = std::string(target.substr(0, target.find('?')));
+    }
+    for (std::size_t at = line.size(); at < head.size();) {
+      const auto next = head.find("\r\n", at + 2);
+      request.headers.AddLine(head.substr(at + 2, next - at - 2));
+      at = next == std::string_view::npos ? head.size() : next;
+    }
+    const bool is_head = request.method == "HEAD";
+
+    const auto length = request.headers.Find("content-length");
+    const std::size_t body_bytes =
+        length ? std::strtoull(std::string(*length).c_str(), nullptr, 10) : 0;
+    std::optional<ServerReply> refused;
+    if (head_end != std::string::npos && gate_)
+      refused = gate_(request);
+    if (head_end == std::string::npos) {
+      Respond(client, {"400 Bad Request", "text/plain", "bad request\n"},
+              false);
+    } else if (refused) {
+      Respond(client, *refused, is_head);
+    } else if (body_bytes > max_body_bytes_) {
+      Respond(client,
+              {"413 Payload Too Large", "text/plain", "request too large\n"},
+              false);
+    } else if (ReadUntil(client, data, head_end + 4 + body_bytes)) {
+      request.body = data.substr(head_end + 4, body_bytes);
+      Respond(client, handler_(request), is_head);
+    }
+    CloseSocket(client);
+  }
+}
+
+} // namespace llaudit
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "header_table.h"
+
+namespace llaudit {
+
+struct ServerRequest {
+  std::string method;
+  std::string path;  // without the query string
+  HeaderTable headers;
+  std::string body;
+};
+
+struct ServerReply {
+  std::string status = "200 OK";
+  std::string content_type = "text/plain";
+  std::string body;
+};
+
+using ServerHandler = std::function<ServerReply(const ServerRequest&)>;
+// Sees a request's method, path and headers before its body is read. A reply
+// is sent in place of reading the body; nullopt lets the request through.
+using ServerGate = std::function<std::optional<ServerReply>(const ServerRequest&)>;
+
+// Minimal HTTP/1.0 endpoint. Requests are answered one at a time on a single
+// thread and every connection is closed after its response, which is plenty
+// for a metrics scrape or a handful of cluster workers. A HEAD request gets
+// the headers of the GET reply without its body.
+class HttpServer {
+ public:
+  // Bodies longer than max_body_bytes are refused with 413, after the gate.
+  explicit HttpServer(ServerHandler handler, std::size_t max_body_bytes = 0,
+                      ServerGate gate = {})
+      : handler_(std::move(handler)), gate_(std::move(gate)), max_body_bytes_(max_body_bytes) {}
+  ~HttpServer();
+
+  HttpServer(const HttpServer&) = delete;
+  HttpServer& operator=(const HttpServer&) = delete;
+
+  // Listens on an IPv4 address; port 0 picks a free port.
+  bool Start(const std::string& bind_address, int port, std::string& error);
+  void Stop();
+
+  int port() const { return port_; }
+
+ private:
+  void Serve();
+
+  ServerHandler handler_;
+  ServerGate gate_;
+  std::size_t max_body_bytes_;
+  std::atomic<bool> stop_{false};
+  std::thread thread_;
+  // A SOCKET on Windows, a file descriptor elsewhere; -1 when not listening.
+  long long listener_ = -1;
+  int port_ = 0;
+};
+
+}  // namespace llaudit
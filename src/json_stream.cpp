@@ -0,0 +1,382 @@
+#include "json_stream.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <system_error>
+
+namespace llaudit {
+namespace {
+
+bool IsSpace(unsigned char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool IsDigit(unsigned char c) { return c >= '0' && c <= '9'; }
+
+int HexValue(unsigned char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+void AppendUtf8(std::string &out, std::uint32_t cp) {
+  if (cp < 0x80) {
+    out += static_cast<char>(cp);
+  } else if (cp < 0x800) {
+    out += static_cast<char>(0xC0 | (cp >> 6));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    out += static_cast<char>(0xE0 | (cp >> 12));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  } else {
+    out += static_cast<char>(0xF0 | (cp >> 18));
+    out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  }
+}
+
+// -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?; integral is set when
+// there is neither a fraction nor an exponent.
+bool ValidNumber(std::string_view s, bool &integral) {
+  std::size_t i = 0;
+  auto digits = [&] {
+    const std::size_t start = i;
+    while (i < s.size() && IsDigit(static_cast<unsigned char>(s[i])))
+      ++i;
+    return i > start;
+  };
+  if (i < s.size() && s[i] == '-')
+    ++i;
+  if (i < s.size() && s[i] == '0')
+    ++i;
+  else if (!digits())
+    return false;
+  integral = true;
+  if (i < s.size() && s[i] == '.') {
+    ++i;
+    if (!digits())
+      return false;
+    integral = false;
+  }
+  if (i < s.size() && (s[i] == 'e' || s[i] == 'E')) {
+    ++i;
+    if (i < s.size() && (s[i] == '+' || s[i] == '-'))
+      ++i;
+    if (!digits())
+      return false;
+    integral = false;
+  }
+  return i == s.size();
+}
+
+} // namespace
+
+void JsonStreamParser::Feed(std::string_view chunk) {
+  for (const char c : chunk) {
+    if (state_ == State::kError)
+      return;
+    Byte(static_cast<unsigned char>(c));
+  }
+}
+
+bool JsonStreamParser::Finish() {
+  if (state_ == State::kNumber && !EndNumber())
+    Fail();
+  else if (state_ == State::kLiteral && !EndLiteral())
+    Fail();
+  return state_ == State::kDone;
+}
+
+void JsonStreamParser::Byte(unsigned char c) {
+  switch (state_) {
+  case State::kBom: {
+    static constexpr unsigned char kBom[] = {0xEF, 0xBB, 0xBF};
+    if (c == kBom[bom_seen_]) {
+      if (++bom_seen_ == 3)
+        state_ = State::kValue;
+      return;
+    }
+    if (bom_seen_ > 0)
+      return Fail();
+    state_ = State::kValue;
+    return Byte(c);
+  }
+  case State::kValue:
+    if (!IsSpace(c))
+      Value(c);
+    return;
+  case State::kFirstValueOrEnd:
+    if (IsSpace(c))
+      return;
+    if (c == ']') {
+      in_object_.pop_back();
+      handler_.EndArray();
+      return AfterValue();
+    }
+    return Value(c);
+  case State::kFirstKeyOrEnd:
+  case State::kKey:
+    if (IsSpace(c))
+      return;
+    if (c == '"') {
+      text_.clear();
+      text_is_key_ = true;
+      state_ = State::kString;
+      return;
+    }
+    if (c == '}' && state_ == State::kFirstKeyOrEnd) {
+      in_object_.pop_back();
+      handler_.EndObject();
+      return AfterValue();
+    }
+    return Fail();
+  case State::kColon:
+    if (IsSpace(c))
+      return;
+    if (c != ':')
+      return Fail();
+    state_ = State::kValue;
+    return;
+  case State::kAfterValue:
+    if (IsSpace(c))
+      return;
+    if (c == ',') {
+      state_ = in_object_.back() ? State::kKey : State::kValue;
+      return;
+    }
+    if (c == (in_object_.back() ? '}' : ']')) {
+      const bool object = in_object_.back();
+      in_object_.pop_back();
+      if (object)
+        handler_.EndObject();
+      else
+        handler_.EndArray();
+      return AfterValue();
+    }
+    return Fail();
+  case State::kString:
+    return StringByte(c);
+  case State::kEscape: {
+    char out = 0;
+    switch (c) {
+    case '"':
+    case '\\':
+    case '/':
+      out = static_cast<char>(c);
+      break;
+    case 'b':
+      out = '\b';
+      break;
+    case 'f':
+      out = '\f';
+      break;
+    case 'n':
+      out = '\n';
+      break;
+    case 'r':
+      out = '\r';
+      break;
+    case 't':
+      out = '\t';
+      break;
+    case 'u':
+      unicode_ = 0;
+      unicode_digits_ = 0;
+      state_ = State::kUnicode;
+      return;
+    default:
+      return Fail();
+    }
+    // A high surrogate must be followed by a \u low surrogate.
+    if (high_surrogate_ != 0)
+      return Fail();
+    text_ += out;
+    state_ = State::kString;
+    return;
+  }
+  case State::kUnicode:
+    return UnicodeDigit(c);
+  case State::kNumber:
+    if (IsDigit(c) || c == '-' || c == '+' || c == '.' || c == 'e' ||
+        c == 'E') {
+      text_ += static_cast<char>(c);
+      return;
+    }
+    if (!EndNumber())
+      return Fail();
+    return Byte(c);
+  case State::kLiteral:
+    if (c >= 'a' && c <= 'z') {
+      if (text_.size() >= 5)
+        return Fail();
+      text_ += static_cast<char>(c);
+      return;
+    }
+    if (!EndLiteral())
+      return Fail();
+    return Byte(c);
+  case State::kDone:
+    if (!IsSpace(c))
+      Fail();
+    return;
+  case State::kError:
+    return;
+  }
+}
+
+void JsonStreamParser::Value(unsigned char c) {
+  switch (c) {
+  case '{':
+    handler_.StartObject();
+    in_object_.push_back(true);
+    state_ = State::kFirstKeyOrEnd;
+    return;
+  case '[':
+    handler_.StartArray();
+    in_object_.push_back(false);
+    state_ = State::kFirstValueOrEnd;
+    return;
+  case '"':
+    text_.clear();
+    text_is_key_ = false;
+    state_ = State::kString;
+    return;
+  case 't':
+  case 'f':
+  case 'n':
+    text_.assign(1, static_cast<char>(c));
+    state_ = State::kLiteral;
+    return;
+  default:
+    if (c == '-' || IsDigit(c)) {
+      text_.assign(1, static_cast<char>(c));
+      state_ = State::kNumber;
+      return;
+    }
+    Fail();
+  }
+}
+
+void JsonStreamParser::StringByte(unsigned char c) {
+  if (utf8_pending_ > 0) {
+    if (c < utf8_lo_ || c > utf8_hi_)
+      return Fail();
+    text_ += static_cast<char>(c);
+    utf8_pending_ -= 1;
+    utf8_lo_ = 0x80;
+    utf8_hi_ = 0xBF;
+    return;
+  }
+  if (high_surrogate_ != 0 && c != '\\')
+    return Fail();
+  if (c == '"')
+    return EndString();
+  if (c == '\\') {
+    state_ = State::kEscape;
+    return;
+  }
+  if (c < 0x20)
+    return Fail();
+  if (c >= 0x80) {
+    // Well-formed UTF-8 only (Unicode table 3-7): no overlongs, surrogates
+    // or code points above U+10FFFF.
+    if (c >= 0xC2 && c <= 0xDF) {
+      utf8_pending_ = 1;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+      utf8_pending_ = 2;
+      if (c == 0xE0)
+        utf8_lo_ = 0xA0;
+      if (c == 0xED)
+        utf8_hi_ = 0x9F;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+      utf8_pending_ = 3;
+      if (c == 0xF0)
+        utf8_lo_ = 0x90;
+      if (c == 0xF4)
+        utf8_hi_ = 0x8F;
+    } else {
+      return Fail();
+    }
+  }
+  text_ += static_cast<char>(c);
+}
+
+void JsonStreamParser::UnicodeDigit(unsigned char c) {
+  const int v = HexValue(c);
+  if (v < 0)
+    return Fail();
+  unicode_ = unicode_ * 16 + static_cast<std::uint32_t>(v);
+  if (++unicode_digits_ < 4)
+    return;
+
+  std::uint32_t cp = unicode_;
+  const bool low = cp >= 0xDC00 && cp <= 0xDFFF;
+  if (high_surrogate_ != 0) {
+    if (!low)
+      return Fail();
+    cp = 0x10000 + ((high_surrogate_ - 0xD800) << 10) + (cp - 0xDC00);
+    high_surrogate_ = 0;
+  } else if (cp >= 0xD800 && cp <= 0xDBFF) {
+    high_surrogate_ = cp;
+    state_ = State::kString;
+    return;
+  } else if (low) {
+    return Fail();
+  }
+  AppendUtf8(text_, cp);
+  state_ = State::kString;
+}
+
+bool JsonStreamParser::EndNumber() {
+  bool integral = false;
+  if (!ValidNumber(text_, integral))
+    return false;
+  const char *first = text_.data();
+  const char *last = first + text_.size();
+  long long n = 0;
+  unsigned long long u = 0;
+  if (integral && std::from_chars(first, last, n).ec == std::errc{}) {
+    handler_.Integer(n);
+  } else if (integral && text_[0] != '-' &&
+             std::from_chars(first, last, u).ec == std::errc{}) {
+    handler_.Integer(static_cast<long long>(u));
+  } else {
+    // Like nlohmann::json, reject numbers that overflow a double.
+    if (!std::isfinite(std::strtod(text_.c_str(), nullptr)))
+      return false;
+    handler_.Scalar();
+  }
+  AfterValue();
+  return true;
+}
+
+bool JsonStreamParser::EndLiteral() {
+  if (text_ != "true" && text_ != "false" && text_ != "null")
+    return false;
+  handler_.Scalar();
+  AfterValue();
+  return true;
+}
+
+void JsonStreamParser::EndString() {
+  if (text_is_key_) {
+    handler_.Key(text_);
+    state_ = State::kColon;
+    return;
+  }
+  handler_.String(text_);
+  AfterValue();
+}
+
+void JsonStreamParser::AfterValue() {
+  state_ = in_object_.empty() ? State::kDone : State::kAfterValue;
+}
+
+} // namespace llaudit
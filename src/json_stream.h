@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace llaudit {
+
+// Receives the events of one JSON document in order. String views are
+// unescaped UTF-8 and only valid during the call.
+class JsonHandler {
+ public:
+  virtual ~JsonHandler() = default;
+
+  virtual void StartObject() {}
+  virtual void EndObject() {}
+  virtual void StartArray() {}
+  virtual void EndArray() {}
+  virtual void Key(std::string_view) {}
+  virtual void String(std::string_view) {}
+  // Integers that fit 64 bits; larger unsigned values wrap, as they do when
+  // nlohmann::json converts them to long long.
+  virtual void Integer(long long) {}
+  // Floating-point numbers, booleans and null.
+  virtual void Scalar() {}
+};
+
+// Push parser for a single JSON value: Feed() takes body chunks split at any
+// byte and emits events as soon as they are complete, so a large response
+// never has to be buffered or built into a DOM. It accepts exactly what
+// nlohmann::json::parse accepts (including a leading UTF-8 BOM); after the
+// first error it stops emitting and ok() turns false, and the handler should
+// discard what it has seen.
+class JsonStreamParser {
+ public:
+  explicit JsonStreamParser(JsonHandler& handler) : handler_(handler) {}
+
+  void Feed(std::string_view chunk);
+  // Ends the input; returns true if one complete, valid value was read.
+  bool Finish();
+
+  bool ok() const { return state_ != State::kError; }
+
+ private:
+  enum class State : std::uint8_t {
+    kBom,
+    kValue,
+    kFirstValueOrEnd,
+    kFirstKeyOrEnd,
+    kKey,
+    kColon,
+    kAfterValue,
+    kString,
+    kEscape,
+    kUnicode,
+    kNumber,
+    kLiteral,
+    kDone,
+    kError,
+  };
+
+  void Byte(unsigned char c);
+  void Value(unsigned char c);
+  void StringByte(unsigned char c);
+  void UnicodeDigit(unsigned char c);
+  bool EndNumber();
+  bool EndLiteral();
+  void EndString();
+  void AfterValue();
+  void Fail() { state_ = State::kError; }
+
+  JsonHandler& handler_;
+  State state_ = State::kBom;
+  std::vector<bool> in_object_;  // container stack; false for arrays
+  std::string text_;             // current string, number or literal
+  bool text_is_key_ = false;
+  int bom_seen_ = 0;
+  int utf8_pending_ = 0;  // continuation bytes still expected
+  unsigned char utf8_lo_ = 0x80;
+  unsigned char utf8_hi_ = 0xBF;
+  int unicode_digits_ = 0;
+  std::uint32_t unicode_ = 0;
+  std::uint32_t high_surrogate_ = 0;
+};
+
+}  // namespace llaudit
@@ -0,0 +1,300 @@
+#include "json_writer.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+
+namespace llaudit {
+namespace {
+
+constexpr std::string_view kReplacement = "\xEF\xBF\xBD";
+
+// nlohmann's number layout: fixed notation (with ".0" for whole numbers)
+// while the decimal point falls within (-4, 15] digits, otherwise d.ddde+XX
+// with at least two exponent digits. std::to_chars supplies the shortest
+// round-trip digits.
+void WriteDouble(std::ostream &out, double d) {
+  if (!std::isfinite(d)) {
+    out << "null";
+    return;
+  }
+  if (std::signbit(d)) {
+    out << '-';
+    d = -d;
+  }
+  if (d == 0) {
+    out << "0.0";
+    return;
+  }
+
+  char sci[32];
+  const auto res = std::to_chars(sci, sci + sizeof(sci), d,
+                                 std::chars_format::scientific);
+  const std::string_view text(sci, static_cast<std::size_t>(res.ptr - sci));
+  const std::size_t e = text.find('e');
+  std::string digits(1, text[0]);
+  if (e > 1)
+    digits.append(text.substr(2, e - 2));
+  const int exponent = std::atoi(std::string(text.substr(e + 1)).c_str());
+
+  const int k = static_cast<int>(digits.size());
+  const int n = exponent + 1;
+  if (k <= n && n <= 15) {
+    out << digits << std::string(static_cast<std::size_t>(n - k), '0')
+        << ".0";
+  } else if (0 < n && n <= 15) {
+    out << std::string_view(digits).substr(0, static_cast<std::size_t>(n))
+        << '.' << std::string_view(digits).substr(static_cast<std::size_t>(n));
+  } else if (-4 < n && n <= 0) {
+    out << "0." << std::string(static_cast<std::size_t>(-n), '0') << digits;
+  } else {
+    out << digits[0];
+    if (k > 1)
+      out << '.' << std::string_view(digits).substr(1);
+    const int shown = n - 1;
+    out << 'e' << (shown < 0 ? '-' : '+');
+    const int magnitude = std::abs(shown);
+    if (magnitude < 10)
+      out << '0';
+    out << magnitude;
+  }
+}
+
+} // namespace
+
+void JsonWriter::Newline(std::size_t depth) {
+  out_ << '\n';
+  for (std::size_t i = 0; i < depth * static_cast<std::size_t>(indent_); ++i)
+    out_ << ' ';
+}
+
+void JsonWriter::BeforeValue() {
+  if (after_key_) {
+    after_key_ = false;
+    return;
+  }
+  if (stack_.empty())
+    return;
+  Frame &top = stack_.back();
+  if (!top.empty)
+    out_ << ',';
+  top.empty = false;
+  if (indent_ >= 0)
+    Newline(stack_.size());
+}
+
+void JsonWriter::Close(char bracket) {
+  const bool empty = stack_.back().empty;
+  stack_.pop_back();
+  if (!empty && indent_ >= 0)
+    Newline(stack_.size());
+  out_ << bracket;
+}
+
+void JsonWriter::StartObject() {
+  BeforeValue();
+  out_ << '{';
+  stack_.push_back({true, true});
+}
+
+void JsonWriter::EndObject() { Close('}'); }
+
+void JsonWriter::StartArray() {
+  BeforeValue();
+  out_ << '[';
+  stack_.push_back({false, true});
+}
+
+void JsonWriter::EndArray() { Close(']'); }
+
+void JsonWriter::Key(std::string_view key) {
+  BeforeValue();
+  Quoted(key);
+  out_ << (indent_ >= 0 ? ": " : ":");
+  after_key_ = true;
+}
+
+void JsonWriter::Value(std::string_view s) {
+  BeforeValue();
+  Quoted(s);
+}
+
+void JsonWriter::Value(bool b) {
+  BeforeValue();
+  out_ << (b ? "true" : "false");
+}
+
+void JsonWriter::Value(double d) {
+  BeforeValue();
+  WriteDouble(out_, d);
+}
+
+void JsonWriter::Value(std::nullptr_t) {
+  BeforeValue();
+  out_ << "null";
+}
+
+void JsonWriter::Signed(long long n) {
+  BeforeValue();
+  out_ << n;
+}
+
+void JsonWriter::Unsigned(unsigned long long n) {
+  BeforeValue();
+  out_ << n;
+}
+
+void JsonWriter::Value(const std::vector<std::string> &items) {
+  StartArray();
+  for (const auto &item : items)
+    Value(item);
+  EndArray();
+}
+
+void JsonWriter::Value(const HeaderTable &headers) {
+  StartObject();
+  for (const auto &h : headers)
+    Field(h.name, h.value);
+  EndObject();
+}
+
+void JsonWriter::Value(const nlohmann::json &j) {
+  switch (j.type()) {
+  case nlohmann::json::value_t::object:
+    StartObject();
+    for (const auto &[key, value] : j.items()) {
+      Key(key);
+      Value(value);
+    }
+    EndObject();
+    break;
+  case nlohmann::json::value_t::array:
+    StartArray();
+    for (const auto &value : j)
+      Value(value);
+    EndArray();
+    break;
+  case nlohmann::json::value_t::string:
+    Value(j.get_ref<const std::string &>());
+    break;
+  case nlohmann::json::value_t::boolean:
+    Value(j.get<bool>());
+    break;
+  case nlohmann::json::value_t::number_integer:
+    Signed(j.get<long long>());
+    break;
+  case nlohmann::json::value_t::number_unsigned:
+    Unsigned(j.get<unsigned long long>());
+    break;
+  case nlohmann::json::value_t::number_float:
+    Value(j.get<double>());
+    break;
+  default:
+    // null, and binary values, which JSON text cannot hold.
+    Value(nullptr);
+    break;
+  }
+}
+
+void JsonWriter::Quoted(std::string_view s) {
+  out_ << '"';
+  std::size_t run = 0; // start of the bytes not yet written
+  int pending = 0;     // continuation bytes still expected
+  std::size_t lead = 0;
+  unsigned char lo = 0x80;
+  unsigned char hi = 0xBF;
+
+  const auto flush = [&](std::size_t end) {
+    out_.write(s.data() + run, static_cast<std::streamsize>(end - run));
+  };
+  for (std::size_t i = 0; i < s.size(); ++i) {
+    const auto c = static_cast<unsigned char>(s[i]);
+    if (pending > 0) {
+      if (c >= lo && c <= hi) {
+        lo = 0x80;
+        hi = 0xBF;
+        --pending;
+        continue;
+      }
+      // Broken sequence: replace it and look at this byte again.
+      flush(lead);
+      out_ << kReplacement;
+      run = i;
+      pending = 0;
+      lo = 0x80;
+      hi = 0xBF;
+      --i;
+      continue;
+    }
+
+    const char *escape = nullptr;
+    switch (c) {
+    case '"':
+      escape = "\\\"";
+      break;
+    case '\\':
+      escape = "\\\\";
+      break;
+    case '\b':
+      escape = "\\b";
+      break;
+    case '\f':
+      escape = "\\f";
+      break;
+    case '\n':
+      escape = "\\n";
+      break;
+    case '\r':
+      escape = "\\r";
+      break;
+    case '\t':
+      escape = "\\t";
+      break;
+    default:
+      break;
+    }
+    if (escape != nullptr || c < 0x20) {
+      flush(i);
+      if (escape != nullptr) {
+        out_ << escape;
+      } else {
+        static constexpr char kHex[] = "0123456789abcdef";
+        out_ << "\\u00" << kHex[c >> 4] << kHex[c & 0xF];
+      }
+      run = i + 1;
+      continue;
+    }
+    if (c < 0x80)
+      continue;
+
+    lead = i;
+    if (c >= 0xC2 && c <= 0xDF) {
+      pending = 1;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+      pending = 2;
+      if (c == 0xE0)
+        lo = 0xA0;
+      if (c == 0xED)
+        hi = 0x9F;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+      pending = 3;
+      if (c == 0xF0)
+        lo = 0x90;
+      if (c == 0xF4)
+        hi = 0x8F;
+    } else {
+      flush(i);
+      out_ << kReplacement;
+      run = i + 1;
+    }
+  }
+  if (pending > 0) {
+    flush(lead);
+    out_ << kReplacement;
+  } else {
+    flush(s.size());
+  }
+  out_ << '"';
+}
+
+} // namespace llaudit
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "header_table.h"
+
+namespace llaudit {
+
+// Writes one JSON value to a stream as it is described, without building a
+// DOM. The layout is exactly that of nlohmann::json::dump(indent): indent < 0
+// is compact, otherwise one member per line. Keys are written in the order
+// given, so callers that want dump()'s output emit them sorted. Doubles get
+// the shortest digits that round-trip, which now and then is one digit
+// shorter than dump() writes, and invalid UTF-8 in strings is replaced with
+// U+FFFD where dump() would throw.
+class JsonWriter {
+ public:
+  explicit JsonWriter(std::ostream& out, int indent = 2) : out_(out), indent_(indent) {}
+
+  void StartObject();
+  void EndObject();
+  void StartArray();
+  void EndArray();
+  void Key(std::string_view key);
+
+  void Value(std::string_view s);
+  void Value(const char* s) { Value(std::string_view(s)); }
+  void Value(const std::string& s) { Value(std::string_view(s)); }
+  void Value(bool b);
+  void Value(double d);
+  void Value(std::nullptr_t);
+  template <std::integral T>
+    requires(!std::same_as<T, bool>)
+  void Value(T n) {
+    if constexpr (std::is_signed_v<T>) {
+      Signed(n);
+    } else {
+      Unsigned(n);
+    }
+  }
+  void Value(const std::vector<std::string>& items);
+  void Value(const HeaderTable& headers);
+  void Value(const nlohmann::json& j);
+
+  template <typename T>
+  void Field(std::string_view key, const T& value) {
+    Key(key);
+    Value(value);
+  }
+
+ private:
+  struct Frame {
+    bool object = false;
+    bool empty = true;
+  };
+
+  void BeforeValue();
+  void Close(char bracket);
+  void Newline(std::size_t depth);
+  void Signed(long long n);
+  void Unsigned(unsigned long long n);
+  void Quoted(std::string_view s);
+
+  std::ostream& out_;
+  int indent_;
+  std::vector<Frame> stack_;
+  bool after_key_ = false;
+};
+
+}  // namespace llaudit
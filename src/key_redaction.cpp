@@ -0,0 +1,23 @@
+#include "key_redaction.h"
+
+namespace llaudit {
+
+std::string MaskKey(const std::string &key) {
+  if (key.empty())
+    return key;
+  if (key.size() <= 10)
+    return "****";
+  return key.substr(0, 6) + "..." + key.substr(key.size() - 4);
+}
+
+std::string RedactKey(std::string text, const std::string &key) {
+  if (key.empty())
+    return text;
+  const std::string masked = MaskKey(key);
+  for (std::size_t pos = text.find(key); pos != std::string::npos;
+       pos = text.find(key, pos + masked.size()))
+    text.replace(pos, key.size(), masked);
+  return text;
+}
+
+} // namespace llaudit
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+
+namespace llaudit {
+
+// First 6 and last 4 characters of a key, for reports and the GUI. Keys of
+// 10 characters or fewer would show most of themselves that way and are
+// masked whole.
+std::string MaskKey(const std::string& key);
+
+// text with every occurrence of key replaced by MaskKey(key). Provider error
+// bodies and transport errors may echo a key sent in the query string, so
+// every free-text field goes through this before it is journaled or sent.
+std::string RedactKey(std::string text, const std::string& key);
+
+}  // namespace llaudit
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace llaudit {
+
+// Case-insensitive multi-substring matcher (Aho-Corasick) built at compile
+// time. Patterns are lower-case ASCII letters; Scan() returns a bit mask of
+// every pattern that occurs anywhere in the text, bit i for patterns[i].
+// Scanning is one table lookup per byte and never allocates. Since no pattern
+// contains a non-letter, any other byte simply restarts the automaton.
+template <std::size_t kPatterns, std::size_t kStates>
+class KeywordMatcher {
+ public:
+  static_assert(kPatterns <= 32, "match mask is 32 bits");
+  static_assert(kStates <= 65535, "states are 16 bits");
+  using Mask = std::uint32_t;
+
+  static constexpr bool Valid(const std::array<std::string_view, kPatterns>& patterns) {
+    std::size_t states = 1;
+    for (const auto pattern : patterns) {
+      if (pattern.empty()) return false;
+      for (const char c : pattern) {
+        if (c < 'a' || c > 'z') return false;
+      }
+      states += pattern.size();
+    }
+    return states <= kStates;
+  }
+
+  constexpr explicit KeywordMatcher(const std::array<std::string_view, kPatterns>& patterns) {
+    // Trie; edge 0 means "none" since the root is never a child.
+    std::size_t used = 1;
+    for (std::size_t p = 0; p < kPatterns; ++p) {
+      std::uint16_t state = 0;
+      for (const char c : patterns[p]) {
+        auto& edge = next_[state][static_cast<std::size_t>(c - 'a')];
+        if (edge == 0) edge = static_cast<std::uint16_t>(used++);
+        state = edge;
+      }
+      out_[state] |= Mask{1} << p;
+    }
+
+    // Breadth-first over the trie, turning it into a full DFA: missing edges
+    // take the failure state's edge and outputs inherit the failure state's.
+    std::array<std::uint16_t, kStates> fail{};
+    std::array<std::uint16_t, kStates> queue{};
+    std::size_t head = 0;
+    std::size_t tail = 0;
+    for (const auto child : next_[0]) {
+      if (child != 0) queue[tail++] = child;
+    }
+    while (head < tail) {
+      const std::uint16_t state = queue[head++];
+      out_[state] |= out_[fail[state]];
+      for (std::size_t c = 0; c < 26; ++c) {
+        const std::uint16_t child = next_[state][c];
+        if (child != 0) {
+          fail[child] = next_[fail[state]][c];
+          queue[tail++] = child;
+        } else {
+          next_[state][c] = next_[fail[state]][c];
+        }
+      }
+    }
+  }
+
+  constexpr Mask Scan(std::string_view text) const {
+    Mask found = 0;
+    std::uint16_t state = 0;
+    for (const char ch : text) {
+      const auto lower = static_cast<unsigned char>(static_cast<unsigned char>(ch) | 0x20);
+      if (lower < 'a' || lower > 'z') {
+        state = 0;
+        continue;
+      }
+      state = next_[state][lower - 'a'];
+      found |= out_[state];
+    }
+    return found;
+  }
+
+ private:
+  std::array<std::array<std::uint16_t, 26>, kStates> next_{};
+  std::array<Mask, kStates> out_{};
+};
+
+// Upper bound on the automaton size for a pattern set: one state per
+// pattern character plus the root.
+template <std::size_t kPatterns>
+constexpr std::size_t KeywordStates(const std::array<std::string_view, kPatterns>& patterns) {
+  std::size_t states = 1;
+  for (const auto pattern : patterns) states += pattern.size();
+  return states;
+}
+
+}  // namespace llaudit
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace llaudit {
+
+// Fixed-size log-linear latency histogram in microseconds (HDR-style): each
+// power of two is split into 16 linear sub-buckets, so any recorded value is
+// reported to within ~6%. Memory is constant no matter how many samples are
+// recorded; min, max and the sum are tracked exactly.
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBucketBits = 4;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  static constexpr int kMaxExponent = 40;  // ~12.7 days, far beyond any timeout
+  static constexpr int kBucketCount = kSubBuckets * (kMaxExponent - kSubBucketBits + 2);
+
+  void Record(long long us) {
+    if (us < 0) return;
+    counts_[BucketOf(us)] += 1;
+    if (count_ == 0 || us < min_) min_ = us;
+    if (count_ == 0 || us > max_) max_ = us;
+    count_ += 1;
+    sum_ += us;
+  }
+
+  // n samples of the same value, e.g. when rebuilding from Buckets().
+  void RecordMany(long long us, std::uint64_t n) {
+    if (us < 0 || n == 0) return;
+    counts_[BucketOf(us)] += static_cast<std::uint32_t>(n);
+    if (count_ == 0 || us < min_) min_ = us;
+    if (count_ == 0 || us > max_) max_ = us;
+    count_ += static_cast<long long>(n);
+    sum_ += us * static_cast<long long>(n);
+  }
+
+  void Merge(const LatencyHistogram& other) {
+    if (other.count_ == 0) return;
+    for (int i = 0; i < kBucketCount; ++i) counts_[i] += other.counts_[i];
+    min_ = count_ == 0 ? other.min_ : std::min(min_, other.min_);
+    max_ = count_ == 0 ? other.max_ : std::max(max_, other.max_);
+    count_ += other.count_;
+    sum_ += other.sum_;
+  }
+
+  long long count() const { return count_; }
+  long long min() const { return count_ ? min_ : -1; }
+  long long max() const { return count_ ? max_ : -1; }
+  long long sum() const { return sum_; }
+  long long mean() const { return count_ ? sum_ / count_ : -1; }
+
+  // Value at quantile q in [0, 1]; the bucket midpoint clamped to [min, max].
+  long long Percentile(double q) const {
+    if (count_ == 0) return -1;
+    q = std::clamp(q, 0.0, 1.0);
+    const auto rank = std::max<long long>(1, static_cast<long long>(q * static_cast<double>(count_) + 0.999999));
+    if (rank >= count_) return max_;
+    long long seen = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+      seen += counts_[i];
+      if (seen >= rank) {
+        const long long mid = LowerBound(i) + (Width(i) - 1) / 2;
+        return std::clamp(mid, min_, max_);
+      }
+    }
+    return max_;
+  }
+
+  // Non-empty buckets as (lower bound in us, sample count).
+  std::vector<std::pair<long long, std::uint32_t>> Buckets() const {
+    std::vector<std::pair<long long, std::uint32_t>> out;
+    for (int i = 0; i < kBucketCount; ++i) {
+      if (counts_[i] != 0) out.emplace_back(LowerBound(i), counts_[i]);
+    }
+    return out;
+  }
+
+ private:
+  static int BucketOf(long long us) {
+    const auto v = static_cast<std::uint64_t>(us);
+    if (v < static_cast<std::uint64_t>(kSubBuckets)) return static_cast<int>(v);
+    const int exponent = std::min(static_cast<int>(std::bit_width(v)) - 1, kMaxExponent);
+    const int shift = exponent - kSubBucketBits;
+    const auto sub = static_cast<int>(std::min<std::uint64_t>(v >> shift, 2 * kSubBuckets - 1)) - kSubBuckets;
+    return kSubBuckets * (shift + 1) + sub;
+  }
+
+  static long long LowerBound(int bucket) {
+    if (bucket < kSubBuckets) return bucket;
+    const int shift = bucket / kSubBuckets - 1;
+    const int sub = bucket % kSubBuckets;
+    return static_cast<long long>(kSubBuckets + sub) << shift;
+  }
+
+  static long long Width(int bucket) {
+    if (bucket < kSubBuckets) return 1;
+    return 1LL << (bucket / kSubBuckets - 1);
+  }
+
+  std::array<std::uint32_t, kBucketCount> counts_{};
+  long long count_ = 0;
+  long long sum_ = 0;
+  long long min_ = 0;
+  long long max_ = 0;
+};
+
+}  // namespace llaudit
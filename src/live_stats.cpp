@@ -0,0 +1,169 @@
+#include "live_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace llaudit {
+
+struct LiveStats::Slot {
+  struct Second {
+    std::atomic<std::int64_t> second{-1};
+    std::array<std::atomic<std::uint32_t>, kLatencyBins> bins{};
+  };
+
+  std::string provider;
+  std::atomic<std::int64_t> models_planned{0};
+  std::atomic<std::int64_t> models_probed{0};
+  std::atomic<std::int64_t> in_flight{0};
+  std::atomic<std::int64_t> finished{0};
+  std::atomic<std::int64_t> throttled{0};
+  std::array<Second, kWindowSeconds> window;
+};
+
+namespace {
+
+int BinOf(long long us) {
+  const double octaves = std::log2(1.0 + static_cast<double>(us) / 1000.0);
+  return std::clamp(static_cast<int>(octaves * 4.0), 0,
+                    LiveStats::kLatencyBins - 1);
+}
+
+float BinMs(int bin) {
+  return static_cast<float>(std::exp2((bin + 0.5) / 4.0) - 1.0);
+}
+
+float Quantile(const std::array<std::uint32_t, LiveStats::kLatencyBins> &bins,
+               std::uint64_t total, double q) {
+  const auto rank = std::max<std::uint64_t>(
+      1, static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(total))));
+  std::uint64_t seen = 0;
+  for (int b = 0; b < LiveStats::kLatencyBins; ++b) {
+    seen += bins[b];
+    if (seen >= rank)
+      return BinMs(b);
+  }
+  return BinMs(LiveStats::kLatencyBins - 1);
+}
+
+} // namespace
+
+LiveStats::LiveStats() : start_(std::chrono::steady_clock::now()) {}
+
+LiveStats::~LiveStats() {
+  for (auto &slot : slots_)
+    delete slot.load(std::memory_order_relaxed);
+}
+
+LiveStats::Slot *LiveStats::Find(std::string_view provider) {
+  Slot *fresh = nullptr;
+  for (auto &slot : slots_) {
+    Slot *s = slot.load(std::memory_order_acquire);
+    if (!s) {
+      if (!fresh) {
+        fresh = new Slot;
+        fresh->provider = provider;
+      }
+      if (slot.compare_exchange_strong(s, fresh, std::memory_order_acq_rel,
+                                       std::memory_order_acquire))
+        return fresh;
+    }
+    if (s->provider == provider) {
+      delete fresh;
+      return s;
+    }
+  }
+  delete fresh;
+  return nullptr;
+}
+
+long long LiveStats::NowSeconds() const {
+  return std::chrono::duration_cast<std::chrono::seconds>(
+             std::chrono::steady_clock::now() - start_)
+      .count();
+}
+
+void LiveStats::PlanModels(std::string_view provider, int count) {
+  if (Slot *s = Find(provider))
+    s->models_planned.fetch_add(count, std::memory_order_relaxed);
+}
+
+void LiveStats::ModelProbed(std::string_view provider) {
+  if (Slot *s = Find(provider))
+    s->models_probed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LiveStats::RequestStarted(std::string_view provider) {
+  if (Slot *s = Find(provider))
+    s->in_flight.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LiveStats::RequestFinished(std::string_view provider, int status,
+                                long long latency_us) {
+  Slot *s = Find(provider);
+  if (!s)
+    return;
+  s->in_flight.fetch_sub(1, std::memory_order_relaxed);
+  s->finished.fetch_add(1, std::memory_order_relaxed);
+  if (status == 429)
+    s->throttled.fetch_add(1, std::memory_order_relaxed);
+  if (latency_us < 0)
+    return;
+
+  // The first writer in a new second claims its slot and clears the bins;
+  // a sample racing with the clear may be lost, which a sparkline absorbs.
+  const long long now = NowSeconds();
+  auto &second = s->window[static_cast<std::size_t>(now % kWindowSeconds)];
+  std::int64_t seen = second.second.load(std::memory_order_acquire);
+  if (seen != now) {
+    if (seen > now)
+      return;
+    if (second.second.compare_exchange_strong(seen, now,
+                                              std::memory_order_acq_rel)) {
+      for (auto &bin : second.bins)
+        bin.store(0, std::memory_order_relaxed);
+    }
+  }
+  second.bins[BinOf(latency_us)].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::vector<LiveStats::Provider> LiveStats::Snapshot() const {
+  const auto relaxed = std::memory_order_relaxed;
+  const long long now = NowSeconds();
+  std::vector<Provider> out;
+  for (const auto &slot : slots_) {
+    const Slot *s = slot.load(std::memory_order_acquire);
+    if (!s)
+      break;
+    Provider p;
+    p.provider = s->provider;
+    p.models_planned = s->models_planned.load(relaxed);
+    p.models_probed = s->models_probed.load(relaxed);
+    p.in_flight = std::max<long long>(0, s->in_flight.load(relaxed));
+    p.finished = s->finished.load(relaxed);
+    p.throttled = s->throttled.load(relaxed);
+    for (int i = 0; i < kWindowSeconds; ++i) {
+      p.p50_ms[i] = p.p99_ms[i] = -1.0f;
+      const long long at = now - (kWindowSeconds - 1) + i;
+      if (at < 0)
+        continue;
+      const auto &second =
+          s->window[static_cast<std::size_t>(at % kWindowSeconds)];
+      if (second.second.load(std::memory_order_acquire) != at)
+        continue;
+      std::array<std::uint32_t, kLatencyBins> bins;
+      std::uint64_t total = 0;
+      for (int b = 0; b < kLatencyBins; ++b) {
+        bins[b] = second.bins[b].load(relaxed);
+        total += bins[b];
+      }
+      if (total == 0)
+        continue;
+      p.p50_ms[i] = Quantile(bins, total, 0.50);
+      p.p99_ms[i] = Quantile(bins, total, 0.99);
+    }
+    out.push_back(std::move(p));
+  }
+  return out;
+}
+
+} // namespace llaudit
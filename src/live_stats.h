@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace llaudit {
+
+// Per-provider progress and rolling latency of the audit in flight, for the
+// GUI dashboard. Writers are the audit and transport threads; every update
+// is a few relaxed atomic operations on a fixed slot, and Snapshot() reads
+// them without locking, so the dashboard costs the same however many
+// requests the run has made. A run gets a fresh instance.
+class LiveStats {
+ public:
+  static constexpr int kMaxProviders = 64;
+  // One latency histogram per second for the last kWindowSeconds.
+  static constexpr int kWindowSeconds = 60;
+  // Quarter-octave bins of (1 + latency in ms), up to ~16 minutes.
+  static constexpr int kLatencyBins = 80;
+
+  struct Provider {
+    std::string provider;
+    long long models_planned = 0;
+    long long models_probed = 0;
+    long long in_flight = 0;
+    long long finished = 0;
+    long long throttled = 0;  // 429 responses
+    // Oldest first, one point per second; -1 where nothing finished.
+    std::array<float, kWindowSeconds> p50_ms{};
+    std::array<float, kWindowSeconds> p99_ms{};
+  };
+
+  LiveStats();
+  ~LiveStats();
+
+  LiveStats(const LiveStats&) = delete;
+  LiveStats& operator=(const LiveStats&) = delete;
+
+  void PlanModels(std::string_view provider, int count);
+  void ModelProbed(std::string_view provider);
+  void RequestStarted(std::string_view provider);
+  // latency_us < 0 ends the request without a latency sample.
+  void RequestFinished(std::string_view provider, int status, long long latency_us);
+
+  // Providers in the order they were first seen.
+  std::vector<Provider> Snapshot() const;
+
+ private:
+  struct Slot;
+
+  Slot* Find(std::string_view provider);
+  long long NowSeconds() const;
+
+  const std::chrono::steady_clock::time_point start_;
+  std::array<std::atomic<Slot*>, kMaxProviders> slots_{};
+};
+
+}  // namespace llaudit
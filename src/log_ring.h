@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace llaudit {
+
+// A reader's copy of a LogRing; LogRing::Sync brings it up to date.
+struct LogView {
+  std::deque<std::string> lines;
+  std::uint64_t generation = 0;
+  // Sequence number one past lines.back().
+  std::uint64_t next_seq = 0;
+};
+
+// Bounded log written by audit threads and read by the UI. Writers hold the
+// lock only to move one line into its slot, and every change bumps a
+// generation counter, so a reader that is already current returns from Sync
+// with one atomic load and otherwise copies just the lines appended since
+// its last sync. Past capacity the oldest lines are dropped.
+class LogRing {
+ public:
+  explicit LogRing(std::size_t capacity = 20000)
+      : capacity_(std::max<std::size_t>(capacity, 1)), slots_(capacity_) {}
+
+  LogRing(const LogRing&) = delete;
+  LogRing& operator=(const LogRing&) = delete;
+
+  void Append(std::string line) {
+    std::scoped_lock lock(mutex_);
+    slots_[next_seq_ % capacity_] = std::move(line);
+    ++next_seq_;
+    generation_.fetch_add(1, std::memory_order_release);
+  }
+
+  void Clear() {
+    std::scoped_lock lock(mutex_);
+    first_seq_ = next_seq_;
+    generation_.fetch_add(1, std::memory_order_release);
+  }
+
+  std::uint64_t generation() const { return generation_.load(std::memory_order_acquire); }
+
+  // Returns false, without locking, when the view is already current.
+  bool Sync(LogView& view) const {
+    if (generation() == view.generation) return false;
+
+    std::scoped_lock lock(mutex_);
+    const std::uint64_t oldest =
+        std::max(first_seq_, next_seq_ - std::min<std::uint64_t>(next_seq_, capacity_));
+    const std::uint64_t view_front = view.next_seq - view.lines.size();
+    if (view_front < oldest) {
+      const auto stale = std::min<std::uint64_t>(view.lines.size(), oldest - view_front);
+      view.lines.erase(view.lines.begin(), view.lines.begin() + static_cast<std::ptrdiff_t>(stale));
+    }
+    for (std::uint64_t seq = std::max(view.next_seq, oldest); seq < next_seq_; ++seq) {
+      view.lines.push_back(slots_[seq % capacity_]);
+    }
+    view.next_seq = next_seq_;
+    view.generation = generation_.load(std::memory_order_relaxed);
+    return true;
+  }
+
+ private:
+  const std::size_t capacity_;
+  mutable std::mutex mutex_;
+  std::vector<std::string> slots_;
+  std::uint64_t first_seq_ = 0;  // lines before this were cleared
+  std::uint64_t next_seq_ = 0;
+  std::atomic<std::uint64_t> generation_{0};
+};
+
+}  // namespace llaudit
@@ -2,42 +2,34 @@
 
 #include <algorithm>
 #include <atomic>
-#include <cstdlib>
+#include <cctype>
+#include <cstdint>
 #include <exception>
 #include <filesystem>
-#include <fstream>
-#include <map>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
 
-#include <nlohmann/json.hpp>
-
 #include "audit_engine.h"
+#include "live_stats.h"
+#include "log_ring.h"
 #include "report_writer.h"
+#include "workspace.h"
 
 namespace {
 
-struct KeyField {
-  std::string id;
-  std::string label;
-  std::string value;
-};
-
-struct AppPaths {
-  std::filesystem::path root_dir;
-  std::filesystem::path config_file;
-  std::filesystem::path reports_dir;
-  std::filesystem::path logs_dir;
-};
-
+// The worker's log lines go through their own ring; the fields under mutex
+// change rarely, and whoever changes them bumps generation so the frame loop
+// copies them only when it moved.
 struct SharedState {
+  llaudit::LogRing logs;
+  std::atomic<std::uint64_t> generation{0};
   std::mutex mutex;
-  llaudit::AuditReport last_report;
-  bool has_report = false;
-  std::vector<std::string> logs;
+  // Shared with the exporters instead of copied each frame.
+  std::shared_ptr<const llaudit::AuditReport> last_report;
   std::string summary_text;
   std::string status_text;
   std::string last_json_path;
@@ -45,6 +37,20 @@ struct SharedState {
   std::string last_log_path;
 };
 
+// Nothing animates, so with no input and no new content the frame loop drops
+// to kIdleFps; the next input or change brings it back after one idle frame.
+constexpr int kActiveFps = 60;
+constexpr int kIdleFps = 10;
+constexpr double kIdleAfterSeconds = 1.0;
+// The dashboard samples LiveStats at this period, not every frame.
+constexpr double kLiveRefreshSeconds = 0.25;
+
+void SetStatus(SharedState& shared, std::string text) {
+  std::scoped_lock lock(shared.mutex);
+  shared.status_text = std::move(text);
+  ++shared.generation;
+}
+
 std::string Trim(std::string s) {
   auto not_space = [](unsigned char c) { return !std::isspace(c); };
   s.erase(s.begin(), std::find_if(s.begin(), s.end(), not_space));
@@ -52,77 +58,6 @@ std::string Trim(std::string s) {
   return s;
 }
 
-std::filesystem::path WorkspaceHintPath() {
-  const char* home = std::getenv("HOME");
-  if (home && *home) {
-    return std::filesystem::path(home) / ".api_tester" / "last_workspace.txt";
-  }
-  return std::filesystem::path(".api_tester") / "last_workspace.txt";
-}
-
-bool SaveWorkspaceHint(const std::string& workspace, std::string& error) {
-  try {
-    const auto hint = WorkspaceHintPath();
-    std::filesystem::create_directories(hint.parent_path());
-    std::ofstream ofs(hint, std::ios::out | std::ios::trunc);
-    if (!ofs) {
-      error = "Failed to open workspace hint file for writing.";
-      return false;
-    }
-    ofs << workspace;
-    return true;
-  } catch (const std::exception& ex) {
-    error = ex.what();
-    return false;
-  }
-}
-
-bool LoadWorkspaceHint(std::string& workspace, std::string& error) {
-  try {
-    const auto hint = WorkspaceHintPath();
-    if (!std::filesystem::exists(hint)) return true;
-    std::ifstream ifs(hint);
-    if (!ifs) {
-      error = "Failed to open workspace hint file for reading.";
-      return false;
-    }
-    std::string content;
-    std::getline(ifs, content);
-    workspace = Trim(content);
-    return true;
-  } catch (const std::exception& ex) {
-    error = ex.what();
-    return false;
-  }
-}
-
-AppPaths BuildPaths(const std::string& workspace_input) {
-  AppPaths out;
-  out.root_dir = std::filesystem::absolute(std::filesystem::path(workspace_input));
-  out.config_file = out.root_dir / "config" / "api_keys.json";
-  out.reports_dir = out.root_dir / "reports";
-  out.logs_dir = out.root_dir / "logs";
-  return out;
-}
-
-bool EnsureWorkspace(const AppPaths& paths, std::string& error) {
-  try {
-    std::filesystem::create_directories(paths.root_dir);
-    std::filesystem::create_directories(paths.config_file.parent_path());
-    std::filesystem::create_directories(paths.reports_dir);
-    std::filesystem::create_directories(paths.logs_dir);
-    return true;
-  } catch (const std::exception& ex) {
-    error = ex.what();
-    return false;
-  }
-}
-
-std::string MaskKey(const std::string& k) {
-  if (k.size() <= 10) return k;
-  return k.substr(0, 6) + "..." + k.substr(k.size() - 4);
-}
-
 float ClampF(float v, float lo, float hi) {
   if (v < lo) return lo;
   if (v > hi) return hi;
@@ -143,12 +78,16 @@ void DrawCard(const Rectangle& rect, Color fill, Color border) {
   DrawRectangleRoundedLinesEx(rect, 0.06f, 10, 1.0f, border);
 }
 
-void DrawPanelText(const Rectangle& panel, const std::vector<std::string>& lines, float& scroll,
-                   int font_size = 18, Color color = {220, 220, 220, 255}) {
+// Lines is any random-access container of strings. Only the rows inside the
+// panel are visited, so the cost does not grow with the length of the log.
+template <typename Lines>
+void DrawPanelText(const Rectangle& panel, const Lines& lines, float& scroll, int font_size = 18,
+                   Color color = {220, 220, 220, 255}) {
   const int line_height = font_size + 4;
   const float content_height = static_cast<float>(lines.size() * line_height + 16);
   const float max_scroll = std::max(0.0f, content_height - panel.height);
 
+  scroll = ClampF(scroll, 0.0f, max_scroll);
   if (CheckCollisionPointRec(GetMousePosition(), panel)) {
     const float wheel = GetMouseWheelMove();
     if (wheel != 0.0f) {
@@ -156,14 +95,103 @@ void DrawPanelText(const Rectangle& panel, const std::vector<std::string>& lines
     }
   }
 
+  const auto first = static_cast<std::size_t>(std::max(0.0f, scroll - 8.0f) / line_height);
+  const auto last = std::min(lines.size(), first + static_cast<std::size_t>(panel.height / line_height) + 2);
+
+  BeginScissorMode(static_cast<int>(panel.x), static_cast<int>(panel.y), static_cast<int>(panel.width),
+                   static_cast<int>(panel.height));
+  for (std::size_t i = first; i < last; ++i) {
+    const float y = panel.y + 8.0f - scroll + static_cast<float>(i * line_height);
+    DrawText(lines[i].c_str(), static_cast<int>(panel.x + 8), static_cast<int>(y), font_size, color);
+  }
+  EndScissorMode();
+}
+
+// Values below 0 are gaps in the line; max_value maps to the top of area.
+void DrawSparkline(const Rectangle& area, const float* values, int count, float max_value, Color color) {
+  if (count < 2 || max_value <= 0.0f) return;
+  const float step = area.width / static_cast<float>(count - 1);
+  auto point = [&](int i) {
+    const float v = std::min(values[i], max_value) / max_value;
+    return Vector2{area.x + step * static_cast<float>(i), area.y + area.height * (1.0f - v)};
+  };
+  for (int i = 1; i < count; ++i) {
+    if (values[i - 1] < 0.0f || values[i] < 0.0f) continue;
+    DrawLineEx(point(i - 1), point(i), 1.5f, color);
+  }
+}
+
+// One row per provider from a LiveStats snapshot: probe progress, requests in
+// flight, 429s and p50/p99 sparklines over the last minute. The work per
+// frame depends only on the number of visible rows.
+void DrawDashboard(const Rectangle& panel, const std::vector<llaudit::LiveStats::Provider>& rows,
+                   float& scroll) {
+  if (rows.empty()) {
+    DrawText("Per-provider progress appears here while an audit runs.", static_cast<int>(panel.x + 8),
+             static_cast<int>(panel.y + 8), 17, {150, 172, 192, 255});
+    return;
+  }
+
+  const float row_h = 30.0f;
+  const float content_height = static_cast<float>(rows.size()) * row_h + 16.0f;
+  const float max_scroll = std::max(0.0f, content_height - panel.height);
+  scroll = ClampF(scroll, 0.0f, max_scroll);
+  if (CheckCollisionPointRec(GetMousePosition(), panel)) {
+    scroll = ClampF(scroll - GetMouseWheelMove() * 28.0f, 0.0f, max_scroll);
+  }
+
+  const auto first = static_cast<std::size_t>(std::max(0.0f, scroll - 8.0f) / row_h);
+  const auto last = std::min(rows.size(), first + static_cast<std::size_t>(panel.height / row_h) + 2);
+
+  const Color text = {212, 224, 235, 255};
+  const Color p50_color = {104, 206, 222, 255};
+  const Color p99_color = {255, 170, 102, 255};
+  const float name_w = 150.0f;
+  const float bar_w = 150.0f;
+  const float counts_w = 200.0f;
+  const float spark_x = panel.x + 8 + name_w + bar_w + 12 + counts_w;
+  const float spark_w = std::max(60.0f, panel.x + panel.width - 110.0f - spark_x);
+
   BeginScissorMode(static_cast<int>(panel.x), static_cast<int>(panel.y), static_cast<int>(panel.width),
                    static_cast<int>(panel.height));
-  float y = panel.y + 8.0f - scroll;
-  for (const auto& line : lines) {
-    if (y + line_height > panel.y && y < panel.y + panel.height) {
-      DrawText(line.c_str(), static_cast<int>(panel.x + 8), static_cast<int>(y), font_size, color);
+  for (std::size_t i = first; i < last; ++i) {
+    const auto& row = rows[i];
+    const float y = panel.y + 8.0f - scroll + static_cast<float>(i) * row_h;
+    const int text_y = static_cast<int>(y + 5);
+
+    DrawText(row.provider.c_str(), static_cast<int>(panel.x + 8), text_y, 17, text);
+
+    const Rectangle bar = {panel.x + 8 + name_w, y + 4, bar_w, row_h - 10};
+    DrawRectangleRec(bar, {35, 46, 58, 255});
+    if (row.models_planned > 0) {
+      const float done = std::min(1.0f, static_cast<float>(row.models_probed) / row.models_planned);
+      DrawRectangleRec({bar.x, bar.y, bar.width * done, bar.height}, {57, 120, 132, 255});
+    }
+    const std::string progress = row.models_planned > 0
+                                     ? std::to_string(row.models_probed) + "/" +
+                                           std::to_string(row.models_planned) + " models"
+                                     : "no probes yet";
+    DrawText(progress.c_str(), static_cast<int>(bar.x + 6), static_cast<int>(bar.y + 3), 14, text);
+
+    const std::string counts = "in flight " + std::to_string(row.in_flight) + "   429s " +
+                               std::to_string(row.throttled);
+    DrawText(counts.c_str(), static_cast<int>(bar.x + bar.width + 12), text_y, 16,
+             row.throttled > 0 ? Color{255, 205, 125, 255} : text);
+
+    float max_ms = 1.0f;
+    float last_p99 = -1.0f;
+    for (const float v : row.p99_ms) {
+      max_ms = std::max(max_ms, v);
+      if (v >= 0.0f) last_p99 = v;
+    }
+    const Rectangle spark = {spark_x, y + 3, spark_w, row_h - 8};
+    DrawRectangleLinesEx(spark, 1.0f, {52, 70, 88, 255});
+    DrawSparkline(spark, row.p99_ms.data(), static_cast<int>(row.p99_ms.size()), max_ms, p99_color);
+    DrawSparkline(spark, row.p50_ms.data(), static_cast<int>(row.p50_ms.size()), max_ms, p50_color);
+    if (last_p99 >= 0.0f) {
+      const std::string label = "p99 " + std::to_string(static_cast<long long>(last_p99)) + " ms";
+      DrawText(label.c_str(), static_cast<int>(spark.x + spark.width + 8), text_y, 15, p99_color);
     }
-    y += static_cast<float>(line_height);
   }
   EndScissorMode();
 }
@@ -192,66 +220,30 @@ bool DrawButton(const Rectangle& rect, const std::string& label, bool enabled =
   return click;
 }
 
-bool SaveConfig(const std::vector<KeyField>& fields, const std::filesystem::path& config_file,
-                std::string& error) {
-  try {
-    std::filesystem::create_directories(config_file.parent_path());
-    nlohmann::json j;
-    for (const auto& field : fields) j[field.id] = field.value;
-    std::ofstream ofs(config_file, std::ios::out | std::ios::trunc);
-    if (!ofs) {
-      error = "Failed to open config file for writing.";
-      return false;
-    }
-    ofs << j.dump(2);
-    return true;
-  } catch (const std::exception& ex) {
-    error = ex.what();
-    return false;
-  }
-}
-
-bool LoadConfig(std::vector<KeyField>& fields, const std::filesystem::path& config_file,
-                std::string& error) {
-  try {
-    if (!std::filesystem::exists(config_file)) return true;
-    std::ifstream ifs(config_file);
-    if (!ifs) {
-      error = "Failed to open config file for reading.";
-      return false;
-    }
-    nlohmann::json j = nlohmann::json::parse(ifs, nullptr, false);
-    if (!j.is_object()) {
-      error = "Config file JSON is invalid.";
-      return false;
-    }
-    for (auto& field : fields) {
-      if (j.contains(field.id) && j[field.id].is_string()) field.value = j[field.id].get<std::string>();
-    }
-    return true;
-  } catch (const std::exception& ex) {
-    error = ex.what();
-    return false;
+std::string BuildFieldText(const std::string& value, bool show_keys) {
+  if (show_keys) return value;
+  const auto keys = llaudit::ParseKeyList(value);
+  if (keys.size() <= 1) return llaudit::MaskKey(value);
+  std::string out = "(" + std::to_string(keys.size()) + " keys) ";
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    if (i > 0) out += ", ";
+    out += llaudit::MaskKey(keys[i].key);
+    if (!keys[i].tier.empty()) out += "@" + keys[i].tier;
   }
-}
-
-std::map<std::string, std::string> KeysToMap(const std::vector<KeyField>& fields) {
-  std::map<std::string, std::string> out;
-  for (const auto& field : fields) out[field.id] = field.value;
   return out;
 }
 
-std::string BuildFieldText(const std::string& value, bool show_keys) {
-  return show_keys ? value : MaskKey(value);
-}
-
 void PasteIntoField(std::string& target, std::size_t max_len = 1024) {
   const char* clip = GetClipboardText();
   if (!clip) return;
 
   for (const unsigned char ch : std::string(clip)) {
     if (target.size() >= max_len) break;
-    if (ch == '\n' || ch == '\r' || ch == '\t') continue;
+    // A pasted list of keys, one per line, becomes a comma-separated pool.
+    if (ch == '\n' || ch == '\r' || ch == '\t') {
+      if (!target.empty() && target.back() != ',') target.push_back(',');
+      continue;
+    }
     if (ch >= 32 && ch != 127) {
       target.push_back(static_cast<char>(ch));
     }
@@ -290,42 +282,51 @@ void HandleTextInput(std::string& target, std::size_t max_len = 1024) {
 int main() {
   SetConfigFlags(FLAG_WINDOW_RESIZABLE | FLAG_MSAA_4X_HINT);
   InitWindow(1580, 980, "API-Tester - Cross Platform GUI");
-  SetTargetFPS(60);
-
-  std::vector<KeyField> fields = {
-      {"openrouter", "OpenRouter API Key", ""},
-      {"google_ai_studio", "Google AI Studio API Key", ""},
-      {"mistral", "Mistral API Key", ""},
-      {"vercel", "Vercel API Key", ""},
-      {"groq", "Groq API Key", ""},
-      {"cohere", "Cohere API Key", ""},
-      {"ai21", "AI21 API Key", ""},
-      {"github_chatgpt", "GitHub PAT (chatgpt)", ""},
-      {"github_chatgpt5", "GitHub PAT (chatgpt5)", ""},
-      {"github_deepseek", "GitHub PAT (deepseek)", ""},
-      {"github_jamba", "GitHub PAT (jamba)", ""},
-  };
+  SetTargetFPS(kActiveFps);
+
+  std::vector<llaudit::KeyField> fields = llaudit::DefaultKeyFields();
+
 
   SharedState shared;
   std::atomic<bool> audit_running{false};
   std::atomic<bool> cancel_requested{false};
   std::thread worker;
 
+  // Frame-loop copies of SharedState, refreshed when its generation moves.
+  std::uint64_t seen_generation = ~std::uint64_t{0};
+  llaudit::LogView log_view;
+  std::vector<std::string> summary_lines;
+  std::shared_ptr<const llaudit::AuditReport> report_copy;
+  std::string status_line;
+  std::string last_json;
+  std::string last_txt;
+  std::string last_log;
+  const std::vector<std::string> kNoLogs = {"No logs yet."};
+
+  // Replaced at the start of every run; the worker holds its own reference.
+  std::shared_ptr<llaudit::LiveStats> live;
+  std::vector<llaudit::LiveStats::Provider> live_rows;
+  double live_sampled_at = 0.0;
+  bool live_final = true;
+
+  double last_activity = GetTime();
+  bool idling = false;
+
   float keys_scroll = 0.0f;
   float summary_scroll = 0.0f;
+  float dashboard_scroll = 0.0f;
   float logs_scroll = 0.0f;
   int active_field = -1;
   bool workspace_input_active = false;
   bool show_keys = false;
 
   std::string workspace_input;
-  AppPaths workspace_paths;
+  llaudit::WorkspacePaths workspace_paths;
   bool workspace_ready = false;
 
   std::string workspace_hint_error;
-  if (!LoadWorkspaceHint(workspace_input, workspace_hint_error)) {
-    std::scoped_lock lock(shared.mutex);
-    shared.status_text = "Workspace hint warning: " + workspace_hint_error;
+  if (!llaudit::LoadWorkspaceHint(workspace_input, workspace_hint_error)) {
+    SetStatus(shared, "Workspace hint warning: " + workspace_hint_error);
   }
   if (workspace_input.empty()) {
     workspace_input = std::filesystem::current_path().string();
@@ -335,23 +336,22 @@ int main() {
     std::scoped_lock lock(shared.mutex);
     if (shared.status_text.empty()) {
       shared.status_text = "Set a working directory, then click Apply Workspace.";
+      ++shared.generation;
     }
   }
 
   auto apply_workspace = [&](bool load_keys) {
     const std::string cleaned = Trim(workspace_input);
     if (cleaned.empty()) {
-      std::scoped_lock lock(shared.mutex);
-      shared.status_text = "Workspace path is empty.";
+      SetStatus(shared, "Workspace path is empty.");
       workspace_ready = false;
       return;
     }
 
-    auto candidate = BuildPaths(cleaned);
+    auto candidate = llaudit::BuildPaths(cleaned);
     std::string error;
-    if (!EnsureWorkspace(candidate, error)) {
-      std::scoped_lock lock(shared.mutex);
-      shared.status_text = "Workspace setup failed: " + error;
+    if (!llaudit::EnsureWorkspace(candidate, error)) {
+      SetStatus(shared, "Workspace setup failed: " + error);
       workspace_ready = false;
       return;
     }
@@ -360,19 +360,35 @@ int main() {
     workspace_ready = true;
 
     std::string hint_error;
-    SaveWorkspaceHint(workspace_paths.root_dir.string(), hint_error);
+    llaudit::SaveWorkspaceHint(workspace_paths.root_dir.string(), hint_error);
+
+    // The workspace's provider registry decides which key inputs exist;
+    // values already typed in are kept by id.
+    std::vector<llaudit::ProviderSpec> providers;
+    std::string providers_error;
+    const bool providers_ok = llaudit::LoadWorkspaceProviders(workspace_paths, providers, providers_error);
+    auto next_fields = llaudit::KeyFieldsFor(providers);
+    for (auto& field : next_fields) {
+      const auto it = std::find_if(fields.begin(), fields.end(),
+                                   [&](const llaudit::KeyField& f) { return f.id == field.id; });
+      if (it != fields.end()) field.value = it->value;
+    }
+    fields = std::move(next_fields);
+    active_field = -1;
+    if (!providers_ok) {
+      SetStatus(shared, "Workspace applied, provider registry ignored: " + providers_error);
+      return;
+    }
 
     if (load_keys) {
       std::string load_error;
-      if (!LoadConfig(fields, workspace_paths.config_file, load_error) && !load_error.empty()) {
-        std::scoped_lock lock(shared.mutex);
-        shared.status_text = "Workspace applied, key-load warning: " + load_error;
+      if (!llaudit::LoadConfig(fields, workspace_paths.config_file, load_error) && !load_error.empty()) {
+        SetStatus(shared, "Workspace applied, key-load warning: " + load_error);
         return;
       }
     }
 
-    std::scoped_lock lock(shared.mutex);
-    shared.status_text = "Workspace applied: " + workspace_paths.root_dir.string();
+    SetStatus(shared, "Workspace applied: " + workspace_paths.root_dir.string());
   };
 
   while (!WindowShouldClose()) {
@@ -380,10 +396,40 @@ int main() {
       worker.join();
     }
 
+    bool changed = shared.logs.Sync(log_view);
+    if (const auto generation = shared.generation.load(); generation != seen_generation) {
+      std::scoped_lock lock(shared.mutex);
+      summary_lines = SplitLines(shared.summary_text.empty() ? "No audit run yet." : shared.summary_text);
+      report_copy = shared.last_report;
+      status_line = shared.status_text;
+      last_json = shared.last_json_path;
+      last_txt = shared.last_txt_path;
+      last_log = shared.last_log_path;
+      seen_generation = generation;
+      changed = true;
+    }
+
+    // One more sample after the run ends, then the last minute stays on screen.
+    if (live && !live_final && GetTime() - live_sampled_at >= kLiveRefreshSeconds) {
+      live_final = !audit_running.load();
+      live_rows = live->Snapshot();
+      live_sampled_at = GetTime();
+    }
+
+    const Vector2 mouse_delta = GetMouseDelta();
+    const bool input = mouse_delta.x != 0.0f || mouse_delta.y != 0.0f || GetMouseWheelMove() != 0.0f ||
+                       IsMouseButtonDown(MOUSE_LEFT_BUTTON) || IsMouseButtonDown(MOUSE_RIGHT_BUTTON) ||
+                       IsWindowResized() || workspace_input_active || active_field >= 0;
+    if (changed || input) last_activity = GetTime();
+    if (const bool idle = GetTime() - last_activity > kIdleAfterSeconds; idle != idling) {
+      SetTargetFPS(idle ? kIdleFps : kActiveFps);
+      idling = idle;
+    }
+
     if (workspace_input_active) {
       HandleTextInput(workspace_input, 2048);
     } else if (active_field >= 0 && active_field < static_cast<int>(fields.size())) {
-      HandleTextInput(fields[active_field].value, 1024);
+      HandleTextInput(fields[active_field].value, 16384);
     }
 
     const int sw = GetScreenWidth();
@@ -405,16 +451,18 @@ int main() {
 
     const Rectangle workspace_card = {left_panel.x + 12.0f, left_panel.y + 12.0f, left_panel.width - 24.0f, 142.0f};
     const Rectangle controls_card = {left_panel.x + 12.0f, workspace_card.y + workspace_card.height + 12.0f,
-                                     left_panel.width - 24.0f, 186.0f};
+                                     left_panel.width - 24.0f, 266.0f};
     const Rectangle fields_area = {left_panel.x + 12.0f, controls_card.y + controls_card.height + 42.0f,
                                    left_panel.width - 24.0f,
                                    left_panel.y + left_panel.height - (controls_card.y + controls_card.height + 54.0f)};
 
     const Rectangle summary_panel = {right_panel.x + 12.0f, right_panel.y + 54.0f, right_panel.width - 24.0f,
-                                     right_panel.height * 0.56f};
-    const Rectangle logs_panel = {right_panel.x + 12.0f, summary_panel.y + summary_panel.height + 42.0f,
-                                  right_panel.width - 24.0f,
-                                  right_panel.y + right_panel.height - (summary_panel.y + summary_panel.height + 54.0f)};
+                                     right_panel.height * 0.34f};
+    const Rectangle dashboard_panel = {right_panel.x + 12.0f, summary_panel.y + summary_panel.height + 42.0f,
+                                       right_panel.width - 24.0f, right_panel.height * 0.24f};
+    const Rectangle logs_panel = {
+        right_panel.x + 12.0f, dashboard_panel.y + dashboard_panel.height + 42.0f, right_panel.width - 24.0f,
+        right_panel.y + right_panel.height - (dashboard_panel.y + dashboard_panel.height + 54.0f)};
 
     BeginDrawing();
 
@@ -485,72 +533,88 @@ int main() {
 
     if (DrawButton({c_x1, c_y0, c_btn_w, c_btn_h}, "Load Keys", workspace_ready && !audit_running.load())) {
       std::string error;
-      if (LoadConfig(fields, workspace_paths.config_file, error)) {
-        std::scoped_lock lock(shared.mutex);
-        shared.status_text = "Loaded API keys from " + workspace_paths.config_file.string();
+      if (llaudit::LoadConfig(fields, workspace_paths.config_file, error)) {
+        SetStatus(shared, "Loaded API keys from " + workspace_paths.config_file.string());
       } else {
-        std::scoped_lock lock(shared.mutex);
-        shared.status_text = "Load failed: " + error;
+        SetStatus(shared, "Load failed: " + error);
       }
     }
 
     if (DrawButton({c_x2, c_y0, c_btn_w, c_btn_h}, "Save Keys", workspace_ready && !audit_running.load())) {
       std::string error;
-      if (SaveConfig(fields, workspace_paths.config_file, error)) {
-        std::scoped_lock lock(shared.mutex);
-        shared.status_text = "Saved API keys to " + workspace_paths.config_file.string();
+      if (llaudit::SaveConfig(fields, workspace_paths.config_file, error)) {
+        SetStatus(shared, "Saved API keys to " + workspace_paths.config_file.string());
       } else {
-        std::scoped_lock lock(shared.mutex);
-        shared.status_text = "Save failed: " + error;
+        SetStatus(shared, "Save failed: " + error);
       }
     }
 
-    if (DrawButton({c_x1, c_y0 + 40, c_btn_w, c_btn_h}, "Run Full Audit",
-                   workspace_ready && !audit_running.load())) {
+    const bool can_start = workspace_ready && !audit_running.load();
+    const bool run_full = DrawButton({c_x1, c_y0 + 40, c_btn_w, c_btn_h}, "Run Full Audit", can_start);
+    // Reuses checkpoints of keys that passed within the TTL; the rest are probed again.
+    const bool run_resume =
+        DrawButton({c_x1, c_y0 + 80, c_btn_w * 2 + c_gap, c_btn_h}, "Re-audit Failed / Stale Only", can_start);
+    if (run_full || run_resume) {
+      const bool resume = run_resume;
       cancel_requested.store(false);
       audit_running.store(true);
       active_field = -1;
       workspace_input_active = false;
 
+      shared.logs.Clear();
       {
         std::scoped_lock lock(shared.mutex);
-        shared.logs.clear();
         shared.summary_text.clear();
-        shared.status_text = "Audit started...";
+        shared.status_text = resume ? "Re-audit started (reusing fresh results)..." : "Audit started...";
+        ++shared.generation;
       }
 
-      const auto keys_map = KeysToMap(fields);
-      const AppPaths paths_copy = workspace_paths;
-      worker = std::thread([&shared, &audit_running, &cancel_requested, keys_map, paths_copy]() {
+      live = std::make_shared<llaudit::LiveStats>();
+      live_rows.clear();
+      live_final = false;
+
+      const auto keys_map = llaudit::KeysToPools(fields);
+      const llaudit::WorkspacePaths paths_copy = workspace_paths;
+      worker = std::thread([&shared, &audit_running, &cancel_requested, keys_map, paths_copy, resume, live]() {
         try {
-          llaudit::AuditEngine engine;
-          auto report = engine.Run(
-              keys_map,
-              [&shared](const std::string& line) {
-                std::scoped_lock lock(shared.mutex);
-                shared.logs.push_back(line);
-              },
+          llaudit::WorkspaceRunOptions run_options;
+          run_options.resume = resume;
+          run_options.live = live.get();
+          const auto run = llaudit::RunWorkspaceAudit(
+              paths_copy, keys_map, run_options,
+              [&shared](const std::string& line) { shared.logs.Append(line); },
               cancel_requested);
 
-          const auto run_log_path = llaudit::WriteRunLog(report, paths_copy.logs_dir);
-
           {
             std::scoped_lock lock(shared.mutex);
-            shared.last_report = report;
-            shared.has_report = true;
-            shared.summary_text = llaudit::BuildSummaryText(report);
-            shared.last_log_path = run_log_path;
+            shared.last_report = run.report;
+            shared.summary_text = llaudit::BuildSummaryText(*run.report);
+            if (!run.history_delta.empty()) {
+              shared.summary_text += "\n" + run.history_delta;
+            }
+            shared.last_log_path = run.run_log_path;
             shared.status_text = cancel_requested.load() ? "Audit canceled." : "Audit completed.";
-            if (!run_log_path.empty()) {
-              shared.status_text += " Run log: " + run_log_path;
+            if (!run.run_log_path.empty()) {
+              shared.status_text += " Run log: " + run.run_log_path;
+            }
+            if (!run.providers_error.empty()) {
+              shared.status_text += " Provider registry ignored: " + run.providers_error;
+            }
+            if (!run.suites_error.empty()) {
+              shared.status_text += " Prompt suites ignored: " + run.suites_error;
             }
+            if (!run.journal_error.empty()) {
+              shared.status_text += " Journal failed: " + run.journal_error;
+            }
+            if (!run.history_error.empty()) {
+              shared.status_text += " History failed: " + run.history_error;
+            }
+            ++shared.generation;
           }
         } catch (const std::exception& ex) {
-          std::scoped_lock lock(shared.mutex);
-          shared.status_text = std::string("Audit failed: ") + ex.what();
+          SetStatus(shared, std::string("Audit failed: ") + ex.what());
         } catch (...) {
-          std::scoped_lock lock(shared.mutex);
-          shared.status_text = "Audit failed: unknown error.";
+          SetStatus(shared, "Audit failed: unknown error.");
         }
         audit_running.store(false);
       });
@@ -558,20 +622,13 @@ int main() {
 
     if (DrawButton({c_x2, c_y0 + 40, c_btn_w, c_btn_h}, "Stop", audit_running.load())) {
       cancel_requested.store(true);
-      std::scoped_lock lock(shared.mutex);
-      shared.status_text = "Cancellation requested...";
+      SetStatus(shared, "Cancellation requested...");
     }
 
-    bool has_report = false;
-    llaudit::AuditReport report_copy;
-    {
-      std::scoped_lock lock(shared.mutex);
-      has_report = shared.has_report;
-      if (has_report) report_copy = shared.last_report;
-    }
+    const bool has_report = report_copy != nullptr;
 
-    if (DrawButton({c_x1, c_y0 + 80, c_btn_w, c_btn_h}, "Export JSON", workspace_ready && has_report)) {
-      const auto path = llaudit::WriteJsonReport(report_copy, workspace_paths.reports_dir);
+    if (DrawButton({c_x1, c_y0 + 120, c_btn_w, c_btn_h}, "Export JSON", workspace_ready && has_report)) {
+      const auto path = llaudit::WriteJsonReport(*report_copy, workspace_paths.reports_dir);
       std::scoped_lock lock(shared.mutex);
       shared.last_json_path = path;
       if (!path.empty()) {
@@ -579,10 +636,11 @@ int main() {
       } else {
         shared.status_text = "Failed to export JSON report.";
       }
+      ++shared.generation;
     }
 
-    if (DrawButton({c_x2, c_y0 + 80, c_btn_w, c_btn_h}, "Export TXT", workspace_ready && has_report)) {
-      const auto path = llaudit::WriteTextReport(report_copy, workspace_paths.reports_dir);
+    if (DrawButton({c_x2, c_y0 + 120, c_btn_w, c_btn_h}, "Export TXT", workspace_ready && has_report)) {
+      const auto path = llaudit::WriteTextReport(*report_copy, workspace_paths.reports_dir);
       std::scoped_lock lock(shared.mutex);
       shared.last_txt_path = path;
       if (!path.empty()) {
@@ -590,16 +648,32 @@ int main() {
       } else {
         shared.status_text = "Failed to export TXT report.";
       }
+      ++shared.generation;
+    }
+
+    if (DrawButton({c_x1, c_y0 + 160, c_btn_w * 2 + c_gap, c_btn_h}, "Export All (JSON + TXT + LOG)",
+                   workspace_ready && has_report)) {
+      const auto paths =
+          llaudit::WriteReports(*report_copy, workspace_paths.reports_dir, workspace_paths.logs_dir);
+      std::scoped_lock lock(shared.mutex);
+      shared.last_json_path = paths.json;
+      shared.last_txt_path = paths.text;
+      shared.last_log_path = paths.run_log;
+      if (!paths.json.empty() && !paths.text.empty() && !paths.run_log.empty()) {
+        shared.status_text = "Reports exported to " + workspace_paths.reports_dir.string();
+      } else {
+        shared.status_text = "Failed to export some reports.";
+      }
+      ++shared.generation;
     }
 
-    if (DrawButton({c_x1, c_y0 + 120, c_btn_w, c_btn_h}, show_keys ? "Hide Keys" : "Show Keys")) {
+    if (DrawButton({c_x1, c_y0 + 200, c_btn_w, c_btn_h}, show_keys ? "Hide Keys" : "Show Keys")) {
       show_keys = !show_keys;
     }
 
-    if (DrawButton({c_x2, c_y0 + 120, c_btn_w, c_btn_h}, "Clear Logs")) {
-      std::scoped_lock lock(shared.mutex);
-      shared.logs.clear();
-      shared.status_text = "Logs cleared.";
+    if (DrawButton({c_x2, c_y0 + 200, c_btn_w, c_btn_h}, "Clear Logs")) {
+      shared.logs.Clear();
+      SetStatus(shared, "Logs cleared.");
     }
 
     DrawText("API Key Inputs", static_cast<int>(left_panel.x + 16), static_cast<int>(fields_area.y - 28), 21,
@@ -665,30 +739,25 @@ int main() {
              {231, 244, 251, 255});
     DrawCard(summary_panel, {20, 27, 37, 245}, {68, 100, 133, 255});
 
-    DrawText("Live Logs", static_cast<int>(logs_panel.x), static_cast<int>(summary_panel.y + summary_panel.height + 8),
-             24, {231, 244, 251, 255});
-    DrawCard(logs_panel, {20, 27, 37, 245}, {68, 100, 133, 255});
-
-    std::vector<std::string> summary_lines;
-    std::vector<std::string> log_lines;
-    std::string status_line;
-    std::string last_json;
-    std::string last_txt;
-    std::string last_log;
+    DrawText("Live Dashboard", static_cast<int>(dashboard_panel.x),
+             static_cast<int>(summary_panel.y + summary_panel.height + 8), 24, {231, 244, 251, 255});
+    DrawText("p50", static_cast<int>(dashboard_panel.x + dashboard_panel.width - 110),
+             static_cast<int>(summary_panel.y + summary_panel.height + 14), 16, {104, 206, 222, 255});
+    DrawText("p99  last 60 s", static_cast<int>(dashboard_panel.x + dashboard_panel.width - 78),
+             static_cast<int>(summary_panel.y + summary_panel.height + 14), 16, {255, 170, 102, 255});
+    DrawCard(dashboard_panel, {20, 27, 37, 245}, {68, 100, 133, 255});
 
-    {
-      std::scoped_lock lock(shared.mutex);
-      summary_lines = SplitLines(shared.summary_text.empty() ? "No audit run yet." : shared.summary_text);
-      log_lines = shared.logs;
-      if (log_lines.empty()) log_lines.push_back("No logs yet.");
-      status_line = shared.status_text;
-      last_json = shared.last_json_path;
-      last_txt = shared.last_txt_path;
-      last_log = shared.last_log_path;
-    }
+    DrawText("Live Logs", static_cast<int>(logs_panel.x),
+             static_cast<int>(dashboard_panel.y + dashboard_panel.height + 8), 24, {231, 244, 251, 255});
+    DrawCard(logs_panel, {20, 27, 37, 245}, {68, 100, 133, 255});
 
     DrawPanelText(summary_panel, summary_lines, summary_scroll, 18, {219, 229, 237, 255});
-    DrawPanelText(logs_panel, log_lines, logs_scroll, 17, {212, 224, 235, 255});
+    DrawDashboard(dashboard_panel, live_rows, dashboard_scroll);
+    if (log_view.lines.empty()) {
+      DrawPanelText(logs_panel, kNoLogs, logs_scroll, 17, {212, 224, 235, 255});
+    } else {
+      DrawPanelText(logs_panel, log_view.lines, logs_scroll, 17, {212, 224, 235, 255});
+    }
 
     const std::string run_state = audit_running.load() ? "RUNNING" : "IDLE";
     DrawText(("State: " + run_state).c_str(), static_cast<int>(left_panel.x + 16),
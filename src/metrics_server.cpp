@@ -0,0 +1,28 @@
+#include "metrics_server.h"
+
+namespace llaudit {
+namespace {
+
+// Scrapes send no body; a request with a larger one is refused unread.
+constexpr std::size_t kMaxBodyBytes = 8 * 1024;
+
+} // namespace
+
+MetricsServer::MetricsServer(const AuditMetrics &metrics)
+    : metrics_(metrics),
+      server_([this](const ServerRequest &r) { return Handle(r); },
+              kMaxBodyBytes) {}
+
+ServerReply MetricsServer::Handle(const ServerRequest &request) const {
+  if (request.method != "GET" && request.method != "HEAD")
+    return {"405 Method Not Allowed", "text/plain", ""};
+  if (request.path == "/metrics")
+    return {"200 OK", "text/plain; version=0.0.4; charset=utf-8",
+            metrics_.Render()};
+  if (request.path == "/")
+    return {"200 OK", "text/plain",
+            "llaudit metrics exporter; scrape /metrics\n"};
+  return {"404 Not Found", "text/plain", "not found\n"};
+}
+
+} // namespace llaudit
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+
+#include "audit_metrics.h"
+#include "http_server.h"
+
+namespace llaudit {
+
+// Serves AuditMetrics::Render() at GET /metrics for Prometheus to scrape,
+// on an HttpServer; answering one request at a time is plenty for a scrape
+// every few seconds.
+class MetricsServer {
+ public:
+  explicit MetricsServer(const AuditMetrics& metrics);
+
+  MetricsServer(const MetricsServer&) = delete;
+  MetricsServer& operator=(const MetricsServer&) = delete;
+
+  // Listens on an IPv4 address; port 0 picks a free port.
+  bool Start(const std::string& bind_address, int port, std::string& error) {
+    return server_.Start(bind_address, port, error);
+  }
+  void Stop() { server_.Stop(); }
+
+  int port() const { return server_.port(); }
+
+ private:
+  ServerReply Handle(const ServerRequest& request) const;
+
+  const AuditMetrics& metrics_;
+  HttpServer server_;
+};
+
+}  // namespace llaudit
@@ -0,0 +1,65 @@
+#include "model_index.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace llaudit {
+namespace {
+
+std::string ToLower(std::string_view s) {
+  std::string out(s);
+  for (auto &c : out)
+    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  return out;
+}
+
+} // namespace
+
+ModelIndex::ModelIndex(const std::vector<std::string> &model_ids) {
+  std::size_t bytes = 0;
+  for (const auto &id : model_ids)
+    bytes += id.size() + 1;
+  lower_.reserve(bytes);
+  offsets_.reserve(model_ids.size());
+
+  for (const auto &id : model_ids) {
+    if (models_.Intern(id) < offsets_.size())
+      continue;
+    offsets_.push_back(static_cast<std::uint32_t>(lower_.size()));
+    for (const char c : id)
+      lower_ += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    lower_ += '\0';
+  }
+}
+
+std::string_view ModelIndex::Lower(Id id) const {
+  return std::string_view(lower_.data() + offsets_[id],
+                          models_.Get(id).size());
+}
+
+std::vector<ModelIndex::Id>
+ModelIndex::Containing(std::string_view needle) const {
+  std::vector<Id> out;
+  if (needle.empty()) {
+    out.resize(size());
+    for (Id i = 0; i < out.size(); ++i)
+      out[i] = i;
+    return out;
+  }
+  const std::string lower = ToLower(needle);
+  std::size_t from = 0;
+  while (true) {
+    const std::size_t at = lower_.find(lower, from);
+    if (at == std::string::npos)
+      break;
+    // The NUL after every id keeps a match from spanning two of them.
+    const auto next = std::upper_bound(offsets_.begin(), offsets_.end(), at);
+    out.push_back(static_cast<Id>(next - offsets_.begin() - 1));
+    if (next == offsets_.end())
+      break;
+    from = *next;
+  }
+  return out;
+}
+
+} // namespace llaudit
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "string_interner.h"
+
+namespace llaudit {
+
+// A provider's model ids, interned once, with their lower-cased spellings laid
+// end to end in one buffer so that a case-insensitive lookup is a scan of that
+// buffer rather than a lower-cased copy of every id. Ids are numbered in
+// catalog order (the first spelling of a repeated id wins), and lookups return
+// them in that order. Read-only after construction, so keys that share a
+// catalog can share one index across threads.
+class ModelIndex {
+ public:
+  using Id = StringInterner::Id;
+
+  ModelIndex() = default;
+  explicit ModelIndex(const std::vector<std::string>& model_ids);
+
+  std::size_t size() const { return models_.size(); }
+  bool empty() const { return models_.size() == 0; }
+  const std::string& Get(Id id) const { return models_.Get(id); }
+  std::string_view Lower(Id id) const;
+
+  // Ids whose spelling contains needle, ignoring case; every id for an empty
+  // needle.
+  std::vector<Id> Containing(std::string_view needle) const;
+
+ private:
+  StringInterner models_;
+  // Every lower-cased id followed by a NUL; id i starts at offsets_[i].
+  std::string lower_;
+  std::vector<std::uint32_t> offsets_;
+};
+
+}  // namespace llaudit
@@ -0,0 +1,313 @@
+#include "prompt_suite.h"
+
+#include "fnv1a.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <exception>
+#include <fstream>
+#include <system_error>
+
+#include <nlohmann/json.hpp>
+
+namespace llaudit {
+namespace {
+
+using nlohmann::json;
+
+std::string Lower(std::string_view s) {
+  std::string out(s);
+  std::transform(out.begin(), out.end(), out.begin(), [](unsigned char c) {
+    return static_cast<char>(std::tolower(c));
+  });
+  return out;
+}
+
+bool Same(std::string_view a, std::string_view b, bool ignore_case) {
+  return ignore_case ? Lower(a) == Lower(b) : a == b;
+}
+
+// The span from the first '{' to the last '}', which skips the prose and
+// code fences models put around a JSON answer.
+json FirstObject(std::string_view answer) {
+  const auto open = answer.find('{');
+  const auto close = answer.rfind('}');
+  if (open == std::string_view::npos || close == std::string_view::npos ||
+      close < open)
+    return json();
+  const auto j = json::parse(answer.substr(open, close - open + 1), nullptr,
+                             false);
+  return j.is_discarded() ? json() : j;
+}
+
+const json *AtPath(const json &root, const std::string &path) {
+  const json *node = &root;
+  std::size_t start = 0;
+  while (node && start <= path.size()) {
+    const auto dot = std::min(path.find('.', start), path.size());
+    const std::string part = path.substr(start, dot - start);
+    if (node->is_object()) {
+      const auto it = node->find(part);
+      node = it != node->end() ? &*it : nullptr;
+    } else if (node->is_array() && !part.empty() &&
+               std::all_of(part.begin(), part.end(), [](unsigned char c) {
+                 return std::isdigit(c);
+               })) {
+      // An index too large for size_t is past the end of any array.
+      std::size_t index = 0;
+      const bool parsed =
+          std::from_chars(part.data(), part.data() + part.size(), index).ec ==
+          std::errc();
+      node = parsed && index < node->size() ? &(*node)[index] : nullptr;
+    } else {
+      node = nullptr;
+    }
+    start = dot + 1;
+  }
+  return node;
+}
+
+bool Matches(const PromptCase &c, std::size_t i, std::string_view answer,
+             const json *field) {
+  const std::string &want = c.expect[i];
+  switch (c.rule) {
+  case ScoreRule::kSubstring:
+    return c.ignore_case ? Lower(answer).find(Lower(want)) != std::string::npos
+                         : answer.find(want) != std::string_view::npos;
+  case ScoreRule::kRegex:
+    return c.patterns && i < c.patterns->size() &&
+           std::regex_search(answer.begin(), answer.end(), (*c.patterns)[i]);
+  case ScoreRule::kJsonField:
+    if (!field)
+      return false;
+    return field->is_string()
+               ? Same(field->get_ref<const std::string &>(), want,
+                      c.ignore_case)
+               : Same(field->dump(), want, c.ignore_case);
+  }
+  return false;
+}
+
+bool ReadCase(const json &entry, PromptCase &c, std::string &error) {
+  if (!entry.is_object()) {
+    error = "a case must be an object";
+    return false;
+  }
+  if (entry.contains("id") && entry["id"].is_string())
+    c.id = entry["id"].get<std::string>();
+  if (!entry.contains("prompt") || !entry["prompt"].is_string() ||
+      entry["prompt"].get<std::string>().empty()) {
+    error = "needs a string \"prompt\"";
+    return false;
+  }
+  c.prompt = entry["prompt"].get<std::string>();
+
+  if (entry.contains("rule") && !entry["rule"].is_string()) {
+    error = "rule must be a string";
+    return false;
+  }
+  const std::string rule = entry.value("rule", std::string("substring"));
+  if (rule == "substring")
+    c.rule = ScoreRule::kSubstring;
+  else if (rule == "regex")
+    c.rule = ScoreRule::kRegex;
+  else if (rule == "json_field")
+    c.rule = ScoreRule::kJsonField;
+  else {
+    error = "unknown rule \"" + rule + "\" (substring, regex or json_field)";
+    return false;
+  }
+
+  if (entry.contains("expect")) {
+    const auto &e = entry["expect"];
+    if (e.is_string()) {
+      c.expect = {e.get<std::string>()};
+    } else if (e.is_array() &&
+               std::all_of(e.begin(), e.end(),
+                           [](const json &v) { return v.is_string(); })) {
+      c.expect = e.get<std::vector<std::string>>();
+    } else {
+      error = "expect must be a string or an array of strings";
+      return false;
+    }
+  }
+  if (c.expect.empty()) {
+    error = "needs at least one \"expect\" value";
+    return false;
+  }
+  if (c.rule == ScoreRule::kJsonField) {
+    if (entry.contains("field") && entry["field"].is_string())
+      c.field = entry["field"].get<std::string>();
+    if (c.field.empty()) {
+      error = "a json_field rule needs a string \"field\"";
+      return false;
+    }
+  }
+
+  try {
+    c.match_all = entry.value("match", std::string("any")) == "all";
+    c.ignore_case = entry.value("ignore_case", c.ignore_case);
+    c.points = entry.value("points", c.points);
+    c.max_tokens = entry.value("max_tokens", c.max_tokens);
+  } catch (const std::exception &) {
+    error = "match must be a string, ignore_case a boolean, points and "
+            "max_tokens integers";
+    return false;
+  }
+  if (c.points < 0 || c.max_tokens <= 0) {
+    error = "points must be >= 0 and max_tokens > 0";
+    return false;
+  }
+
+  if (c.rule == ScoreRule::kRegex) {
+    auto flags = std::regex::ECMAScript;
+    if (c.ignore_case)
+      flags |= std::regex::icase;
+    auto patterns = std::make_shared<std::vector<std::regex>>();
+    for (const auto &pattern : c.expect) {
+      try {
+        patterns->emplace_back(pattern, flags);
+      } catch (const std::regex_error &ex) {
+        error = "bad pattern \"" + pattern + "\": " + ex.what();
+        return false;
+      }
+    }
+    c.patterns = std::move(patterns);
+  }
+  return true;
+}
+
+} // namespace
+
+bool LoadPromptSuite(const std::filesystem::path &file, PromptSuite &suite,
+                     std::string &error) {
+  std::ifstream ifs(file);
+  if (!ifs) {
+    error = "Failed to open " + file.string() + " for reading.";
+    return false;
+  }
+  PromptSuite out;
+  out.name = file.stem().string();
+  const std::string where = file.filename().string();
+
+  // Cases are read from a list of JSON values, each with the file defaults
+  // applied first.
+  json defaults = json::object();
+  std::vector<json> entries;
+  if (file.extension() == ".jsonl") {
+    std::string line;
+    std::size_t number = 0;
+    while (std::getline(ifs, line)) {
+      ++number;
+      if (std::all_of(line.begin(), line.end(),
+                      [](unsigned char c) { return std::isspace(c); }))
+        continue;
+      auto j = json::parse(line, nullptr, false);
+      if (j.is_discarded()) {
+        error = where + " line " + std::to_string(number) + ": invalid JSON";
+        return false;
+      }
+      entries.push_back(std::move(j));
+    }
+  } else {
+    auto j = json::parse(ifs, nullptr, false);
+    if (!j.is_object() || !j.contains("cases") || !j["cases"].is_array()) {
+      error = where + ": expected {\"name\": ..., \"cases\": [...]}";
+      return false;
+    }
+    if (j.contains("name") && j["name"].is_string() &&
+        !j["name"].get<std::string>().empty())
+      out.name = j["name"].get<std::string>();
+    for (const char *key : {"max_tokens", "ignore_case", "points"}) {
+      if (j.contains(key))
+        defaults[key] = j[key];
+    }
+    for (auto &entry : j["cases"])
+      entries.push_back(std::move(entry));
+  }
+
+  for (std::size_t i = 0; i < entries.size(); ++i) {
+    json entry = entries[i];
+    if (entry.is_object()) {
+      for (const auto &[key, value] : defaults.items()) {
+        if (!entry.contains(key))
+          entry[key] = value;
+      }
+    }
+    PromptCase c;
+    std::string case_error;
+    if (!ReadCase(entry, c, case_error)) {
+      error = where + " case " + std::to_string(i + 1) + ": " + case_error;
+      return false;
+    }
+    if (c.id.empty())
+      c.id = std::to_string(i + 1);
+    out.cases.push_back(std::move(c));
+  }
+  if (out.cases.empty()) {
+    error = where + ": no cases";
+    return false;
+  }
+  suite = std::move(out);
+  return true;
+}
+
+bool LoadPromptSuites(const std::filesystem::path &dir,
+                      std::vector<PromptSuite> &suites, std::string &error) {
+  suites.clear();
+  std::error_code ec;
+  if (!std::filesystem::is_directory(dir, ec))
+    return true;
+
+  // The iterator steps with increment(ec), since operator++ throws; an entry
+  // whose type cannot be read (a dangling link) is skipped, not an error.
+  std::vector<std::filesystem::path> files;
+  std::filesystem::directory_iterator it(dir, ec);
+  for (; !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+    const auto ext = it->path().extension();
+    std::error_code entry_ec;
+    if (it->is_regular_file(entry_ec) && (ext == ".json" || ext == ".jsonl"))
+      files.push_back(it->path());
+  }
+  if (ec) {
+    error = dir.string() + ": " + ec.message();
+    return false;
+  }
+  std::sort(files.begin(), files.end());
+
+  std::vector<PromptSuite> out;
+  for (const auto &file : files) {
+    PromptSuite suite;
+    if (!LoadPromptSuite(file, suite, error))
+      return false;
+    out.push_back(std::move(suite));
+  }
+  suites = std::move(out);
+  return true;
+}
+
+int ScoreAnswer(const PromptCase &c, std::string_view answer) {
+  json parsed;
+  const json *field = nullptr;
+  if (c.rule == ScoreRule::kJsonField) {
+    parsed = FirstObject(answer);
+    field = AtPath(parsed, c.field);
+  }
+  std::size_t matched = 0;
+  for (std::size_t i = 0; i < c.expect.size(); ++i) {
+    if (Matches(c, i, answer, field))
+      ++matched;
+    else if (c.match_all)
+      return 0;
+    if (matched > 0 && !c.match_all)
+      break;
+  }
+  return matched > 0 ? c.points : 0;
+}
+
+std::uint64_t HashText(std::string_view text) {
+  return Fnv1a64(text);
+}
+
+} // namespace llaudit
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace llaudit {
+
+enum class ScoreRule {
+  kSubstring,  // the answer contains the expected text
+  kRegex,      // the expected ECMAScript pattern matches somewhere in the answer
+  kJsonField,  // the first JSON object in the answer has the expected value at `field`
+};
+
+// One prompt of a suite and how its answer is scored.
+struct PromptCase {
+  std::string id;
+  std::string prompt;
+  ScoreRule rule = ScoreRule::kSubstring;
+  // Accepted answers; one match earns the points unless match_all is set.
+  std::vector<std::string> expect;
+  // kJsonField only: a dotted path such as "action.target_id"; array
+  // elements are addressed by index.
+  std::string field;
+  bool match_all = false;
+  bool ignore_case = true;
+  int points = 1;
+  int max_tokens = 300;
+  // kRegex only: expect compiled once, shared by copies of the case.
+  std::shared_ptr<const std::vector<std::regex>> patterns;
+};
+
+struct PromptSuite {
+  std::string name;
+  std::vector<PromptCase> cases;
+};
+
+// Reads a suite from a .json file ({"name": ..., "cases": [...]}, where
+// "max_tokens", "ignore_case" and "points" at the top apply to every case
+// that does not set them) or a .jsonl file with one case per line, named
+// after the file.
+bool LoadPromptSuite(const std::filesystem::path& file, PromptSuite& suite, std::string& error);
+
+// Every *.json and *.jsonl file in dir, in file name order. A missing
+// directory is no suites, not an error; a bad file fails the whole load.
+bool LoadPromptSuites(const std::filesystem::path& dir, std::vector<PromptSuite>& suites,
+                      std::string& error);
+
+// The case's points when the answer passes its rule, otherwise 0.
+int ScoreAnswer(const PromptCase& c, std::string_view answer);
+
+// 64-bit FNV-1a, the content hash kept for every suite answer.
+std::uint64_t HashText(std::string_view text);
+
+}  // namespace llaudit
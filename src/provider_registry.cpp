@@ -0,0 +1,285 @@
+#include "provider_registry.h"
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+
+#include <nlohmann/json.hpp>
+
+namespace llaudit {
+namespace {
+
+ProviderSpec OpenAICompatible(std::string id, std::string name,
+                              std::string base_url,
+                              std::vector<std::string> preferred) {
+  ProviderSpec s;
+  s.id = std::move(id);
+  s.name = std::move(name);
+  s.list_url = base_url + "/models";
+  s.chat_url = base_url + "/chat/completions";
+  s.preferred_models = std::move(preferred);
+  return s;
+}
+
+ProviderSpec GitHubModels(const std::string &id, const std::string &label) {
+  ProviderSpec s = OpenAICompatible(
+      id, "GitHub PAT (" + label + ")", "https://models.inference.ai.azure.com",
+      {"gpt-4.1", "gpt-4o", "gpt-4o-mini", "deepseek-r1", "phi-4"});
+  s.key_label = s.name;
+  s.check_url = "https://api.github.com/user";
+  s.check_headers = {"Accept: application/vnd.github+json"};
+  s.no_models_note = "No models discovered for this token.";
+  return s;
+}
+
+std::vector<ProviderSpec> MakeBuiltins() {
+  std::vector<ProviderSpec> out;
+  out.push_back(OpenAICompatible(
+      "openrouter", "OpenRouter", "https://openrouter.ai/api/v1",
+      {"openai/gpt-4.1", "openai/gpt-4o", "anthropic/claude-3.7-sonnet",
+       "google/gemini-2.5-pro"}));
+
+  ProviderSpec google;
+  google.id = "google_ai_studio";
+  google.name = "Google AI Studio";
+  google.format = ChatFormat::kGoogle;
+  google.auth = AuthStyle::kQueryKey;
+  google.list_url =
+      "https://generativelanguage.googleapis.com/v1beta/models?key={key}";
+  google.chat_url = "https://generativelanguage.googleapis.com/v1beta/{model}"
+                    ":generateContent?key={key}";
+  google.stream_url =
+      "https://generativelanguage.googleapis.com/v1beta/{model}"
+      ":streamGenerateContent?alt=sse&key={key}";
+  google.preferred_models = {"models/gemini-2.5-pro", "models/gemini-2.5-flash",
+                             "models/gemini-2.0-flash",
+                             "models/gemini-1.5-pro"};
+  google.no_models_note = "No generateContent models discovered.";
+  out.push_back(std::move(google));
+
+  ProviderSpec mistral = OpenAICompatible(
+      "mistral", "Mistral", "https://api.mistral.ai/v1",
+      {"mistral-large-latest", "magistral-medium-latest",
+       "mistral-medium-latest", "mistral-small-latest"});
+  mistral.batch = BatchStyle::kMistral;
+  mistral.batch_url = "https://api.mistral.ai/v1";
+  out.push_back(std::move(mistral));
+
+  ProviderSpec vercel = OpenAICompatible(
+      "vercel", "Vercel AI Gateway", "https://ai-gateway.vercel.sh/v1",
+      {"openai/gpt-5", "openai/gpt-4.1", "openai/gpt-4o",
+       "anthropic/claude-3.7-sonnet", "google/gemini-2.5-pro"});
+  vercel.key_label = "Vercel API Key";
+  vercel.check_url = "https://api.vercel.com/v2/user";
+  vercel.send_temperature = false;
+  vercel.no_models_note = "No models discovered from AI Gateway.";
+  out.push_back(std::move(vercel));
+
+  ProviderSpec groq = OpenAICompatible(
+      "groq", "Groq", "https://api.groq.com/openai/v1",
+      {"llama-3.3-70b-versatile", "deepseek-r1-distill-llama-70b",
+       "qwen/qwen3-32b"});
+  groq.batch = BatchStyle::kOpenAI;
+  groq.batch_url = "https://api.groq.com/openai/v1";
+  out.push_back(std::move(groq));
+
+  ProviderSpec cohere;
+  cohere.id = "cohere";
+  cohere.name = "Cohere";
+  cohere.format = ChatFormat::kCohere;
+  cohere.headers = {"Cohere-Version: 2022-12-06"};
+  cohere.list_url = "https://api.cohere.com/v1/models";
+  cohere.chat_url = "https://api.cohere.com/v1/chat";
+  cohere.preferred_models = {"command-a-reasoning-08-2025",
+                             "command-r-08-2024", "command-a-vision-07-2025"};
+  cohere.exclude_models = {"embed", "rerank"};
+  cohere.no_models_note = "No chat-capable models inferred from model names.";
+  out.push_back(std::move(cohere));
+
+  out.push_back(OpenAICompatible(
+      "ai21", "AI21", "https://api.ai21.com/studio/v1",
+      {"jamba-1.5-large", "jamba-large", "jamba-1.5-mini", "jamba-mini"}));
+
+  for (const char *label : {"chatgpt", "chatgpt5", "deepseek", "jamba"})
+    out.push_back(GitHubModels(std::string("github_") + label, label));
+  return out;
+}
+
+bool ReadString(const nlohmann::json &entry, const char *field,
+                std::string &out, std::string &error) {
+  if (!entry.contains(field))
+    return true;
+  if (!entry[field].is_string()) {
+    error = std::string(field) + " must be a string";
+    return false;
+  }
+  out = entry[field].get<std::string>();
+  return true;
+}
+
+bool ReadStrings(const nlohmann::json &entry, const char *field,
+                 std::vector<std::string> &out, std::string &error) {
+  if (!entry.contains(field))
+    return true;
+  const auto &v = entry[field];
+  const bool ok =
+      v.is_array() && std::all_of(v.begin(), v.end(), [](const auto &item) {
+        return item.is_string();
+      });
+  if (!ok) {
+    error = std::string(field) + " must be an array of strings";
+    return false;
+  }
+  out = v.get<std::vector<std::string>>();
+  return true;
+}
+
+bool ApplyEntry(const nlohmann::json &entry, ProviderSpec &s,
+                std::string &error) {
+  std::string format;
+  std::string auth;
+  std::string batch;
+  if (!ReadString(entry, "name", s.name, error) ||
+      !ReadString(entry, "key_label", s.key_label, error) ||
+      !ReadString(entry, "format", format, error) ||
+      !ReadString(entry, "auth", auth, error) ||
+      !ReadStrings(entry, "headers", s.headers, error) ||
+      !ReadString(entry, "list_url", s.list_url, error) ||
+      !ReadString(entry, "chat_url", s.chat_url, error) ||
+      !ReadString(entry, "stream_url", s.stream_url, error) ||
+      !ReadString(entry, "check_url", s.check_url, error) ||
+      !ReadStrings(entry, "check_headers", s.check_headers, error) ||
+      !ReadStrings(entry, "preferred_models", s.preferred_models, error) ||
+      !ReadStrings(entry, "exclude_models", s.exclude_models, error) ||
+      !ReadString(entry, "no_models_note", s.no_models_note, error) ||
+      !ReadString(entry, "batch", batch, error) ||
+      !ReadString(entry, "batch_url", s.batch_url, error))
+    return false;
+
+  if (format == "openai")
+    s.format = ChatFormat::kOpenAI;
+  else if (format == "google")
+    s.format = ChatFormat::kGoogle;
+  else if (format == "cohere")
+    s.format = ChatFormat::kCohere;
+  else if (!format.empty()) {
+    error = "unknown format \"" + format + "\" (openai, google or cohere)";
+    return false;
+  }
+
+  if (auth == "bearer")
+    s.auth = AuthStyle::kBearer;
+  else if (auth == "query")
+    s.auth = AuthStyle::kQueryKey;
+  else if (!auth.empty()) {
+    error = "unknown auth \"" + auth + "\" (bearer or query)";
+    return false;
+  }
+
+  if (batch == "openai")
+    s.batch = BatchStyle::kOpenAI;
+  else if (batch == "mistral")
+    s.batch = BatchStyle::kMistral;
+  else if (batch == "none")
+    s.batch = BatchStyle::kNone;
+  else if (!batch.empty()) {
+    error = "unknown batch \"" + batch + "\" (openai, mistral or none)";
+    return false;
+  }
+  if (s.batch != BatchStyle::kNone &&
+      (s.format != ChatFormat::kOpenAI || s.batch_url.empty())) {
+    error = "batch needs the openai format and a batch_url";
+    return false;
+  }
+
+  if (entry.contains("send_temperature")) {
+    if (!entry["send_temperature"].is_boolean()) {
+      error = "send_temperature must be true or false";
+      return false;
+    }
+    s.send_temperature = entry["send_temperature"].get<bool>();
+  }
+  if (entry.contains("max_in_flight")) {
+    if (!entry["max_in_flight"].is_number_integer() ||
+        entry["max_in_flight"].get<int>() < 0) {
+      error = "max_in_flight must be a non-negative integer";
+      return false;
+    }
+    s.max_in_flight = entry["max_in_flight"].get<int>();
+  }
+  return true;
+}
+
+} // namespace
+
+const std::vector<ProviderSpec> &BuiltinProviders() {
+  static const std::vector<ProviderSpec> builtins = MakeBuiltins();
+  return builtins;
+}
+
+bool LoadProviderRegistry(const std::filesystem::path &file,
+                          std::vector<ProviderSpec> &specs,
+                          std::string &error) {
+  try {
+    std::ifstream ifs(file);
+    if (!ifs) {
+      error = "Failed to open " + file.string() + " for reading.";
+      return false;
+    }
+    const nlohmann::json j = nlohmann::json::parse(ifs, nullptr, false);
+    if (!j.is_object() || !j.contains("providers") ||
+        !j["providers"].is_array()) {
+      error = file.string() + ": expected {\"providers\": [...]}";
+      return false;
+    }
+
+    std::vector<ProviderSpec> out = specs;
+    std::size_t index = 0;
+    for (const auto &entry : j["providers"]) {
+      ++index;
+      const std::string where =
+          file.filename().string() + " entry " + std::to_string(index);
+      if (!entry.is_object() || !entry.contains("id") ||
+          !entry["id"].is_string() ||
+          entry["id"].get<std::string>().empty()) {
+        error = where + ": needs a string \"id\"";
+        return false;
+      }
+      const std::string id = entry["id"].get<std::string>();
+      auto it = std::find_if(out.begin(), out.end(),
+                             [&](const ProviderSpec &s) { return s.id == id; });
+
+      if (entry.contains("enabled") && entry["enabled"].is_boolean() &&
+          !entry["enabled"].get<bool>()) {
+        if (it != out.end())
+          out.erase(it);
+        continue;
+      }
+
+      ProviderSpec fresh;
+      fresh.id = id;
+      ProviderSpec &spec = it != out.end() ? *it : fresh;
+      std::string field_error;
+      if (!ApplyEntry(entry, spec, field_error)) {
+        error = where + " (" + id + "): " + field_error;
+        return false;
+      }
+      if (it == out.end()) {
+        if (spec.name.empty() || spec.list_url.empty() ||
+            spec.chat_url.empty()) {
+          error = where + " (" + id +
+                  "): a new provider needs name, list_url and chat_url";
+          return false;
+        }
+        out.push_back(std::move(fresh));
+      }
+    }
+    specs = std::move(out);
+    return true;
+  } catch (const std::exception &ex) {
+    error = ex.what();
+    return false;
+  }
+}
+
+} // namespace llaudit
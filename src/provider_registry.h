@@ -0,0 +1,62 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "batch_api.h"
+
+namespace llaudit {
+
+// Request and response dialect of a chat endpoint; it also picks the text
+// extractor and how the model list is read.
+enum class ChatFormat { kOpenAI, kGoogle, kCohere };
+
+enum class AuthStyle {
+  kBearer,    // Authorization: Bearer <key>
+  kQueryKey,  // "{key}" in the URLs is replaced with the key
+};
+
+// One provider of the audit. Every spec runs through the same pipeline:
+// optional token check, model list, model probes, prompt suite, benchmark.
+// "{model}" in chat_url and stream_url is replaced with the model id.
+struct ProviderSpec {
+  std::string id;
+  std::string name;
+  // Shown next to the key input; defaults to "<name> API Key".
+  std::string key_label;
+  ChatFormat format = ChatFormat::kOpenAI;
+  AuthStyle auth = AuthStyle::kBearer;
+  // Sent with every request besides the auth header.
+  std::vector<std::string> headers;
+  std::string list_url;
+  std::string chat_url;
+  // Only Google streams from a different method; the others take stream=true.
+  std::string stream_url;
+  // A GET made before the model list to record the key's scope, e.g. GitHub's
+  // /user; check_headers are added to headers for it.
+  std::string check_url;
+  std::vector<std::string> check_headers;
+  std::vector<std::string> preferred_models;
+  // Models whose lower-cased id contains one of these are not probed.
+  std::vector<std::string> exclude_models;
+  bool send_temperature = true;
+  // Concurrent requests to chat_url's host; 0 keeps max_in_flight_per_host.
+  int max_in_flight = 0;
+  std::string no_models_note = "No models discovered or access denied.";
+  // Used in batch mode (AuditOptions::batch); needs the OpenAI chat format.
+  // batch_url is where "/files" lives, e.g. "https://api.mistral.ai/v1".
+  BatchStyle batch = BatchStyle::kNone;
+  std::string batch_url;
+};
+
+// The providers audited when no registry file is given, in report order.
+const std::vector<ProviderSpec>& BuiltinProviders();
+
+// Applies a providers.json file to specs. An entry whose id is already in
+// specs overrides the fields it lists, "enabled": false removes it, and any
+// other entry is appended and must have name, list_url and chat_url.
+bool LoadProviderRegistry(const std::filesystem::path& file, std::vector<ProviderSpec>& specs,
+                          std::string& error);
+
+}  // namespace llaudit
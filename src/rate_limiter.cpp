@@ -0,0 +1,261 @@
+#include "rate_limiter.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <limits>
+
+namespace llaudit {
+namespace {
+
+// Used when a provider reports a remaining count without a reset time.
+constexpr long long kDefaultWindowMs = 1000;
+
+std::string_view TrimView(std::string_view s) {
+  while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front())))
+    s.remove_prefix(1);
+  while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back())))
+    s.remove_suffix(1);
+  return s;
+}
+
+long long UnitMs(std::string_view unit) {
+  if (unit == "ms")
+    return 1;
+  if (unit == "s" || unit.empty())
+    return 1000;
+  if (unit == "m")
+    return 60 * 1000;
+  if (unit == "h")
+    return 60 * 60 * 1000;
+  return -1;
+}
+
+} // namespace
+
+long long ParseResetMs(std::string_view value) {
+  value = TrimView(value);
+  if (value.empty())
+    return -1;
+
+  const bool plain = std::all_of(value.begin(), value.end(), [](char c) {
+    return std::isdigit(static_cast<unsigned char>(c)) || c == '.';
+  });
+  if (plain) {
+    const double v = std::strtod(std::string(value).c_str(), nullptr);
+    if (v > 1e9) {
+      // Absolute Unix time, in milliseconds above 1e12 and seconds otherwise.
+      const double epoch_ms = v > 1e12 ? v : v * 1000.0;
+      const auto now_ms =
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::system_clock::now().time_since_epoch())
+              .count();
+      return std::max(0LL, static_cast<long long>(epoch_ms) - now_ms);
+    }
+    return static_cast<long long>(v * 1000.0);
+  }
+
+  double total = 0;
+  std::size_t i = 0;
+  while (i < value.size()) {
+    const std::size_t num_start = i;
+    while (i < value.size() &&
+           (std::isdigit(static_cast<unsigned char>(value[i])) ||
+            value[i] == '.'))
+      ++i;
+    if (i == num_start)
+      return -1;
+    const double n =
+        std::strtod(std::string(value.substr(num_start, i - num_start)).c_str(),
+                    nullptr);
+    const std::size_t unit_start = i;
+    while (i < value.size() &&
+           std::isalpha(static_cast<unsigned char>(value[i])))
+      ++i;
+    const long long unit = UnitMs(value.substr(unit_start, i - unit_start));
+    if (unit < 0)
+      return -1;
+    total += n * static_cast<double>(unit);
+  }
+  return static_cast<long long>(total);
+}
+
+RateLimitState ParseRateLimitState(const HeaderTable &headers) {
+  RateLimitState s;
+  // Indexed by RateLimitField.
+  const std::array<long long *, 8> members = {
+      nullptr,           &s.limit_requests,     &s.remaining_requests,
+      &s.reset_requests_ms, &s.limit_tokens,    &s.remaining_tokens,
+      &s.reset_tokens_ms,   &s.retry_after_ms,
+  };
+  std::array<int, 8> best_rank;
+  best_rank.fill(std::numeric_limits<int>::max());
+  for (const auto &h : headers) {
+    const auto field = static_cast<std::size_t>(h.field);
+    if (h.field == RateLimitField::kNone || h.number < 0 ||
+        h.rank >= best_rank[field])
+      continue;
+    best_rank[field] = h.rank;
+    *members[field] = h.number;
+  }
+  return s;
+}
+
+RateLimiter::RateLimiter(RateLimiterOptions options)
+    : options_(options), rng_(std::random_device{}()) {}
+
+long long RateLimiter::Acquire(long long token_cost,
+                               const std::atomic<bool> *cancel_requested) {
+  using namespace std::chrono;
+  std::unique_lock lock(mutex_);
+  const auto start = Clock::now();
+  const auto give_up = start + milliseconds(options_.max_wait_ms);
+
+  for (;;) {
+    const auto now = Clock::now();
+    // A known limit refills the next window, assumed as long as the longest
+    // reset seen; otherwise the bucket is unknown until a response says.
+    if (requests_ >= 0 && now >= requests_reset_at_) {
+      if (limit_requests_ > 0) {
+        requests_ = static_cast<double>(limit_requests_);
+        requests_reset_at_ = now + requests_window_;
+      } else {
+        requests_ = -1;
+      }
+    }
+    if (tokens_ >= 0 && now >= tokens_reset_at_) {
+      if (limit_tokens_ > 0) {
+        tokens_ = limit_tokens_;
+        tokens_reset_at_ = now + tokens_window_;
+      } else {
+        tokens_ = -1;
+      }
+    }
+
+    auto ready = std::max(now, blocked_until_);
+    if (requests_ >= 0 && requests_ < 1) {
+      ready = std::max(ready, requests_reset_at_);
+    } else if (requests_ >= 1 && requests_ < options_.pace_below) {
+      const auto spacing = duration_cast<Clock::duration>(
+          (requests_reset_at_ - now) / requests_);
+      ready = std::max(ready, last_send_ + spacing);
+    }
+    if (tokens_ >= 0 && tokens_ < token_cost)
+      ready = std::max(ready, tokens_reset_at_);
+
+    if (ready <= now || now >= give_up ||
+        (cancel_requested && cancel_requested->load()))
+      break;
+    changed_.wait_until(lock, std::min({ready, give_up, now + 100ms}));
+  }
+
+  const auto now = Clock::now();
+  if (requests_ >= 0)
+    requests_ = std::max(0.0, requests_ - 1);
+  if (tokens_ >= 0)
+    tokens_ = std::max(0LL, tokens_ - token_cost);
+  last_send_ = now;
+  in_flight_ += 1;
+  return duration_cast<milliseconds>(now - start).count();
+}
+
+void RateLimiter::ApplyLocked(const RateLimitState &state,
+                              Clock::time_point now) {
+  using namespace std::chrono;
+  // Requests still in flight were sent after the server computed this count.
+  if (state.remaining_requests >= 0) {
+    const milliseconds reset(state.reset_requests_ms >= 0
+                                 ? state.reset_requests_ms
+                                 : kDefaultWindowMs);
+    requests_ = static_cast<double>(
+        std::max(0LL, state.remaining_requests - in_flight_));
+    requests_reset_at_ = now + reset;
+    requests_window_ = std::max<Clock::duration>(requests_window_, reset);
+    if (state.limit_requests > 0)
+      limit_requests_ = state.limit_requests;
+  }
+  if (state.remaining_tokens >= 0) {
+    const milliseconds reset(state.reset_tokens_ms >= 0
+                                 ? state.reset_tokens_ms
+                                 : kDefaultWindowMs);
+    tokens_ = state.remaining_tokens;
+    tokens_reset_at_ = now + reset;
+    tokens_window_ = std::max<Clock::duration>(tokens_window_, reset);
+    if (state.limit_tokens > 0)
+      limit_tokens_ = state.limit_tokens;
+  }
+  if (state.remaining_requests >= 0 || state.remaining_tokens >= 0 ||
+      state.retry_after_ms >= 0)
+    last_state_ = state;
+}
+
+long long
+RateLimiter::Observe(long status, const HeaderTable &headers) {
+  using namespace std::chrono;
+  const RateLimitState state = ParseRateLimitState(headers);
+  std::scoped_lock lock(mutex_);
+  const auto now = Clock::now();
+  in_flight_ = std::max(0, in_flight_ - 1);
+  ApplyLocked(state, now);
+
+  long long backoff_ms = 0;
+  if (status == 429 || status == 503) {
+    consecutive_throttles_ += 1;
+    throttled_count_ += 1;
+    if (state.retry_after_ms >= 0) {
+      std::uniform_int_distribution<long long> jitter(
+          0, state.retry_after_ms / 10 + 1);
+      backoff_ms = state.retry_after_ms + jitter(rng_);
+    } else {
+      const int doublings = std::min(consecutive_throttles_ - 1, 16);
+      const long long cap = std::min(options_.max_backoff_ms,
+                                     options_.base_backoff_ms << doublings);
+      std::uniform_int_distribution<long long> jitter(cap / 2, cap);
+      backoff_ms = jitter(rng_);
+    }
+    blocked_until_ = std::max(blocked_until_, now + milliseconds(backoff_ms));
+  } else if (status >= 200 && status < 300) {
+    consecutive_throttles_ = 0;
+  }
+  changed_.notify_all();
+  return backoff_ms;
+}
+
+void RateLimiter::Seed(const RateLimitState &state) {
+  std::scoped_lock lock(mutex_);
+  const auto now = Clock::now();
+  ApplyLocked(state, now);
+  if (state.retry_after_ms >= 0)
+    blocked_until_ = std::max(
+        blocked_until_, now + std::chrono::milliseconds(state.retry_after_ms));
+  changed_.notify_all();
+}
+
+bool RateLimiter::ShouldRetry(long status, int attempt) const {
+  return (status == 429 || status == 503) && attempt < options_.max_attempts;
+}
+
+RateLimitState RateLimiter::last_state() const {
+  std::scoped_lock lock(mutex_);
+  return last_state_;
+}
+
+int RateLimiter::throttled_count() const {
+  std::scoped_lock lock(mutex_);
+  return throttled_count_;
+}
+
+RateLimiter &RateLimiterPool::For(const std::string &scope,
+                                  const RateLimitState *seed) {
+  std::scoped_lock lock(mutex_);
+  auto &slot = limiters_[scope];
+  if (!slot) {
+    slot = std::make_unique<RateLimiter>(options_);
+    if (seed)
+      slot->Seed(*seed);
+  }
+  return *slot;
+}
+
+} // namespace llaudit
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "header_table.h"
+
+namespace llaudit {
+
+// Numeric view of a response's rate-limit headers; -1 means not reported.
+// Reset and retry values are converted to milliseconds from now.
+struct RateLimitState {
+  long long limit_requests = -1;
+  long long remaining_requests = -1;
+  long long reset_requests_ms = -1;
+  long long limit_tokens = -1;
+  long long remaining_tokens = -1;
+  long long reset_tokens_ms = -1;
+  long long retry_after_ms = -1;
+};
+
+// Accepts "1m30.5s", "250ms", "2h", plain seconds, and Unix epoch seconds or
+// milliseconds (converted to the time remaining). Returns -1 if unparseable.
+long long ParseResetMs(std::string_view value);
+
+// Reads the numbers HeaderTable parsed for the known rate-limit headers; where
+// several headers fill one member the highest-ranked one that parsed wins.
+RateLimitState ParseRateLimitState(const HeaderTable& headers);
+
+struct RateLimiterOptions {
+  int max_attempts = 3;  // per request, counting the first send
+  long long base_backoff_ms = 500;
+  long long max_backoff_ms = 20000;
+  // Never hold a request longer than this; it is sent and may be rejected.
+  long long max_wait_ms = 30000;
+  // Spread the remaining budget over the reset window once it drops this low.
+  int pace_below = 10;
+};
+
+// Pacing for one provider key against one host. Acquire() before each send,
+// Observe() with each response. The remaining-requests and remaining-tokens
+// headers fill two fixed-window buckets that refill at their reset time;
+// 429/503 responses block the whole key for retry-after, or for an
+// exponential backoff with jitter when the provider gives no hint.
+class RateLimiter {
+ public:
+  explicit RateLimiter(RateLimiterOptions options = {});
+
+  // Blocks until the request may go and returns the milliseconds waited.
+  long long Acquire(long long token_cost, const std::atomic<bool>* cancel_requested);
+
+  // Returns the backoff applied for a 429/503, otherwise 0.
+  long long Observe(long status, const HeaderTable& headers);
+  // Starts from budgets observed elsewhere, as if they had been reported now;
+  // a retry_after_ms blocks the key for that long.
+  void Seed(const RateLimitState& state);
+
+  bool ShouldRetry(long status, int attempt) const;
+  RateLimitState last_state() const;
+  int throttled_count() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  void ApplyLocked(const RateLimitState& state, Clock::time_point now);
+
+  RateLimiterOptions options_;
+  mutable std::mutex mutex_;
+  std::condition_variable changed_;
+  std::mt19937 rng_;
+
+  double requests_ = -1;  // -1 while unknown
+  Clock::time_point requests_reset_at_{};
+  Clock::duration requests_window_{};
+  long long limit_requests_ = -1;
+  long long tokens_ = -1;
+  Clock::time_point tokens_reset_at_{};
+  Clock::duration tokens_window_{};
+  long long limit_tokens_ = -1;
+  Clock::time_point blocked_until_{};
+  Clock::time_point last_send_{};
+  int in_flight_ = 0;
+  int consecutive_throttles_ = 0;
+  int throttled_count_ = 0;
+  RateLimitState last_state_;
+};
+
+// One limiter per scope string (provider id, host and key), created on first
+// use and kept for the whole run.
+class RateLimiterPool {
+ public:
+  explicit RateLimiterPool(RateLimiterOptions options = {}) : options_(options) {}
+
+  // seed, when given, is applied to a limiter created by this call.
+  RateLimiter& For(const std::string& scope, const RateLimitState* seed = nullptr);
+
+ private:
+  RateLimiterOptions options_;
+  std::mutex mutex_;
+  std::map<std::string, std::unique_ptr<RateLimiter>> limiters_;
+};
+
+}  // namespace llaudit
@@ -1,59 +1,391 @@
 #include "report_writer.h"
 
+#include <algorithm>
 #include <chrono>
 #include <ctime>
 #include <fstream>
 #include <iomanip>
 #include <sstream>
+#include <streambuf>
+#include <utility>
+#include <vector>
 
 namespace llaudit {
 namespace {
 
-std::string TimestampFile() {
-  using namespace std::chrono;
-  const auto now = system_clock::now();
-  const auto t = system_clock::to_time_t(now);
-  std::tm tm{};
-#if defined(_WIN32)
-  localtime_s(&tm, &t);
-#else
-  localtime_r(&t, &tm);
-#endif
-  std::ostringstream oss;
-  oss << std::put_time(&tm, "%Y%m%d_%H%M%S");
-  return oss.str();
+// Report files are written in many small pieces; give them a larger buffer
+// than the library default.
+class ReportFile {
+public:
+  explicit ReportFile(const std::filesystem::path &path)
+      : buffer_(64 * 1024) {
+    stream_.rdbuf()->pubsetbuf(buffer_.data(),
+                               static_cast<std::streamsize>(buffer_.size()));
+    stream_.open(path, std::ios::out | std::ios::trunc);
+  }
+
+  explicit operator bool() const { return stream_.is_open(); }
+  std::ostream &stream() { return stream_; }
+
+private:
+  std::vector<char> buffer_;
+  std::ofstream stream_;
+};
+
+// Forwards every byte to two streams, so one serialization fills both.
+class TeeBuf : public std::streambuf {
+public:
+  TeeBuf(std::streambuf *a, std::streambuf *b) : a_(a), b_(b) {}
+
+protected:
+  int_type overflow(int_type c) override {
+    if (traits_type::eq_int_type(c, traits_type::eof()))
+      return traits_type::not_eof(c);
+    const char ch = traits_type::to_char_type(c);
+    const auto eof = traits_type::eof();
+    const bool a_ok = !traits_type::eq_int_type(a_->sputc(ch), eof);
+    const bool b_ok = !traits_type::eq_int_type(b_->sputc(ch), eof);
+    return a_ok && b_ok ? c : eof;
+  }
+
+  std::streamsize xsputn(const char *s, std::streamsize n) override {
+    return std::min(a_->sputn(s, n), b_->sputn(s, n));
+  }
+
+private:
+  std::streambuf *a_;
+  std::streambuf *b_;
+};
+
+// Maps keyed by status are written with string keys, as JSON needs, in the
+// order a JSON object keeps them.
+void WriteStatusCounts(JsonWriter &out, const std::map<long, int> &counts) {
+  std::vector<std::pair<std::string, int>> sorted;
+  sorted.reserve(counts.size());
+  for (const auto &[status, n] : counts)
+    sorted.emplace_back(std::to_string(status), n);
+  std::sort(sorted.begin(), sorted.end());
+  out.StartObject();
+  for (const auto &[status, n] : sorted)
+    out.Field(status, n);
+  out.EndObject();
 }
 
-} // namespace
+void WriteLatencyJson(JsonWriter &out, const LatencyHistogram &h) {
+  out.StartObject();
+  out.Field("count", h.count());
+  out.Key("histogram");
+  out.StartArray();
+  for (const auto &[lower_us, n] : h.Buckets()) {
+    out.StartArray();
+    out.Value(lower_us);
+    out.Value(n);
+    out.EndArray();
+  }
+  out.EndArray();
+  out.Field("max_us", h.max());
+  out.Field("mean_us", h.mean());
+  out.Field("min_us", h.min());
+  out.Field("p50_us", h.Percentile(0.50));
+  out.Field("p90_us", h.Percentile(0.90));
+  out.Field("p99_us", h.Percentile(0.99));
+  out.EndObject();
+}
 
-std::string WriteJsonReport(const AuditReport &report,
-                            const std::filesystem::path &out_dir) {
-  std::filesystem::create_directories(out_dir);
-  const auto file = out_dir / ("llm_api_audit_" + TimestampFile() + ".json");
+void WriteBenchmarkJson(JsonWriter &out, const BenchmarkResult &b) {
+  out.StartObject();
+  out.Field("achieved_rps", b.achieved_rps);
+  out.Field("completed", b.completed);
+  out.Field("concurrency", b.concurrency);
+  out.Field("duration_seconds", b.duration_seconds);
+  out.Field("error_rate", b.error_rate);
+  out.Field("first_429_ms", b.first_429_ms);
+  out.Field("last_rate_limit_headers", b.last_rate_limit_headers);
+  out.Key("latency");
+  WriteLatencyJson(out, b.latency);
+  out.Field("mode", b.mode);
+  out.Field("model", b.model);
+  out.Field("notes", b.notes);
+  out.Field("ran", b.ran);
+  out.Field("rps_at_first_429", b.rps_at_first_429);
+  out.Field("sent", b.sent);
+  out.Field("sent_before_first_429", b.sent_before_first_429);
+  out.Key("status_counts");
+  WriteStatusCounts(out, b.status_counts);
+  out.Field("succeeded", b.succeeded);
+  out.Field("target_rps", b.target_rps);
+  out.Key("windows");
+  out.StartArray();
+  for (const auto &w : b.windows) {
+    out.StartObject();
+    out.Field("errors", w.errors);
+    out.Field("p50_us", w.p50_us);
+    out.Field("p99_us", w.p99_us);
+    out.Field("rate_limited", w.rate_limited);
+    out.Field("sent", w.sent);
+    out.Field("start_ms", w.start_ms);
+    out.EndObject();
+  }
+  out.EndArray();
+  out.EndObject();
+}
 
-  std::ofstream ofs(file, std::ios::out | std::ios::trunc);
-  if (!ofs)
-    return {};
+std::string HashHex(std::uint64_t h) {
+  static constexpr char kHex[] = "0123456789abcdef";
+  std::string out(16, '0');
+  for (int i = 15; i >= 0; --i) {
+    out[static_cast<std::size_t>(i)] = kHex[h & 0xF];
+    h >>= 4;
+  }
+  return out;
+}
 
-  ofs << ReportToJson(report).dump(2);
-  return file.string();
+// Identical responses are written once, in "responses", and results refer to
+// them by index.
+void WriteSuitesJson(JsonWriter &out, const SuiteResults &s) {
+  out.StartObject();
+  out.Key("responses");
+  out.StartArray();
+  for (StringInterner::Id i = 0; i < s.responses.size(); ++i)
+    out.Value(s.responses.Get(i));
+  out.EndArray();
+  out.Key("results");
+  out.StartArray();
+  for (const auto &r : s.results) {
+    out.StartObject();
+    out.Field("case", s.names.Get(r.case_id));
+    out.Field("latency_ms", r.latency_ms);
+    out.Field("max_points", r.max_points);
+    out.Field("model", s.names.Get(r.model));
+    out.Field("points", r.points);
+    out.Field("response", r.response);
+    out.Field("response_hash", HashHex(r.response_hash));
+    out.Field("status", r.status);
+    out.Field("suite", s.names.Get(r.suite));
+    out.EndObject();
+  }
+  out.EndArray();
+  out.Key("summary");
+  out.StartArray();
+  for (const auto &sum : SummarizeSuites(s)) {
+    out.StartObject();
+    out.Field("cases", sum.cases);
+    out.Field("failed_requests", sum.failed_requests);
+    out.Key("latency");
+    WriteLatencyJson(out, sum.latency);
+    out.Field("max_points", sum.max_points);
+    out.Field("model", sum.model);
+    out.Field("passed", sum.passed);
+    out.Field("points", sum.points);
+    out.Field("suite", sum.suite);
+    out.EndObject();
+  }
+  out.EndArray();
+  out.EndObject();
 }
 
-std::string WriteTextReport(const AuditReport &report,
-                            const std::filesystem::path &out_dir) {
-  std::filesystem::create_directories(out_dir);
-  const auto file = out_dir / ("llm_api_audit_" + TimestampFile() + ".txt");
+void WriteProviderJson(JsonWriter &out, const ProviderAudit &p) {
+  out.StartObject();
+  out.Field("api_key", p.api_key);
+  out.Field("auth_latency_ms", p.auth_latency_ms);
+  out.Field("auth_rate_limit_headers", p.auth_rate_limit_headers);
+  out.Field("auth_status", p.auth_status);
+  out.Field("avg_latency_ms", p.avg_latency_ms);
+  if (!p.batches.empty()) {
+    out.Key("batches");
+    out.StartArray();
+    for (const auto &b : p.batches) {
+      out.StartObject();
+      out.Field("error", b.error);
+      out.Field("failed", b.failed);
+      out.Field("id", b.id);
+      out.Field("model", b.model);
+      out.Field("polls", b.polls);
+      out.Field("requests", b.requests);
+      out.Field("status", b.status);
+      out.Field("succeeded", b.succeeded);
+      out.Field("turnaround_ms", b.turnaround_ms);
+      out.Field("upload_ms", b.upload_ms);
+      out.EndObject();
+    }
+    out.EndArray();
+  }
+  if (p.benchmark.ran) {
+    out.Key("benchmark");
+    WriteBenchmarkJson(out, p.benchmark);
+  }
+  out.Field("capability_tags", p.capability_tags);
+  out.Field("catalog_shared", p.catalog_shared);
+  out.Field("catalog_source", p.catalog_source);
+  out.Field("checkpoint_saved_at", p.checkpoint_saved_at);
+  out.Field("error_snippet", p.error_snippet);
+  out.Field("failed_requests", p.failed_requests);
+  out.Field("failing_models", p.failing_models);
+  out.Field("key_index", p.key_index);
+  out.Field("key_supplied", p.key_supplied);
+  out.Field("key_tier", p.key_tier);
+  out.Key("latency_summary");
+  WriteLatencyJson(out, p.latency);
+  out.Field("max_context_seen", p.max_context_seen);
 
-  std::ofstream ofs(file, std::ios::out | std::ios::trunc);
-  if (!ofs)
-    return {};
+  out.Key("model_checks");
+  out.StartArray();
+  for (const auto &c : p.model_checks) {
+    out.StartObject();
+    out.Field("error_snippet", c.error_snippet);
+    out.Field("latency_ms", c.latency_ms);
+    out.Field("model", c.model);
+    out.Field("status", c.status);
+    out.Field("working", c.working);
+    out.EndObject();
+  }
+  out.EndArray();
+
+  out.Key("model_latency");
+  out.StartObject();
+  for (const auto &[model, hist] : p.model_latency) {
+    out.Key(model);
+    WriteLatencyJson(out, hist);
+  }
+  out.EndObject();
+
+  out.Field("model_used", p.model_used);
+  out.Field("models_latency_ms", p.models_latency_ms);
+  out.Field("models_rate_limit_headers", p.models_rate_limit_headers);
+  out.Field("models_status", p.models_status);
+  out.Field("notes", p.notes);
+
+  out.Key("prompt_tests");
+  out.StartArray();
+  for (const auto &t : p.prompt_tests) {
+    out.StartObject();
+    out.Field("answer", t.answer);
+    out.Field("error_snippet", t.error_snippet);
+    out.Field("inter_token_p50_us", t.inter_token_p50_us);
+    out.Field("inter_token_p90_us", t.inter_token_p90_us);
+    out.Field("inter_token_p99_us", t.inter_token_p99_us);
+    out.Field("latency_ms", t.latency_ms);
+    out.Field("name", t.name);
+    out.Field("output_tokens", t.output_tokens);
+    out.Field("rate_limit_headers", t.rate_limit_headers);
+    out.Field("status", t.status);
+    out.Field("streamed", t.streamed);
+    out.Field("tokens_per_second", t.tokens_per_second);
+    out.Field("ttft_us", t.ttft_us);
+    out.EndObject();
+  }
+  out.EndArray();
+
+  out.Field("provider_id", p.provider_id);
+  out.Field("provider_name", p.provider_name);
+
+  const auto &rl = p.rate_limit;
+  out.Key("rate_limit_state");
+  out.StartObject();
+  out.Field("limit_requests", rl.limit_requests);
+  out.Field("limit_tokens", rl.limit_tokens);
+  out.Field("remaining_requests", rl.remaining_requests);
+  out.Field("remaining_tokens", rl.remaining_tokens);
+  out.Field("reset_requests_ms", rl.reset_requests_ms);
+  out.Field("reset_tokens_ms", rl.reset_tokens_ms);
+  out.Field("retry_after_ms", rl.retry_after_ms);
+  out.EndObject();
+
+  out.Field("raw_payload", p.raw_payload);
+  if (!p.region.empty())
+    out.Field("region", p.region);
 
+  out.Key("request_traces");
+  out.StartArray();
+  for (const auto &tr : p.traces.Retained()) {
+    out.StartObject();
+    out.Field("attempt", tr.attempt);
+    out.Field("backoff_ms", tr.backoff_ms);
+    out.Field("connection_reused", tr.connection_reused);
+    out.Field("error", tr.error);
+    out.Field("latency_ms", tr.latency_ms);
+    out.Field("method", tr.method);
+    out.Field("paced_ms", tr.paced_ms);
+    out.Key("phases_us");
+    out.StartObject();
+    out.Field("connect", tr.phases.connect_us);
+    out.Field("dns", tr.phases.dns_us);
+    out.Field("tls", tr.phases.tls_us);
+    out.Field("total", tr.phases.total_us);
+    out.Field("ttfb", tr.phases.ttfb_us);
+    out.EndObject();
+    out.Field("rate_limit_headers", tr.rate_limit_headers);
+    out.Field("response_snippet", tr.response_snippet);
+    out.Field("seq", tr.seq);
+    out.Field("state", tr.state);
+    out.Field("status", tr.status);
+    out.Field("step", tr.step);
+    out.Field("url", tr.url);
+    out.EndObject();
+  }
+  out.EndArray();
+
+  out.Field("sample_models", p.sample_models);
+  out.Field("score_axui", p.score_axui);
+  out.Field("score_coding", p.score_coding);
+  out.Field("score_reasoning", p.score_reasoning);
+  out.Field("score_total", p.score_total);
+  out.Field("successful_requests", p.successful_requests);
+  if (!p.suites.results.empty()) {
+    out.Key("suites");
+    WriteSuitesJson(out, p.suites);
+  }
+  out.Field("throttled_requests", p.throttled_requests);
+  out.Field("total_requests", p.total_requests);
+
+  out.Key("trace_steps");
+  out.StartArray();
+  for (const auto &st : p.traces.StepSummary()) {
+    out.StartObject();
+    out.Field("count", st.count);
+    out.Field("errors", st.errors);
+    out.Field("latency_ms_sum", st.latency_ms_sum);
+    out.Key("status_counts");
+    WriteStatusCounts(out, st.status_counts);
+    out.Field("step", st.step);
+    out.EndObject();
+  }
+  out.EndArray();
+
+  out.Field("traces_recorded", p.traces.size());
+  out.Field("traces_retained", p.traces.retained());
+  out.Field("working_models", p.working_models);
+  out.EndObject();
+}
+
+void WriteTextHead(std::ostream &ofs, const AuditReport &report) {
   ofs << "API-TESTER FULL AUDIT REPORT\n";
   ofs << "Generated at (UTC): " << report.generated_at_utc << "\n";
   ofs << "\n";
   ofs << "========================= RUN LOGS =========================\n";
-  for (const auto &line : report.run_logs)
-    ofs << line << "\n";
+}
+
+// Everything after the run logs up to the embedded JSON report.
+void WriteTextSections(std::ostream &ofs, const AuditReport &report) {
+  ofs << "\n";
+
+  ofs << "========================= KEY POOLS ========================\n";
+  for (const auto &pool : report.pools) {
+    ofs << pool.provider_name << " (" << pool.provider_id << ")\n";
+    if (!pool.region.empty())
+      ofs << "  region: " << pool.region << "\n";
+    ofs << "  keys_healthy: " << pool.keys_healthy << "/" << pool.keys_total
+        << "\n";
+    ofs << "  remaining_requests: " << pool.remaining_requests << "\n";
+    ofs << "  remaining_tokens: " << pool.remaining_tokens << "\n";
+    ofs << "  keys_reporting_quota: " << pool.keys_reporting_quota << "\n";
+    ofs << "  throttled_requests: " << pool.throttled_requests << "\n";
+    ofs << "  working_models: " << pool.working_models.size() << "\n";
+    for (const auto &k : pool.healthy_keys)
+      ofs << "  healthy: " << k << "\n";
+    for (const auto &k : pool.unhealthy_keys)
+      ofs << "  unhealthy: " << k << "\n";
+  }
   ofs << "\n";
 
   for (const auto &p : report.providers) {
@@ -61,6 +393,14 @@ std::string WriteTextReport(const AuditReport &report,
     ofs << "PROVIDER: " << p.provider_name << " (" << p.provider_id << ")\n";
     ofs << "API KEY: " << p.api_key << "\n";
     ofs << "key_supplied: " << (p.key_supplied ? "true" : "false") << "\n";
+    ofs << "key_index: " << p.key_index << "\n";
+    ofs << "key_tier: " << p.key_tier << "\n";
+    if (!p.region.empty())
+      ofs << "region: " << p.region << "\n";
+    ofs << "catalog_shared: " << (p.catalog_shared ? "true" : "false")
+        << "\n";
+    ofs << "catalog_source: " << p.catalog_source << "\n";
+    ofs << "checkpoint_saved_at: " << p.checkpoint_saved_at << "\n";
     ofs << "auth_status: " << p.auth_status << "\n";
     ofs << "models_status: " << p.models_status << "\n";
     ofs << "auth_latency_ms: " << p.auth_latency_ms << "\n";
@@ -75,6 +415,20 @@ std::string WriteTextReport(const AuditReport &report,
     ofs << "successful_requests: " << p.successful_requests << "\n";
     ofs << "failed_requests: " << p.failed_requests << "\n";
     ofs << "avg_latency_ms: " << p.avg_latency_ms << "\n";
+    ofs << "latency_ms: " << FormatLatencyMs(p.latency) << "\n";
+    ofs << "latency_histogram_us:\n";
+    for (const auto &[lower_us, n] : p.latency.Buckets())
+      ofs << "  >=" << lower_us << ": " << n << "\n";
+    ofs << "model_latency_ms:\n";
+    for (const auto &[model, hist] : p.model_latency)
+      ofs << "  " << model << ": " << FormatLatencyMs(hist) << "\n";
+    ofs << "throttled_requests: " << p.throttled_requests << "\n";
+    ofs << "rate_limit_state: requests " << p.rate_limit.remaining_requests
+        << "/" << p.rate_limit.limit_requests << " reset_ms="
+        << p.rate_limit.reset_requests_ms << ", tokens "
+        << p.rate_limit.remaining_tokens << "/" << p.rate_limit.limit_tokens
+        << " reset_ms=" << p.rate_limit.reset_tokens_ms
+        << ", retry_after_ms=" << p.rate_limit.retry_after_ms << "\n";
     ofs << "notes: " << p.notes << "\n";
     ofs << "error_snippet: " << p.error_snippet << "\n";
 
@@ -95,12 +449,12 @@ std::string WriteTextReport(const AuditReport &report,
       ofs << "  - " << m << "\n";
 
     ofs << "auth_rate_limit_headers:\n";
-    for (const auto &[k, v] : p.auth_rate_limit_headers)
-      ofs << "  " << k << ": " << v << "\n";
+    for (const auto &h : p.auth_rate_limit_headers)
+      ofs << "  " << h.name << ": " << h.value << "\n";
 
     ofs << "models_rate_limit_headers:\n";
-    for (const auto &[k, v] : p.models_rate_limit_headers)
-      ofs << "  " << k << ": " << v << "\n";
+    for (const auto &h : p.models_rate_limit_headers)
+      ofs << "  " << h.name << ": " << h.value << "\n";
 
     ofs << "model_checks:\n";
     for (const auto &c : p.model_checks) {
@@ -118,53 +472,299 @@ std::string WriteTextReport(const AuditReport &report,
       ofs << "    latency_ms: " << t.latency_ms << "\n";
       ofs << "    answer: " << t.answer << "\n";
       ofs << "    error_snippet: " << t.error_snippet << "\n";
+      if (t.streamed) {
+        ofs << "    ttft_us: " << t.ttft_us << "\n";
+        ofs << "    inter_token_us: p50=" << t.inter_token_p50_us
+            << " p90=" << t.inter_token_p90_us
+            << " p99=" << t.inter_token_p99_us << "\n";
+        ofs << "    output_tokens: " << t.output_tokens << "\n";
+        ofs << "    tokens_per_second: " << t.tokens_per_second << "\n";
+      }
       ofs << "    rate_limit_headers:\n";
-      for (const auto &[k, v] : t.rate_limit_headers) {
-        ofs << "      " << k << ": " << v << "\n";
+      for (const auto &h : t.rate_limit_headers) {
+        ofs << "      " << h.name << ": " << h.value << "\n";
+      }
+    }
+
+    if (!p.batches.empty()) {
+      ofs << "batches:\n";
+      for (const auto &b : p.batches) {
+        ofs << "  - id: " << b.id << "\n";
+        ofs << "    model: " << b.model << "\n";
+        ofs << "    status: " << b.status << "\n";
+        ofs << "    requests: " << b.requests << "\n";
+        ofs << "    succeeded: " << b.succeeded << "\n";
+        ofs << "    failed: " << b.failed << "\n";
+        ofs << "    upload_ms: " << b.upload_ms << "\n";
+        ofs << "    turnaround_ms: " << b.turnaround_ms << "\n";
+        ofs << "    polls: " << b.polls << "\n";
+        ofs << "    error: " << b.error << "\n";
+      }
+    }
+
+    if (!p.suites.results.empty()) {
+      const auto &suites = p.suites;
+      ofs << "suites:\n";
+      for (const auto &sum : SummarizeSuites(suites)) {
+        ofs << "  - suite: " << sum.suite << "\n";
+        ofs << "    model: " << sum.model << "\n";
+        ofs << "    points: " << sum.points << "/" << sum.max_points << "\n";
+        ofs << "    passed: " << sum.passed << "/" << sum.cases << "\n";
+        ofs << "    failed_requests: " << sum.failed_requests << "\n";
+        ofs << "    latency_ms: " << FormatLatencyMs(sum.latency) << "\n";
+      }
+      ofs << "suite_results:\n";
+      for (const auto &r : suites.results) {
+        ofs << "  - " << suites.names.Get(r.suite) << "/"
+            << suites.names.Get(r.case_id) << " on "
+            << suites.names.Get(r.model) << ": status=" << r.status
+            << " latency_ms=" << r.latency_ms << " points=" << r.points << "/"
+            << r.max_points << " response=#" << r.response << " hash="
+            << HashHex(r.response_hash) << "\n";
+      }
+      ofs << "suite_responses (" << suites.responses.size()
+          << " distinct):\n";
+      for (StringInterner::Id i = 0; i < suites.responses.size(); ++i)
+        ofs << "  #" << i << ": " << suites.responses.Get(i) << "\n";
+    }
+
+    if (p.benchmark.ran) {
+      const auto &b = p.benchmark;
+      ofs << "benchmark:\n";
+      ofs << "  model: " << b.model << "\n";
+      ofs << "  mode: " << b.mode << "\n";
+      ofs << "  target_rps: " << b.target_rps << "\n";
+      ofs << "  concurrency: " << b.concurrency << "\n";
+      ofs << "  duration_seconds: " << b.duration_seconds << "\n";
+      ofs << "  sent: " << b.sent << "\n";
+      ofs << "  completed: " << b.completed << "\n";
+      ofs << "  succeeded: " << b.succeeded << "\n";
+      ofs << "  achieved_rps: " << b.achieved_rps << "\n";
+      ofs << "  error_rate: " << b.error_rate << "\n";
+      ofs << "  latency_ms: " << FormatLatencyMs(b.latency) << "\n";
+      ofs << "  first_429_ms: " << b.first_429_ms << "\n";
+      ofs << "  sent_before_first_429: " << b.sent_before_first_429 << "\n";
+      ofs << "  rps_at_first_429: " << b.rps_at_first_429 << "\n";
+      ofs << "  notes: " << b.notes << "\n";
+      ofs << "  status_counts:\n";
+      for (const auto &[status, n] : b.status_counts)
+        ofs << "    " << status << ": " << n << "\n";
+      ofs << "  windows:\n";
+      for (const auto &w : b.windows) {
+        ofs << "    - start_ms: " << w.start_ms << "\n";
+        ofs << "      sent: " << w.sent << "\n";
+        ofs << "      errors: " << w.errors << "\n";
+        ofs << "      rate_limited: " << w.rate_limited << "\n";
+        ofs << "      p50_us: " << w.p50_us << "\n";
+        ofs << "      p99_us: " << w.p99_us << "\n";
       }
+      ofs << "  last_rate_limit_headers:\n";
+      for (const auto &h : b.last_rate_limit_headers)
+        ofs << "    " << h.name << ": " << h.value << "\n";
     }
 
-    ofs << "request_traces:\n";
-    for (const auto &tr : p.request_traces) {
-      ofs << "  - step: " << tr.step << "\n";
+    ofs << "trace_steps (all " << p.traces.size() << " requests):\n";
+    for (const auto &st : p.traces.StepSummary()) {
+      ofs << "  - " << st.step << ": count=" << st.count
+          << " errors=" << st.errors << " statuses=";
+      bool first = true;
+      for (const auto &[status, n] : st.status_counts) {
+        ofs << (first ? "" : ",") << status << ":" << n;
+        first = false;
+      }
+      ofs << "\n";
+    }
+
+    ofs << "request_traces (" << p.traces.retained() << " of "
+        << p.traces.size() << " kept):\n";
+    for (const auto &tr : p.traces.Retained()) {
+      ofs << "  - seq: " << tr.seq << "\n";
+      ofs << "    step: " << tr.step << "\n";
       ofs << "    method: " << tr.method << "\n";
       ofs << "    url: " << tr.url << "\n";
       ofs << "    status: " << tr.status << "\n";
       ofs << "    latency_ms: " << tr.latency_ms << "\n";
+      ofs << "    phases_us: dns=" << tr.phases.dns_us
+          << " connect=" << tr.phases.connect_us
+          << " tls=" << tr.phases.tls_us << " ttfb=" << tr.phases.ttfb_us
+          << " total=" << tr.phases.total_us << "\n";
+      ofs << "    connection_reused: "
+          << (tr.connection_reused ? "true" : "false") << "\n";
+      ofs << "    state: " << tr.state << " (attempt " << tr.attempt
+          << ", paced_ms=" << tr.paced_ms << ", backoff_ms=" << tr.backoff_ms
+          << ")\n";
       ofs << "    error: " << tr.error << "\n";
       ofs << "    response_snippet: " << tr.response_snippet << "\n";
       ofs << "    rate_limit_headers:\n";
-      for (const auto &[k, v] : tr.rate_limit_headers) {
-        ofs << "      " << k << ": " << v << "\n";
+      for (const auto &h : tr.rate_limit_headers) {
+        ofs << "      " << h.name << ": " << h.value << "\n";
       }
     }
 
-    ofs << "raw_payload_json:\n";
-    ofs << p.raw_payload.dump(2) << "\n\n";
+    if (!p.raw_payload.is_null()) {
+      ofs << "raw_payload_json:\n";
+      JsonWriter(ofs).Value(p.raw_payload);
+      ofs << "\n";
+    }
+    ofs << "\n";
   }
 
   ofs << "========================= RAW FULL JSON =========================\n";
-  ofs << ReportToJson(report).dump(2) << "\n";
+}
+
+void WriteRunLogHead(std::ostream &ofs, const AuditReport &report) {
+  ofs << "API-Tester Run Log\n";
+  ofs << "Generated at (UTC): " << report.generated_at_utc << "\n\n";
+}
+
+} // namespace
+
+std::string ReportTimestamp() {
+  using namespace std::chrono;
+  const auto now = system_clock::now();
+  const auto t = system_clock::to_time_t(now);
+  std::tm tm{};
+#if defined(_WIN32)
+  localtime_s(&tm, &t);
+#else
+  localtime_r(&t, &tm);
+#endif
+  std::ostringstream oss;
+  oss << std::put_time(&tm, "%Y%m%d_%H%M%S");
+  return oss.str();
+}
+
+void WriteReportJson(JsonWriter &out, const AuditReport &report) {
+  out.StartObject();
+  out.Field("generated_at_utc", report.generated_at_utc);
 
+  out.Key("key_pools");
+  out.StartArray();
+  for (const auto &pool : report.pools) {
+    out.StartObject();
+    out.Field("healthy_keys", pool.healthy_keys);
+    out.Field("keys_healthy", pool.keys_healthy);
+    out.Field("keys_reporting_quota", pool.keys_reporting_quota);
+    out.Field("keys_total", pool.keys_total);
+    out.Field("provider_id", pool.provider_id);
+    out.Field("provider_name", pool.provider_name);
+    if (!pool.region.empty())
+      out.Field("region", pool.region);
+    out.Field("remaining_requests", pool.remaining_requests);
+    out.Field("remaining_tokens", pool.remaining_tokens);
+    out.Field("throttled_requests", pool.throttled_requests);
+    out.Field("unhealthy_keys", pool.unhealthy_keys);
+    out.Field("working_models", pool.working_models);
+    out.EndObject();
+  }
+  out.EndArray();
+
+  out.Key("providers");
+  out.StartArray();
+  for (const auto &p : report.providers)
+    WriteProviderJson(out, p);
+  out.EndArray();
+
+  out.Field("run_logs", report.run_logs);
+  out.EndObject();
+}
+
+std::string WriteJsonReport(const AuditReport &report,
+                            const std::filesystem::path &out_dir) {
+  std::filesystem::create_directories(out_dir);
+  const auto file = out_dir / ("llm_api_audit_" + ReportTimestamp() + ".json");
+
+  ReportFile out(file);
+  if (!out)
+    return {};
+
+  JsonWriter json(out.stream());
+  WriteReportJson(json, report);
+  return file.string();
+}
+
+std::string WriteTextReport(const AuditReport &report,
+                            const std::filesystem::path &out_dir) {
+  std::filesystem::create_directories(out_dir);
+  const auto file = out_dir / ("llm_api_audit_" + ReportTimestamp() + ".txt");
+
+  ReportFile out(file);
+  if (!out)
+    return {};
+
+  std::ostream &ofs = out.stream();
+  WriteTextHead(ofs, report);
+  for (const auto &line : report.run_logs)
+    ofs << line << "\n";
+  WriteTextSections(ofs, report);
+  JsonWriter json(ofs);
+  WriteReportJson(json, report);
+  ofs << "\n";
   return file.string();
 }
 
 std::string WriteRunLog(const AuditReport &report,
                         const std::filesystem::path &out_dir) {
   std::filesystem::create_directories(out_dir);
-  const auto file = out_dir / ("llm_api_runlog_" + TimestampFile() + ".log");
+  const auto file = out_dir / ("llm_api_runlog_" + ReportTimestamp() + ".log");
 
-  std::ofstream ofs(file, std::ios::out | std::ios::trunc);
-  if (!ofs)
+  ReportFile out(file);
+  if (!out)
     return {};
 
-  ofs << "API-Tester Run Log\n";
-  ofs << "Generated at (UTC): " << report.generated_at_utc << "\n\n";
+  WriteRunLogHead(out.stream(), report);
+  for (const auto &line : report.run_logs)
+    out.stream() << line << "\n";
+  return file.string();
+}
+
+ReportPaths WriteReports(const AuditReport &report,
+                         const std::filesystem::path &reports_dir,
+                         const std::filesystem::path &logs_dir) {
+  std::filesystem::create_directories(reports_dir);
+  if (!logs_dir.empty())
+    std::filesystem::create_directories(logs_dir);
+  const std::string stamp = ReportTimestamp();
+  const auto json_file = reports_dir / ("llm_api_audit_" + stamp + ".json");
+  const auto text_file = reports_dir / ("llm_api_audit_" + stamp + ".txt");
+  // An unopened log file takes the writes below and drops them.
+  const auto log_file =
+      logs_dir.empty() ? std::filesystem::path()
+                       : logs_dir / ("llm_api_runlog_" + stamp + ".log");
+
+  ReportFile json_out(json_file);
+  ReportFile text_out(text_file);
+  ReportFile log_out(log_file);
+  std::ostream &text = text_out.stream();
+  std::ostream &log = log_out.stream();
+
+  WriteTextHead(text, report);
+  WriteRunLogHead(log, report);
   for (const auto &line : report.run_logs) {
-    ofs << line << "\n";
+    text << line << "\n";
+    log << line << "\n";
   }
+  WriteTextSections(text, report);
 
-  return file.string();
+  // The JSON report is serialized once, into its own file and the tail of
+  // the TXT report.
+  TeeBuf tee(json_out.stream().rdbuf(), text.rdbuf());
+  std::ostream both(&tee);
+  std::ostream &json_stream =
+      json_out && text_out ? both : (json_out ? json_out.stream() : text);
+  JsonWriter json(json_stream);
+  WriteReportJson(json, report);
+  json_stream.flush();
+  text << "\n";
+
+  ReportPaths paths;
+  if (json_out)
+    paths.json = json_file.string();
+  if (text_out)
+    paths.text = text_file.string();
+  if (log_out)
+    paths.run_log = log_file.string();
+  return paths;
 }
 
 } // namespace llaudit
@@ -4,11 +4,33 @@
 #include <string>
 
 #include "audit_engine.h"
+#include "json_writer.h"
 
 namespace llaudit {
 
+// Local time as YYYYmmdd_HHMMSS, the stamp in report and journal file names.
+std::string ReportTimestamp();
+
+// Streams the report straight from AuditReport, keys in sorted order as a
+// nlohmann::json object would hold them.
+void WriteReportJson(JsonWriter& out, const AuditReport& report);
+
 std::string WriteJsonReport(const AuditReport& report, const std::filesystem::path& out_dir);
 std::string WriteTextReport(const AuditReport& report, const std::filesystem::path& out_dir);
 std::string WriteRunLog(const AuditReport& report, const std::filesystem::path& out_dir);
 
+// Empty for files that could not be created.
+struct ReportPaths {
+  std::string json;
+  std::string text;
+  std::string run_log;
+};
+
+// Writes the JSON report, the TXT report and the run log under one timestamp.
+// The run logs are walked once for both text files, and the JSON is
+// serialized once into the .json file and the tail of the TXT report. An
+// empty logs_dir skips the run log, for a run that has written its own.
+ReportPaths WriteReports(const AuditReport& report, const std::filesystem::path& reports_dir,
+                         const std::filesystem::path& logs_dir);
+
 }  // namespace llaudit
@@ -0,0 +1,232 @@
+#include "response_store.h"
+
+#include "fnv1a.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <map>
+#include <string_view>
+#include <system_error>
+
+#include <nlohmann/json.hpp>
+
+namespace llaudit {
+namespace {
+
+constexpr int kFormatVersion = 2;
+
+std::string Hex(std::uint64_t h) {
+  static constexpr char kHex[] = "0123456789abcdef";
+  std::string out(16, '0');
+  for (int i = 15; i >= 0; --i) {
+    out[static_cast<std::size_t>(i)] = kHex[h & 0xF];
+    h >>= 4;
+  }
+  return out;
+}
+
+bool IsConditional(const std::string &header) {
+  std::string name = header.substr(0, header.find(':'));
+  std::transform(name.begin(), name.end(), name.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return name == "if-none-match" || name == "if-modified-since";
+}
+
+nlohmann::json HeadersJson(const HeaderTable &headers) {
+  nlohmann::json out = nlohmann::json::object();
+  for (const auto &h : headers)
+    out[std::string(h.name)] = h.value;
+  return out;
+}
+
+bool ReadFile(const std::filesystem::path &file, std::string &out) {
+  std::ifstream ifs(file, std::ios::binary);
+  if (!ifs)
+    return false;
+  out.assign(std::istreambuf_iterator<char>(ifs),
+             std::istreambuf_iterator<char>());
+  return !ifs.bad();
+}
+
+} // namespace
+
+ResponseStore::ResponseStore(std::filesystem::path dir, RecordMode mode)
+    : dir_(std::move(dir)), mode_(mode) {
+  if (mode_ == RecordMode::kReplay) {
+    Load();
+  } else if (mode_ == RecordMode::kRecord) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir_ / "objects", ec);
+    index_.open(dir_ / "index.jsonl", std::ios::out | std::ios::trunc);
+    if (ec || !index_)
+      error_ = "cannot write " + (dir_ / "index.jsonl").string();
+  }
+}
+
+std::string ResponseStore::error() const {
+  std::scoped_lock lock(mutex_);
+  return error_;
+}
+
+std::size_t ResponseStore::size() const {
+  std::scoped_lock lock(mutex_);
+  return count_;
+}
+
+std::string ResponseStore::Fingerprint(const std::string &method,
+                                       const std::string &url,
+                                       const std::vector<std::string> &headers,
+                                       const std::optional<std::string> &body) {
+  std::vector<const std::string *> kept;
+  for (const auto &h : headers) {
+    if (!IsConditional(h))
+      kept.push_back(&h);
+  }
+  std::sort(kept.begin(), kept.end(),
+            [](const std::string *a, const std::string *b) { return *a < *b; });
+
+  // Every part is followed by a NUL so that moving bytes between parts
+  // changes the hash.
+  const std::string_view sep("\0", 1);
+  std::uint64_t h = Fnv1a64(sep, Fnv1a64(method));
+  h = Fnv1a64(sep, Fnv1a64(url, h));
+  for (const auto *header : kept)
+    h = Fnv1a64(sep, Fnv1a64(*header, h));
+  h = Fnv1a64(body ? "B" : "-", h);
+  if (body)
+    h = Fnv1a64(*body, h);
+  return Hex(h);
+}
+
+void ResponseStore::Record(const std::string &fingerprint,
+                           const HttpResponse &response) {
+  if (mode_ != RecordMode::kRecord || response.error == "canceled")
+    return;
+  const std::string hash =
+      response.body.empty() ? "" : Hex(Fnv1a64(response.body));
+  const auto &ph = response.phases;
+  const nlohmann::json line = {
+      {"v", kFormatVersion},
+      {"request", fingerprint},
+      {"status", response.status},
+      {"latency_ms", response.latency_ms},
+      {"phases",
+       {ph.dns_us, ph.connect_us, ph.tls_us, ph.ttfb_us, ph.total_us}},
+      {"reused", response.connection_reused},
+      {"headers", HeadersJson(response.headers)},
+      {"body", hash},
+      {"error", response.error},
+  };
+
+  std::scoped_lock lock(mutex_);
+  if (!index_)
+    return;
+  if (!hash.empty() && objects_.insert(hash).second) {
+    const auto file = dir_ / "objects" / hash;
+    std::error_code ec;
+    if (!std::filesystem::exists(file, ec)) {
+      auto tmp = file;
+      tmp += ".tmp";
+      {
+        std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+        ofs.write(response.body.data(),
+                  static_cast<std::streamsize>(response.body.size()));
+        if (!ofs)
+          error_ = "cannot write " + tmp.string();
+      }
+      std::filesystem::rename(tmp, file, ec);
+      if (ec)
+        error_ = "cannot write " + file.string() + ": " + ec.message();
+    }
+  }
+  index_ << line.dump() << '\n';
+  index_.flush();
+  if (!index_)
+    error_ = "cannot write " + (dir_ / "index.jsonl").string();
+  ++count_;
+}
+
+std::optional<HttpResponse>
+ResponseStore::Replay(const std::string &fingerprint) {
+  if (mode_ != RecordMode::kReplay)
+    return std::nullopt;
+  std::scoped_lock lock(mutex_);
+  auto it = entries_.find(fingerprint);
+  if (it == entries_.end())
+    return std::nullopt;
+  Entry &e = it->second;
+  const std::size_t i = std::min(e.next, e.responses.size() - 1);
+  e.next = i + 1;
+  return e.responses[i];
+}
+
+bool ResponseStore::Load() {
+  const auto index_file = dir_ / "index.jsonl";
+  std::ifstream ifs(index_file);
+  if (!ifs) {
+    error_ = "no recording at " + index_file.string();
+    return false;
+  }
+
+  std::map<std::string, std::string> bodies;
+  std::string line;
+  std::size_t number = 0;
+  while (std::getline(ifs, line)) {
+    ++number;
+    const auto j = nlohmann::json::parse(line, nullptr, false);
+    if (!j.is_object() || j.value("v", 0) != kFormatVersion ||
+        !j.contains("request") || !j["request"].is_string()) {
+      if (!line.empty())
+        error_ = index_file.filename().string() + " line " +
+                 std::to_string(number) + " skipped";
+      continue;
+    }
+
+    HttpResponse r;
+    try {
+      r.status = j.value("status", -1L);
+      r.latency_ms = j.value("latency_ms", -1L);
+      r.connection_reused = j.value("reused", false);
+      r.error = j.value("error", std::string{});
+      if (j.contains("headers") && j["headers"].is_object()) {
+        for (const auto &[name, value] : j["headers"].items())
+          r.headers.Add(name, value.get<std::string>());
+      }
+      if (j.contains("phases") && j["phases"].is_array() &&
+          j["phases"].size() == 5) {
+        const auto &p = j["phases"];
+        r.phases = {p[0].get<long long>(), p[1].get<long long>(),
+                    p[2].get<long long>(), p[3].get<long long>(),
+                    p[4].get<long long>()};
+      }
+    } catch (const std::exception &) {
+      error_ = index_file.filename().string() + " line " +
+               std::to_string(number) + " skipped";
+      continue;
+    }
+
+    const std::string hash = j.value("body", std::string{});
+    if (!hash.empty()) {
+      auto body = bodies.find(hash);
+      if (body == bodies.end()) {
+        std::string bytes;
+        if (!ReadFile(dir_ / "objects" / hash, bytes)) {
+          error_ = "missing body " + hash + " for " + index_file.string() +
+                   " line " + std::to_string(number);
+          continue;
+        }
+        body = bodies.emplace(hash, std::move(bytes)).first;
+      }
+      r.body = body->second;
+    }
+    entries_[j["request"].get<std::string>()].responses.push_back(
+        std::move(r));
+    ++count_;
+  }
+  return error_.empty();
+}
+
+} // namespace llaudit
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "http_client.h"
+
+namespace llaudit {
+
+enum class RecordMode {
+  kOff,
+  kRecord,  // every response is written to the store as it arrives
+  kReplay,  // responses come from the store; the network is never touched
+};
+
+// Responses of one recorded run, keyed by request fingerprint.
+//
+// On disk, dir/index.jsonl holds one line per response in arrival order:
+// fingerprint, status, headers, latency, phases and the hash of the body,
+// which lives in dir/objects/<hash>. Bodies are content addressed, so a
+// catalog or answer that repeats is written once and survives re-recording.
+// The n-th request with a fingerprint gets the n-th response recorded for
+// it, and the last one repeats after that, so retries and job polls replay
+// in order.
+//
+// Record mode starts a fresh index. Replay mode reads the whole store into
+// memory when it is opened. Both are safe to use from several threads.
+class ResponseStore {
+ public:
+  // A disabled store: Record() and Replay() do nothing.
+  ResponseStore() = default;
+  ResponseStore(std::filesystem::path dir, RecordMode mode);
+
+  ResponseStore(const ResponseStore&) = delete;
+  ResponseStore& operator=(const ResponseStore&) = delete;
+
+  RecordMode mode() const { return mode_; }
+  // Why the store could not be opened or written; empty when it is fine.
+  std::string error() const;
+  // Responses read (replay) or written (record) so far.
+  std::size_t size() const;
+
+  // Method, URL, request headers and body, as 16 hex digits. Keys are only
+  // ever hashed into it; the conditional catalog headers are left out, since
+  // they change with the catalog cache between runs.
+  static std::string Fingerprint(const std::string& method, const std::string& url,
+                                 const std::vector<std::string>& headers,
+                                 const std::optional<std::string>& body);
+
+  // Record mode only; a canceled request is not a response and is skipped.
+  void Record(const std::string& fingerprint, const HttpResponse& response);
+  // Replay mode only; nullopt when the request was never recorded.
+  std::optional<HttpResponse> Replay(const std::string& fingerprint);
+
+ private:
+  struct Entry {
+    std::vector<HttpResponse> responses;
+    std::size_t next = 0;
+  };
+
+  bool Load();
+
+  std::filesystem::path dir_;
+  RecordMode mode_ = RecordMode::kOff;
+
+  mutable std::mutex mutex_;
+  std::string error_;
+  std::size_t count_ = 0;
+  std::unordered_map<std::string, Entry> entries_;  // replay
+  std::ofstream index_;                             // record
+  std::set<std::string> objects_;                   // record: bodies on disk
+};
+
+}  // namespace llaudit
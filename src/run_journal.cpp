@@ -0,0 +1,410 @@
+#include "run_journal.h"
+
+#include <iterator>
+#include <string_view>
+
+#if defined(LLAUDIT_HAS_ZSTD)
+#include <zstd.h>
+#endif
+
+namespace llaudit {
+namespace {
+
+constexpr int kIndexVersion = 1;
+
+// CBOR tag 24, "encoded CBOR data item": the record travels as a byte string,
+// so a reader learns its length before decoding it.
+constexpr unsigned char kTag24[] = {0xD8, 0x18};
+
+void AppendCborRecord(std::string &out, const nlohmann::json &record) {
+  const std::vector<std::uint8_t> bytes = nlohmann::json::to_cbor(record);
+  out.append(reinterpret_cast<const char *>(kTag24), sizeof(kTag24));
+  const std::uint64_t n = bytes.size();
+  int width = 0;
+  if (n < 24) {
+    out.push_back(static_cast<char>(0x40 | n));
+  } else if (n <= 0xFF) {
+    out.push_back(static_cast<char>(0x58));
+    width = 1;
+  } else if (n <= 0xFFFF) {
+    out.push_back(static_cast<char>(0x59));
+    width = 2;
+  } else if (n <= 0xFFFFFFFFULL) {
+    out.push_back(static_cast<char>(0x5A));
+    width = 4;
+  } else {
+    out.push_back(static_cast<char>(0x5B));
+    width = 8;
+  }
+  for (int i = width - 1; i >= 0; --i)
+    out.push_back(static_cast<char>((n >> (8 * i)) & 0xFF));
+  out.append(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+}
+
+enum class Decode { kOk, kStopped, kError };
+
+// Decodes every complete record in data. An incomplete record at the end is
+// a torn write and ends the data without an error.
+Decode DecodeRecords(JournalFormat format, std::string_view data,
+                     const JournalRecordFn &fn, std::string &error) {
+  std::size_t pos = 0;
+  while (pos < data.size()) {
+    nlohmann::json record;
+    if (format == JournalFormat::kNdjson) {
+      const std::size_t nl = data.find('\n', pos);
+      if (nl == std::string_view::npos)
+        return Decode::kOk;
+      record = nlohmann::json::parse(data.substr(pos, nl - pos), nullptr,
+                                     false);
+      pos = nl + 1;
+    } else {
+      const auto *p = reinterpret_cast<const unsigned char *>(data.data());
+      if (data.size() - pos < 3)
+        return Decode::kOk;
+      if (p[pos] != kTag24[0] || p[pos + 1] != kTag24[1] ||
+          (p[pos + 2] & 0xE0) != 0x40) {
+        error = "Journal record at byte " + std::to_string(pos) +
+                " is not an encoded CBOR item.";
+        return Decode::kError;
+      }
+      const unsigned info = p[pos + 2] & 0x1F;
+      pos += 3;
+      std::uint64_t n = info;
+      if (info >= 24) {
+        const std::size_t width = info == 24   ? 1
+                                  : info == 25 ? 2
+                                  : info == 26 ? 4
+                                               : 8;
+        if (data.size() - pos < width)
+          return Decode::kOk;
+        n = 0;
+        for (std::size_t i = 0; i < width; ++i)
+          n = (n << 8) | p[pos + i];
+        pos += width;
+      }
+      if (data.size() - pos < n)
+        return Decode::kOk;
+      record = nlohmann::json::from_cbor(p + pos, p + pos + n, true, false);
+      pos += static_cast<std::size_t>(n);
+    }
+    if (record.is_discarded()) {
+      error = "Journal record ending at byte " + std::to_string(pos) +
+              " does not decode.";
+      return Decode::kError;
+    }
+    if (!fn(record))
+      return Decode::kStopped;
+  }
+  return Decode::kOk;
+}
+
+bool ReadFile(const std::filesystem::path &path, std::string &out,
+              std::string &error) {
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs) {
+    error = "Cannot open " + path.string();
+    return false;
+  }
+  out.assign(std::istreambuf_iterator<char>(ifs),
+             std::istreambuf_iterator<char>());
+  return true;
+}
+
+bool IsCompressedPath(const std::filesystem::path &path) {
+  return path.extension() == ".zst";
+}
+
+JournalFormat FormatOfPath(std::filesystem::path path) {
+  if (IsCompressedPath(path))
+    path.replace_extension();
+  return path.extension() == ".cbor" ? JournalFormat::kCbor
+                                     : JournalFormat::kNdjson;
+}
+
+#if defined(LLAUDIT_HAS_ZSTD)
+// Size of the complete zstd frame at the start of data, or 0 if it is torn.
+std::size_t FrameSize(std::string_view data) {
+  const std::size_t n = ZSTD_findFrameCompressedSize(data.data(), data.size());
+  return ZSTD_isError(n) ? 0 : n;
+}
+
+bool DecompressFrame(std::string_view frame, std::string &out,
+                     std::string &error) {
+  const unsigned long long size =
+      ZSTD_getFrameContentSize(frame.data(), frame.size());
+  if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN) {
+    error = "Journal block has no content size.";
+    return false;
+  }
+  out.resize(static_cast<std::size_t>(size));
+  const std::size_t n =
+      ZSTD_decompress(out.data(), out.size(), frame.data(), frame.size());
+  if (ZSTD_isError(n)) {
+    error = std::string("Journal block does not decompress: ") +
+            ZSTD_getErrorName(n);
+    return false;
+  }
+  out.resize(n);
+  return true;
+}
+#endif
+
+} // namespace
+
+RunJournal::RunJournal(std::filesystem::path path, JournalOptions options)
+    : path_(std::move(path)), options_(options), last_write_(Clock::now()) {
+  if (!CompressionAvailable())
+    options_.compress = false;
+  std::error_code ec;
+  std::filesystem::create_directories(path_.parent_path(), ec);
+  out_.open(path_, std::ios::out | std::ios::trunc | std::ios::binary);
+  index_.open(index_path(), std::ios::out | std::ios::trunc);
+  if (!out_ || !index_) {
+    error_ = "Cannot create journal " + path_.string();
+    return;
+  }
+  index_ << nlohmann::json{
+                {"version", kIndexVersion},
+                {"format", options_.format == JournalFormat::kCbor ? "cbor"
+                                                                   : "ndjson"},
+                {"compression", options_.compress ? "zstd" : "none"},
+            }
+                .dump()
+         << "\n";
+  index_.flush();
+}
+
+RunJournal::~RunJournal() { Close(); }
+
+bool RunJournal::ok() const {
+  std::scoped_lock lock(mutex_);
+  return error_.empty();
+}
+
+std::string RunJournal::error() const {
+  std::scoped_lock lock(mutex_);
+  return error_;
+}
+
+std::filesystem::path RunJournal::index_path() const {
+  return path_.string() + ".idx";
+}
+
+bool RunJournal::CompressionAvailable() {
+#if defined(LLAUDIT_HAS_ZSTD)
+  return true;
+#else
+  return false;
+#endif
+}
+
+std::string RunJournal::Extension(const JournalOptions &options) {
+  std::string ext =
+      options.format == JournalFormat::kCbor ? ".cbor" : ".ndjson";
+  if (options.compress && CompressionAvailable())
+    ext += ".zst";
+  return ext;
+}
+
+void RunJournal::Append(const nlohmann::json &record) {
+  std::scoped_lock lock(mutex_);
+  if (!error_.empty() || closed_)
+    return;
+
+  if (pending_.records == 0)
+    pending_.first_record = records_;
+  if (options_.format == JournalFormat::kCbor) {
+    AppendCborRecord(block_, record);
+  } else {
+    block_ += record.dump(-1, ' ', false,
+                          nlohmann::json::error_handler_t::replace);
+    block_ += '\n';
+  }
+  pending_.records += 1;
+  records_ += 1;
+
+  // A finished provider is written at once; otherwise a crash loses at most
+  // flush_interval_ms of traces.
+  const std::string type = record.value("type", "");
+  if (type == "provider")
+    pending_.providers.push_back(record.value("provider_id", "") + "#" +
+                                 std::to_string(record.value("key_index", 0)));
+  const bool due =
+      Clock::now() - last_write_ >=
+      std::chrono::milliseconds(options_.flush_interval_ms);
+  if (type == "provider" || type == "run_end" ||
+      block_.size() >= options_.block_bytes || due)
+    WriteBlockLocked();
+}
+
+void RunJournal::Flush() {
+  std::scoped_lock lock(mutex_);
+  WriteBlockLocked();
+}
+
+void RunJournal::Close() {
+  std::scoped_lock lock(mutex_);
+  if (closed_)
+    return;
+  WriteBlockLocked();
+  closed_ = true;
+  if (!error_.empty())
+    return;
+  index_ << nlohmann::json{{"closed", true}, {"records", records_}}.dump()
+         << "\n";
+  index_.flush();
+}
+
+void RunJournal::WriteBlockLocked() {
+  last_write_ = Clock::now();
+  if (pending_.records == 0 || !error_.empty())
+    return;
+
+  std::string_view bytes = block_;
+#if defined(LLAUDIT_HAS_ZSTD)
+  std::string frame;
+  if (options_.compress) {
+    frame.resize(ZSTD_compressBound(block_.size()));
+    const std::size_t n =
+        ZSTD_compress(frame.data(), frame.size(), block_.data(), block_.size(),
+                      options_.compression_level);
+    if (ZSTD_isError(n)) {
+      error_ = std::string("zstd: ") + ZSTD_getErrorName(n);
+      return;
+    }
+    frame.resize(n);
+    bytes = frame;
+  }
+#endif
+
+  out_.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  out_.flush();
+  if (!out_) {
+    error_ = "Write to journal " + path_.string() + " failed.";
+    return;
+  }
+
+  pending_.offset = offset_;
+  pending_.bytes = bytes.size();
+  offset_ += bytes.size();
+  index_ << nlohmann::json{
+                {"offset", pending_.offset},
+                {"bytes", pending_.bytes},
+                {"first_record", pending_.first_record},
+                {"records", pending_.records},
+                {"providers", pending_.providers},
+            }
+                .dump()
+         << "\n";
+  index_.flush();
+
+  block_.clear();
+  pending_ = {};
+}
+
+bool ReadJournal(const std::filesystem::path &path, const JournalRecordFn &fn,
+                 std::string &error) {
+  std::string data;
+  if (!ReadFile(path, data, error))
+    return false;
+  const JournalFormat format = FormatOfPath(path);
+  if (!IsCompressedPath(path))
+    return DecodeRecords(format, data, fn, error) != Decode::kError;
+
+#if defined(LLAUDIT_HAS_ZSTD)
+  std::string_view rest = data;
+  std::string block;
+  while (!rest.empty()) {
+    const std::size_t n = FrameSize(rest);
+    if (n == 0)
+      break;
+    if (!DecompressFrame(rest.substr(0, n), block, error))
+      return false;
+    const Decode d = DecodeRecords(format, block, fn, error);
+    if (d == Decode::kError)
+      return false;
+    if (d == Decode::kStopped)
+      break;
+    rest.remove_prefix(n);
+  }
+  return true;
+#else
+  error = "This build cannot read zstd journals.";
+  return false;
+#endif
+}
+
+bool ReadJournalIndex(const std::filesystem::path &path, JournalIndex &index,
+                      std::string &error) {
+  std::ifstream ifs(path.string() + ".idx");
+  if (!ifs) {
+    error = "Cannot open the index of " + path.string();
+    return false;
+  }
+  index = {};
+  std::string line;
+  bool header = true;
+  while (std::getline(ifs, line)) {
+    const auto j = nlohmann::json::parse(line, nullptr, false);
+    if (!j.is_object())
+      break; // torn last line
+    if (header) {
+      if (j.value("version", 0) != kIndexVersion) {
+        error = "Unsupported journal index version.";
+        return false;
+      }
+      index.format = j.value("format", "") == "cbor" ? JournalFormat::kCbor
+                                                     : JournalFormat::kNdjson;
+      index.compressed = j.value("compression", "") == "zstd";
+      header = false;
+    } else if (j.contains("closed")) {
+      index.closed = j.value("closed", false);
+      index.records = j.value("records", index.records);
+    } else {
+      JournalBlock b;
+      b.offset = j.value("offset", std::uint64_t{0});
+      b.bytes = j.value("bytes", std::uint64_t{0});
+      b.first_record = j.value("first_record", std::uint64_t{0});
+      b.records = j.value("records", std::uint64_t{0});
+      b.providers = j.value("providers", std::vector<std::string>{});
+      index.records = b.first_record + b.records;
+      index.blocks.push_back(std::move(b));
+    }
+  }
+  if (header) {
+    error = "Journal index is empty.";
+    return false;
+  }
+  return true;
+}
+
+bool ReadJournalBlock(const std::filesystem::path &path,
+                      const JournalIndex &index, const JournalBlock &block,
+                      const JournalRecordFn &fn, std::string &error) {
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs) {
+    error = "Cannot open " + path.string();
+    return false;
+  }
+  std::string data(static_cast<std::size_t>(block.bytes), '\0');
+  ifs.seekg(static_cast<std::streamoff>(block.offset));
+  if (!ifs.read(data.data(), static_cast<std::streamsize>(data.size()))) {
+    error = "Journal block at " + std::to_string(block.offset) +
+            " is past the end of the file.";
+    return false;
+  }
+  if (!index.compressed)
+    return DecodeRecords(index.format, data, fn, error) != Decode::kError;
+
+#if defined(LLAUDIT_HAS_ZSTD)
+  std::string records;
+  if (!DecompressFrame(data, records, error))
+    return false;
+  return DecodeRecords(index.format, records, fn, error) != Decode::kError;
+#else
+  error = "This build cannot read zstd journals.";
+  return false;
+#endif
+}
+
+} // namespace llaudit
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace llaudit {
+
+enum class JournalFormat {
+  kNdjson,  // one JSON object per line
+  kCbor,    // RFC 8742 CBOR sequence; each record wrapped in tag 24
+};
+
+struct JournalOptions {
+  JournalFormat format = JournalFormat::kNdjson;
+  // Each block becomes one zstd frame. Ignored when built without zstd.
+  bool compress = false;
+  int compression_level = 3;
+  // A block is written once it holds this many bytes, once this long has
+  // passed since the last write, or when Flush() is called.
+  std::size_t block_bytes = 64 * 1024;
+  long long flush_interval_ms = 1000;
+};
+
+// One written block, as listed in the index.
+struct JournalBlock {
+  std::uint64_t offset = 0;
+  std::uint64_t bytes = 0;  // on disk, compressed if the journal is
+  std::uint64_t first_record = 0;
+  std::uint64_t records = 0;
+  // "provider_id#key_index" of each provider record in the block.
+  std::vector<std::string> providers;
+};
+
+struct JournalIndex {
+  JournalFormat format = JournalFormat::kNdjson;
+  bool compressed = false;
+  std::vector<JournalBlock> blocks;
+  bool closed = false;  // false if the writer never finished
+  std::uint64_t records = 0;
+};
+
+using JournalRecordFn = std::function<bool(const nlohmann::json& record)>;
+
+// Append-only record file written while an audit runs. Records are grouped
+// into blocks, and each block is written and flushed in one go together with
+// its line in the "<path>.idx" index, so after a crash every complete block
+// is readable and a torn last block is skipped. Safe to call from several
+// threads.
+class RunJournal {
+ public:
+  RunJournal(std::filesystem::path path, JournalOptions options = {});
+  ~RunJournal();
+
+  RunJournal(const RunJournal&) = delete;
+  RunJournal& operator=(const RunJournal&) = delete;
+
+  bool ok() const;
+  std::string error() const;
+  const std::filesystem::path& path() const { return path_; }
+  std::filesystem::path index_path() const;
+
+  void Append(const nlohmann::json& record);
+  // Writes the pending block, if any.
+  void Flush();
+  // Flushes and marks the index complete. Called by the destructor.
+  void Close();
+
+  static bool CompressionAvailable();
+  // ".ndjson" or ".cbor", plus ".zst" when the options compress.
+  static std::string Extension(const JournalOptions& options);
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  void WriteBlockLocked();
+
+  std::filesystem::path path_;
+  JournalOptions options_;
+  mutable std::mutex mutex_;
+  std::ofstream out_;
+  std::ofstream index_;
+  std::string error_;
+  bool closed_ = false;
+
+  std::string block_;
+  JournalBlock pending_;
+  std::uint64_t offset_ = 0;
+  std::uint64_t records_ = 0;
+  Clock::time_point last_write_;
+};
+
+// Reads a journal front to back without needing its index. Stops quietly at
+// a torn tail; returns false only if the file cannot be read or a complete
+// record does not decode. The callback returns false to stop early.
+bool ReadJournal(const std::filesystem::path& path, const JournalRecordFn& fn,
+                 std::string& error);
+bool ReadJournalIndex(const std::filesystem::path& path, JournalIndex& index,
+                      std::string& error);
+// Decodes a single block located through the index.
+bool ReadJournalBlock(const std::filesystem::path& path, const JournalIndex& index,
+                      const JournalBlock& block, const JournalRecordFn& fn, std::string& error);
+
+}  // namespace llaudit
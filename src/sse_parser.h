@@ -0,0 +1,75 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace llaudit {
+
+// Incremental text/event-stream parser. Feed() takes body chunks split at any
+// byte and calls on_event once per complete event with its data field
+// (multi-line data joined with '\n'). Bare JSON lines, which Cohere's v1 chat
+// stream sends instead of SSE, are passed through as one event each.
+class SseParser {
+ public:
+  using EventFn = std::function<void(std::string_view data)>;
+
+  explicit SseParser(EventFn on_event) : on_event_(std::move(on_event)) {}
+
+  void Feed(std::string_view chunk) {
+    pending_.append(chunk);
+    std::size_t start = 0;
+    for (;;) {
+      const auto nl = pending_.find('\n', start);
+      if (nl == std::string::npos) break;
+      Line(std::string_view(pending_).substr(start, nl - start));
+      start = nl + 1;
+    }
+    pending_.erase(0, start);
+  }
+
+  // Flushes a trailing line and event that were not newline-terminated.
+  void Finish() {
+    if (!pending_.empty()) {
+      const std::string last = std::move(pending_);
+      pending_.clear();
+      Line(last);
+    }
+    Dispatch();
+  }
+
+ private:
+  void Line(std::string_view line) {
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    if (line.empty()) {
+      Dispatch();
+      return;
+    }
+    if (line.front() == '{') {
+      on_event_(line);
+      return;
+    }
+    // Comments and the event/id/retry fields carry nothing we use.
+    if (line.substr(0, 5) != "data:") return;
+    line.remove_prefix(5);
+    if (!line.empty() && line.front() == ' ') line.remove_prefix(1);
+    if (has_data_) data_ += '\n';
+    data_.append(line);
+    has_data_ = true;
+  }
+
+  void Dispatch() {
+    if (!has_data_) return;
+    on_event_(data_);
+    data_.clear();
+    has_data_ = false;
+  }
+
+  EventFn on_event_;
+  std::string pending_;
+  std::string data_;
+  bool has_data_ = false;
+};
+
+}  // namespace llaudit
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace llaudit {
+
+// Maps repeated strings (header names, steps, URLs) to small dense ids.
+// Each distinct string is stored once; ids stay valid for the interner's
+// lifetime and survive copies.
+class StringInterner {
+ public:
+  using Id = std::uint32_t;
+
+  Id Intern(std::string_view s) {
+    if (const auto it = ids_.find(s); it != ids_.end()) return it->second;
+    const auto id = static_cast<Id>(strings_.size());
+    strings_.emplace_back(s);
+    ids_.emplace(strings_.back(), id);
+    return id;
+  }
+
+  const std::string& Get(Id id) const { return strings_[id]; }
+  std::size_t size() const { return strings_.size(); }
+
+ private:
+  struct Hash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+  };
+
+  std::vector<std::string> strings_;
+  std::unordered_map<std::string, Id, Hash, std::equal_to<>> ids_;
+};
+
+}  // namespace llaudit
@@ -0,0 +1,186 @@
+#include "trace_store.h"
+
+#include <algorithm>
+
+namespace llaudit {
+namespace {
+
+bool IsError(const RequestTrace &t) {
+  const bool ok = (t.status >= 200 && t.status < 300) || t.status == 304;
+  return !ok || !t.error.empty() || t.state != "completed";
+}
+
+} // namespace
+
+TraceStore::Span TraceStore::Store(std::string_view s) {
+  Span span{static_cast<std::uint32_t>(arena_.size()),
+            static_cast<std::uint32_t>(s.size())};
+  arena_.append(s);
+  return span;
+}
+
+std::string_view TraceStore::View(Span span) const {
+  return std::string_view(arena_).substr(span.offset, span.size);
+}
+
+void TraceStore::Add(const RequestTrace &trace) {
+  const auto seq = static_cast<std::uint32_t>(status_.size());
+  const bool error = IsError(trace);
+  std::uint8_t flags = 0;
+  if (trace.connection_reused)
+    flags |= kConnectionReused;
+  if (trace.state == "throttled")
+    flags |= kThrottled;
+  if (error)
+    flags |= kError;
+  step_.push_back(strings_.Intern(trace.step));
+  status_.push_back(static_cast<std::int32_t>(trace.status));
+  latency_ms_.push_back(static_cast<std::int32_t>(trace.latency_ms));
+  flags_.push_back(flags);
+
+  if (seq < static_cast<std::uint32_t>(std::max(retention_.first, 0))) {
+    Keep(trace, seq);
+    return;
+  }
+  if (error) {
+    if (retention_.errors < 0 || errors_kept_ < retention_.errors) {
+      Keep(trace, seq);
+      errors_kept_ += 1;
+    }
+    return;
+  }
+  if (retention_.slowest <= 0)
+    return;
+
+  // Min-heap on latency: the root is the fastest of the slow set.
+  const auto slower = [this](std::uint32_t a, std::uint32_t b) {
+    return latency_ms_[details_[a].seq] > latency_ms_[details_[b].seq];
+  };
+  if (slow_heap_.size() >= static_cast<std::size_t>(retention_.slowest)) {
+    if (trace.latency_ms <= latency_ms_[details_[slow_heap_.front()].seq])
+      return;
+    std::pop_heap(slow_heap_.begin(), slow_heap_.end(), slower);
+    Evict(slow_heap_.back());
+    slow_heap_.pop_back();
+  }
+  slow_heap_.push_back(Keep(trace, seq));
+  std::push_heap(slow_heap_.begin(), slow_heap_.end(), slower);
+}
+
+std::uint32_t TraceStore::Keep(const RequestTrace &trace, std::uint32_t seq) {
+  std::uint32_t slot;
+  if (!free_.empty()) {
+    slot = free_.back();
+    free_.pop_back();
+  } else {
+    slot = static_cast<std::uint32_t>(details_.size());
+    details_.emplace_back();
+  }
+
+  Detail &d = details_[slot];
+  d.live = true;
+  d.seq = seq;
+  d.method = strings_.Intern(trace.method);
+  d.url = strings_.Intern(trace.url);
+  d.phases = trace.phases;
+  d.attempt = trace.attempt;
+  d.paced_ms = trace.paced_ms;
+  d.backoff_ms = trace.backoff_ms;
+  d.snippet = Store(trace.response_snippet);
+  d.error = Store(trace.error);
+  d.headers.clear();
+  for (const auto &h : trace.rate_limit_headers)
+    d.headers.push_back({strings_.Intern(h.name), Store(h.value)});
+  return slot;
+}
+
+void TraceStore::Evict(std::uint32_t slot) {
+  Detail &d = details_[slot];
+  d.live = false;
+  arena_garbage_ += d.snippet.size + d.error.size;
+  for (const auto &h : d.headers)
+    arena_garbage_ += h.value.size;
+  free_.push_back(slot);
+  if (arena_garbage_ > 4096 && arena_garbage_ * 2 > arena_.size())
+    Compact();
+}
+
+void TraceStore::Compact() {
+  std::string fresh;
+  fresh.reserve(arena_.size() - arena_garbage_);
+  auto relocate = [&](Span &span) {
+    const auto offset = static_cast<std::uint32_t>(fresh.size());
+    fresh.append(View(span));
+    span.offset = offset;
+  };
+  for (auto &d : details_) {
+    if (!d.live)
+      continue;
+    relocate(d.snippet);
+    relocate(d.error);
+    for (auto &h : d.headers)
+      relocate(h.value);
+  }
+  arena_ = std::move(fresh);
+  arena_garbage_ = 0;
+}
+
+RequestTrace TraceStore::Materialize(const Detail &d) const {
+  RequestTrace t;
+  t.seq = d.seq;
+  t.step = strings_.Get(step_[d.seq]);
+  t.method = strings_.Get(d.method);
+  t.url = strings_.Get(d.url);
+  t.status = status_[d.seq];
+  t.latency_ms = latency_ms_[d.seq];
+  t.phases = d.phases;
+  t.connection_reused = (flags_[d.seq] & kConnectionReused) != 0;
+  for (const auto &h : d.headers)
+    t.rate_limit_headers.Add(strings_.Get(h.name), View(h.value));
+  t.response_snippet = View(d.snippet);
+  t.error = View(d.error);
+  t.state = (flags_[d.seq] & kThrottled) != 0 ? "throttled" : "completed";
+  t.attempt = d.attempt;
+  t.paced_ms = d.paced_ms;
+  t.backoff_ms = d.backoff_ms;
+  return t;
+}
+
+std::vector<RequestTrace> TraceStore::Retained() const {
+  std::vector<const Detail *> live;
+  live.reserve(retained());
+  for (const auto &d : details_) {
+    if (d.live)
+      live.push_back(&d);
+  }
+  std::sort(live.begin(), live.end(),
+            [](const Detail *a, const Detail *b) { return a->seq < b->seq; });
+
+  std::vector<RequestTrace> out;
+  out.reserve(live.size());
+  for (const Detail *d : live)
+    out.push_back(Materialize(*d));
+  return out;
+}
+
+std::vector<TraceStepSummary> TraceStore::StepSummary() const {
+  std::vector<TraceStepSummary> out;
+  std::vector<int> index_of(strings_.size(), -1);
+  for (std::size_t i = 0; i < step_.size(); ++i) {
+    int &index = index_of[step_[i]];
+    if (index < 0) {
+      index = static_cast<int>(out.size());
+      out.emplace_back().step = strings_.Get(step_[i]);
+    }
+    auto &s = out[static_cast<std::size_t>(index)];
+    s.count += 1;
+    if ((flags_[i] & kError) != 0)
+      s.errors += 1;
+    s.status_counts[status_[i]] += 1;
+    if (latency_ms_[i] >= 0)
+      s.latency_ms_sum += latency_ms_[i];
+  }
+  return out;
+}
+
+} // namespace llaudit
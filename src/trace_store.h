@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "http_client.h"
+#include "string_interner.h"
+
+namespace llaudit {
+
+struct RequestTrace {
+  std::size_t seq = 0;  // position among every request the provider made
+  std::string step;
+  std::string method;
+  std::string url;
+  long status = -1;
+  long latency_ms = -1;
+  LatencyPhases phases;
+  bool connection_reused = false;
+  HeaderTable rate_limit_headers;
+  std::string response_snippet;
+  std::string error;
+  // "completed", or "throttled" for a 429/503 that was retried after backoff.
+  std::string state = "completed";
+  int attempt = 1;
+  long long paced_ms = 0;  // held by the rate limiter before sending
+  long long backoff_ms = 0;
+};
+
+// Which traces keep their full detail. A trace counts as an error when it
+// failed, was throttled or got no 2xx/304 response.
+struct TraceRetention {
+  int first = 100;    // the earliest traces, whatever their outcome
+  int slowest = 50;   // highest latency among the other successful traces
+  int errors = -1;    // -1 keeps every error trace
+};
+
+// Per-step totals over every recorded trace, retained or not.
+struct TraceStepSummary {
+  std::string step;
+  int count = 0;
+  int errors = 0;
+  std::map<long, int> status_counts;
+  long long latency_ms_sum = 0;
+};
+
+// All requests of one provider audit. Step, status, latency and outcome of
+// every trace live in fixed-size columns; URL, method, headers, snippet and
+// error text are kept only for the traces the retention policy selects.
+// Strings that repeat (steps, methods, URLs, header names) are interned, and
+// snippets, errors and header values share one byte arena that is compacted
+// once evicted slow traces leave it half empty.
+class TraceStore {
+ public:
+  explicit TraceStore(TraceRetention retention = {}) : retention_(retention) {}
+
+  void Add(const RequestTrace& trace);
+
+  std::size_t size() const { return status_.size(); }
+  std::size_t retained() const { return details_.size() - free_.size(); }
+
+  // Retained traces in recording order.
+  std::vector<RequestTrace> Retained() const;
+  // In order of first appearance.
+  std::vector<TraceStepSummary> StepSummary() const;
+
+ private:
+  struct Span {
+    std::uint32_t offset = 0;
+    std::uint32_t size = 0;
+  };
+  struct Header {
+    StringInterner::Id name = 0;
+    Span value;
+  };
+  struct Detail {
+    bool live = false;
+    std::uint32_t seq = 0;
+    StringInterner::Id method = 0;
+    StringInterner::Id url = 0;
+    LatencyPhases phases;
+    std::int32_t attempt = 1;
+    std::int64_t paced_ms = 0;
+    std::int64_t backoff_ms = 0;
+    Span snippet;
+    Span error;
+    std::vector<Header> headers;
+  };
+
+  enum Flags : std::uint8_t {
+    kConnectionReused = 1,
+    kThrottled = 2,
+    kError = 4,
+  };
+
+  Span Store(std::string_view s);
+  std::string_view View(Span span) const;
+  std::uint32_t Keep(const RequestTrace& trace, std::uint32_t seq);
+  void Evict(std::uint32_t slot);
+  void Compact();
+  RequestTrace Materialize(const Detail& d) const;
+
+  TraceRetention retention_;
+  StringInterner strings_;
+
+  // One entry per recorded trace.
+  std::vector<StringInterner::Id> step_;
+  std::vector<std::int32_t> status_;
+  std::vector<std::int32_t> latency_ms_;
+  std::vector<std::uint8_t> flags_;
+
+  std::vector<Detail> details_;
+  std::vector<std::uint32_t> free_;       // evicted detail slots
+  std::vector<std::uint32_t> slow_heap_;  // min-heap of slots by latency
+  int errors_kept_ = 0;
+  std::string arena_;
+  std::size_t arena_garbage_ = 0;
+};
+
+}  // namespace llaudit
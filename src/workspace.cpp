@@ -0,0 +1,277 @@
+#include "workspace.h"
+#include "history_store.h"
+#include "provider_registry.h"
+#include "report_writer.h"
+#include "run_journal.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+
+#include <nlohmann/json.hpp>
+
+namespace llaudit {
+namespace {
+
+std::string Trim(std::string s) {
+  auto not_space = [](unsigned char c) { return !std::isspace(c); };
+  s.erase(s.begin(), std::find_if(s.begin(), s.end(), not_space));
+  s.erase(std::find_if(s.rbegin(), s.rend(), not_space).base(), s.end());
+  return s;
+}
+
+std::filesystem::path WorkspaceHintPath() {
+  const char *home = std::getenv("HOME");
+  if (home && *home)
+    return std::filesystem::path(home) / ".api_tester" / "last_workspace.txt";
+  return std::filesystem::path(".api_tester") / "last_workspace.txt";
+}
+
+} // namespace
+
+std::vector<KeyField> KeyFieldsFor(const std::vector<ProviderSpec> &providers) {
+  std::vector<KeyField> out;
+  out.reserve(providers.size());
+  for (const auto &spec : providers)
+    out.push_back({spec.id,
+                   spec.key_label.empty() ? spec.name + " API Key"
+                                          : spec.key_label,
+                   ""});
+  return out;
+}
+
+std::vector<KeyField> DefaultKeyFields() {
+  return KeyFieldsFor(BuiltinProviders());
+}
+
+WorkspacePaths BuildPaths(const std::string &workspace_input) {
+  WorkspacePaths out;
+  out.root_dir =
+      std::filesystem::absolute(std::filesystem::path(workspace_input));
+  out.config_file = out.root_dir / "config" / "api_keys.json";
+  out.providers_file = out.root_dir / "config" / "providers.json";
+  out.suites_dir = out.root_dir / "suites";
+  out.reports_dir = out.root_dir / "reports";
+  out.logs_dir = out.root_dir / "logs";
+  out.cache_dir = out.root_dir / "cache";
+  out.history_dir = out.root_dir / "history";
+  return out;
+}
+
+bool EnsureWorkspace(const WorkspacePaths &paths, std::string &error) {
+  try {
+    std::filesystem::create_directories(paths.root_dir);
+    std::filesystem::create_directories(paths.config_file.parent_path());
+    std::filesystem::create_directories(paths.reports_dir);
+    std::filesystem::create_directories(paths.logs_dir);
+    std::filesystem::create_directories(paths.cache_dir);
+    std::filesystem::create_directories(paths.history_dir);
+    return true;
+  } catch (const std::exception &ex) {
+    error = ex.what();
+    return false;
+  }
+}
+
+bool SaveWorkspaceHint(const std::string &workspace, std::string &error) {
+  try {
+    const auto hint = WorkspaceHintPath();
+    std::filesystem::create_directories(hint.parent_path());
+    std::ofstream ofs(hint, std::ios::out | std::ios::trunc);
+    if (!ofs) {
+      error = "Failed to open workspace hint file for writing.";
+      return false;
+    }
+    ofs << workspace;
+    return true;
+  } catch (const std::exception &ex) {
+    error = ex.what();
+    return false;
+  }
+}
+
+bool LoadWorkspaceHint(std::string &workspace, std::string &error) {
+  try {
+    const auto hint = WorkspaceHintPath();
+    if (!std::filesystem::exists(hint))
+      return true;
+    std::ifstream ifs(hint);
+    if (!ifs) {
+      error = "Failed to open workspace hint file for reading.";
+      return false;
+    }
+    std::string content;
+    std::getline(ifs, content);
+    workspace = Trim(content);
+    return true;
+  } catch (const std::exception &ex) {
+    error = ex.what();
+    return false;
+  }
+}
+
+bool SaveConfig(const std::vector<KeyField> &fields,
+                const std::filesystem::path &config_file, std::string &error) {
+  try {
+    std::filesystem::create_directories(config_file.parent_path());
+    nlohmann::json j;
+    for (const auto &field : fields)
+      j[field.id] = field.value;
+    std::ofstream ofs(config_file, std::ios::out | std::ios::trunc);
+    if (!ofs) {
+      error = "Failed to open config file for writing.";
+      return false;
+    }
+    ofs << j.dump(2);
+    return true;
+  } catch (const std::exception &ex) {
+    error = ex.what();
+    return false;
+  }
+}
+
+bool LoadConfig(std::vector<KeyField> &fields,
+                const std::filesystem::path &config_file, std::string &error) {
+  try {
+    if (!std::filesystem::exists(config_file))
+      return true;
+    std::ifstream ifs(config_file);
+    if (!ifs) {
+      error = "Failed to open config file for reading.";
+      return false;
+    }
+    nlohmann::json j = nlohmann::json::parse(ifs, nullptr, false);
+    if (!j.is_object()) {
+      error = "Config file JSON is invalid.";
+      return false;
+    }
+    for (auto &field : fields) {
+      if (!j.contains(field.id))
+        continue;
+      const auto &v = j[field.id];
+      if (v.is_string()) {
+        field.value = v.get<std::string>();
+      } else if (v.is_array()) {
+        // A key pool: ["k1", "k2"] or [{"key": "k1", "tier": "free"}, ...].
+        std::string joined;
+        for (const auto &item : v) {
+          std::string entry;
+          if (item.is_string()) {
+            entry = item.get<std::string>();
+          } else if (item.is_object() && item.contains("key") &&
+                     item["key"].is_string()) {
+            entry = item["key"].get<std::string>();
+            if (item.contains("tier") && item["tier"].is_string() &&
+                !item["tier"].get<std::string>().empty())
+              entry += "@" + item["tier"].get<std::string>();
+          }
+          if (entry.empty())
+            continue;
+          if (!joined.empty())
+            joined += ", ";
+          joined += entry;
+        }
+        field.value = joined;
+      }
+    }
+    return true;
+  } catch (const std::exception &ex) {
+    error = ex.what();
+    return false;
+  }
+}
+
+KeyPools KeysToPools(const std::vector<KeyField> &fields) {
+  KeyPools out;
+  for (const auto &field : fields)
+    out[field.id] = ParseKeyList(field.value);
+  return out;
+}
+
+bool LoadWorkspaceProviders(const WorkspacePaths &paths,
+                            std::vector<ProviderSpec> &providers,
+                            std::string &error) {
+  providers = BuiltinProviders();
+  std::error_code ec;
+  if (!std::filesystem::exists(paths.providers_file, ec))
+    return true;
+  return LoadProviderRegistry(paths.providers_file, providers, error);
+}
+
+WorkspaceRun RunWorkspaceAudit(const WorkspacePaths &paths,
+                               const KeyPools &keys,
+                               const WorkspaceRunOptions &options,
+                               const LogFn &log,
+                               const std::atomic<bool> &cancel_requested) {
+  AuditOptions audit_options;
+  audit_options.catalog_cache_dir = (paths.cache_dir / "catalogs").string();
+  audit_options.checkpoint_dir = (paths.cache_dir / "checkpoints").string();
+  audit_options.resume = options.resume;
+  audit_options.batch.enabled = options.batch;
+  audit_options.record_mode = options.record;
+  audit_options.record_dir = (paths.cache_dir / "responses").string();
+  audit_options.replay_latency = options.replay_latency;
+  audit_options.metrics = options.metrics;
+  audit_options.live = options.live;
+  audit_options.initial_rate_limits = options.initial_rate_limits;
+  WorkspaceRun out;
+  if (!LoadWorkspaceProviders(paths, audit_options.providers,
+                              out.providers_error) &&
+      log)
+    log("Provider registry ignored: " + out.providers_error);
+  if (options.only_keyed_providers)
+    std::erase_if(audit_options.providers, [&keys](const ProviderSpec &spec) {
+      const auto it = keys.find(spec.id);
+      return it == keys.end() || it->second.empty();
+    });
+  if (!LoadPromptSuites(paths.suites_dir, audit_options.prompt_suites,
+                        out.suites_error) &&
+      log)
+    log("Prompt suites ignored: " + out.suites_error);
+  AuditEngine engine(audit_options);
+
+  // Written as results arrive, so a crash still leaves a readable partial
+  // run.
+  std::unique_ptr<RunJournal> journal;
+  RecordFn record;
+  if (options.journal) {
+    JournalOptions journal_options;
+    journal_options.compress = RunJournal::CompressionAvailable();
+    journal = std::make_unique<RunJournal>(
+        paths.reports_dir / ("llm_api_audit_" + ReportTimestamp() +
+                             RunJournal::Extension(journal_options)),
+        journal_options);
+    record = [&journal](const nlohmann::json &r) { journal->Append(r); };
+  }
+  if (options.on_record)
+    record = [&journal, &options](const nlohmann::json &r) {
+      if (journal)
+        journal->Append(r);
+      options.on_record(r);
+    };
+
+  out.report = std::make_shared<const AuditReport>(
+      engine.Run(keys, log, cancel_requested, record));
+  if (journal) {
+    journal->Close();
+    out.journal_path = journal->path().string();
+    if (!journal->ok())
+      out.journal_error = journal->error();
+  }
+
+  out.run_log_path = WriteRunLog(*out.report, paths.logs_dir);
+
+  // A canceled run is partial and would skew the trends, and a replay
+  // repeats a run history already has, so neither is recorded.
+  if (options.history && !cancel_requested.load() &&
+      options.record != RecordMode::kReplay) {
+    HistoryStore history(paths.history_dir);
+    out.history_delta = BuildHistoryDeltaText(history, *out.report);
+    history.Ingest(*out.report, out.history_error);
+  }
+  return out;
+}
+
+} // namespace llaudit
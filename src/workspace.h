@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "audit_engine.h"
+
+namespace llaudit {
+
+// One provider's entry in config/api_keys.json. value may hold several keys
+// separated by commas, semicolons or spaces, each with an optional "@tier".
+struct KeyField {
+  std::string id;
+  std::string label;
+  std::string value;
+};
+
+// One empty field per provider, in report order.
+std::vector<KeyField> KeyFieldsFor(const std::vector<ProviderSpec>& providers);
+// KeyFieldsFor(BuiltinProviders()).
+std::vector<KeyField> DefaultKeyFields();
+
+struct WorkspacePaths {
+  std::filesystem::path root_dir;
+  std::filesystem::path config_file;
+  // Optional provider registry; see LoadProviderRegistry().
+  std::filesystem::path providers_file;
+  // Prompt suites run on every working model; see LoadPromptSuites().
+  std::filesystem::path suites_dir;
+  std::filesystem::path reports_dir;
+  std::filesystem::path logs_dir;
+  std::filesystem::path cache_dir;
+  std::filesystem::path history_dir;
+};
+
+WorkspacePaths BuildPaths(const std::string& workspace_input);
+bool EnsureWorkspace(const WorkspacePaths& paths, std::string& error);
+
+// The last applied workspace, remembered in ~/.api_tester/last_workspace.txt.
+// Loading leaves workspace untouched when nothing was saved yet.
+bool SaveWorkspaceHint(const std::string& workspace, std::string& error);
+bool LoadWorkspaceHint(std::string& workspace, std::string& error);
+
+bool SaveConfig(const std::vector<KeyField>& fields, const std::filesystem::path& config_file,
+                std::string& error);
+// Fills the fields whose ids appear in the file; a missing file is not an error.
+bool LoadConfig(std::vector<KeyField>& fields, const std::filesystem::path& config_file,
+                std::string& error);
+KeyPools KeysToPools(const std::vector<KeyField>& fields);
+
+// The built-in providers with config/providers.json applied when it exists.
+// On error providers holds the built-ins.
+bool LoadWorkspaceProviders(const WorkspacePaths& paths, std::vector<ProviderSpec>& providers,
+                            std::string& error);
+
+struct WorkspaceRunOptions {
+  // Reuse fresh checkpoints; see AuditOptions::resume.
+  bool resume = false;
+  // Use provider batch APIs; see AuditOptions::batch.
+  bool batch = false;
+  // Record responses into cache/responses, or replay them from there; a
+  // replayed run is not appended to history. See AuditOptions::record_mode.
+  RecordMode record = RecordMode::kOff;
+  bool replay_latency = false;
+  bool journal = true;
+  bool history = true;
+  // Also given every journal record, whether or not journal is set.
+  RecordFn on_record;
+  // Audit only the providers with keys in the pools, without the "No API
+  // key supplied." records of the rest; cluster workers run one key a time.
+  bool only_keyed_providers = false;
+  // See AuditOptions::initial_rate_limits.
+  std::map<std::string, RateLimitState> initial_rate_limits;
+  // Live counters for the Prometheus exporter; may be null.
+  AuditMetrics* metrics = nullptr;
+  LiveStats* live = nullptr;
+};
+
+struct WorkspaceRun {
+  std::shared_ptr<const AuditReport> report;
+  std::string run_log_path;
+  std::string journal_path;
+  // BuildHistoryDeltaText() against the runs before this one.
+  std::string history_delta;
+  std::string journal_error;
+  std::string history_error;
+  // The run fell back to the built-in providers.
+  std::string providers_error;
+  // The run went without the workspace prompt suites.
+  std::string suites_error;
+};
+
+// One audit the way the GUI and the CLI run it: catalogs and checkpoints
+// cached under cache/, a run journal next to the reports, the run log
+// written, and the result appended to history/ unless it was canceled.
+WorkspaceRun RunWorkspaceAudit(const WorkspacePaths& paths, const KeyPools& keys,
+                               const WorkspaceRunOptions& options, const LogFn& log,
+                               const std::atomic<bool>& cancel_requested);
+
+}  // namespace llaudit